@@ -24,8 +24,12 @@
  *  reference_parquet_file_path: file_path to Parquet file compatible with the standard Arrow library Parquet reading functions. 
  *    This file should contain the same values as the first file and is used for verifying the hardware output.
  *  num_val: How many values to read.
+ *  runs: How many times to read the values, the FPGA is only initialized once. Optional, 1 by default.
+ *  segment_size: Bytes of Parquet data per kernel run. With a segment size, copies to and from the FPGA overlap with
+ *    the kernel processing the segment before. Optional, 0 (the whole column chunk at once) by default.
  */
 
+#include <algorithm>
 #include <chrono>
 #include <memory>
 #include <vector>
@@ -44,55 +48,10 @@
 // Fletcher
 #include "fletcher/api.h"
 
-#define PRIM_WIDTH 32
-
-std::shared_ptr<arrow::RecordBatch> prepareRecordBatch(uint32_t num_val) {
-  std::shared_ptr<arrow::Buffer> values;
-
-  if (!arrow::AllocateBuffer(arrow::default_memory_pool(), sizeof(int32_t)*num_val, &values).ok()) {
-    throw std::runtime_error("Could not allocate values buffer.");
-  }
-
-  auto array = std::make_shared<arrow::Int32Array>(arrow::int32(), num_val, values);
-
-  auto schema_meta = metaMode(fletcher::Mode::WRITE);
-
-  std::shared_ptr<arrow::Schema> schema = arrow::schema({arrow::field("int", arrow::int32(), false)}, schema_meta);
-
-  auto rb = arrow::RecordBatch::Make(schema, num_val, {array});
-
-  return rb;
-}
-
-void setPtoaArguments(std::shared_ptr<fletcher::Platform> platform, uint32_t num_val, uint64_t max_size, da_t device_parquet_address, da_t device_arrow_address) {
-  dau_t mmio64_writer;
-
-  platform->writeMMIO(2, num_val);
-
-  mmio64_writer.full = device_parquet_address;
-  platform->writeMMIO(3, mmio64_writer.lo);
-  platform->writeMMIO(4, mmio64_writer.hi);
-  
-  mmio64_writer.full = max_size;
-  platform->writeMMIO(5, mmio64_writer.lo);
-  platform->writeMMIO(6, mmio64_writer.hi);
-  
-  mmio64_writer.full = device_arrow_address;
-  platform->writeMMIO(7, mmio64_writer.lo);
-  platform->writeMMIO(8, mmio64_writer.hi);
+// Ptoa
+#include "fpgareader.h"
 
-  return;
-}
-
-void checkMMIO(std::shared_ptr<fletcher::Platform> platform, uint32_t num_val, uint64_t max_size, da_t device_parquet_address, da_t device_arrow_address) {
-  uint64_t value64;
-  uint32_t value32;
-
-  platform->readMMIO(2, &value32);
-
-  std::cout << "MMIO num_val=" << value32 << ", should be " << num_val << std::endl;
-
-}
+#define PRIM_WIDTH 32
 
 //Use standard Arrow library functions to read Arrow array from Parquet file
 //Only works for Parquet version 1 style files.
@@ -111,15 +70,16 @@ std::shared_ptr<arrow::Array> readArray(std::string hw_input_file_path) {
 
 int main(int argc, char **argv) {
 
-  std::shared_ptr<fletcher::Platform> platform;
-  std::shared_ptr<fletcher::Context> context;
-  std::shared_ptr<fletcher::UserCore> usercore;
+  ptoa::FpgaReader fpga_reader;
+  ptoa::job_timing timing;
 
   fletcher::Timer t;
 
   char* hw_input_file_path;
   char* reference_parquet_file_path;
   uint32_t num_val;
+  int runs = 1;
+  int64_t segment_size = 0;
   uint64_t file_size;
   uint8_t* file_data;
 
@@ -127,9 +87,15 @@ int main(int argc, char **argv) {
     hw_input_file_path = argv[1];
     reference_parquet_file_path = argv[2];
     num_val = (uint32_t) std::strtoul(argv[3], nullptr, 10);
+    if (argc > 4) {
+      runs = std::max(1, std::atoi(argv[4]));
+    }
+    if (argc > 5) {
+      segment_size = std::strtoll(argv[5], nullptr, 10);
+    }
 
   } else {
-    std::cerr << "Usage: prim32 <parquet_hw_input_file_path> <reference_parquet_file_path> <num_values>" << std::endl;
+    std::cerr << "Usage: prim32 <parquet_hw_input_file_path> <reference_parquet_file_path> <num_values> [runs] [segment_size]" << std::endl;
     return 1;
   }
 
@@ -156,85 +122,45 @@ int main(int argc, char **argv) {
   posix_memalign((void**)&file_data, 4096, file_size);
   parquet_file.read((char *)file_data, file_size);
 
-
-  /*************************************************************
-  * FPGA RecordBatch preparation
-  *************************************************************/
-
-  t.start();
-  auto arrow_rb_fpga = prepareRecordBatch(num_val);
-  t.stop();
-  std::cout << "Prepare FPGA RecordBatch         : "
-            << t.seconds() << std::endl;
-
   /*************************************************************
   * FPGA Initilialization
   *************************************************************/
 
   t.start();
-  // Create and intitialize platform
-  fletcher::Platform::Make(&platform).ewf("Could not create platform.");
-  platform->init();
-
-  //Create context
-  fletcher::Context::Make(&context, platform);
-
-  //Create usercore and reset CL
-  usercore = std::make_shared<fletcher::UserCore>(context);
-  usercore->reset();
-
-  //Setup destination recordbatch on device
-  context->queueRecordBatch(arrow_rb_fpga);
-  context->enable();
-
-  //Malloc parquet file on device
-  da_t device_parquet_address;
-  platform->deviceMalloc(&device_parquet_address, file_size);
-
-  // Set all the MMIO registers to their correct value
-  // Add 4 to device_parquet_address to skip magic number
-  setPtoaArguments(platform, num_val, file_size, device_parquet_address+4, context->device_arrays[0]->buffers[0].device_address);
+  if (fpga_reader.init() != ptoa::status::OK) {
+    std::cerr << "Could not initialize the FPGA" << std::endl;
+    return 1;
+  }
+  fpga_reader.set_segment_size(segment_size);
   t.stop();
   std::cout << "FPGA Initialize                  : "
             << t.seconds() << std::endl;
 
   /*************************************************************
-  * FPGA host to device copy
+  * FPGA reads, the column chunk starts after the magic number
   *************************************************************/
 
-  t.start();
-  platform->copyHostToDevice(file_data, device_parquet_address, file_size);
-  t.stop();
-  std::cout << "FPGA host to device copy         : "
-            << t.seconds() << std::endl;
-
-  /*************************************************************
-  * FPGA processing
-  *************************************************************/
-
-  t.start();
-  usercore->start();
-  usercore->waitForFinish(100);
-  t.stop();
-  std::cout << "FPGA processing time             : "
-            << t.seconds() << std::endl;
+  ptoa::column_descriptor column(arrow::field("int", arrow::int32(), false), ptoa::encoding::DELTA, num_val);
+  std::shared_ptr<arrow::Array> array;
 
-  /*************************************************************
-  * FPGA device to host copy
-  *************************************************************/
+  for (int run = 0; run < runs; run++) {
+    if (fpga_reader.read(file_data, file_size, column, &array, &timing) != ptoa::status::OK) {
+      std::cerr << "Could not read the values on the FPGA" << std::endl;
+      return 1;
+    }
 
-  t.start();
-  auto result_array = std::dynamic_pointer_cast<arrow::Int32Array>(arrow_rb_fpga->column(0));
-  auto result_buffer_raw_data = result_array->values()->mutable_data();
-  platform->copyDeviceToHost(context->device_arrays[0]->buffers[0].device_address,
-                             result_buffer_raw_data,
-                             sizeof(int32_t) * (num_val));
-  t.stop();
+    std::cout << "FPGA host to device copy         : "
+              << timing.copy_to_device << std::endl;
+    std::cout << "FPGA processing time             : "
+              << timing.process << std::endl;
+    std::cout << "FPGA device to host copy         : "
+              << timing.copy_to_host << std::endl;
+    std::cout << "FPGA total read time             : "
+              << timing.total << std::endl;
+  }
 
   size_t total_arrow_size = sizeof(int32_t) * num_val;
-  
-  std::cout << "FPGA device to host copy         : "
-            << t.seconds() << std::endl;
+
   std::cout << "Arrow buffers total size         : "
             << total_arrow_size << std::endl;
 
@@ -242,6 +168,7 @@ int main(int argc, char **argv) {
   * Check results
   *************************************************************/
 
+  auto result_array = std::dynamic_pointer_cast<arrow::Int32Array>(array);
   auto correct_array = std::dynamic_pointer_cast<arrow::Int32Array>(readArray(std::string(reference_parquet_file_path)));
   int error_count = 0;
   for(int i=0; i<result_array->length(); i++) {
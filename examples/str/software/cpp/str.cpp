@@ -24,8 +24,12 @@
  *  reference_parquet_file_path: file_path to Parquet file compatible with the standard Arrow library Parquet reading functions. 
  *    This file should contain the same values as the first file and is used for verifying the hardware output.
  *  num_val: How many values to read.
+ *  runs: How many times to read the values, the FPGA is only initialized once. Optional, 1 by default.
+ *  segment_size: Bytes of Parquet data per kernel run. With a segment size, copies to and from the FPGA overlap with
+ *    the kernel processing the segment before. Optional, 0 (the whole column chunk at once) by default.
  */
 
+#include <algorithm>
 #include <chrono>
 #include <memory>
 #include <vector>
@@ -44,53 +48,8 @@
 // Fletcher
 #include "fletcher/api.h"
 
-
-std::shared_ptr<arrow::RecordBatch> prepareRecordBatch(uint32_t num_strings, uint32_t num_chars) {
-  std::shared_ptr<arrow::Buffer> values;
-  std::shared_ptr<arrow::Buffer> offsets;
-
-  if (!arrow::AllocateBuffer(arrow::default_memory_pool(), num_chars, &values).ok()) {
-    throw std::runtime_error("Could not allocate values buffer.");
-  }
-
-  if (!arrow::AllocateBuffer(arrow::default_memory_pool(), sizeof(int32_t)*(num_strings+1), &offsets).ok()) {
-    throw std::runtime_error("Could not allocate offsets buffer.");
-  }
-
-  auto array = std::make_shared<arrow::StringArray>(num_strings, offsets, values);
-
-  auto schema_meta = metaMode(fletcher::Mode::WRITE);
-
-  std::shared_ptr<arrow::Schema> schema = arrow::schema({arrow::field("str", arrow::utf8(), false)}, schema_meta);
-
-  auto rb = arrow::RecordBatch::Make(schema, num_strings, {array});
-
-  return rb;
-}
-
-void setPtoaArguments(std::shared_ptr<fletcher::Platform> platform, uint32_t num_val, uint64_t max_size, da_t device_parquet_address, da_t device_arrow_offsets_address, da_t device_arrow_values_address) {
-  dau_t mmio64_writer;
-
-  platform->writeMMIO(2, num_val);
-
-  mmio64_writer.full = device_parquet_address;
-  platform->writeMMIO(3, mmio64_writer.lo);
-  platform->writeMMIO(4, mmio64_writer.hi);
-  
-  mmio64_writer.full = max_size;
-  platform->writeMMIO(5, mmio64_writer.lo);
-  platform->writeMMIO(6, mmio64_writer.hi);
-  
-  mmio64_writer.full = device_arrow_values_address;
-  platform->writeMMIO(7, mmio64_writer.lo);
-  platform->writeMMIO(8, mmio64_writer.hi);
-  
-  mmio64_writer.full = device_arrow_offsets_address;
-  platform->writeMMIO(9, mmio64_writer.lo);
-  platform->writeMMIO(10, mmio64_writer.hi);
-
-  return;
-}
+// Ptoa
+#include "fpgareader.h"
 
 //Use standard Arrow library functions to read Arrow array from Parquet file
 //Only works for Parquet version 1 style files.
@@ -109,9 +68,8 @@ std::shared_ptr<arrow::Array> readArray(std::string hw_input_file_path) {
 
 int main(int argc, char **argv) {
 
-  std::shared_ptr<fletcher::Platform> platform;
-  std::shared_ptr<fletcher::Context> context;
-  std::shared_ptr<fletcher::UserCore> usercore;
+  ptoa::FpgaReader fpga_reader;
+  ptoa::job_timing timing;
 
   fletcher::Timer t;
 
@@ -119,6 +77,8 @@ int main(int argc, char **argv) {
   char* reference_parquet_file_path;
   uint32_t num_strings;
   uint32_t num_chars;
+  int runs = 1;
+  int64_t segment_size = 0;
   uint64_t file_size;
   uint8_t* file_data;
 
@@ -126,9 +86,15 @@ int main(int argc, char **argv) {
     hw_input_file_path = argv[1];
     reference_parquet_file_path = argv[2];
     num_strings = (uint32_t) std::strtoul(argv[3], nullptr, 10);
+    if (argc > 4) {
+      runs = std::max(1, std::atoi(argv[4]));
+    }
+    if (argc > 5) {
+      segment_size = std::strtoll(argv[5], nullptr, 10);
+    }
 
   } else {
-    std::cerr << "Usage: prim32 <parquet_hw_input_file_path> <reference_parquet_file_path> <num_strings>" << std::endl;
+    std::cerr << "Usage: prim32 <parquet_hw_input_file_path> <reference_parquet_file_path> <num_strings> [runs] [segment_size]" << std::endl;
     return 1;
   }
 
@@ -162,96 +128,53 @@ int main(int argc, char **argv) {
   parquet_file.read((char *)file_data, file_size);
 
 
-  /*************************************************************
-  * FPGA RecordBatch preparation
-  *************************************************************/
-
-  t.start();
-  auto arrow_rb_fpga = prepareRecordBatch(num_strings, num_chars);
-  t.stop();
-  std::cout << "Prepare FPGA RecordBatch         : "
-            << t.seconds() << std::endl;
-
   /*************************************************************
   * FPGA Initilialization
   *************************************************************/
 
   t.start();
-  // Create and intitialize platform
-  fletcher::Platform::Make(&platform).ewf("Could not create platform.");
-  platform->init();
-
-  //Create context
-  fletcher::Context::Make(&context, platform);
-
-  //Create usercore and reset CL
-  usercore = std::make_shared<fletcher::UserCore>(context);
-  usercore->reset();
-
-  //Setup destination recordbatch on device
-  context->queueRecordBatch(arrow_rb_fpga);
-  context->enable();
-
-  //Malloc parquet file on device
-  da_t device_parquet_address;
-  platform->deviceMalloc(&device_parquet_address, file_size);
-
-  // Set all the MMIO registers to their correct value
-  // Add 4 to device_parquet_address to skip magic number
-  setPtoaArguments(platform, num_strings, file_size, device_parquet_address+4, context->device_arrays[0]->buffers[0].device_address, context->device_arrays[0]->buffers[1].device_address);
+  if (fpga_reader.init() != ptoa::status::OK) {
+    std::cerr << "Could not initialize the FPGA" << std::endl;
+    return 1;
+  }
+  fpga_reader.set_segment_size(segment_size);
   t.stop();
   std::cout << "FPGA Initialize                  : "
             << t.seconds() << std::endl;
 
   /*************************************************************
-  * FPGA host to device copy
-  *************************************************************/
-
-  t.start();
-  platform->copyHostToDevice(file_data, device_parquet_address, file_size);
-  t.stop();
-  std::cout << "FPGA host to device copy         : "
-            << t.seconds() << std::endl;
-
-  /*************************************************************
-  * FPGA processing
+  * FPGA reads, the column chunk starts after the magic number
   *************************************************************/
 
-  t.start();
-  usercore->start();
-  usercore->waitForFinish(100);
-  t.stop();
-  std::cout << "FPGA processing time             : "
-            << t.seconds() << std::endl;
-
-  /*************************************************************
-  * FPGA device to host copy
-  *************************************************************/
-
-  t.start();
-  auto result_array = std::dynamic_pointer_cast<arrow::StringArray>(arrow_rb_fpga->column(0));
-  auto result_buffer_raw_offsets = result_array->value_offsets()->mutable_data();
-  auto result_buffer_raw_values = result_array->value_data()->mutable_data();
+  ptoa::column_descriptor column(arrow::field("str", arrow::utf8(), false), ptoa::encoding::DELTA_LENGTH, num_strings, num_chars);
+  std::shared_ptr<arrow::Array> array;
 
-  platform->copyDeviceToHost(context->device_arrays[0]->buffers[0].device_address,
-                             result_buffer_raw_offsets,
-                             sizeof(int32_t) * (num_strings+1));
+  for (int run = 0; run < runs; run++) {
+    if (fpga_reader.read(file_data, file_size, column, &array, &timing) != ptoa::status::OK) {
+      std::cerr << "Could not read the strings on the FPGA" << std::endl;
+      return 1;
+    }
 
-  platform->copyDeviceToHost(context->device_arrays[0]->buffers[1].device_address,
-                             result_buffer_raw_values,
-                             num_chars);
-  t.stop();
+    std::cout << "FPGA host to device copy         : "
+              << timing.copy_to_device << std::endl;
+    std::cout << "FPGA processing time             : "
+              << timing.process << std::endl;
+    std::cout << "FPGA device to host copy         : "
+              << timing.copy_to_host << std::endl;
+    std::cout << "FPGA total read time             : "
+              << timing.total << std::endl;
+  }
 
   size_t total_arrow_size = sizeof(int32_t) * (num_strings+1) + num_chars;
 
-  std::cout << "FPGA device to host copy         : "
-            << t.seconds() << std::endl;
   std::cout << "Arrow buffers total size         : "
             << total_arrow_size << std::endl;
 
   /*************************************************************
   * Check results
   *************************************************************/
+
+  auto result_array = std::dynamic_pointer_cast<arrow::StringArray>(array);
   int error_count = 0;
   for(int i=0; i<result_array->length(); i++) {
     if(result_array->GetString(i).compare(correct_array->GetString(i)) != 0) {
@@ -0,0 +1,383 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <arrow/api.h>
+
+#include <SWParquetReader.h>
+#include <ptoa.h>
+
+#include "fletcher_emu.h"
+
+namespace {
+
+typedef std::chrono::steady_clock emu_clock;
+
+// The columns a kernel reads, prim_width is 0 for strings
+struct emu_kernel {
+    const char* name;
+    int32_t prim_width;
+    ptoa::encoding enc;
+};
+
+const emu_kernel kernels[] = {
+    {"prim32_delta", 32, ptoa::encoding::DELTA},
+    {"prim32_plain", 32, ptoa::encoding::PLAIN},
+    {"prim64_delta", 64, ptoa::encoding::DELTA},
+    {"prim64_plain", 64, ptoa::encoding::PLAIN},
+    {"strings", 0, ptoa::encoding::DELTA_LENGTH}
+};
+
+struct emu_state {
+    const emu_kernel* kernel = nullptr;
+    // Bytes per second, 0 for unlimited
+    double link_bandwidth = 0;
+    double kernel_throughput = 0;
+    // Seconds
+    double link_latency = 0;
+
+    // Start and size of every device allocation
+    std::mutex memory_mutex;
+    std::map<uint64_t, int64_t> allocations;
+
+    // Transfers in the same direction take turns on the link, transfers in opposite directions overlap
+    std::mutex to_device_link;
+    std::mutex to_host_link;
+
+    std::mutex regs_mutex;
+    uint32_t regs[EMU_NUM_REGS] = {0};
+    std::thread kernel_thread;
+    std::atomic<bool> busy{false};
+    std::atomic<bool> done{false};
+    // Latched until the next start or reset, so the host sees it after the kernel is done
+    std::atomic<bool> failed{false};
+};
+
+emu_state emu;
+
+// Wait until seconds have passed since start, to stretch an operation that was faster than the emulated hardware
+void pad(emu_clock::time_point start, double seconds) {
+    if(seconds > 0){
+        std::this_thread::sleep_until(start + std::chrono::duration_cast<emu_clock::duration>(std::chrono::duration<double>(seconds)));
+    }
+}
+
+// Whether size bytes at address lie within one device allocation. available is set to the bytes from address to the
+// end of that allocation.
+bool in_device_memory(uint64_t address, int64_t size, int64_t* available) {
+    std::lock_guard<std::mutex> lock(emu.memory_mutex);
+
+    auto allocation = emu.allocations.upper_bound(address);
+    if(allocation == emu.allocations.begin() || size < 0){
+        return false;
+    }
+    --allocation;
+
+    int64_t remaining = (int64_t) (allocation->first + allocation->second) - (int64_t) address;
+    if(available != nullptr){
+        *available = remaining;
+    }
+
+    return size <= remaining;
+}
+
+fstatus_t transfer(uint8_t* destination, const uint8_t* source, int64_t size, std::mutex* link) {
+    std::lock_guard<std::mutex> lock(*link);
+    emu_clock::time_point start = emu_clock::now();
+
+    std::memcpy(destination, source, size);
+
+    pad(start, emu.link_latency + (emu.link_bandwidth > 0 ? size/emu.link_bandwidth : 0));
+
+    return FLETCHER_STATUS_OK;
+}
+
+uint64_t reg64(const uint32_t* regs, int reg) {
+    return (uint64_t) regs[reg] | ((uint64_t) regs[reg + 1] << 32);
+}
+
+// Run SWParquetReader on the device memory the arguments point to, as the kernel would
+ptoa::status decode(const uint32_t* regs) {
+    const emu_kernel* kernel = emu.kernel;
+    int64_t num_values = regs[EMU_REG_NUM_VAL];
+    uint64_t page_address = reg64(regs, EMU_REG_PAGE_ADDR);
+    int64_t max_size = reg64(regs, EMU_REG_MAX_SIZE);
+    uint64_t values_address = reg64(regs, EMU_REG_VAL_ADDR);
+    uint64_t offsets_address = reg64(regs, EMU_REG_OFF_ADDR);
+    int64_t values_available;
+    int64_t offsets_available;
+
+    if(!in_device_memory(page_address, max_size, nullptr)){
+        std::cerr << "[ERROR] Parquet data at 0x" << std::hex << page_address << std::dec << " with max_size " << max_size << " is not in device memory" << std::endl;
+        return ptoa::status::FAIL;
+    }
+
+    int64_t values_size = kernel->prim_width*num_values/8;
+    if(!in_device_memory(values_address, values_size, &values_available)){
+        std::cerr << "[ERROR] Arrow values at 0x" << std::hex << values_address << std::dec << " are not in device memory" << std::endl;
+        return ptoa::status::FAIL;
+    }
+
+    ptoa::SWParquetReader reader((const uint8_t*) page_address, max_size);
+    std::shared_ptr<arrow::Buffer> values = std::make_shared<arrow::MutableBuffer>((uint8_t*) values_address, values_available);
+
+    if(kernel->prim_width > 0){
+        std::shared_ptr<arrow::PrimitiveArray> array;
+        return reader.read_prim(kernel->prim_width, num_values, 0, &array, values, kernel->enc);
+    }
+
+    if(!in_device_memory(offsets_address, sizeof(int32_t)*(num_values + 1), &offsets_available)){
+        std::cerr << "[ERROR] Arrow offsets at 0x" << std::hex << offsets_address << std::dec << " are not in device memory" << std::endl;
+        return ptoa::status::FAIL;
+    }
+
+    std::shared_ptr<arrow::Buffer> offsets = std::make_shared<arrow::MutableBuffer>((uint8_t*) offsets_address, offsets_available);
+    std::shared_ptr<arrow::StringArray> array;
+
+    // The reader fails before copying characters past values_available, like the kernel stops at the end of the buffer
+    return reader.read_string(num_values, 0, &array, offsets, values, kernel->enc);
+}
+
+void run_kernel(uint32_t* regs) {
+    emu_clock::time_point start = emu_clock::now();
+
+    if(decode(regs) != ptoa::status::OK){
+        std::cerr << "[ERROR] Emulated " << emu.kernel->name << " kernel failed" << std::endl;
+        emu.failed = true;
+    }
+
+    if(emu.kernel_throughput > 0){
+        pad(start, reg64(regs, EMU_REG_MAX_SIZE)/emu.kernel_throughput);
+    }
+
+    delete[] regs;
+
+    emu.done = true;
+    emu.busy = false;
+}
+
+void join_kernel() {
+    if(emu.kernel_thread.joinable()){
+        emu.kernel_thread.join();
+    }
+}
+
+fstatus_t read_setting(const char* variable, double scale, double* setting) {
+    const char* value = getenv(variable);
+    *setting = 0;
+
+    if(value == nullptr || *value == '\0'){
+        return FLETCHER_STATUS_OK;
+    }
+
+    char* end;
+    double parsed = std::strtod(value, &end);
+    if(*end != '\0' || parsed < 0){
+        std::cerr << "[ERROR] " << variable << " should be a non-negative number, not " << value << std::endl;
+        return FLETCHER_STATUS_ERROR;
+    }
+
+    *setting = parsed*scale;
+
+    return FLETCHER_STATUS_OK;
+}
+
+}
+
+fstatus_t platformGetName(char* name, size_t size) {
+    if(size > 0){
+        std::strncpy(name, EMU_PLATFORM_NAME, size - 1);
+        name[size - 1] = '\0';
+    }
+
+    return FLETCHER_STATUS_OK;
+}
+
+fstatus_t platformInit(void* arg) {
+    (void) arg;
+
+    const char* kernel_name = getenv(EMU_ENV_KERNEL);
+    std::string name = kernel_name == nullptr || *kernel_name == '\0' ? kernels[0].name : kernel_name;
+
+    emu.kernel = nullptr;
+    for(const emu_kernel& kernel : kernels){
+        if(name == kernel.name){
+            emu.kernel = &kernel;
+        }
+    }
+    if(emu.kernel == nullptr){
+        std::cerr << "[ERROR] Unknown kernel " << name << " in " << EMU_ENV_KERNEL << std::endl;
+        return FLETCHER_STATUS_ERROR;
+    }
+
+    if(read_setting(EMU_ENV_LINK_BANDWIDTH, 1e9, &emu.link_bandwidth) != FLETCHER_STATUS_OK ||
+       read_setting(EMU_ENV_LINK_LATENCY, 1e-6, &emu.link_latency) != FLETCHER_STATUS_OK ||
+       read_setting(EMU_ENV_KERNEL_THROUGHPUT, 1e9, &emu.kernel_throughput) != FLETCHER_STATUS_OK){
+        return FLETCHER_STATUS_ERROR;
+    }
+
+    join_kernel();
+    std::lock_guard<std::mutex> lock(emu.regs_mutex);
+    std::memset(emu.regs, 0, sizeof(emu.regs));
+    emu.busy = false;
+    emu.done = false;
+    emu.failed = false;
+
+    return FLETCHER_STATUS_OK;
+}
+
+fstatus_t platformWriteMMIO(uint64_t offset, uint32_t value) {
+    if(offset >= EMU_NUM_REGS){
+        std::cerr << "[ERROR] Write to register " << offset << " outside of the MMIO space" << std::endl;
+        return FLETCHER_STATUS_ERROR;
+    }
+    if(offset == EMU_REG_STATUS){
+        return FLETCHER_STATUS_OK;
+    }
+
+    std::lock_guard<std::mutex> lock(emu.regs_mutex);
+    emu.regs[offset] = value;
+
+    if(offset != EMU_REG_CONTROL){
+        return FLETCHER_STATUS_OK;
+    }
+
+    // The kernel cannot be interrupted, a reset waits for it to finish
+    if(value & EMU_CONTROL_RESET){
+        join_kernel();
+        emu.done = false;
+        emu.failed = false;
+    }
+
+    if(value & EMU_CONTROL_START){
+        if(emu.busy){
+            std::cerr << "[WARNING] Kernel started while it is busy, ignored" << std::endl;
+            return FLETCHER_STATUS_OK;
+        }
+        join_kernel();
+
+        // The arguments are taken at the start, like the hardware does
+        uint32_t* regs = new uint32_t[EMU_NUM_REGS];
+        std::memcpy(regs, emu.regs, sizeof(emu.regs));
+
+        emu.done = false;
+        emu.failed = false;
+        emu.busy = true;
+        emu.kernel_thread = std::thread(run_kernel, regs);
+    }
+
+    return FLETCHER_STATUS_OK;
+}
+
+fstatus_t platformReadMMIO(uint64_t offset, uint32_t* value) {
+    if(offset >= EMU_NUM_REGS){
+        std::cerr << "[ERROR] Read from register " << offset << " outside of the MMIO space" << std::endl;
+        return FLETCHER_STATUS_ERROR;
+    }
+
+    if(offset == EMU_REG_STATUS){
+        *value = emu.busy ? EMU_STATUS_BUSY : EMU_STATUS_IDLE | (emu.done ? EMU_STATUS_DONE : 0) | (emu.failed ? EMU_STATUS_FAILED : 0);
+        return FLETCHER_STATUS_OK;
+    }
+
+    std::lock_guard<std::mutex> lock(emu.regs_mutex);
+    *value = emu.regs[offset];
+
+    return FLETCHER_STATUS_OK;
+}
+
+fstatus_t platformCopyHostToDevice(const uint8_t* host_source, da_t device_destination, int64_t size) {
+    if(!in_device_memory(device_destination, size, nullptr)){
+        std::cerr << "[ERROR] Copy of " << size << " bytes to 0x" << std::hex << device_destination << std::dec << " outside of device memory" << std::endl;
+        return FLETCHER_STATUS_ERROR;
+    }
+
+    return transfer((uint8_t*) device_destination, host_source, size, &emu.to_device_link);
+}
+
+fstatus_t platformCopyDeviceToHost(da_t device_source, uint8_t* host_destination, int64_t size) {
+    if(!in_device_memory(device_source, size, nullptr)){
+        std::cerr << "[ERROR] Copy of " << size << " bytes from 0x" << std::hex << device_source << std::dec << " outside of device memory" << std::endl;
+        return FLETCHER_STATUS_ERROR;
+    }
+
+    return transfer(host_destination, (const uint8_t*) device_source, size, &emu.to_host_link);
+}
+
+fstatus_t platformDeviceMalloc(da_t* device_address, int64_t size) {
+    void* allocation;
+
+    if(size < 0 || posix_memalign(&allocation, EMU_DEVICE_ALIGNMENT, size + EMU_DEVICE_PADDING) != 0){
+        std::cerr << "[ERROR] Could not allocate " << size << " bytes of device memory" << std::endl;
+        return FLETCHER_STATUS_ERROR;
+    }
+    std::memset((uint8_t*) allocation + size, 0, EMU_DEVICE_PADDING);
+
+    std::lock_guard<std::mutex> lock(emu.memory_mutex);
+    emu.allocations[(uint64_t) allocation] = size;
+    *device_address = (da_t) allocation;
+
+    return FLETCHER_STATUS_OK;
+}
+
+fstatus_t platformDeviceFree(da_t device_address) {
+    std::lock_guard<std::mutex> lock(emu.memory_mutex);
+
+    auto allocation = emu.allocations.find(device_address);
+    if(allocation == emu.allocations.end()){
+        std::cerr << "[ERROR] 0x" << std::hex << device_address << std::dec << " is not a device allocation" << std::endl;
+        return FLETCHER_STATUS_ERROR;
+    }
+
+    free((void*) allocation->first);
+    emu.allocations.erase(allocation);
+
+    return FLETCHER_STATUS_OK;
+}
+
+// Host and device share the memory, but buffers the kernel reads get padding, so they are always copied
+fstatus_t platformPrepareHostBuffer(const uint8_t* host_source, da_t* device_destination, int64_t size, int* alloced) {
+    *alloced = 1;
+    return platformCacheHostBuffer(host_source, device_destination, size);
+}
+
+fstatus_t platformCacheHostBuffer(const uint8_t* host_source, da_t* device_destination, int64_t size) {
+    if(platformDeviceMalloc(device_destination, size) != FLETCHER_STATUS_OK){
+        return FLETCHER_STATUS_ERROR;
+    }
+
+    return platformCopyHostToDevice(host_source, *device_destination, size);
+}
+
+fstatus_t platformTerminate(void* arg) {
+    (void) arg;
+
+    join_kernel();
+
+    std::lock_guard<std::mutex> lock(emu.memory_mutex);
+    for(auto& allocation : emu.allocations){
+        free((void*) allocation.first);
+    }
+    emu.allocations.clear();
+
+    return FLETCHER_STATUS_OK;
+}
@@ -0,0 +1,83 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <fletcher/fletcher.h>
+
+// Name under which the Fletcher runtime finds the platform (libfletcher_emu.so)
+#define EMU_PLATFORM_NAME "emu"
+
+// Environment variables configuring the emulator, read by platformInit
+// Kernel the emulated bitstream contains: prim32_delta (default), prim32_plain, prim64_delta, prim64_plain or strings
+#define EMU_ENV_KERNEL "PTOA_EMU_KERNEL"
+// Bandwidth of the host to device and device to host links in GB/s, unlimited if not set
+#define EMU_ENV_LINK_BANDWIDTH "PTOA_EMU_LINK_BANDWIDTH"
+// Fixed cost of every copy in microseconds, 0 if not set
+#define EMU_ENV_LINK_LATENCY "PTOA_EMU_LINK_LATENCY"
+// Parquet data the kernel consumes in GB/s, unlimited if not set
+#define EMU_ENV_KERNEL_THROUGHPUT "PTOA_EMU_KERNEL_THROUGHPUT"
+
+// Registers of the emulated MMIO space, 0 and 1 are the Fletcher control and status registers followed by the
+// arguments of the Ptoa kernel (see ptoa_wrapper.vhd)
+#define EMU_NUM_REGS 11
+#define EMU_REG_CONTROL 0
+#define EMU_REG_STATUS 1
+#define EMU_REG_NUM_VAL 2
+#define EMU_REG_PAGE_ADDR 3
+#define EMU_REG_MAX_SIZE 5
+#define EMU_REG_VAL_ADDR 7
+#define EMU_REG_OFF_ADDR 9
+
+// Bits of the control and status registers of the Fletcher UserCore
+#define EMU_CONTROL_START (1u << 0)
+#define EMU_CONTROL_STOP (1u << 1)
+#define EMU_CONTROL_RESET (1u << 2)
+#define EMU_STATUS_IDLE (1u << 0)
+#define EMU_STATUS_BUSY (1u << 1)
+#define EMU_STATUS_DONE (1u << 2)
+// Set together with done when the emulated kernel failed, e.g. on a corrupt page or an Arrow buffer that is too small.
+// The hardware kernel leaves this bit 0.
+#define EMU_STATUS_FAILED (1u << 3)
+
+// Zeroed bytes after every device allocation, the software decoders load whole words past the end of their input
+#define EMU_DEVICE_PADDING 4096
+
+// Alignment of device allocations, the same as the burst boundary of the AWS shell
+#define EMU_DEVICE_ALIGNMENT 4096
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Platform functions the Fletcher runtime loads from the platform library. Device memory is host memory: device
+ * addresses are pointers into allocations made by platformDeviceMalloc, copies are checked to stay within one.
+ */
+fstatus_t platformGetName(char* name, size_t size);
+fstatus_t platformInit(void* arg);
+fstatus_t platformWriteMMIO(uint64_t offset, uint32_t value);
+fstatus_t platformReadMMIO(uint64_t offset, uint32_t* value);
+fstatus_t platformCopyHostToDevice(const uint8_t* host_source, da_t device_destination, int64_t size);
+fstatus_t platformCopyDeviceToHost(da_t device_source, uint8_t* host_destination, int64_t size);
+fstatus_t platformDeviceMalloc(da_t* device_address, int64_t size);
+fstatus_t platformDeviceFree(da_t device_address);
+fstatus_t platformPrepareHostBuffer(const uint8_t* host_source, da_t* device_destination, int64_t size, int* alloced);
+fstatus_t platformCacheHostBuffer(const uint8_t* host_source, da_t* device_destination, int64_t size);
+fstatus_t platformTerminate(void* arg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,888 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <parquet/arrow/reader.h>
+
+#include <SWParquetReader.h>
+#include <datagen.h>
+#include <hwpages.h>
+#include <timer.h>
+#include <options.h>
+
+// Defaults of the hardware model, taken from the AWS F1 builds: clk_main_a0 in cl_clocks_aws.xdc, the 512 bit AXI bus
+// of the shell and the prim(64;epc=8) configuration of ptoa_wrapper.vhd
+#define HW_CLOCK_MHZ 250
+#define HW_BUS_DATA_WIDTH 512
+#define HW_ELEMENTS_PER_CYCLE 8
+// Cycles between the pages of a column chunk: the metadata interpreter handing over a new page and the decoder pipeline
+// being reset. Not measured, tune it with Ptoa_sim.
+#define HW_PAGE_CYCLES 16
+
+// Pages of the files that measure the cost of parsing a page header
+#define CALIBRATION_PAGES (64*1024)
+// Length of the strings of the file that measures the cost of copying characters
+#define CALIBRATION_STRING_LENGTH 32
+
+struct advise_options {
+    std::string input_path;
+    std::vector<std::string> columns;
+    std::vector<column_spec> generated;
+    int64_t sample_rows = 1000000;
+    std::vector<std::string> encodings = {"plain", "delta"};
+    std::vector<int64_t> rows_per_page = {1000, 2000, 5000, 10000, 20000, 50000, 100000};
+    std::vector<int> decoder_widths = {64, 128};
+    std::string target = "ptoa";
+    double tolerance = 0.05;
+    int64_t hw_epc = HW_ELEMENTS_PER_CYCLE;
+    int64_t hw_clock_mhz = HW_CLOCK_MHZ;
+    int64_t hw_page_cycles = HW_PAGE_CYCLES;
+    int64_t calibration_values = 1024*1024;
+    int64_t iterations = 5;
+    int64_t warmup_iterations = 1;
+    uint64_t seed = 42;
+    int64_t threads = 0;
+    std::string dir = ".";
+    std::string output_path;
+    bool verify = false;
+};
+
+/**
+ * Decoding costs of SWParquetReader in nanoseconds, measured on files in which a single cost dominates. Arrays indexed
+ * by prim width have the 32 bit cost first. A miniblock costs its bit unpacking, the prefix sum of its 32 values and a
+ * quarter of a block header. Strings pay a cost per value for their offsets and per character for the copy, the bit
+ * width of their length deltas adds what it adds to a 32 bit miniblock.
+ */
+struct decode_costs {
+    double plain_page;
+    double plain_byte;
+    double delta_page[2];
+    double miniblock[2][DELTA_BIT_WIDTHS];
+    double string_page;
+    double string_value;
+    double string_char;
+};
+
+// Sampled values of a column. Strings are kept as offsets and characters like in an Arrow StringArray.
+struct column_sample {
+    std::string name;
+    arrow::Type::type type;
+    int64_t total_rows;
+    std::vector<int32_t> int32_values;
+    std::vector<int64_t> int64_values;
+    std::vector<int32_t> offsets = {0};
+    std::string chars;
+
+    int64_t num_values() const;
+    int prim_width() const { return type == arrow::Type::INT32 ? 32 : 64; }
+    bool is_string() const { return type == arrow::Type::STRING || type == arrow::Type::BINARY; }
+    // Bytes of the Arrow buffers the sample decodes into
+    int64_t output_bytes() const;
+};
+
+// Sample written with one encoding and page size. seconds holds the estimate of every model, -1 if it does not apply.
+struct candidate {
+    std::string encoding;
+    int64_t rows_per_page;
+    int64_t pages;
+    int64_t blocks;
+    int64_t width_counts[DELTA_BIT_WIDTHS];
+    std::vector<uint8_t> file;
+    std::vector<double> seconds;
+};
+
+int64_t column_sample::num_values() const {
+    if(is_string()) {
+        return offsets.size() - 1;
+    }
+    return type == arrow::Type::INT32 ? int32_values.size() : int64_values.size();
+}
+
+int64_t column_sample::output_bytes() const {
+    if(is_string()) {
+        return (num_values() + 1)*sizeof(int32_t) + chars.size();
+    }
+    return num_values()*(prim_width()/8);
+}
+
+void print_usage() {
+    std::cerr << "Usage: advise [--option=value]... [<input.parquet>]" << std::endl
+              << "Estimates the decoding time of sampled columns for every encoding and page size from calibrated costs of" << std::endl
+              << "SWParquetReader and a model of the hardware decoders, and recommends the fastest configuration." << std::endl
+              << "  --columns             comma separated columns of the input to sample (default all)" << std::endl
+              << "  --generate            sample a generated column instead, name:type:distribution[:key=value,...] as for" << std::endl
+              << "                        the generate benchmark, repeat for more columns" << std::endl
+              << "  --sample_rows         values sampled from the start of every column (default 1000000)" << std::endl
+              << "  --encodings           candidate encodings of integer columns, plain and/or delta, strings are always" << std::endl
+              << "                        delta length encoded (default plain,delta)" << std::endl
+              << "  --rows_per_page       candidate page sizes in values (default 1000,2000,5000,10000,20000,50000,100000)" << std::endl
+              << "  --hardware            decoder widths of the modeled hardware builds, e.g. 64,128 for decw_64 and" << std::endl
+              << "                        decw_128, or none (default 64,128)" << std::endl
+              << "  --target              ptoa or decw_<width>, the decoder the recommendation is made for (default ptoa)" << std::endl
+              << "  --tolerance           configurations this much slower than the fastest compete on size (default 0.05)" << std::endl
+              << "  --hw_epc              values the hardware decoders produce per cycle (default " << HW_ELEMENTS_PER_CYCLE << ")" << std::endl
+              << "  --hw_clock_mhz        clock of the hardware decoders (default " << HW_CLOCK_MHZ << ")" << std::endl
+              << "  --hw_page_cycles      cycles the hardware spends between pages (default " << HW_PAGE_CYCLES << ")" << std::endl
+              << "  --calibration_values  values per calibration file (default 1048576)" << std::endl
+              << "  --iterations          timed decodes per calibration file (default 5)" << std::endl
+              << "  --warmup              untimed decodes per calibration file (default 1)" << std::endl
+              << "  --seed                seed of the calibration data and the generated columns (default 42)" << std::endl
+              << "  --threads             threads generating columns, 0 for all cores (default 0)" << std::endl
+              << "  --dir                 directory for the calibration files (default .)" << std::endl
+              << "  --output              write the recommendation as transcode --config file" << std::endl
+              << "  --verify              decode the sample in the recommended configuration and compare with the estimate" << std::endl
+              << "The recommendation of every column is printed as transcode --column option, the same settings can be" << std::endl
+              << "passed to ParquetWriter with set_encoding, set_rows_per_page and set_page_size." << std::endl;
+}
+
+// Decoder width of a decw_<width> target, 0 for anything else
+int target_decoder_width(const std::string& target) {
+    if(target.compare(0, 5, "decw_") != 0 || target.size() == 5 || target.find_first_not_of("0123456789", 5) != std::string::npos) {
+        return 0;
+    }
+    return std::atoi(target.c_str() + 5);
+}
+
+bool parse_options(int argc, char** argv, advise_options* options) {
+    std::vector<std::string> paths;
+
+    for(int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+        if(arg.compare(0, 2, "--") != 0) {
+            paths.push_back(arg);
+            continue;
+        }
+
+        size_t equals = arg.find('=');
+        std::string name = arg.substr(2, equals == std::string::npos ? std::string::npos : equals - 2);
+        std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+        bool valid;
+
+        if(name == "columns") {
+            options->columns = split_list(value);
+            valid = !options->columns.empty();
+        } else if(name == "generate") {
+            column_spec spec;
+            valid = parse_column_spec(value, &spec);
+            options->generated.push_back(spec);
+        } else if(name == "sample_rows") {
+            valid = parse_number(name, value, 1, &options->sample_rows);
+        } else if(name == "encodings") {
+            options->encodings = split_list(value);
+            valid = !options->encodings.empty();
+            for(const std::string& encoding : options->encodings) {
+                if(encoding != "plain" && encoding != "delta") {
+                    std::cerr << "[ERROR] Invalid value \"" << encoding << "\" for option --encodings" << std::endl;
+                    valid = false;
+                }
+            }
+        } else if(name == "rows_per_page") {
+            valid = parse_numbers(name, value, 1, &options->rows_per_page);
+        } else if(name == "hardware") {
+            std::vector<int64_t> widths;
+            options->decoder_widths.clear();
+            valid = value == "none" || parse_numbers(name, value, 64, &widths);
+            options->decoder_widths.assign(widths.begin(), widths.end());
+        } else if(name == "target") {
+            options->target = value;
+            valid = value == "ptoa" || target_decoder_width(value) >= 64;
+            if(!valid) {
+                std::cerr << "[ERROR] Invalid value \"" << value << "\" for option --target, expected ptoa or decw_<width> with a width of at least 64" << std::endl;
+            }
+        } else if(name == "tolerance") {
+            options->tolerance = std::strtod(value.c_str(), nullptr);
+            valid = options->tolerance >= 0;
+        } else if(name == "hw_epc") {
+            valid = parse_number(name, value, 1, &options->hw_epc);
+        } else if(name == "hw_clock_mhz") {
+            valid = parse_number(name, value, 1, &options->hw_clock_mhz);
+        } else if(name == "hw_page_cycles") {
+            valid = parse_number(name, value, 0, &options->hw_page_cycles);
+        } else if(name == "calibration_values") {
+            valid = parse_number(name, value, DELTA_BLOCK_SIZE, &options->calibration_values);
+        } else if(name == "iterations") {
+            valid = parse_number(name, value, 1, &options->iterations);
+        } else if(name == "warmup") {
+            valid = parse_number(name, value, 0, &options->warmup_iterations);
+        } else if(name == "seed") {
+            options->seed = std::strtoull(value.c_str(), nullptr, 10);
+            valid = true;
+        } else if(name == "threads") {
+            valid = parse_number(name, value, 0, &options->threads);
+        } else if(name == "dir") {
+            options->dir = value;
+            valid = !value.empty();
+        } else if(name == "output") {
+            options->output_path = value;
+            valid = !value.empty();
+        } else if(name == "verify") {
+            options->verify = true;
+            valid = true;
+        } else {
+            std::cerr << "[ERROR] Unknown option --" << name << std::endl;
+            valid = false;
+        }
+
+        if(!valid) {
+            return false;
+        }
+    }
+
+    int width = target_decoder_width(options->target);
+    if(width > 0 && std::find(options->decoder_widths.begin(), options->decoder_widths.end(), width) == options->decoder_widths.end()) {
+        options->decoder_widths.push_back(width);
+    }
+
+    if(paths.size() > 1 || (paths.empty() == options->generated.empty())) {
+        std::cerr << "[ERROR] Expected either an input file or --generate" << std::endl;
+        return false;
+    }
+    if(!paths.empty()) {
+        options->input_path = paths[0];
+    }
+    if(options->threads == 0) {
+        options->threads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+
+    return true;
+}
+
+// Median seconds of decoding file with decode, which gets a reader of the file
+template<typename F>
+bool time_decode(const advise_options& options, const std::vector<uint8_t>& file, F decode, double* seconds) {
+    std::string path = options.dir + "/advise_decode.prq";
+    std::ofstream out(path, std::ios::binary);
+    if(!out.write((const char*) file.data(), file.size())) {
+        std::cerr << "[ERROR] Could not write " << path << std::endl;
+        return false;
+    }
+    out.close();
+
+    ptoa::SWParquetReader reader(path);
+    Timer t;
+
+    for(int i=0; i<options.warmup_iterations+options.iterations; i++) {
+        t.start();
+        ptoa::status result = decode(reader);
+        t.stop();
+        if(result != ptoa::status::OK) {
+            std::remove(path.c_str());
+            return false;
+        }
+        if(i >= options.warmup_iterations) {
+            t.record();
+        }
+    }
+    std::remove(path.c_str());
+
+    std::vector<double> history = t.get_history();
+    std::sort(history.begin(), history.end());
+    *seconds = history[history.size()/2];
+
+    return true;
+}
+
+// Magic number followed by num_pages pages of a single value, so decoding is dominated by parsing the page headers
+std::vector<uint8_t> single_value_pages(int32_t encoding, int prim_width, int64_t num_pages) {
+    std::vector<uint8_t> file = {'P', 'A', 'R', '1'};
+    std::vector<uint8_t> page;
+
+    if(encoding == PARQUET_PLAIN) {
+        page.resize(prim_width/8, 0);
+    } else {
+        int64_t value = 0;
+        append_delta(&page, &value, 1);
+    }
+
+    for(int64_t p=0; p<num_pages; p++) {
+        append_page_header(&file, page.size(), 1, encoding);
+        file.insert(file.end(), page.begin(), page.end());
+    }
+
+    return file;
+}
+
+/**
+ * Magic number followed by a single page of 1 + num_blocks*DELTA_BLOCK_SIZE values of which all miniblocks have the
+ * given bit width. All blocks are copies of one random block, the decoder does the same work as for distinct ones.
+ * Delta length encoded pages hold strings of string_length characters and use bit width 0.
+ */
+std::vector<uint8_t> fixed_width_page(int32_t encoding, int bit_width, int64_t num_blocks, int64_t string_length, std::mt19937_64* rng) {
+    int64_t num_values = 1 + num_blocks*DELTA_BLOCK_SIZE;
+    std::vector<uint8_t> page;
+    std::vector<uint8_t> block;
+
+    append_varint(&page, DELTA_BLOCK_SIZE);
+    append_varint(&page, DELTA_MINIBLOCKS);
+    append_varint(&page, num_values);
+    append_zigzag(&page, string_length);
+
+    // min_delta of 0, every miniblock has a delta with the highest bit of its width set
+    append_zigzag(&block, 0);
+    block.insert(block.end(), DELTA_MINIBLOCKS, (uint8_t) bit_width);
+    for(int m=0; m<DELTA_MINIBLOCKS; m++) {
+        uint64_t deltas[DELTA_MINIBLOCK_SIZE];
+        uint64_t mask = bit_width >= 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << bit_width) - 1;
+        for(int i=0; i<DELTA_MINIBLOCK_SIZE; i++) {
+            deltas[i] = (*rng)() & mask;
+        }
+        if(bit_width > 0) {
+            deltas[m] |= (uint64_t) 1 << (bit_width - 1);
+        }
+        append_packed(&block, deltas, bit_width);
+    }
+
+    for(int64_t b=0; b<num_blocks; b++) {
+        page.insert(page.end(), block.begin(), block.end());
+    }
+    page.insert(page.end(), num_values*string_length, 'a');
+
+    std::vector<uint8_t> file = {'P', 'A', 'R', '1'};
+    append_page_header(&file, page.size(), num_values, encoding);
+    file.insert(file.end(), page.begin(), page.end());
+
+    return file;
+}
+
+/**
+ * Measures decode_costs by timing SWParquetReader on generated files: files of single value pages for the page costs,
+ * a large plain page for the copy cost, a delta page per prim width and bit width for the miniblock costs and two
+ * string pages of equal lengths for the string costs. Outputs go to preallocated buffers, allocation is left out.
+ */
+bool calibrate(const advise_options& options, decode_costs* costs) {
+    std::mt19937_64 rng(options.seed);
+    int64_t num_blocks = options.calibration_values/DELTA_BLOCK_SIZE;
+    int64_t num_values = 1 + num_blocks*DELTA_BLOCK_SIZE;
+    int64_t max_values = std::max(num_values, (int64_t) CALIBRATION_PAGES);
+
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+    std::shared_ptr<arrow::Buffer> off_buffer;
+    std::shared_ptr<arrow::Buffer> val_buffer;
+    arrow::AllocateBuffer(max_values*sizeof(int64_t), &arr_buffer);
+    arrow::AllocateBuffer((max_values+1)*sizeof(int32_t), &off_buffer);
+    arrow::AllocateBuffer(num_values*CALIBRATION_STRING_LENGTH, &val_buffer);
+    std::memset(arr_buffer->mutable_data(), 0, arr_buffer->size());
+    std::memset(off_buffer->mutable_data(), 0, off_buffer->size());
+    std::memset(val_buffer->mutable_data(), 0, val_buffer->size());
+
+    std::shared_ptr<arrow::PrimitiveArray> prim_array;
+    std::shared_ptr<arrow::StringArray> string_array;
+    double seconds = 0;
+    double empty = 0;
+
+    std::cout << "Calibrating SWParquetReader with " << num_values << " values per file" << std::endl;
+
+    if(!time_decode(options, single_value_pages(PARQUET_PLAIN, 64, CALIBRATION_PAGES), [&](ptoa::SWParquetReader& reader) {
+        return reader.read_prim(64, CALIBRATION_PAGES, 4, &prim_array, arr_buffer, ptoa::encoding::PLAIN);
+    }, &seconds)) {
+        return false;
+    }
+    costs->plain_page = seconds*1e9/CALIBRATION_PAGES;
+
+    std::vector<uint8_t> plain = {'P', 'A', 'R', '1'};
+    append_page_header(&plain, num_values*sizeof(int64_t), num_values, PARQUET_PLAIN);
+    plain.resize(plain.size() + num_values*sizeof(int64_t), 1);
+    if(!time_decode(options, plain, [&](ptoa::SWParquetReader& reader) {
+        return reader.read_prim(64, num_values, 4, &prim_array, arr_buffer, ptoa::encoding::PLAIN);
+    }, &seconds)) {
+        return false;
+    }
+    costs->plain_byte = seconds*1e9/(num_values*sizeof(int64_t));
+
+    for(int w=0; w<2; w++) {
+        int prim_width = w == 0 ? 32 : 64;
+
+        if(!time_decode(options, single_value_pages(PARQUET_DELTA_BINARY_PACKED, prim_width, CALIBRATION_PAGES), [&](ptoa::SWParquetReader& reader) {
+            return reader.read_prim(prim_width, CALIBRATION_PAGES, 4, &prim_array, arr_buffer, ptoa::encoding::DELTA);
+        }, &seconds)) {
+            return false;
+        }
+        costs->delta_page[w] = seconds*1e9/CALIBRATION_PAGES;
+
+        for(int bit_width=0; bit_width<DELTA_BIT_WIDTHS; bit_width++) {
+            costs->miniblock[w][bit_width] = 0;
+            if(bit_width > prim_width) {
+                continue;
+            }
+            if(!time_decode(options, fixed_width_page(PARQUET_DELTA_BINARY_PACKED, bit_width, num_blocks, 0, &rng), [&](ptoa::SWParquetReader& reader) {
+                return reader.read_prim(prim_width, num_values, 4, &prim_array, arr_buffer, ptoa::encoding::DELTA);
+            }, &seconds)) {
+                return false;
+            }
+            costs->miniblock[w][bit_width] = seconds*1e9/(num_blocks*DELTA_MINIBLOCKS);
+        }
+    }
+
+    if(!time_decode(options, single_value_pages(PARQUET_DELTA_LENGTH_BYTE_ARRAY, 32, CALIBRATION_PAGES), [&](ptoa::SWParquetReader& reader) {
+        return reader.read_string(CALIBRATION_PAGES, 4, &string_array, off_buffer, val_buffer, ptoa::encoding::DELTA_LENGTH);
+    }, &seconds)) {
+        return false;
+    }
+    costs->string_page = seconds*1e9/CALIBRATION_PAGES;
+
+    // Both files have length deltas of bit width 0, the difference between them is the copy of the characters
+    if(!time_decode(options, fixed_width_page(PARQUET_DELTA_LENGTH_BYTE_ARRAY, 0, num_blocks, 0, &rng), [&](ptoa::SWParquetReader& reader) {
+        return reader.read_string(num_values, 4, &string_array, off_buffer, val_buffer, ptoa::encoding::DELTA_LENGTH);
+    }, &empty) || !time_decode(options, fixed_width_page(PARQUET_DELTA_LENGTH_BYTE_ARRAY, 0, num_blocks, CALIBRATION_STRING_LENGTH, &rng), [&](ptoa::SWParquetReader& reader) {
+        return reader.read_string(num_values, 4, &string_array, off_buffer, val_buffer, ptoa::encoding::DELTA_LENGTH);
+    }, &seconds)) {
+        return false;
+    }
+    costs->string_value = empty*1e9/num_values;
+    costs->string_char = std::max(seconds - empty, 0.0)*1e9/(num_values*CALIBRATION_STRING_LENGTH);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "    page: plain " << costs->plain_page << " ns, delta " << costs->delta_page[0] << "/" << costs->delta_page[1] << " ns (int32/int64), strings " << costs->string_page << " ns" << std::endl
+              << "    plain copy: " << costs->plain_byte*1000 << " ns per 1000 bytes" << std::endl
+              << "    strings: " << costs->string_value << " ns per value, " << costs->string_char*1000 << " ns per 1000 characters" << std::endl
+              << "    int32 miniblocks by bit width:";
+    for(int bit_width=0; bit_width<=32; bit_width++) {
+        std::cout << (bit_width % 8 == 0 ? "\n        " : " ") << std::setw(2) << bit_width << ":" << std::setw(6) << costs->miniblock[0][bit_width];
+    }
+    std::cout << std::endl << "    int64 miniblocks by bit width:";
+    for(int bit_width=0; bit_width<=64; bit_width++) {
+        std::cout << (bit_width % 8 == 0 ? "\n        " : " ") << std::setw(2) << bit_width << ":" << std::setw(6) << costs->miniblock[1][bit_width];
+    }
+    std::cout << std::endl << std::defaultfloat;
+
+    return true;
+}
+
+// Adds the values of array to the sample, false if the array has nulls, which the hardware layout cannot hold
+bool append_array(const std::shared_ptr<arrow::Array>& array, column_sample* sample) {
+    if(array->null_count() > 0) {
+        std::cerr << "[WARNING] Column " << sample->name << " has nulls, it is left out" << std::endl;
+        return false;
+    }
+
+    if(sample->is_string()) {
+        auto strings = std::static_pointer_cast<arrow::BinaryArray>(array);
+        const char* chars = (const char*) strings->value_data()->data();
+        for(int64_t i=0; i<strings->length(); i++) {
+            sample->chars.append(chars + strings->value_offset(i), strings->value_offset(i+1) - strings->value_offset(i));
+            sample->offsets.push_back(sample->chars.size());
+        }
+    } else {
+        auto prim = std::static_pointer_cast<arrow::PrimitiveArray>(array);
+        if(sample->type == arrow::Type::INT32) {
+            const int32_t* values = (const int32_t*) prim->values()->data() + prim->offset();
+            sample->int32_values.insert(sample->int32_values.end(), values, values + prim->length());
+        } else {
+            const int64_t* values = (const int64_t*) prim->values()->data() + prim->offset();
+            sample->int64_values.insert(sample->int64_values.end(), values, values + prim->length());
+        }
+    }
+
+    return true;
+}
+
+bool supported_type(arrow::Type::type type) {
+    return type == arrow::Type::INT32 || type == arrow::Type::INT64 || type == arrow::Type::STRING || type == arrow::Type::BINARY;
+}
+
+// Reads up to sample_rows values from the start of every selected column of the input
+bool read_samples(const advise_options& options, std::vector<column_sample>* samples) {
+    std::shared_ptr<arrow::io::ReadableFile> infile;
+    PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(options.input_path, arrow::default_memory_pool(), &infile));
+
+    std::unique_ptr<parquet::arrow::FileReader> reader;
+    PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+
+    std::shared_ptr<arrow::Schema> schema;
+    PARQUET_THROW_NOT_OK(reader->GetSchema(&schema));
+    int64_t total_rows = reader->parquet_reader()->metadata()->num_rows();
+
+    std::vector<int> column_indices;
+    if(options.columns.empty()) {
+        for(int c=0; c<schema->num_fields(); c++) {
+            column_indices.push_back(c);
+        }
+    }
+    for(const std::string& name : options.columns) {
+        int c = schema->GetFieldIndex(name);
+        if(c < 0) {
+            std::cerr << "[ERROR] " << options.input_path << " has no column " << name << std::endl;
+            return false;
+        }
+        column_indices.push_back(c);
+    }
+
+    for(int c : column_indices) {
+        std::shared_ptr<arrow::Field> field = schema->field(c);
+        if(!supported_type(field->type()->id())) {
+            std::cerr << "[WARNING] Column " << field->name() << " has type " << field->type()->ToString() << ", only int32, int64, utf8 and binary columns are sampled" << std::endl;
+            continue;
+        }
+
+        column_sample sample;
+        sample.name = field->name();
+        sample.type = field->type()->id();
+        sample.total_rows = total_rows;
+
+        std::unique_ptr<parquet::arrow::ColumnReader> column_reader;
+        PARQUET_THROW_NOT_OK(reader->GetColumn(c, &column_reader));
+
+        bool valid = true;
+        while(valid && sample.num_values() < options.sample_rows) {
+            std::shared_ptr<arrow::ChunkedArray> batch;
+            PARQUET_THROW_NOT_OK(column_reader->NextBatch(options.sample_rows - sample.num_values(), &batch));
+            if(!batch || batch->length() == 0) {
+                break;
+            }
+            for(int i=0; valid && i<batch->num_chunks(); i++) {
+                valid = append_array(batch->chunk(i), &sample);
+            }
+        }
+
+        if(valid && sample.num_values() > 0) {
+            samples->push_back(sample);
+        }
+    }
+
+    return true;
+}
+
+bool generate_samples(const advise_options& options, std::vector<column_sample>* samples) {
+    std::shared_ptr<arrow::Table> table;
+    if(!generate_table(options.generated, options.sample_rows, options.seed, options.threads, &table)) {
+        return false;
+    }
+
+    for(int c=0; c<table->num_columns(); c++) {
+        column_sample sample;
+        sample.name = options.generated[c].name;
+        sample.type = options.generated[c].type;
+        sample.total_rows = options.sample_rows;
+        append_array(table->column(c)->data()->chunk(0), &sample);
+        samples->push_back(sample);
+    }
+
+    return true;
+}
+
+// Writes the sample in the hardware layout with pages of rows_per_page values and counts what the models need
+candidate encode_sample(const column_sample& sample, const std::string& encoding, int64_t rows_per_page) {
+    candidate c;
+    c.encoding = encoding;
+    c.rows_per_page = rows_per_page;
+    c.pages = 0;
+    c.blocks = 0;
+    std::fill(c.width_counts, c.width_counts + DELTA_BIT_WIDTHS, 0);
+    c.file = {'P', 'A', 'R', '1'};
+
+    int64_t num_values = sample.num_values();
+    std::vector<uint8_t> page;
+    std::vector<int32_t> lengths;
+
+    for(int64_t first=0; first<num_values; first+=rows_per_page) {
+        int64_t count = std::min(rows_per_page, num_values - first);
+        int32_t parquet_encoding;
+        page.clear();
+
+        if(sample.is_string()) {
+            lengths.resize(count);
+            for(int64_t i=0; i<count; i++) {
+                lengths[i] = sample.offsets[first+i+1] - sample.offsets[first+i];
+            }
+            append_delta(&page, lengths.data(), count, c.width_counts);
+            page.insert(page.end(), sample.chars.begin() + sample.offsets[first], sample.chars.begin() + sample.offsets[first+count]);
+            parquet_encoding = PARQUET_DELTA_LENGTH_BYTE_ARRAY;
+        } else if(encoding == "delta") {
+            if(sample.type == arrow::Type::INT32) {
+                append_delta(&page, sample.int32_values.data() + first, count, c.width_counts);
+            } else {
+                append_delta(&page, sample.int64_values.data() + first, count, c.width_counts);
+            }
+            parquet_encoding = PARQUET_DELTA_BINARY_PACKED;
+        } else {
+            const uint8_t* values = sample.type == arrow::Type::INT32 ? (const uint8_t*) (sample.int32_values.data() + first) : (const uint8_t*) (sample.int64_values.data() + first);
+            page.insert(page.end(), values, values + count*(sample.prim_width()/8));
+            parquet_encoding = PARQUET_PLAIN;
+        }
+
+        append_page_header(&c.file, page.size(), count, parquet_encoding);
+        c.file.insert(c.file.end(), page.begin(), page.end());
+        c.pages++;
+        c.blocks += (count - 1 + DELTA_BLOCK_SIZE - 1)/DELTA_BLOCK_SIZE;
+    }
+
+    return c;
+}
+
+// Estimated seconds SWParquetReader takes to decode the candidate
+double estimate_ptoa(const decode_costs& costs, const column_sample& sample, const candidate& c) {
+    int64_t num_values = sample.num_values();
+    double ns;
+
+    if(sample.is_string()) {
+        ns = c.pages*costs.string_page + num_values*costs.string_value + sample.chars.size()*costs.string_char;
+        for(int w=0; w<=32; w++) {
+            ns += c.width_counts[w]*std::max(costs.miniblock[0][w] - costs.miniblock[0][0], 0.0);
+        }
+    } else if(c.encoding == "delta") {
+        int index = sample.prim_width() == 32 ? 0 : 1;
+        ns = c.pages*costs.delta_page[index];
+        for(int w=0; w<=sample.prim_width(); w++) {
+            ns += c.width_counts[w]*costs.miniblock[index][w];
+        }
+    } else {
+        ns = c.pages*costs.plain_page + num_values*(sample.prim_width()/8)*costs.plain_byte;
+    }
+
+    return ns*1e-9;
+}
+
+// Values the BitUnpacker of the hardware unpacks per cycle, unpacking_count of Delta.vhd
+int64_t unpacking_count(int bit_width, int64_t elements_per_cycle, int decoder_width) {
+    if(bit_width == 0) {
+        return elements_per_cycle;
+    }
+    int64_t fit = decoder_width/bit_width;
+    int64_t pow2 = 1;
+    while(pow2*2 <= fit) {
+        pow2 *= 2;
+    }
+    return std::min(elements_per_cycle, std::min(pow2, (int64_t) 32));
+}
+
+/**
+ * Estimated seconds a hardware build with the given decoder width takes to decode the candidate, -1 for anything but
+ * delta encoded integers, the decw builds only hold a DeltaDecoder. Miniblocks take as many cycles as the BitUnpacker
+ * needs for them, every block header a cycle and every page hw_page_cycles. The decoder cannot go faster than the bus
+ * delivers the pages.
+ */
+double estimate_hw(const advise_options& options, int decoder_width, const column_sample& sample, const candidate& c) {
+    if(sample.is_string() || c.encoding != "delta" || decoder_width < sample.prim_width()) {
+        return -1;
+    }
+
+    double cycles = c.pages*options.hw_page_cycles + c.blocks;
+    for(int w=0; w<=sample.prim_width(); w++) {
+        int64_t count = unpacking_count(w, options.hw_epc, decoder_width);
+        cycles += c.width_counts[w]*((DELTA_MINIBLOCK_SIZE + count - 1)/count);
+    }
+
+    double bus_cycles = (double) (c.file.size() - 4)*8/HW_BUS_DATA_WIDTH;
+
+    return std::max(cycles, bus_cycles)/(options.hw_clock_mhz*1e6);
+}
+
+/**
+ * Index of the recommended candidate for the model: the fastest, unless a smaller file is at most tolerance slower.
+ * -1 if the model has no estimate for the sample.
+ */
+int recommend(const std::vector<candidate>& candidates, int model, double tolerance) {
+    int fastest = -1;
+    for(size_t i=0; i<candidates.size(); i++) {
+        double seconds = candidates[i].seconds[model];
+        if(seconds >= 0 && (fastest < 0 || seconds < candidates[fastest].seconds[model])) {
+            fastest = i;
+        }
+    }
+    if(fastest < 0) {
+        return -1;
+    }
+
+    int best = fastest;
+    for(size_t i=0; i<candidates.size(); i++) {
+        double seconds = candidates[i].seconds[model];
+        if(seconds >= 0 && seconds <= candidates[fastest].seconds[model]*(1 + tolerance) && candidates[i].file.size() < candidates[best].file.size()) {
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+// Settings of a recommended candidate in the --column format of transcode. The page size lets rows_per_page end the
+// pages: plain encoded pages of the sample never exceed it.
+std::string column_setting(const column_sample& sample, const candidate& c) {
+    int64_t value_bytes = sample.prim_width()/8;
+    if(sample.is_string()) {
+        int64_t max_length = 0;
+        for(int64_t i=0; i<sample.num_values(); i++) {
+            max_length = std::max(max_length, (int64_t) (sample.offsets[i+1] - sample.offsets[i]));
+        }
+        value_bytes = sizeof(int32_t) + max_length;
+    }
+
+    return sample.name + ":encoding=" + c.encoding + ",rows_per_page=" + std::to_string(c.rows_per_page) + ",page_size=" + std::to_string(c.rows_per_page*value_bytes);
+}
+
+// Median seconds of decoding the candidate with SWParquetReader, into preallocated buffers like the calibration
+bool measure_ptoa(const advise_options& options, const column_sample& sample, const candidate& c, double* seconds) {
+    int64_t num_values = sample.num_values();
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+    std::shared_ptr<arrow::Buffer> off_buffer;
+    std::shared_ptr<arrow::Buffer> val_buffer;
+    std::shared_ptr<arrow::PrimitiveArray> prim_array;
+    std::shared_ptr<arrow::StringArray> string_array;
+
+    if(sample.is_string()) {
+        arrow::AllocateBuffer((num_values+1)*sizeof(int32_t), &off_buffer);
+        arrow::AllocateBuffer(sample.chars.size(), &val_buffer);
+        std::memset(off_buffer->mutable_data(), 0, off_buffer->size());
+        std::memset(val_buffer->mutable_data(), 0, val_buffer->size());
+        return time_decode(options, c.file, [&](ptoa::SWParquetReader& reader) {
+            return reader.read_string(num_values, 4, &string_array, off_buffer, val_buffer, ptoa::encoding::DELTA_LENGTH);
+        }, seconds);
+    }
+
+    int prim_width = sample.prim_width();
+    ptoa::encoding enc = c.encoding == "delta" ? ptoa::encoding::DELTA : ptoa::encoding::PLAIN;
+    arrow::AllocateBuffer(num_values*(prim_width/8), &arr_buffer);
+    std::memset(arr_buffer->mutable_data(), 0, arr_buffer->size());
+    return time_decode(options, c.file, [&](ptoa::SWParquetReader& reader) {
+        return reader.read_prim(prim_width, num_values, 4, &prim_array, arr_buffer, enc);
+    }, seconds);
+}
+
+void print_candidates(const column_sample& sample, const std::vector<candidate>& candidates, const std::vector<std::string>& models, int recommended) {
+    std::cout << std::endl << "Column " << sample.name << " (" << (sample.is_string() ? "string" : sample.type == arrow::Type::INT32 ? "int32" : "int64") << "): "
+              << sample.num_values() << " of " << sample.total_rows << " values sampled" << std::endl;
+
+    std::cout << "  " << std::left << std::setw(14) << "encoding" << std::right << std::setw(10) << "rows/page" << std::setw(8) << "pages" << std::setw(13) << "bytes/value";
+    for(const std::string& model : models) {
+        std::cout << std::setw(18) << (model + " ns/value");
+    }
+    std::cout << std::endl;
+
+    for(size_t i=0; i<candidates.size(); i++) {
+        const candidate& c = candidates[i];
+        std::cout << ((int) i == recommended ? "* " : "  ") << std::left << std::setw(14) << c.encoding << std::right << std::setw(10) << c.rows_per_page << std::setw(8) << c.pages
+                  << std::fixed << std::setprecision(3) << std::setw(13) << (double) (c.file.size() - 4)/sample.num_values();
+        for(size_t m=0; m<models.size(); m++) {
+            if(c.seconds[m] < 0) {
+                std::cout << std::setw(18) << "-";
+            } else {
+                std::cout << std::setw(18) << c.seconds[m]*1e9/sample.num_values();
+            }
+        }
+        std::cout << std::defaultfloat << std::endl;
+    }
+}
+
+/**
+ * Calibrates the decoding costs of SWParquetReader on this machine, samples every column, writes the sample with every
+ * candidate encoding and page size and estimates how long every decoder takes for it. The candidate recommended for the
+ * target decoder is printed as transcode option and optionally written as transcode configuration.
+ */
+int main(int argc, char **argv) {
+    advise_options options;
+
+    if(!parse_options(argc, argv, &options)) {
+        print_usage();
+        return 1;
+    }
+
+    decode_costs costs;
+    if(!calibrate(options, &costs)) {
+        std::cerr << "[ERROR] Calibration failed" << std::endl;
+        return 1;
+    }
+
+    std::vector<column_sample> samples;
+    if(!(options.input_path.empty() ? generate_samples(options, &samples) : read_samples(options, &samples))) {
+        return 1;
+    }
+
+    std::vector<std::string> models = {"ptoa"};
+    for(int width : options.decoder_widths) {
+        models.push_back("decw_" + std::to_string(width));
+    }
+    int target = std::find(models.begin(), models.end(), options.target) - models.begin();
+
+    std::vector<std::string> settings;
+
+    for(const column_sample& sample : samples) {
+        std::vector<std::string> encodings = sample.is_string() ? std::vector<std::string>{"delta_length"} : options.encodings;
+        std::vector<candidate> candidates;
+
+        for(const std::string& encoding : encodings) {
+            bool whole_sample = false;
+            for(int64_t rows_per_page : options.rows_per_page) {
+                // Pages of at least the sample size all hold the whole sample, only the first of them is estimated
+                if(rows_per_page >= sample.num_values()) {
+                    if(whole_sample) {
+                        continue;
+                    }
+                    whole_sample = true;
+                }
+                candidates.push_back(encode_sample(sample, encoding, rows_per_page));
+                candidate& c = candidates.back();
+
+                c.seconds.push_back(estimate_ptoa(costs, sample, c));
+                for(int width : options.decoder_widths) {
+                    c.seconds.push_back(estimate_hw(options, width, sample, c));
+                }
+            }
+        }
+
+        // Columns the hardware builds cannot read are read in software
+        int model = target;
+        int best = recommend(candidates, model, options.tolerance);
+        if(best < 0) {
+            model = 0;
+            best = recommend(candidates, model, options.tolerance);
+        }
+
+        print_candidates(sample, candidates, models, best);
+
+        const candidate& c = candidates[best];
+        double seconds = c.seconds[model]*sample.total_rows/sample.num_values();
+        std::cout << "Recommended for " << models[model] << ": " << c.encoding << " with " << c.rows_per_page << " rows per page, "
+                  << sample.output_bytes()/c.seconds[model]*1e-9 << " GB/s estimated, " << seconds << " s for all " << sample.total_rows << " values" << std::endl;
+
+        if(options.verify) {
+            double measured;
+            if(!measure_ptoa(options, sample, c, &measured)) {
+                return 1;
+            }
+            std::cout << "    SWParquetReader measured " << measured*1e9/sample.num_values() << " ns/value, estimated " << c.seconds[0]*1e9/sample.num_values() << " ns/value" << std::endl;
+        }
+
+        settings.push_back(column_setting(sample, c));
+    }
+
+    std::cout << std::endl << "transcode options:";
+    for(const std::string& setting : settings) {
+        std::cout << " --column=" << setting;
+    }
+    std::cout << std::endl;
+
+    if(!options.output_path.empty()) {
+        std::ofstream out(options.output_path);
+        out << "# Column settings recommended by advise for " << options.target << ", use with transcode --config" << std::endl;
+        for(const std::string& setting : settings) {
+            out << setting << std::endl;
+        }
+        if(!out) {
+            std::cerr << "[ERROR] Could not write " << options.output_path << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote the recommendation to " << options.output_path << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <sys/stat.h>
+
+#include <DatasetScanner.h>
+#include <timer.h>
+
+#define TARGET_TASK_BYTES (8*1024*1024)
+
+int main(int argc, char **argv) {
+    char* dataset_directory;
+    int32_t prim_width;
+    ptoa::encoding enc;
+    int num_threads;
+    bool ordered;
+    int iterations;
+    std::string column;
+    int column_index = 0;
+    int64_t file_offset = -1;
+
+    Timer t;
+
+    if (argc > 6) {
+      dataset_directory = argv[1];
+      prim_width = (int32_t) std::strtoul(argv[2], nullptr, 10);
+      if(argv[3][0] == 'y') {
+        enc = ptoa::encoding::DELTA;
+      } else if (argv[3][0] == 'n') {
+        enc = ptoa::encoding::PLAIN;
+      } else {
+        std::cerr << "Invalid argument. Option \"delta_encoded\" should be \"y\" or \"n\"" << std::endl;
+        return 1;
+      }
+      num_threads = (uint32_t) std::strtoul(argv[4], nullptr, 10);
+      if(num_threads == 0) {
+        num_threads = std::thread::hardware_concurrency();
+      }
+      if(argv[5][0] == 'y') {
+        ordered = true;
+      } else if (argv[5][0] == 'n') {
+        ordered = false;
+      } else {
+        std::cerr << "Invalid argument. Option \"ordered\" should be \"y\" or \"n\"" << std::endl;
+        return 1;
+      }
+      iterations = (uint32_t) std::strtoul(argv[6], nullptr, 10);
+      if(argc > 7) {
+        // A column name, or the index of the column if it is a number
+        char* end;
+        column_index = (int) std::strtol(argv[7], &end, 10);
+        if(argv[7][0] == '\0' || *end != '\0') {
+          column = argv[7];
+          column_index = 0;
+        }
+      }
+      if(argc > 8) {
+        file_offset = std::strtoll(argv[8], nullptr, 10);
+      }
+    } else {
+      std::cerr << "Usage: dataset dataset_directory prim_width(32 or 64) delta_encoded(y or n) num_threads(0 for all cores) ordered(y or n) iterations [column(name or index, default 0)] [file_offset(of the pages of files without footer, e.g. 4 for hardware style files)]" << std::endl;
+      return 1;
+    }
+
+    std::vector<std::string> file_paths;
+    if(ptoa::DatasetScanner::list_directory(dataset_directory, &file_paths) != ptoa::status::OK){
+      return 1;
+    }
+
+    int64_t dataset_bytes = 0;
+    for(const std::string& path : file_paths) {
+      struct stat file_stat;
+      if(stat(path.c_str(), &file_stat) == 0) {
+        dataset_bytes += file_stat.st_size;
+      }
+    }
+
+    // The column chunks are found through the footer of every file, unless file_offset is given
+    ptoa::scan_options options = {prim_width, enc, column, column_index, file_offset, num_threads, ordered, TARGET_TASK_BYTES, ptoa::ingestion::BUFFERED};
+
+    int64_t num_batches = 0;
+    int64_t num_values = 0;
+
+    for(int i=0; i<iterations; i++){
+        num_batches = 0;
+        num_values = 0;
+
+        t.start();
+        ptoa::DatasetScanner scanner(file_paths, options);
+        if(scanner.start() != ptoa::status::OK){
+            return 1;
+        }
+
+        ptoa::scan_batch batch;
+        while(true){
+            if(scanner.next(&batch) != ptoa::status::OK){
+                return 1;
+            }
+            if(batch.batch == nullptr){
+                break;
+            }
+            num_batches++;
+            num_values += batch.batch->num_rows();
+        }
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Scanned " << file_paths.size() << " files, " << num_batches << " batches, " << num_values << " values" << std::endl;
+    std::cout << "Average time in seconds (" << num_threads << " threads, " << (ordered ? "ordered" : "unordered") << "): " << t.average() << std::endl;
+    std::cout << "Throughput: " << dataset_bytes/t.average()/1e9 << " GB/s" << std::endl;
+}
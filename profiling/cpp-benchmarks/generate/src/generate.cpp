@@ -0,0 +1,183 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/properties.h>
+
+#include <datagen.h>
+#include <timer.h>
+#include <report.h>
+#include <options.h>
+
+struct generate_options {
+    int64_t num_rows = 1000000;
+    std::vector<column_spec> columns;
+    uint64_t seed = 42;
+    int threads = 0;
+    int64_t iterations = 1;
+    int64_t warmup_iterations = 0;
+    std::string output_path;
+    std::string report_path = "generate";
+};
+
+void print_usage() {
+    std::cerr << "Usage: generate [--option=value]..." << std::endl
+              << "  --rows        rows of the generated table (default 1000000)" << std::endl
+              << "  --column      column as name:type:distribution[:key=value,...], repeat for more columns" << std::endl
+              << "                types: int32, int64, string" << std::endl
+              << "                distributions: uniform, zipf, sorted, timestamp, runs, bit_widths" << std::endl
+              << "                keys: min, max, exponent, step, interval, jitter, gap, gap_probability, run_length," << std::endl
+              << "                page_values, bit_widths (slash separated), see datagen.h, e.g. --column=ts:int64:timestamp:jitter=10" << std::endl
+              << "                string columns draw their lengths from the distribution (default --column=values:int64:uniform)" << std::endl
+              << "  --seed        seed of the generator, the data does not depend on the thread count (default 42)" << std::endl
+              << "  --threads     generating threads, 0 for all cores (default 0)" << std::endl
+              << "  --iterations  timed generations of the table (default 1)" << std::endl
+              << "  --warmup      untimed generations before the timed ones (default 0)" << std::endl
+              << "  --output      write the table to this Parquet file, plain encoded and uncompressed" << std::endl
+              << "  --report      path of the report, written to <report>.csv and <report>.json (default generate)" << std::endl;
+}
+
+bool parse_options(int argc, char** argv, generate_options* options) {
+    for(int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+        if(arg.compare(0, 2, "--") != 0) {
+            std::cerr << "[ERROR] Unexpected argument " << arg << std::endl;
+            return false;
+        }
+
+        size_t equals = arg.find('=');
+        std::string name = arg.substr(2, equals == std::string::npos ? std::string::npos : equals - 2);
+        std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+        int64_t number;
+        bool valid;
+
+        if(name == "rows") {
+            valid = parse_number(name, value, 1, &options->num_rows);
+        } else if(name == "column") {
+            options->columns.emplace_back();
+            valid = parse_column_spec(value, &options->columns.back());
+        } else if(name == "seed") {
+            options->seed = std::strtoull(value.c_str(), nullptr, 10);
+            valid = true;
+        } else if(name == "threads") {
+            valid = parse_number(name, value, 0, &number);
+            options->threads = (int) number;
+        } else if(name == "iterations") {
+            valid = parse_number(name, value, 1, &options->iterations);
+        } else if(name == "warmup") {
+            valid = parse_number(name, value, 0, &options->warmup_iterations);
+        } else if(name == "output") {
+            options->output_path = value;
+            valid = !value.empty();
+        } else if(name == "report") {
+            options->report_path = value;
+            valid = !value.empty();
+        } else {
+            std::cerr << "[ERROR] Unknown option --" << name << std::endl;
+            valid = false;
+        }
+
+        if(!valid) {
+            return false;
+        }
+    }
+
+    if(options->columns.empty()) {
+        options->columns.emplace_back();
+        parse_column_spec("values:int64:uniform", &options->columns.back());
+    }
+    if(options->threads == 0) {
+        options->threads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+
+    return true;
+}
+
+int64_t table_bytes(const std::shared_ptr<arrow::Table>& table) {
+    int64_t bytes = 0;
+
+    for(int c=0; c<table->num_columns(); c++) {
+        std::shared_ptr<arrow::Field> field = table->schema()->field(c);
+        if(field->type()->id() == arrow::Type::STRING) {
+            bytes += (table->num_rows() + 1)*sizeof(int32_t);
+            bytes += std::static_pointer_cast<arrow::StringArray>(table->column(c)->data()->chunk(0))->value_offset(table->num_rows());
+        } else {
+            bytes += table->num_rows()*(field->type()->id() == arrow::Type::INT32 ? sizeof(int32_t) : sizeof(int64_t));
+        }
+    }
+
+    return bytes;
+}
+
+int main(int argc, char **argv) {
+    generate_options options;
+
+    if(!parse_options(argc, argv, &options)) {
+        print_usage();
+        return 1;
+    }
+
+    Timer t;
+    BenchmarkReport report("generate", options.warmup_iterations);
+    report.set_parameter("rows", std::to_string(options.num_rows));
+    report.set_parameter("seed", std::to_string(options.seed));
+    report.set_parameter("threads", std::to_string(options.threads));
+
+    std::shared_ptr<arrow::Table> table;
+    for(int64_t i=0; i<options.warmup_iterations + options.iterations; i++) {
+        table.reset();
+
+        t.start();
+        bool generated = generate_table(options.columns, options.num_rows, options.seed, options.threads, &table);
+        t.stop();
+
+        if(!generated) {
+            return 1;
+        }
+        if(i >= options.warmup_iterations) {
+            t.record();
+        }
+    }
+
+    int64_t output_bytes = table_bytes(table);
+    const run_summary& run = report.add_run("generate", t.get_history(), options.num_rows*options.columns.size(), 0, output_bytes);
+    BenchmarkReport::print(std::cout, run);
+
+    if(!options.output_path.empty()) {
+        parquet::WriterProperties::Builder properties;
+        properties.disable_dictionary();
+        properties.compression(parquet::Compression::UNCOMPRESSED);
+
+        t.start();
+        std::shared_ptr<arrow::io::FileOutputStream> outfile;
+        PARQUET_THROW_NOT_OK(arrow::io::FileOutputStream::Open(options.output_path, &outfile));
+        PARQUET_THROW_NOT_OK(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), outfile, options.num_rows, properties.build()));
+        PARQUET_THROW_NOT_OK(outfile->Close());
+        t.stop();
+
+        std::cout << "Wrote " << options.output_path << " in " << t.seconds() << " s" << std::endl;
+    }
+
+    if(!report.write_csv(options.report_path + ".csv") || !report.write_json(options.report_path + ".json")) {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,626 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <parquet/api/reader.h>
+
+#include <SWParquetReader.h>
+#include <options.h>
+
+struct inspector_options {
+    std::string input_path;
+    std::vector<std::string> columns;
+    int64_t offset = -1;
+    bool strings = false;
+    bool pages = false;
+    std::string format = "table";
+    int64_t threads = 0;
+    ptoa::ingestion mode = ptoa::ingestion::MMAP;
+};
+
+/**
+ * Column chunk to inspect. Chunks found through the footer span size bytes from offset and hold num_values values, chunks
+ * given by --offset run to the end of the file and have both set to -1.
+ */
+struct column_chunk {
+    std::string name;
+    std::string type;
+    int row_group;
+    int64_t offset;
+    int64_t size;
+    int64_t num_values;
+    std::string compression;
+    ptoa::inspect_options options;
+    std::vector<ptoa::page_stats> pages;
+};
+
+/**
+ * Statistics of all pages of a column chunk. The value statistics of the inspected pages are added up in values.
+ */
+struct chunk_totals {
+    int64_t data_pages = 0;
+    int64_t dictionary_pages = 0;
+    int64_t other_pages = 0;
+    int64_t inspected_pages = 0;
+    std::vector<int32_t> encodings;
+    std::vector<std::pair<int32_t, int32_t>> block_layouts;
+    int64_t header_bytes = 0;
+    int64_t page_bytes = 0;
+    int64_t data_page_bytes = 0;
+    int64_t num_values = 0;
+    int64_t num_nulls = 0;
+    int32_t min_page_values = 0;
+    int32_t max_page_values = 0;
+    int32_t min_page_size = 0;
+    int32_t max_page_size = 0;
+    ptoa::page_stats values;
+};
+
+void print_usage() {
+    std::cerr << "Usage: inspect [--option=value]... <input.parquet>" << std::endl
+              << "Reports the pages of every column chunk of a Parquet file: header sizes, value counts, bit widths of the" << std::endl
+              << "miniblocks, the distributions of min_delta and of string lengths, and bytes per value." << std::endl
+              << "  --columns    comma separated columns to inspect (default all)" << std::endl
+              << "  --offset     walk the pages from this file offset to the end of the pages instead of reading the" << std::endl
+              << "               footer, e.g. 4 for the files the hardware reads" << std::endl
+              << "  --strings    with --offset, plain pages hold byte arrays" << std::endl
+              << "  --pages      report every page as well" << std::endl
+              << "  --format     table or json (default table)" << std::endl
+              << "  --threads    threads inspecting the pages of a column chunk, 0 for all cores (default 0)" << std::endl
+              << "  --ingestion  buffered or mmap (default mmap)" << std::endl
+              << "Value statistics are collected for uncompressed DELTA_BINARY_PACKED and DELTA_LENGTH_BYTE_ARRAY pages and" << std::endl
+              << "plain pages of byte arrays." << std::endl;
+}
+
+bool parse_options(int argc, char** argv, inspector_options* options) {
+    std::vector<std::string> paths;
+
+    for(int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+        if(arg.compare(0, 2, "--") != 0) {
+            paths.push_back(arg);
+            continue;
+        }
+
+        size_t equals = arg.find('=');
+        std::string name = arg.substr(2, equals == std::string::npos ? std::string::npos : equals - 2);
+        std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+        bool valid;
+
+        if(name == "columns") {
+            options->columns = split_list(value);
+            valid = !options->columns.empty();
+        } else if(name == "offset") {
+            valid = parse_number(name, value, 0, &options->offset);
+        } else if(name == "strings") {
+            options->strings = true;
+            valid = value.empty();
+        } else if(name == "pages") {
+            options->pages = true;
+            valid = value.empty();
+        } else if(name == "format") {
+            options->format = value;
+            valid = value == "table" || value == "json";
+        } else if(name == "threads") {
+            valid = parse_number(name, value, 0, &options->threads);
+        } else if(name == "ingestion") {
+            valid = value == "buffered" || value == "mmap";
+            options->mode = value == "buffered" ? ptoa::ingestion::BUFFERED : ptoa::ingestion::MMAP;
+        } else {
+            std::cerr << "[ERROR] Unknown option --" << name << std::endl;
+            return false;
+        }
+
+        if(!valid) {
+            std::cerr << "[ERROR] Invalid value \"" << value << "\" for option --" << name << std::endl;
+            return false;
+        }
+    }
+
+    if(paths.size() != 1) {
+        std::cerr << "[ERROR] Expected a single input file" << std::endl;
+        return false;
+    }
+    options->input_path = paths[0];
+
+    if(options->offset >= 0 && !options->columns.empty()) {
+        std::cerr << "[ERROR] Options --offset and --columns exclude each other" << std::endl;
+        return false;
+    }
+
+    if(options->threads == 0) {
+        options->threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    return true;
+}
+
+const char* page_type_name(ptoa::page_type type) {
+    const char* names[] = {"DATA_PAGE", "INDEX_PAGE", "DICTIONARY_PAGE", "DATA_PAGE_V2"};
+    return names[type];
+}
+
+std::string encoding_name(int32_t encoding) {
+    const char* names[] = {"PLAIN", "GROUP_VAR_INT", "PLAIN_DICTIONARY", "RLE", "BIT_PACKED", "DELTA_BINARY_PACKED",
+                           "DELTA_LENGTH_BYTE_ARRAY", "DELTA_BYTE_ARRAY", "RLE_DICTIONARY", "BYTE_STREAM_SPLIT"};
+    if(encoding < 0 || encoding >= (int32_t) (sizeof(names)/sizeof(names[0]))) {
+        return "ENCODING_" + std::to_string(encoding);
+    }
+    return names[encoding];
+}
+
+std::string compression_name(parquet::Compression::type compression) {
+    switch(compression) {
+        case parquet::Compression::UNCOMPRESSED:
+            return "UNCOMPRESSED";
+        case parquet::Compression::SNAPPY:
+            return "SNAPPY";
+        case parquet::Compression::GZIP:
+            return "GZIP";
+        case parquet::Compression::LZO:
+            return "LZO";
+        case parquet::Compression::BROTLI:
+            return "BROTLI";
+        case parquet::Compression::LZ4:
+            return "LZ4";
+        case parquet::Compression::ZSTD:
+            return "ZSTD";
+        default:
+            return "COMPRESSED";
+    }
+}
+
+std::string json_string(const std::string& value) {
+    std::string escaped = "\"";
+
+    for(char c : value) {
+        if(c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if((unsigned char) c < 0x20) {
+            escaped += ' ';
+        } else {
+            escaped += c;
+        }
+    }
+
+    return escaped + "\"";
+}
+
+bool is_data_page(const ptoa::page_stats& page) {
+    return page.type == ptoa::page_type::DATA_PAGE || page.type == ptoa::page_type::DATA_PAGE_V2;
+}
+
+// Find the column chunks of the selected columns in the footer, in the order of the row groups
+bool read_footer(const inspector_options& options, std::vector<column_chunk>* chunks) {
+    std::unique_ptr<parquet::ParquetFileReader> file_reader;
+    try {
+        file_reader = parquet::ParquetFileReader::OpenFile(options.input_path);
+    } catch(const parquet::ParquetException& e) {
+        std::cerr << "[ERROR] Could not read the footer of " << options.input_path << ": " << e.what() << std::endl;
+        std::cerr << "[ERROR] Use --offset to walk the pages of a file without footer" << std::endl;
+        return false;
+    }
+
+    std::shared_ptr<parquet::FileMetaData> metadata = file_reader->metadata();
+    const parquet::SchemaDescriptor* schema = metadata->schema();
+
+    std::vector<int> column_indices;
+    if(options.columns.empty()) {
+        for(int c=0; c<schema->num_columns(); c++) {
+            column_indices.push_back(c);
+        }
+    }
+    for(const std::string& name : options.columns) {
+        int index = -1;
+        for(int c=0; c<schema->num_columns(); c++) {
+            if(schema->Column(c)->path()->ToDotString() == name) {
+                index = c;
+            }
+        }
+        if(index < 0) {
+            std::cerr << "[ERROR] " << options.input_path << " has no column " << name << std::endl;
+            return false;
+        }
+        column_indices.push_back(index);
+    }
+
+    for(int r=0; r<metadata->num_row_groups(); r++) {
+        std::unique_ptr<parquet::RowGroupMetaData> row_group = metadata->RowGroup(r);
+
+        for(int c : column_indices) {
+            std::unique_ptr<parquet::ColumnChunkMetaData> column_chunk_metadata = row_group->ColumnChunk(c);
+            const parquet::ColumnDescriptor* descriptor = schema->Column(c);
+
+            column_chunk chunk;
+            chunk.name = descriptor->path()->ToDotString();
+            chunk.type = parquet::TypeToString(descriptor->physical_type());
+            chunk.row_group = r;
+            chunk.offset = column_chunk_metadata->data_page_offset();
+            // Some writers set the dictionary page offset to 0 when there is no dictionary page
+            if(column_chunk_metadata->has_dictionary_page() && column_chunk_metadata->dictionary_page_offset() > 0) {
+                chunk.offset = std::min(chunk.offset, column_chunk_metadata->dictionary_page_offset());
+            }
+            chunk.size = column_chunk_metadata->total_compressed_size();
+            chunk.num_values = column_chunk_metadata->num_values();
+            chunk.compression = compression_name(column_chunk_metadata->compression());
+
+            chunk.options.end_offset = chunk.offset + chunk.size;
+            chunk.options.byte_array = descriptor->physical_type() == parquet::Type::BYTE_ARRAY;
+            chunk.options.compressed = column_chunk_metadata->compression() != parquet::Compression::UNCOMPRESSED;
+            chunk.options.max_definition_level = descriptor->max_definition_level();
+            chunk.options.max_repetition_level = descriptor->max_repetition_level();
+            chunk.options.headers_only = false;
+            chunk.options.num_threads = options.threads;
+
+            chunks->push_back(chunk);
+        }
+    }
+
+    return true;
+}
+
+// A single chunk with the pages from --offset on, laid out like the hardware reads them: non-nullable and uncompressed
+void raw_chunk(const inspector_options& options, std::vector<column_chunk>* chunks) {
+    column_chunk chunk;
+    chunk.name = "pages";
+    chunk.type = options.strings ? "BYTE_ARRAY" : "UNKNOWN";
+    chunk.row_group = 0;
+    chunk.offset = options.offset;
+    chunk.size = -1;
+    chunk.num_values = -1;
+    chunk.compression = "UNCOMPRESSED";
+
+    chunk.options.end_offset = -1;
+    chunk.options.byte_array = options.strings;
+    chunk.options.compressed = false;
+    chunk.options.max_definition_level = 0;
+    chunk.options.max_repetition_level = 0;
+    chunk.options.headers_only = false;
+    chunk.options.num_threads = options.threads;
+
+    chunks->push_back(chunk);
+}
+
+void add_histogram(int64_t* total, const int64_t* counts) {
+    for(int i=0; i<INSPECT_BIT_LENGTHS; i++) {
+        total[i] += counts[i];
+    }
+}
+
+void add_values(ptoa::page_stats* total, const ptoa::page_stats& page) {
+    if(page.blocks > 0) {
+        total->min_delta_min = total->blocks == 0 ? page.min_delta_min : std::min(total->min_delta_min, page.min_delta_min);
+        total->min_delta_max = total->blocks == 0 ? page.min_delta_max : std::max(total->min_delta_max, page.min_delta_max);
+        total->blocks += page.blocks;
+        add_histogram(total->miniblock_widths, page.miniblock_widths);
+        add_histogram(total->min_delta_lengths, page.min_delta_lengths);
+    }
+    if(page.num_strings > 0) {
+        total->string_length_min = total->num_strings == 0 ? page.string_length_min : std::min(total->string_length_min, page.string_length_min);
+        total->string_length_max = total->num_strings == 0 ? page.string_length_max : std::max(total->string_length_max, page.string_length_max);
+        total->num_strings += page.num_strings;
+        total->num_chars += page.num_chars;
+        add_histogram(total->string_lengths, page.string_lengths);
+    }
+}
+
+chunk_totals sum_pages(const column_chunk& chunk) {
+    chunk_totals totals;
+    std::memset(&totals.values, 0, sizeof(ptoa::page_stats));
+
+    for(const ptoa::page_stats& page : chunk.pages) {
+        totals.header_bytes += page.header_size;
+        totals.page_bytes += page.compressed_size;
+
+        if(page.type == ptoa::page_type::DICTIONARY_PAGE) {
+            totals.dictionary_pages++;
+            continue;
+        }
+        if(!is_data_page(page)) {
+            totals.other_pages++;
+            continue;
+        }
+
+        if(totals.data_pages == 0) {
+            totals.min_page_values = page.num_values;
+            totals.max_page_values = page.num_values;
+            totals.min_page_size = page.compressed_size;
+            totals.max_page_size = page.compressed_size;
+        }
+        totals.data_pages++;
+        totals.data_page_bytes += page.compressed_size;
+        totals.num_values += page.num_values;
+        totals.num_nulls += page.num_nulls;
+        totals.min_page_values = std::min(totals.min_page_values, page.num_values);
+        totals.max_page_values = std::max(totals.max_page_values, page.num_values);
+        totals.min_page_size = std::min(totals.min_page_size, page.compressed_size);
+        totals.max_page_size = std::max(totals.max_page_size, page.compressed_size);
+
+        if(std::find(totals.encodings.begin(), totals.encodings.end(), page.parquet_encoding) == totals.encodings.end()) {
+            totals.encodings.push_back(page.parquet_encoding);
+        }
+
+        std::pair<int32_t, int32_t> layout(page.delta_block_size, page.delta_miniblocks);
+        if(page.delta_block_size > 0 && std::find(totals.block_layouts.begin(), totals.block_layouts.end(), layout) == totals.block_layouts.end()) {
+            totals.block_layouts.push_back(layout);
+        }
+
+        if(page.inspected) {
+            totals.inspected_pages++;
+            add_values(&totals.values, page);
+        }
+    }
+
+    return totals;
+}
+
+// Bytes of a page or column chunk per value that is not null. Nulls are only known for V2 pages, for V1 pages they count
+// as values.
+double bytes_per_value(int64_t bytes, int64_t num_values, int64_t num_nulls) {
+    return num_values > num_nulls ? (double) bytes/(num_values - num_nulls) : 0;
+}
+
+double mean_bit_length(const int64_t* counts) {
+    int64_t total = 0;
+    int64_t weighted = 0;
+    for(int i=0; i<INSPECT_BIT_LENGTHS; i++) {
+        total += counts[i];
+        weighted += i*counts[i];
+    }
+    return total > 0 ? (double) weighted/total : 0;
+}
+
+int max_bit_length(const int64_t* counts) {
+    for(int i=INSPECT_BIT_LENGTHS-1; i>0; i--) {
+        if(counts[i] > 0) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void print_histogram(const int64_t* counts) {
+    int64_t total = 0;
+    for(int i=0; i<INSPECT_BIT_LENGTHS; i++) {
+        total += counts[i];
+    }
+    for(int i=0; i<INSPECT_BIT_LENGTHS; i++) {
+        if(counts[i] > 0) {
+            std::cout << " " << i << ":" << counts[i] << " (" << std::setprecision(3) << 100.0*counts[i]/total << "%)";
+        }
+    }
+    std::cout << std::endl;
+}
+
+void print_table(const column_chunk& chunk, const chunk_totals& totals, bool pages) {
+    std::cout << "Column " << chunk.name << " (" << chunk.type << ") of row group " << chunk.row_group << " at file offset " << chunk.offset
+              << ", " << totals.header_bytes + totals.page_bytes << " bytes, " << chunk.compression << std::endl;
+
+    std::cout << "    Pages           : " << totals.data_pages << " data (" << totals.inspected_pages << " inspected), "
+              << totals.dictionary_pages << " dictionary, " << totals.other_pages << " other" << std::endl;
+
+    std::cout << "    Encodings       :";
+    for(int32_t encoding : totals.encodings) {
+        std::cout << " " << encoding_name(encoding);
+    }
+    std::cout << std::endl;
+
+    std::cout << "    Values          : " << totals.num_values << " (" << totals.num_nulls << " nulls)";
+    if(chunk.num_values >= 0 && chunk.num_values != totals.num_values) {
+        std::cout << ", footer has " << chunk.num_values;
+    }
+    std::cout << std::endl;
+
+    if(totals.data_pages > 0) {
+        std::cout << "    Values per page : " << totals.min_page_values << " to " << totals.max_page_values << ", "
+                  << totals.num_values/totals.data_pages << " average" << std::endl;
+        std::cout << "    Page sizes      : " << totals.min_page_size << " to " << totals.max_page_size << " bytes, "
+                  << totals.data_page_bytes/totals.data_pages << " average" << std::endl;
+        std::cout << "    Header bytes    : " << totals.header_bytes << ", "
+                  << std::setprecision(4) << (double) totals.header_bytes/chunk.pages.size() << " per page" << std::endl;
+        std::cout << "    Bytes per value : " << std::setprecision(4) << bytes_per_value(totals.header_bytes + totals.page_bytes, totals.num_values, totals.num_nulls)
+                  << ", of which headers " << bytes_per_value(totals.header_bytes, totals.num_values, totals.num_nulls) << std::endl;
+    }
+
+    const ptoa::page_stats& values = totals.values;
+    if(values.blocks > 0) {
+        std::cout << "    Blocks          : " << values.blocks << ", miniblock bit widths " << std::setprecision(3)
+                  << mean_bit_length(values.miniblock_widths) << " average, " << max_bit_length(values.miniblock_widths) << " maximum" << std::endl;
+        std::cout << "    Block layout    :";
+        for(const std::pair<int32_t, int32_t>& layout : totals.block_layouts) {
+            std::cout << " " << layout.first << " values in " << layout.second << " miniblocks";
+            if(layout.first != BLOCK_SIZE || layout.second != MINIBLOCKS_IN_BLOCK) {
+                std::cout << " (not supported by the decoders)";
+            }
+        }
+        std::cout << std::endl;
+        std::cout << "    Bit widths      :";
+        print_histogram(values.miniblock_widths);
+        std::cout << "    min_delta       : " << values.min_delta_min << " to " << values.min_delta_max << ", zigzag bit lengths";
+        print_histogram(values.min_delta_lengths);
+    }
+    if(values.num_strings > 0) {
+        std::cout << "    String lengths  : " << values.string_length_min << " to " << values.string_length_max << ", "
+                  << std::setprecision(4) << (double) values.num_chars/values.num_strings << " average, bit lengths";
+        print_histogram(values.string_lengths);
+    }
+
+    if(pages) {
+        std::cout << std::endl;
+        std::cout << "    " << std::setw(12) << "offset" << std::setw(16) << "type" << std::setw(24) << "encoding" << std::setw(8) << "header"
+                  << std::setw(10) << "size" << std::setw(9) << "values" << std::setw(7) << "nulls" << std::setw(9) << "B/value"
+                  << std::setw(7) << "blocks" << std::setw(8) << "width" << std::setw(10) << "max width"
+                  << std::setw(24) << "min_delta" << std::setw(16) << "string lengths" << std::endl;
+
+        for(const ptoa::page_stats& page : chunk.pages) {
+            std::cout << "    " << std::setw(12) << page.offset << std::setw(16) << page_type_name(page.type)
+                      << std::setw(24) << encoding_name(page.parquet_encoding) << std::setw(8) << page.header_size
+                      << std::setw(10) << page.compressed_size << std::setw(9) << page.num_values << std::setw(7) << page.num_nulls
+                      << std::setw(9) << std::setprecision(4) << bytes_per_value(page.header_size + page.compressed_size, page.num_values, page.num_nulls);
+
+            if(page.blocks > 0) {
+                std::cout << std::setw(7) << page.blocks << std::setw(8) << std::setprecision(3) << mean_bit_length(page.miniblock_widths)
+                          << std::setw(10) << max_bit_length(page.miniblock_widths)
+                          << std::setw(24) << std::to_string(page.min_delta_min) + ".." + std::to_string(page.min_delta_max);
+            } else {
+                std::cout << std::setw(7) << "-" << std::setw(8) << "-" << std::setw(10) << "-" << std::setw(24) << "-";
+            }
+
+            if(page.num_strings > 0) {
+                std::cout << std::setw(16) << std::to_string(page.string_length_min) + ".." + std::to_string(page.string_length_max);
+            } else {
+                std::cout << std::setw(16) << "-";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    std::cout << std::endl;
+}
+
+void print_json_histogram(const int64_t* counts) {
+    bool first = true;
+    std::cout << "{";
+    for(int i=0; i<INSPECT_BIT_LENGTHS; i++) {
+        if(counts[i] > 0) {
+            std::cout << (first ? "" : ", ") << "\"" << i << "\": " << counts[i];
+            first = false;
+        }
+    }
+    std::cout << "}";
+}
+
+// Value statistics of a page or column chunk as the members of a JSON object, each preceded by a comma
+void print_json_values(const ptoa::page_stats& values) {
+    if(values.blocks > 0) {
+        std::cout << ", \"blocks\": " << values.blocks << ", \"miniblock_widths\": ";
+        print_json_histogram(values.miniblock_widths);
+        std::cout << ", \"min_delta\": {\"min\": " << values.min_delta_min << ", \"max\": " << values.min_delta_max << ", \"zigzag_bit_lengths\": ";
+        print_json_histogram(values.min_delta_lengths);
+        std::cout << "}";
+    }
+    if(values.num_strings > 0) {
+        std::cout << ", \"strings\": {\"count\": " << values.num_strings << ", \"chars\": " << values.num_chars
+                  << ", \"min\": " << values.string_length_min << ", \"max\": " << values.string_length_max << ", \"bit_lengths\": ";
+        print_json_histogram(values.string_lengths);
+        std::cout << "}";
+    }
+}
+
+void print_json(const column_chunk& chunk, const chunk_totals& totals, bool pages, bool last) {
+    std::cout << "    {\"name\": " << json_string(chunk.name) << ", \"type\": " << json_string(chunk.type) << ", \"row_group\": " << chunk.row_group
+              << ", \"offset\": " << chunk.offset << ", \"bytes\": " << totals.header_bytes + totals.page_bytes
+              << ", \"compression\": " << json_string(chunk.compression) << "," << std::endl;
+
+    std::cout << "     \"pages\": {\"data\": " << totals.data_pages << ", \"dictionary\": " << totals.dictionary_pages
+              << ", \"other\": " << totals.other_pages << ", \"inspected\": " << totals.inspected_pages << "}, \"encodings\": [";
+    for(size_t i=0; i<totals.encodings.size(); i++) {
+        std::cout << (i > 0 ? ", " : "") << json_string(encoding_name(totals.encodings[i]));
+    }
+    std::cout << "]," << std::endl;
+
+    std::cout << "     \"values\": " << totals.num_values << ", \"nulls\": " << totals.num_nulls;
+    if(chunk.num_values >= 0) {
+        std::cout << ", \"footer_values\": " << chunk.num_values;
+    }
+    std::cout << ", \"header_bytes\": " << totals.header_bytes << ", \"page_bytes\": " << totals.page_bytes
+              << ", \"bytes_per_value\": " << bytes_per_value(totals.header_bytes + totals.page_bytes, totals.num_values, totals.num_nulls)
+              << ", \"values_per_page\": {\"min\": " << totals.min_page_values << ", \"max\": " << totals.max_page_values << "}"
+              << ", \"page_size\": {\"min\": " << totals.min_page_size << ", \"max\": " << totals.max_page_size << "}";
+    if(!totals.block_layouts.empty()) {
+        std::cout << ", \"block_layouts\": [";
+        for(size_t i=0; i<totals.block_layouts.size(); i++) {
+            std::cout << (i > 0 ? ", " : "") << "{\"block_size\": " << totals.block_layouts[i].first << ", \"miniblocks\": " << totals.block_layouts[i].second << "}";
+        }
+        std::cout << "]";
+    }
+    print_json_values(totals.values);
+
+    if(pages) {
+        std::cout << "," << std::endl << "     \"page_list\": [";
+        for(size_t p=0; p<chunk.pages.size(); p++) {
+            const ptoa::page_stats& page = chunk.pages[p];
+            std::cout << (p > 0 ? "," : "") << std::endl;
+            std::cout << "       {\"offset\": " << page.offset << ", \"type\": " << json_string(page_type_name(page.type))
+                      << ", \"encoding\": " << json_string(encoding_name(page.parquet_encoding)) << ", \"header_size\": " << page.header_size
+                      << ", \"compressed_size\": " << page.compressed_size << ", \"uncompressed_size\": " << page.uncompressed_size
+                      << ", \"values\": " << page.num_values << ", \"nulls\": " << page.num_nulls
+                      << ", \"bytes_per_value\": " << bytes_per_value(page.header_size + page.compressed_size, page.num_values, page.num_nulls)
+                      << ", \"inspected\": " << (page.inspected ? "true" : "false");
+            if(page.delta_block_size > 0) {
+                std::cout << ", \"block_size\": " << page.delta_block_size << ", \"miniblocks\": " << page.delta_miniblocks;
+            }
+            print_json_values(page);
+            std::cout << "}";
+        }
+        std::cout << std::endl << "     ]";
+    }
+
+    std::cout << "}" << (last ? "" : ",") << std::endl;
+}
+
+int main(int argc, char **argv) {
+    inspector_options options;
+
+    if(!parse_options(argc, argv, &options)) {
+        print_usage();
+        return 1;
+    }
+
+    std::vector<column_chunk> chunks;
+    if(options.offset >= 0) {
+        raw_chunk(options, &chunks);
+    } else if(!read_footer(options, &chunks)) {
+        return 1;
+    }
+
+    ptoa::SWParquetReader reader(options.input_path, arrow::default_memory_pool(), options.mode);
+
+    for(column_chunk& chunk : chunks) {
+        if(reader.inspect_pages(chunk.offset, chunk.options, &chunk.pages) != ptoa::status::OK) {
+            std::cerr << "[ERROR] Could not inspect column " << chunk.name << " of row group " << chunk.row_group << std::endl;
+            return 1;
+        }
+    }
+
+    if(options.format == "json") {
+        std::cout << "{" << std::endl;
+        std::cout << "  \"file\": " << json_string(options.input_path) << "," << std::endl;
+        std::cout << "  \"columns\": [" << std::endl;
+    }
+
+    for(size_t c=0; c<chunks.size(); c++) {
+        chunk_totals totals = sum_pages(chunks[c]);
+        if(options.format == "json") {
+            print_json(chunks[c], totals, options.pages, c+1 == chunks.size());
+        } else {
+            print_table(chunks[c], totals, options.pages);
+        }
+    }
+
+    if(options.format == "json") {
+        std::cout << "  ]" << std::endl << "}" << std::endl;
+    }
+
+    return 0;
+}
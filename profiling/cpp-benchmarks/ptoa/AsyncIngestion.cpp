@@ -0,0 +1,264 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include <AsyncIngestion.h>
+#include <ptoa.h>
+
+namespace ptoa {
+
+AsyncIngestion::AsyncIngestion(int fd, uint8_t* buffer, int64_t size) : fd(fd), buffer(buffer), size(size),
+    num_extents((size + INGESTION_EXTENT_BYTES - 1)/INGESTION_EXTENT_BYTES), extent_done(num_extents, 0),
+    next_resident_extent(0), resident_bytes(0), failed(false), stop(false), io_uring_used(false) {
+    ingestion_thread = std::thread(&AsyncIngestion::run, this);
+}
+
+AsyncIngestion::~AsyncIngestion() {
+    stop = true;
+    ingestion_thread.join();
+    close(fd);
+}
+
+status AsyncIngestion::wait_resident(int64_t end_offset) {
+    if(is_resident(end_offset)){
+        return status::OK;
+    }
+
+    std::unique_lock<std::mutex> lock(resident_mutex);
+    resident_cv.wait(lock, [&](){return failed || is_resident(end_offset);});
+
+    return is_resident(end_offset) ? status::OK : status::FAIL;
+}
+
+void AsyncIngestion::run() {
+    if(run_io_uring() || stop){
+        return;
+    }
+
+    // Also picks up extents io_uring did not complete
+    if(!run_pread()){
+        fail();
+    }
+}
+
+// Returns false if io_uring is not available or not all extents were read, extents that did complete are not read again
+bool AsyncIngestion::run_io_uring() {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    int ring_fd = syscall(__NR_io_uring_setup, INGESTION_QUEUE_DEPTH, &params);
+    if(ring_fd < 0){
+        return false;
+    }
+
+    size_t sq_ring_size = params.sq_off.array + params.sq_entries*sizeof(uint32_t);
+    size_t cq_ring_size = params.cq_off.cqes + params.cq_entries*sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+
+    if(single_mmap){
+        sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+    }
+
+    void* sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    void* cq_ring = single_mmap ? sq_ring : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    void* sqe_area = mmap(nullptr, params.sq_entries*sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+
+    if(sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqe_area == MAP_FAILED){
+        if(sq_ring != MAP_FAILED) munmap(sq_ring, sq_ring_size);
+        if(!single_mmap && cq_ring != MAP_FAILED) munmap(cq_ring, cq_ring_size);
+        if(sqe_area != MAP_FAILED) munmap(sqe_area, params.sq_entries*sizeof(struct io_uring_sqe));
+        close(ring_fd);
+        return false;
+    }
+
+    uint32_t* sq_tail = (uint32_t*) ((uint8_t*) sq_ring + params.sq_off.tail);
+    uint32_t sq_mask = *(uint32_t*) ((uint8_t*) sq_ring + params.sq_off.ring_mask);
+    uint32_t* sq_array = (uint32_t*) ((uint8_t*) sq_ring + params.sq_off.array);
+    struct io_uring_sqe* sqes = (struct io_uring_sqe*) sqe_area;
+
+    uint32_t* cq_head = (uint32_t*) ((uint8_t*) cq_ring + params.cq_off.head);
+    uint32_t* cq_tail = (uint32_t*) ((uint8_t*) cq_ring + params.cq_off.tail);
+    uint32_t cq_mask = *(uint32_t*) ((uint8_t*) cq_ring + params.cq_off.ring_mask);
+    struct io_uring_cqe* cqes = (struct io_uring_cqe*) ((uint8_t*) cq_ring + params.cq_off.cqes);
+
+    // One iovec per extent, they have to stay valid until the read completes
+    std::vector<struct iovec> iovecs(num_extents);
+
+    int64_t next_extent = 0;
+    int in_flight = 0;
+    uint32_t not_submitted = 0;
+    bool ok = true;
+    bool submitted_any = false;
+
+    io_uring_used = true;
+
+    while((ok && !stop && next_extent < num_extents) || in_flight > 0){
+        uint32_t tail = *sq_tail;
+
+        while(ok && !stop && next_extent < num_extents && in_flight < INGESTION_QUEUE_DEPTH){
+            int64_t offset = next_extent*INGESTION_EXTENT_BYTES;
+            uint32_t index = tail & sq_mask;
+            struct io_uring_sqe* sqe = &sqes[index];
+
+            iovecs[next_extent].iov_base = buffer + offset;
+            iovecs[next_extent].iov_len = std::min((int64_t) INGESTION_EXTENT_BYTES, size - offset);
+
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READV;
+            sqe->fd = fd;
+            sqe->off = offset;
+            sqe->addr = (uint64_t) &iovecs[next_extent];
+            sqe->len = 1;
+            sqe->user_data = next_extent;
+
+            sq_array[index] = index;
+            tail++;
+            next_extent++;
+            in_flight++;
+            not_submitted++;
+        }
+
+        __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+
+        int ret = syscall(__NR_io_uring_enter, ring_fd, not_submitted, in_flight > 0 ? 1 : 0, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+        if(ret < 0){
+            if(errno == EINTR || errno == EAGAIN || errno == EBUSY){
+                continue;
+            }
+
+            if(ok){
+                // Stop submitting. Reads that were already submitted may still write into the buffer, so they are reaped
+                // before the pread fallback reads the missing extents into it. Nothing is in flight if the very first
+                // submission failed, e.g. io_uring blocked by seccomp.
+                io_uring_used = submitted_any;
+                in_flight -= not_submitted;
+                not_submitted = 0;
+                ok = false;
+            } else {
+                // Waiting for completions failed as well, poll the completion queue until the reads are done
+                std::this_thread::sleep_for(std::chrono::microseconds(INGESTION_POLL_US));
+            }
+        } else {
+            not_submitted -= ret;
+            submitted_any |= ret > 0;
+        }
+
+        uint32_t head = *cq_head;
+        uint32_t completed_tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+
+        while(head != completed_tail){
+            struct io_uring_cqe* cqe = &cqes[head & cq_mask];
+            int64_t extent = cqe->user_data;
+            int64_t offset = extent*INGESTION_EXTENT_BYTES;
+            int64_t length = iovecs[extent].iov_len;
+
+            if(cqe->res < 0){
+                ok = false;
+            } else if(cqe->res < length && !read_remainder(offset + cqe->res, length - cqe->res)){
+                ok = false;
+            } else {
+                complete_extent(extent);
+            }
+
+            in_flight--;
+            head++;
+        }
+
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    munmap(sqe_area, params.sq_entries*sizeof(struct io_uring_sqe));
+    if(!single_mmap){
+        munmap(cq_ring, cq_ring_size);
+    }
+    munmap(sq_ring, sq_ring_size);
+    close(ring_fd);
+
+    return ok;
+}
+
+bool AsyncIngestion::run_pread() {
+    for(int64_t extent=0; extent<num_extents && !stop; extent++){
+        if(extent_done[extent]){
+            continue;
+        }
+
+        int64_t offset = extent*INGESTION_EXTENT_BYTES;
+        if(!read_remainder(offset, std::min((int64_t) INGESTION_EXTENT_BYTES, size - offset))){
+            return false;
+        }
+        complete_extent(extent);
+    }
+
+    return true;
+}
+
+bool AsyncIngestion::read_remainder(int64_t offset, int64_t length) {
+    while(length > 0){
+        ssize_t ret = pread(fd, buffer + offset, length, offset);
+
+        if(ret < 0 && errno == EINTR){
+            continue;
+        }
+        if(ret <= 0){
+            return false;
+        }
+
+        offset += ret;
+        length -= ret;
+    }
+
+    return true;
+}
+
+// Extents complete out of order, only the prefix of the file without gaps is published
+void AsyncIngestion::complete_extent(int64_t extent) {
+    extent_done[extent] = 1;
+
+    if(extent != next_resident_extent){
+        return;
+    }
+
+    while(next_resident_extent < num_extents && extent_done[next_resident_extent]){
+        next_resident_extent++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(resident_mutex);
+        resident_bytes.store(std::min(next_resident_extent*INGESTION_EXTENT_BYTES, size), std::memory_order_release);
+    }
+    resident_cv.notify_all();
+}
+
+void AsyncIngestion::fail() {
+    std::cerr << "[ERROR] Reading Parquet file failed: " << std::strerror(errno) << std::endl;
+
+    {
+        std::lock_guard<std::mutex> lock(resident_mutex);
+        failed = true;
+    }
+    resident_cv.notify_all();
+}
+
+}
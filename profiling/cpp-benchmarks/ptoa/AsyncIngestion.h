@@ -0,0 +1,78 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <ptoa.h>
+
+// Size of the reads issued by the ingestion thread, multiple of the 4K alignment O_DIRECT requires
+#define INGESTION_EXTENT_BYTES (8*1024*1024)
+// Maximum amount of reads in flight
+#define INGESTION_QUEUE_DEPTH 8
+// Interval at which the completion queue is polled when waiting on it with io_uring_enter fails
+#define INGESTION_POLL_US 100
+
+namespace ptoa{
+
+/**
+ * Reads a file into a buffer on a background thread using io_uring, so the file can be decoded while it is still being
+ * read. The file is read in large extents that complete in any order, the prefix of the file that has completely
+ * arrived is published as resident_bytes. If io_uring is not available (old kernel, seccomp) the thread falls back to
+ * pread, which still overlaps I/O with decoding.
+ */
+class AsyncIngestion {
+  public:
+    // Starts reading size bytes from fd into buffer, takes ownership of fd
+    AsyncIngestion(int fd, uint8_t* buffer, int64_t size);
+    ~AsyncIngestion();
+
+    bool is_resident(int64_t end_offset) const {return resident_bytes.load(std::memory_order_acquire) >= end_offset;}
+    // Block until the first end_offset bytes of the file are in the buffer, fails if reading the file failed
+    status wait_resident(int64_t end_offset);
+
+    int64_t get_resident_bytes() const {return resident_bytes.load(std::memory_order_acquire);}
+    bool uses_io_uring() const {return io_uring_used;}
+
+  private:
+    void run();
+    bool run_io_uring();
+    bool run_pread();
+    bool read_remainder(int64_t offset, int64_t length);
+    void complete_extent(int64_t extent);
+    void fail();
+
+    int fd;
+    uint8_t* buffer;
+    int64_t size;
+    int64_t num_extents;
+
+    std::vector<char> extent_done;
+    int64_t next_resident_extent;
+
+    std::atomic<int64_t> resident_bytes;
+    std::atomic<bool> failed;
+    std::atomic<bool> stop;
+    bool io_uring_used;
+
+    std::mutex resident_mutex;
+    std::condition_variable resident_cv;
+    std::thread ingestion_thread;
+};
+
+}
@@ -0,0 +1,354 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <algorithm>
+#include <limits>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <parquet/api/reader.h>
+
+#include <DatasetScanner.h>
+#include <SWParquetReader.h>
+#include <ptoa.h>
+
+namespace ptoa {
+
+DatasetScanner::DatasetScanner(std::vector<std::string> file_paths, const scan_options& options, arrow::MemoryPool* pool) :
+    file_paths(file_paths), options(options), pool(pool), file_parts(file_paths.size(), -1), files_opened(0),
+    parts_expected(0), parts_returned(0), failed(false), cancelled(false), next_file(0), next_part(0) {
+    std::shared_ptr<arrow::DataType> type = options.prim_width == 64 ? arrow::int64() : arrow::int32();
+    schema = arrow::schema({arrow::field(options.column.empty() ? "values" : options.column, type, false)});
+
+    // Direct ingestion streams the file, the scanner needs it in memory to index and split the pages
+    if(this->options.mode == ingestion::DIRECT){
+        this->options.mode = ingestion::BUFFERED;
+    }
+}
+
+DatasetScanner::~DatasetScanner() {
+    cancelled = true;
+
+    // Running tasks may still submit to the pool, so it has to stay valid until they are done
+    if(thread_pool != nullptr){
+        thread_pool->wait_idle();
+        thread_pool.reset();
+    }
+}
+
+status DatasetScanner::list_directory(const std::string& directory, std::vector<std::string>* file_paths) {
+    DIR* dir = opendir(directory.c_str());
+
+    if(dir == nullptr){
+        std::cerr << "[ERROR] Could not open directory " << directory << std::endl;
+        return status::FAIL;
+    }
+
+    struct dirent* entry;
+    file_paths->clear();
+
+    while((entry = readdir(dir)) != nullptr){
+        std::string path = directory + "/" + entry->d_name;
+        struct stat file_stat;
+
+        if(entry->d_name[0] != '.' && stat(path.c_str(), &file_stat) == 0 && S_ISREG(file_stat.st_mode)){
+            file_paths->push_back(path);
+        }
+    }
+    closedir(dir);
+
+    std::sort(file_paths->begin(), file_paths->end());
+
+    return status::OK;
+}
+
+status DatasetScanner::start() {
+    if(options.prim_width != 32 && options.prim_width != 64){
+        std::cerr << "[ERROR] Unsupported prim width " << options.prim_width << std::endl;
+        return status::FAIL;
+    }
+
+    thread_pool.reset(new WorkStealingPool(options.num_threads));
+
+    // Submitted in reverse, the worker that gets several files takes the newest task first
+    for(int file_index=file_paths.size()-1; file_index>=0; file_index--){
+        thread_pool->submit([this, file_index](){open_file(file_index);});
+    }
+
+    return status::OK;
+}
+
+status DatasetScanner::next(scan_batch* batch) {
+    std::unique_lock<std::mutex> lock(result_mutex);
+
+    if(options.ordered){
+        while(true){
+            // Skip files that are done, including files without pages
+            while(next_file < (int) file_paths.size() && file_parts[next_file] >= 0 && next_part >= file_parts[next_file]){
+                next_file++;
+                next_part = 0;
+            }
+
+            if(failed){
+                return status::FAIL;
+            }
+
+            if(next_file == (int) file_paths.size()){
+                batch->batch = nullptr;
+                return status::OK;
+            }
+
+            auto it = ordered_batches.find(std::make_pair(next_file, next_part));
+            if(it != ordered_batches.end()){
+                *batch = it->second;
+                ordered_batches.erase(it);
+                next_part++;
+                parts_returned++;
+                return status::OK;
+            }
+
+            result_cv.wait(lock);
+        }
+    } else {
+        while(true){
+            if(failed){
+                return status::FAIL;
+            }
+
+            if(!unordered_batches.empty()){
+                *batch = unordered_batches.front();
+                unordered_batches.pop_front();
+                parts_returned++;
+                return status::OK;
+            }
+
+            if(files_opened == (int) file_paths.size() && parts_returned == parts_expected){
+                batch->batch = nullptr;
+                return status::OK;
+            }
+
+            result_cv.wait(lock);
+        }
+    }
+}
+
+// Find the column chunk of the scanned column in every row group through the footer of the file. The chunks have to be
+// laid out like the decoders expect them: non-nullable and uncompressed.
+status DatasetScanner::find_chunks(int file_index, std::vector<chunk_location>* chunks) {
+    const std::string& path = file_paths[file_index];
+
+    chunks->clear();
+
+    // A file without footer holds a single column chunk that runs until the end of the file
+    if(options.file_offset >= 0){
+        chunks->push_back({0, options.file_offset, -1, -1});
+        return status::OK;
+    }
+
+    std::unique_ptr<parquet::ParquetFileReader> file_reader;
+    try {
+        file_reader = parquet::ParquetFileReader::OpenFile(path);
+    } catch(const parquet::ParquetException& e) {
+        std::cerr << "[ERROR] Could not read the footer of " << path << ": " << e.what() << std::endl;
+        return status::FAIL;
+    }
+
+    std::shared_ptr<parquet::FileMetaData> metadata = file_reader->metadata();
+    const parquet::SchemaDescriptor* file_schema = metadata->schema();
+
+    int column_index = options.column.empty() ? options.column_index : -1;
+    for(int c=0; c<file_schema->num_columns() && !options.column.empty(); c++){
+        if(file_schema->Column(c)->path()->ToDotString() == options.column){
+            column_index = c;
+        }
+    }
+
+    if(column_index < 0 || column_index >= file_schema->num_columns()){
+        std::cerr << "[ERROR] " << path << " has no column " << (options.column.empty() ? std::to_string(options.column_index) : options.column) << std::endl;
+        return status::FAIL;
+    }
+
+    const parquet::ColumnDescriptor* descriptor = file_schema->Column(column_index);
+    parquet::Type::type physical_type = options.prim_width == 64 ? parquet::Type::INT64 : parquet::Type::INT32;
+
+    if(descriptor->physical_type() != physical_type){
+        std::cerr << "[ERROR] Column " << descriptor->path()->ToDotString() << " of " << path << " is of type "
+                  << parquet::TypeToString(descriptor->physical_type()) << ", not " << parquet::TypeToString(physical_type) << std::endl;
+        return status::FAIL;
+    }
+    if(descriptor->max_definition_level() > 0 || descriptor->max_repetition_level() > 0){
+        std::cerr << "[ERROR] Column " << descriptor->path()->ToDotString() << " of " << path << " is not a required column" << std::endl;
+        return status::FAIL;
+    }
+
+    for(int r=0; r<metadata->num_row_groups(); r++){
+        std::unique_ptr<parquet::ColumnChunkMetaData> column_chunk = metadata->RowGroup(r)->ColumnChunk(column_index);
+
+        if(column_chunk->compression() != parquet::Compression::UNCOMPRESSED){
+            std::cerr << "[ERROR] Column chunk " << r << " of " << path << " is compressed" << std::endl;
+            return status::FAIL;
+        }
+
+        chunk_location chunk;
+        chunk.row_group = r;
+        chunk.offset = column_chunk->data_page_offset();
+        // Some writers set the dictionary page offset to 0 when there is no dictionary page
+        if(column_chunk->has_dictionary_page() && column_chunk->dictionary_page_offset() > 0){
+            chunk.offset = std::min(chunk.offset, column_chunk->dictionary_page_offset());
+        }
+        chunk.size = column_chunk->total_compressed_size();
+        chunk.num_values = column_chunk->num_values();
+
+        chunks->push_back(chunk);
+    }
+
+    return status::OK;
+}
+
+// Load a file, index the pages of every column chunk and split them into parts of about target_task_bytes. Parts do not
+// cross column chunks and are numbered through all chunks of the file.
+void DatasetScanner::open_file(int file_index) {
+    if(cancelled){
+        return;
+    }
+
+    std::vector<chunk_location> chunks;
+
+    if(find_chunks(file_index, &chunks) != status::OK){
+        fail();
+        return;
+    }
+
+    std::shared_ptr<SWParquetReader> reader = std::make_shared<SWParquetReader>(file_paths[file_index], pool, options.mode);
+    // find_chunks only accepts required columns
+    reader->set_max_levels(0, 0);
+
+    struct part_location {
+        int row_group;
+        int64_t first_value_index;
+        int64_t num_values;
+        int64_t file_offset;
+    };
+    std::vector<part_location> parts;
+
+    for(const chunk_location& chunk : chunks){
+        std::vector<page_info> pages;
+        int64_t end_offset = chunk.size < 0 ? -1 : chunk.offset + chunk.size;
+
+        if(reader->index_pages(-1, chunk.offset, options.enc, &pages, end_offset) != status::OK){
+            std::cerr << "[ERROR] Could not index pages of row group " << chunk.row_group << " of " << file_paths[file_index] << std::endl;
+            fail();
+            return;
+        }
+
+        int64_t chunk_values = pages.empty() ? 0 : pages.back().first_value_index + pages.back().num_values;
+        if(chunk.num_values >= 0 && chunk_values != chunk.num_values){
+            std::cerr << "[ERROR] Pages of row group " << chunk.row_group << " of " << file_paths[file_index] << " hold " << chunk_values
+                      << " values instead of " << chunk.num_values << std::endl;
+            fail();
+            return;
+        }
+
+        // First page of every part, followed by the end of the last part
+        std::vector<size_t> part_bounds;
+        int64_t part_bytes = 0;
+
+        for(size_t page=0; page<pages.size(); page++){
+            if(page == 0 || part_bytes >= options.target_task_bytes){
+                part_bounds.push_back(page);
+                part_bytes = 0;
+            }
+            part_bytes += pages[page].size;
+        }
+        part_bounds.push_back(pages.size());
+
+        for(size_t part=0; part+1<part_bounds.size(); part++){
+            const page_info& first = pages[part_bounds[part]];
+            const page_info& last = pages[part_bounds[part+1]-1];
+
+            parts.push_back({chunk.row_group, first.first_value_index, last.first_value_index + last.num_values - first.first_value_index, first.offset});
+        }
+    }
+
+    int64_t num_parts = parts.size();
+
+    {
+        std::lock_guard<std::mutex> lock(result_mutex);
+        file_parts[file_index] = num_parts;
+        parts_expected += num_parts;
+        files_opened++;
+    }
+    result_cv.notify_all();
+
+    // The reader, and the file in memory, is released once the last part of the file is decoded. Parts are submitted in
+    // reverse so this worker decodes them front to back while thieves take the parts at the end.
+    for(int64_t part=num_parts-1; part>=0; part--){
+        part_location location = parts[part];
+
+        thread_pool->submit([this, reader, file_index, part, location](){
+            decode_part(reader, file_index, location.row_group, part, location.first_value_index, location.num_values, location.file_offset);
+        });
+    }
+}
+
+void DatasetScanner::decode_part(std::shared_ptr<SWParquetReader> reader, int file_index, int row_group, int64_t part_index, int64_t first_value_index, int64_t num_values, int64_t file_offset) {
+    if(cancelled){
+        return;
+    }
+
+    if(file_offset > std::numeric_limits<int32_t>::max()){
+        std::cerr << "[ERROR] Page offset " << file_offset << " in " << file_paths[file_index] << " is out of range" << std::endl;
+        fail();
+        return;
+    }
+
+    std::shared_ptr<arrow::PrimitiveArray> array;
+    if(reader->read_prim(options.prim_width, num_values, file_offset, &array, options.enc) != status::OK){
+        std::cerr << "[ERROR] Could not decode " << file_paths[file_index] << std::endl;
+        fail();
+        return;
+    }
+
+    scan_batch batch;
+    batch.file_index = file_index;
+    batch.row_group = row_group;
+    batch.first_value_index = first_value_index;
+    batch.batch = arrow::RecordBatch::Make(schema, num_values, {array});
+
+    add_batch(part_index, batch);
+}
+
+void DatasetScanner::add_batch(int64_t part_index, const scan_batch& batch) {
+    {
+        std::lock_guard<std::mutex> lock(result_mutex);
+
+        if(options.ordered){
+            ordered_batches[std::make_pair(batch.file_index, part_index)] = batch;
+        } else {
+            unordered_batches.push_back(batch);
+        }
+    }
+    result_cv.notify_all();
+}
+
+void DatasetScanner::fail() {
+    {
+        std::lock_guard<std::mutex> lock(result_mutex);
+        failed = true;
+    }
+    result_cv.notify_all();
+    cancelled = true;
+}
+
+}
@@ -0,0 +1,126 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <arrow/api.h>
+
+#include <ptoa.h>
+#include <SWParquetReader.h>
+#include <WorkStealingPool.h>
+
+namespace ptoa{
+
+/**
+ * Options for DatasetScanner. Every file holds a column of prim_width bit integers, selected by its (dot separated) name
+ * or, if column is empty, by column_index. Its column chunks are found through the footer of the file. Files without a
+ * footer, like the ones written for the hardware, hold a single column chunk with pages starting at file_offset, which
+ * has to be -1 for files with a footer. Column chunks with more than target_task_bytes of pages are split at page
+ * boundaries into tasks of about that size. With ordered set, batches are returned in file, row group and page order,
+ * otherwise in order of completion.
+ */
+struct scan_options {
+    int32_t prim_width;
+    encoding enc;
+    std::string column;
+    int column_index;
+    int64_t file_offset;
+    int num_threads;
+    bool ordered;
+    int64_t target_task_bytes;
+    ingestion mode;
+};
+
+/**
+ * Part of a column chunk returned by the scanner. first_value_index is the index of the first value of the batch in the
+ * column chunk of row group row_group of file file_index.
+ */
+struct scan_batch {
+    int file_index;
+    int row_group;
+    int64_t first_value_index;
+    std::shared_ptr<arrow::RecordBatch> batch;
+};
+
+/**
+ * Location of the scanned column chunk of a row group. The pages span size bytes from offset, including a dictionary
+ * page, and hold num_values values (-1 if unknown).
+ */
+struct chunk_location {
+    int row_group;
+    int64_t offset;
+    int64_t size;
+    int64_t num_values;
+};
+
+/**
+ * Scans a column from every file of a dataset with a work-stealing thread pool. Opening a file (reading its footer,
+ * loading it and indexing the pages of every column chunk) is a task, which submits a decode task for every part of
+ * every column chunk. Workers first finish the parts of the file they opened, idle workers steal the remaining parts of
+ * large files or open the next files. In ordered mode batches that complete early are kept until they are next in line.
+ */
+class DatasetScanner {
+  public:
+    DatasetScanner(std::vector<std::string> file_paths, const scan_options& options, arrow::MemoryPool* pool = arrow::default_memory_pool());
+    ~DatasetScanner();
+
+    // Every regular file in the directory, sorted by name
+    static status list_directory(const std::string& directory, std::vector<std::string>* file_paths);
+
+    // Start opening and decoding all files in the background
+    status start();
+    // Wait for the next batch, batch->batch is nullptr once all batches have been returned
+    status next(scan_batch* batch);
+
+    int get_num_files() {return file_paths.size();}
+
+  private:
+    status find_chunks(int file_index, std::vector<chunk_location>* chunks);
+    void open_file(int file_index);
+    void decode_part(std::shared_ptr<SWParquetReader> reader, int file_index, int row_group, int64_t part_index, int64_t first_value_index, int64_t num_values, int64_t file_offset);
+    void add_batch(int64_t part_index, const scan_batch& batch);
+    void fail();
+
+    std::vector<std::string> file_paths;
+    scan_options options;
+    arrow::MemoryPool* pool;
+    std::shared_ptr<arrow::Schema> schema;
+
+    std::mutex result_mutex;
+    std::condition_variable result_cv;
+    // Amount of parts of every file over all of its column chunks, -1 until the file has been opened
+    std::vector<int64_t> file_parts;
+    int files_opened;
+    int64_t parts_expected;
+    int64_t parts_returned;
+    bool failed;
+    std::atomic<bool> cancelled;
+
+    std::deque<scan_batch> unordered_batches;
+    std::map<std::pair<int, int64_t>, scan_batch> ordered_batches;
+    int next_file;
+    int64_t next_part;
+
+    std::unique_ptr<WorkStealingPool> thread_pool;
+};
+
+}
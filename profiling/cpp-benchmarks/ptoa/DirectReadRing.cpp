@@ -0,0 +1,146 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <DirectReadRing.h>
+#include <ptoa.h>
+
+namespace ptoa {
+
+DirectReadRing::DirectReadRing(int fd, int64_t file_size, int64_t start_offset, bool o_direct) : fd(fd),
+    file_size(file_size), start_offset(start_offset & ~((int64_t) DIRECT_ALIGNMENT - 1)), o_direct(o_direct),
+    buffers(DIRECT_RING_BUFFERS), buffer_state(DIRECT_RING_BUFFERS, 0), next_consumed(0), failed(false), stop(false) {
+    num_reads = (file_size - this->start_offset + DIRECT_BUFFER_BYTES - 1)/DIRECT_BUFFER_BYTES;
+
+    for(int i=0; i<DIRECT_RING_BUFFERS; i++){
+        void* allocation;
+        if(posix_memalign(&allocation, DIRECT_ALIGNMENT, DIRECT_MAX_PAGE_BYTES + DIRECT_BUFFER_BYTES + DIRECT_PADDING_BYTES) != 0){
+            std::cerr << "[ERROR] Could not allocate O_DIRECT buffers" << std::endl;
+            failed = true;
+            return;
+        }
+        allocations.push_back((uint8_t*) allocation);
+        buffers[i].data = (uint8_t*) allocation + DIRECT_MAX_PAGE_BYTES;
+    }
+
+    reader_thread = std::thread(&DirectReadRing::run, this);
+}
+
+DirectReadRing::~DirectReadRing() {
+    {
+        std::lock_guard<std::mutex> lock(ring_mutex);
+        stop = true;
+    }
+    ring_cv.notify_all();
+
+    if(reader_thread.joinable()){
+        reader_thread.join();
+    }
+
+    for(uint8_t* allocation : allocations){
+        free(allocation);
+    }
+}
+
+status DirectReadRing::next(direct_buffer** buffer) {
+    if(next_consumed >= num_reads){
+        return status::FAIL;
+    }
+
+    int slot = next_consumed%DIRECT_RING_BUFFERS;
+
+    std::unique_lock<std::mutex> lock(ring_mutex);
+    ring_cv.wait(lock, [&](){return failed || buffer_state[slot] == 1;});
+
+    if(buffer_state[slot] != 1){
+        return status::FAIL;
+    }
+
+    buffer_state[slot] = 2;
+    *buffer = &buffers[slot];
+    next_consumed++;
+
+    return status::OK;
+}
+
+void DirectReadRing::release(direct_buffer* buffer) {
+    {
+        std::lock_guard<std::mutex> lock(ring_mutex);
+        buffer_state[buffer - &buffers[0]] = 0;
+    }
+    ring_cv.notify_all();
+}
+
+void DirectReadRing::run() {
+    for(int64_t read=0; read<num_reads; read++){
+        int slot = read%DIRECT_RING_BUFFERS;
+
+        {
+            std::unique_lock<std::mutex> lock(ring_mutex);
+            ring_cv.wait(lock, [&](){return stop || buffer_state[slot] == 0;});
+
+            if(stop){
+                return;
+            }
+        }
+
+        uint8_t* data = buffers[slot].data;
+        int64_t offset = start_offset + read*DIRECT_BUFFER_BYTES;
+        int64_t length = std::min((int64_t) DIRECT_BUFFER_BYTES, file_size - offset);
+        // O_DIRECT reads have to be a multiple of the alignment, the read returns less at the end of the file
+        int64_t read_length = o_direct ? (length + DIRECT_ALIGNMENT - 1) & ~((int64_t) DIRECT_ALIGNMENT - 1) : length;
+        int64_t bytes_read = 0;
+
+        while(bytes_read < length){
+            ssize_t ret = pread(fd, data + bytes_read, read_length - bytes_read, offset + bytes_read);
+
+            if(ret < 0 && errno == EINTR){
+                continue;
+            }
+            if(ret <= 0){
+                std::cerr << "[ERROR] Reading Parquet file failed: " << (ret < 0 ? std::strerror(errno) : "unexpected end of file") << std::endl;
+                {
+                    std::lock_guard<std::mutex> lock(ring_mutex);
+                    failed = true;
+                }
+                ring_cv.notify_all();
+                return;
+            }
+
+            bytes_read += ret;
+        }
+
+        if(!o_direct){
+            posix_fadvise(fd, offset, length, POSIX_FADV_DONTNEED);
+        }
+
+        std::memset(data + length, 0, DIRECT_PADDING_BYTES);
+
+        {
+            std::lock_guard<std::mutex> lock(ring_mutex);
+            buffers[slot].file_offset = offset;
+            buffers[slot].length = length;
+            buffer_state[slot] = 1;
+        }
+        ring_cv.notify_all();
+    }
+}
+
+}
@@ -0,0 +1,83 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <ptoa.h>
+
+// Alignment O_DIRECT requires for buffers, file offsets and read sizes
+#define DIRECT_ALIGNMENT 4096
+// Bytes read from the file into every buffer of the ring
+#define DIRECT_BUFFER_BYTES (4*1024*1024)
+#define DIRECT_RING_BUFFERS 4
+// Largest page that can straddle two buffers, the part in the first buffer is copied in front of the second one
+#define DIRECT_MAX_PAGE_BYTES DIRECT_BUFFER_BYTES
+// Zeroed bytes after the data of every buffer, the bit unpacking kernels read whole words past the end of a page
+#define DIRECT_PADDING_BYTES 64
+
+namespace ptoa{
+
+/**
+ * Buffer of the ring. data points to the bytes of the file starting at file_offset. Up to DIRECT_MAX_PAGE_BYTES in front
+ * of data can be written by the consumer.
+ */
+struct direct_buffer {
+    uint8_t* data;
+    int64_t file_offset;
+    int64_t length;
+};
+
+/**
+ * Reads a file front to back into a small ring of aligned buffers on a background thread, bypassing the page cache
+ * with O_DIRECT. The consumer gets the buffers in file order and releases them once it is done, after which they are
+ * refilled. Memory use is bounded by the ring, no matter how large the file is.
+ */
+class DirectReadRing {
+  public:
+    // fd should be opened with O_DIRECT, without it the pages read are dropped from the page cache after every read
+    DirectReadRing(int fd, int64_t file_size, int64_t start_offset, bool o_direct);
+    ~DirectReadRing();
+
+    // Wait for the next buffer in file order. Fails at the end of the file or if reading failed.
+    status next(direct_buffer** buffer);
+    void release(direct_buffer* buffer);
+
+  private:
+    void run();
+
+    int fd;
+    int64_t file_size;
+    int64_t start_offset;
+    bool o_direct;
+
+    std::vector<uint8_t*> allocations;
+    std::vector<direct_buffer> buffers;
+    // Per buffer: 0 free, 1 filled, 2 handed to the consumer
+    std::vector<int> buffer_state;
+    int64_t num_reads;
+    int64_t next_consumed;
+
+    bool failed;
+    bool stop;
+
+    std::mutex ring_mutex;
+    std::condition_variable ring_cv;
+    std::thread reader_thread;
+};
+
+}
@@ -0,0 +1,109 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sstream>
+
+#include <Instrumentation.h>
+
+namespace ptoa {
+
+const char* stage_name(stage s) {
+    switch(s){
+        case STAGE_PAGE_HEADER:
+            return "page_header";
+        case STAGE_BLOCK_HEADER:
+            return "block_header";
+        case STAGE_UNPACK:
+            return "unpack";
+        case STAGE_PREFIX_SUM:
+            return "prefix_sum";
+        case STAGE_CHAR_COPY:
+            return "char_copy";
+        case STAGE_PLAIN_COPY:
+            return "plain_copy";
+        case STAGE_ALLOCATION:
+            return "allocation";
+        default:
+            return "unknown";
+    }
+}
+
+reader_stats::reader_stats() {
+#ifdef PTOA_INSTRUMENT
+    instrumented = true;
+#else
+    instrumented = false;
+#endif
+    clear();
+}
+
+void reader_stats::clear() {
+    for(int s=0; s<NUM_STAGES; s++){
+        cycles[s] = 0;
+    }
+    for(int w=0; w<BIT_WIDTH_SLOTS; w++){
+        miniblocks[w] = 0;
+    }
+    pages = 0;
+    blocks = 0;
+    bytes_in = 0;
+    bytes_out = 0;
+    bytes_allocated = 0;
+}
+
+void reader_stats::merge(const reader_stats& other) {
+    for(int s=0; s<NUM_STAGES; s++){
+        cycles[s] += other.cycles[s];
+    }
+    for(int w=0; w<BIT_WIDTH_SLOTS; w++){
+        miniblocks[w] += other.miniblocks[w];
+    }
+    pages += other.pages;
+    blocks += other.blocks;
+    bytes_in += other.bytes_in;
+    bytes_out += other.bytes_out;
+    bytes_allocated += other.bytes_allocated;
+}
+
+uint64_t reader_stats::total_cycles() const {
+    uint64_t total = 0;
+    for(int s=0; s<NUM_STAGES; s++){
+        total += cycles[s];
+    }
+    return total;
+}
+
+// Single JSON object, miniblocks only lists the bit widths that occurred
+std::string reader_stats::to_json() const {
+    std::ostringstream json;
+
+    json << "{\"instrumented\": " << (instrumented ? "true" : "false") << ", \"cycles\": {";
+    for(int s=0; s<NUM_STAGES; s++){
+        json << (s > 0 ? ", " : "") << "\"" << stage_name((stage) s) << "\": " << cycles[s];
+    }
+    json << "}, \"total_cycles\": " << total_cycles();
+    json << ", \"pages\": " << pages << ", \"blocks\": " << blocks << ", \"miniblocks_per_bit_width\": {";
+
+    bool first = true;
+    for(int w=0; w<BIT_WIDTH_SLOTS; w++){
+        if(miniblocks[w] != 0){
+            json << (first ? "" : ", ") << "\"" << w << "\": " << miniblocks[w];
+            first = false;
+        }
+    }
+
+    json << "}, \"bytes_in\": " << bytes_in << ", \"bytes_out\": " << bytes_out << ", \"bytes_allocated\": " << bytes_allocated << "}";
+
+    return json.str();
+}
+
+}
@@ -0,0 +1,104 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+#ifdef PTOA_INSTRUMENT
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+// Statements that are only compiled in when the reader is built with PTOA_INSTRUMENT (cmake -DPTOA_INSTRUMENT=ON), so
+// the decoding loops carry no instrumentation otherwise
+#ifdef PTOA_INSTRUMENT
+#define PTOA_INSTRUMENTED(...) __VA_ARGS__
+#else
+#define PTOA_INSTRUMENTED(...)
+#endif
+
+// Miniblock bit widths are stored in a byte, so corrupted pages can hold any width up to 255
+#define BIT_WIDTH_SLOTS 256
+
+namespace ptoa{
+
+enum stage{
+	STAGE_PAGE_HEADER,
+	STAGE_BLOCK_HEADER,
+	STAGE_UNPACK,
+	STAGE_PREFIX_SUM,
+	STAGE_CHAR_COPY,
+	STAGE_PLAIN_COPY,
+	STAGE_ALLOCATION,
+	NUM_STAGES
+};
+
+/**
+ * Counters of the decoding stages of SWParquetReader. cycles are time stamp counter ticks spent per stage: page header
+ * parsing (including waiting for pages that are still being ingested), delta and block header parsing, bit unpacking,
+ * prefix accumulation of the deltas, copying of string characters and plain values, and allocation of output buffers.
+ * bytes_in counts the bytes of the pages that were decoded (headers included), bytes_out the bytes written to Arrow
+ * buffers. All counters stay 0 if the reader was built without PTOA_INSTRUMENT, instrumented is false in that case.
+ */
+struct reader_stats {
+    bool instrumented;
+    uint64_t cycles[NUM_STAGES];
+    int64_t pages;
+    int64_t blocks;
+    int64_t miniblocks[BIT_WIDTH_SLOTS];
+    int64_t bytes_in;
+    int64_t bytes_out;
+    int64_t bytes_allocated;
+
+    reader_stats();
+    void clear();
+    void merge(const reader_stats& other);
+    uint64_t total_cycles() const;
+    std::string to_json() const;
+};
+
+const char* stage_name(stage s);
+
+#ifdef PTOA_INSTRUMENT
+inline uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * Attributes the cycles between two consecutive calls of lap to the stage passed to the second one, which takes a single
+ * counter read per stage boundary.
+ */
+class stage_clock {
+  public:
+    stage_clock() : last(read_cycles()) {}
+
+    inline void lap(reader_stats* stats, stage s) {
+        uint64_t now = read_cycles();
+        stats->cycles[s] += now - last;
+        last = now;
+    }
+
+  private:
+    uint64_t last;
+};
+#endif
+
+}
@@ -2,4 +2,8 @@
 
 void fastunpack(const uint *  __restrict__ in, uint *  __restrict__  out, const uint bit);
 void int64fastunpack(const uint64_t *  __restrict__ in, uint64_t *  __restrict__  out, const uint bit);
-void fastpack(const uint *  __restrict__ in, uint *  __restrict__  out, const uint bit);
\ No newline at end of file
+void fastpack(const uint *  __restrict__ in, uint *  __restrict__  out, const uint bit);
+
+// Unpack one miniblock of 32 values, picking the unpacker that matches the output width
+inline void unpack_miniblock(const uint8_t* in, uint32_t* out, uint8_t bit) { fastunpack((const uint*) in, out, bit); }
+inline void unpack_miniblock(const uint8_t* in, uint64_t* out, uint8_t bit) { int64fastunpack((const uint64_t*) in, out, bit); }
\ No newline at end of file
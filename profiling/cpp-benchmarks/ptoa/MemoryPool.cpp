@@ -0,0 +1,224 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <algorithm>
+
+#include <sys/mman.h>
+
+#include <MemoryPool.h>
+#include <ptoa.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+namespace ptoa {
+
+// Arrow hands out this area for zero sized allocations as well, it is never written to
+alignas(64) static uint8_t zero_size_area[1];
+
+MemoryPool::MemoryPool(page_backing backing, bool prefault) : backing(backing), prefault(prefault),
+    free_lists((MAX_CLASS_SHIFT-MIN_CLASS_SHIFT)*CLASSES_PER_SHIFT+1),
+    bytes_allocated_(0), max_memory_(0), bytes_reserved_(0), os_allocations_(0) {
+}
+
+MemoryPool::~MemoryPool() {
+    release_unused();
+}
+
+arrow::Status MemoryPool::Allocate(int64_t size, uint8_t** out) {
+    if(size == 0){
+        *out = zero_size_area;
+        return arrow::Status::OK();
+    }
+
+    int c = size_class(size);
+    if(c < 0){
+        return arrow::Status::OutOfMemory("Allocation size exceeds largest size class");
+    }
+
+    uint8_t* region = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(free_list_mutex);
+        if(!free_lists[c].empty()){
+            region = free_lists[c].back();
+            free_lists[c].pop_back();
+        }
+    }
+
+    if(region == nullptr){
+        region = map_region(class_size(c));
+        if(region == nullptr){
+            return arrow::Status::OutOfMemory("mmap failed");
+        }
+    }
+
+    int64_t allocated = (bytes_allocated_ += size);
+    int64_t peak = max_memory_;
+    while(allocated > peak && !max_memory_.compare_exchange_weak(peak, allocated)){}
+
+    *out = region;
+    return arrow::Status::OK();
+}
+
+arrow::Status MemoryPool::Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) {
+    // Growing or shrinking within a size class keeps the region
+    if(old_size > 0 && new_size > 0 && size_class(old_size) == size_class(new_size)){
+        bytes_allocated_ += new_size-old_size;
+        return arrow::Status::OK();
+    }
+
+    uint8_t* new_region;
+    arrow::Status status = Allocate(new_size, &new_region);
+    if(!status.ok()){
+        return status;
+    }
+
+    std::memcpy(new_region, *ptr, std::min(old_size, new_size));
+    Free(*ptr, old_size);
+    *ptr = new_region;
+
+    return arrow::Status::OK();
+}
+
+// Regions are not returned to the OS but kept for the next allocation in the same size class
+void MemoryPool::Free(uint8_t* buffer, int64_t size) {
+    if(buffer == zero_size_area){
+        return;
+    }
+
+    int c = size_class(size);
+    {
+        std::lock_guard<std::mutex> lock(free_list_mutex);
+        free_lists[c].push_back(buffer);
+    }
+
+    bytes_allocated_ -= size;
+}
+
+void MemoryPool::release_unused() {
+    std::lock_guard<std::mutex> lock(free_list_mutex);
+
+    for(size_t c=0; c<free_lists.size(); c++){
+        for(uint8_t* region : free_lists[c]){
+            unmap_region(region);
+        }
+        free_lists[c].clear();
+    }
+}
+
+// Smallest size class that fits size, or -1 if size is too large. Every power of two is split into CLASSES_PER_SHIFT
+// classes so no more than 25% of a region is wasted.
+int MemoryPool::size_class(int64_t size) {
+    if(size <= (1LL << MIN_CLASS_SHIFT)){
+        return 0;
+    }
+
+    int shift = 63 - __builtin_clzll(size-1);
+    int64_t step = 1LL << (shift-2);
+    int sub_class = (size - (1LL << shift) + step - 1)/step;
+    int c = (shift-MIN_CLASS_SHIFT)*CLASSES_PER_SHIFT + sub_class;
+
+    if(c >= (int)free_lists.size()){
+        return -1;
+    }
+
+    return c;
+}
+
+int64_t MemoryPool::class_size(int size_class) {
+    int shift = MIN_CLASS_SHIFT + size_class/CLASSES_PER_SHIFT;
+    int sub_class = size_class%CLASSES_PER_SHIFT;
+
+    return (1LL << shift) + sub_class*(1LL << (shift-2));
+}
+
+uint8_t* MemoryPool::map_region(int64_t size) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    int64_t huge_page_size = 0;
+    void* region = MAP_FAILED;
+
+    if(prefault){
+        flags |= MAP_POPULATE;
+    }
+
+    if(backing == page_backing::HUGE_PAGES_2MB){
+        huge_page_size = 1LL << 21;
+    } else if(backing == page_backing::HUGE_PAGES_1GB){
+        huge_page_size = 1LL << 30;
+    }
+
+    if(huge_page_size > 0){
+        int huge_flags = MAP_HUGETLB | (backing == page_backing::HUGE_PAGES_2MB ? MAP_HUGE_2MB : MAP_HUGE_1GB);
+        int64_t rounded_size = (size + huge_page_size - 1) & ~(huge_page_size - 1);
+
+        region = mmap(nullptr, rounded_size, PROT_READ | PROT_WRITE, flags | huge_flags, -1, 0);
+
+        if(region != MAP_FAILED){
+            size = rounded_size;
+        }
+    }
+
+    // Fall back to regular pages if no huge pages are reserved on the system, but still ask for transparent huge pages.
+    // These have to be requested before the region is faulted in.
+    if(region == MAP_FAILED){
+        if(huge_page_size > 0){
+            region = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags & ~MAP_POPULATE, -1, 0);
+
+            if(region == MAP_FAILED){
+                return nullptr;
+            }
+
+            madvise(region, size, MADV_HUGEPAGE);
+
+            if(prefault){
+                for(int64_t offset=0; offset<size; offset+=4096){
+                    ((volatile uint8_t*) region)[offset] = 0;
+                }
+            }
+        } else {
+            region = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+
+            if(region == MAP_FAILED){
+                return nullptr;
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(free_list_mutex);
+        mapped_sizes[(uint8_t*) region] = size;
+    }
+
+    bytes_reserved_ += size;
+    os_allocations_++;
+
+    return (uint8_t*) region;
+}
+
+// Caller must hold free_list_mutex
+void MemoryPool::unmap_region(uint8_t* region) {
+    auto it = mapped_sizes.find(region);
+
+    munmap(region, it->second);
+    bytes_reserved_ -= it->second;
+    mapped_sizes.erase(it);
+}
+
+}
@@ -0,0 +1,77 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <arrow/api.h>
+
+#include <ptoa.h>
+
+// Size classes: 4 classes per power of two from 2^MIN_CLASS_SHIFT up to 2^MAX_CLASS_SHIFT bytes
+#define MIN_CLASS_SHIFT 12
+#define MAX_CLASS_SHIFT 40
+#define CLASSES_PER_SHIFT 4
+
+namespace ptoa{
+
+/**
+ * Arrow memory pool that hands out mmapped regions from size classes and keeps regions released by consumers on a free
+ * list instead of returning them to the OS. Once every size class used by a workload has been populated, repeated reads
+ * are served from the free lists without any page faults or system calls.
+ * Regions can optionally be backed by 2MB or 1GB huge pages and be pre-faulted on allocation.
+ */
+class MemoryPool : public arrow::MemoryPool {
+  public:
+    MemoryPool(page_backing backing = page_backing::REGULAR_PAGES, bool prefault = false);
+    ~MemoryPool() override;
+
+    arrow::Status Allocate(int64_t size, uint8_t** out) override;
+    arrow::Status Reallocate(int64_t old_size, int64_t new_size, uint8_t** ptr) override;
+    void Free(uint8_t* buffer, int64_t size) override;
+
+    int64_t bytes_allocated() const override {return bytes_allocated_;}
+    int64_t max_memory() const override {return max_memory_;}
+
+    // Bytes currently mapped from the OS, including regions on the free lists
+    int64_t bytes_reserved() const {return bytes_reserved_;}
+    // Amount of times memory was requested from the OS
+    int64_t os_allocations() const {return os_allocations_;}
+
+    // Return all regions on the free lists to the OS
+    void release_unused();
+
+  private:
+    int size_class(int64_t size);
+    int64_t class_size(int size_class);
+    uint8_t* map_region(int64_t size);
+    void unmap_region(uint8_t* region);
+
+    page_backing backing;
+    bool prefault;
+
+    std::mutex free_list_mutex;
+    std::vector<std::vector<uint8_t*>> free_lists;
+    // Size of every region mapped from the OS, huge page regions are rounded up to the huge page size
+    std::unordered_map<uint8_t*, int64_t> mapped_sizes;
+
+    std::atomic<int64_t> bytes_allocated_;
+    std::atomic<int64_t> max_memory_;
+    std::atomic<int64_t> bytes_reserved_;
+    std::atomic<int64_t> os_allocations_;
+};
+
+}
@@ -0,0 +1,121 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include <Numa.h>
+#include <ptoa.h>
+
+namespace ptoa {
+
+namespace {
+
+// Parse a kernel cpulist such as "0-7,16-23"
+std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+
+    while(std::getline(ss, range, ',')){
+        if(range.empty() || range == "\n"){
+            continue;
+        }
+
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash+1));
+
+        for(int cpu=first; cpu<=last; cpu++){
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+}
+
+status detect_numa_topology(numa_topology* topology) {
+    topology->node_ids.clear();
+    topology->node_cpus.clear();
+
+    DIR* node_dir = opendir("/sys/devices/system/node");
+
+    if(node_dir != nullptr){
+        struct dirent* entry;
+        std::vector<int> node_ids;
+
+        while((entry = readdir(node_dir)) != nullptr){
+            std::string name(entry->d_name);
+            if(name.compare(0, 4, "node") == 0 && name.size() > 4 && std::isdigit(name[4])){
+                node_ids.push_back(std::stoi(name.substr(4)));
+            }
+        }
+        closedir(node_dir);
+
+        std::sort(node_ids.begin(), node_ids.end());
+
+        for(int node_id : node_ids){
+            std::ifstream cpulist_file("/sys/devices/system/node/node" + std::to_string(node_id) + "/cpulist");
+            std::string cpulist;
+            std::getline(cpulist_file, cpulist);
+
+            std::vector<int> cpus = parse_cpu_list(cpulist);
+
+            // Memory only nodes can not run workers
+            if(!cpus.empty()){
+                topology->node_ids.push_back(node_id);
+                topology->node_cpus.push_back(cpus);
+            }
+        }
+    }
+
+    if(topology->node_ids.empty()){
+        std::vector<int> cpus;
+        long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        for(int cpu=0; cpu<num_cpus; cpu++){
+            cpus.push_back(cpu);
+        }
+
+        topology->node_ids.push_back(0);
+        topology->node_cpus.push_back(cpus);
+    }
+
+    return status::OK;
+}
+
+status pin_thread_to_cpus(const std::vector<int>& cpus) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+
+    for(int cpu : cpus){
+        CPU_SET(cpu, &cpu_set);
+    }
+
+    if(sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0){
+        std::cerr << "[WARNING] Could not pin thread to its NUMA node" << std::endl;
+        return status::FAIL;
+    }
+
+    return status::OK;
+}
+
+}
@@ -0,0 +1,37 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <vector>
+
+#include <ptoa.h>
+
+namespace ptoa{
+
+/**
+ * NUMA topology as exposed by the kernel in /sys/devices/system/node. Systems without that directory (or with
+ * NUMA disabled) are reported as a single node containing every online CPU.
+ */
+struct numa_topology {
+    std::vector<int> node_ids;
+    std::vector<std::vector<int>> node_cpus;
+
+    int num_nodes() const {return node_ids.size();}
+};
+
+status detect_numa_topology(numa_topology* topology);
+
+// Restrict the calling thread to the given CPUs
+status pin_thread_to_cpus(const std::vector<int>& cpus);
+
+}
@@ -0,0 +1,442 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <PageHeader.h>
+#include <Varint.h>
+#include <ptoa.h>
+
+// Highest field id of the decoded structures, fields with higher ids are skipped
+#define MAX_FIELD_ID 8
+// Nesting depth up to which unknown structures, lists and maps are skipped
+#define MAX_SKIP_DEPTH 16
+// Bytes the fast path may read: 11 fields of at most 1+6 bytes, the struct header, is_compressed and two stop fields
+#define FAST_PATH_MAX_BYTES 80
+
+namespace ptoa {
+
+namespace {
+
+// Types of the Thrift compact protocol. Booleans in structures have their value encoded in the type.
+enum compact_type : uint8_t {
+    CT_STOP = 0,
+    CT_BOOLEAN_TRUE = 1,
+    CT_BOOLEAN_FALSE = 2,
+    CT_BYTE = 3,
+    CT_I16 = 4,
+    CT_I32 = 5,
+    CT_I64 = 6,
+    CT_DOUBLE = 7,
+    CT_BINARY = 8,
+    CT_LIST = 9,
+    CT_SET = 10,
+    CT_MAP = 11,
+    CT_STRUCT = 12
+};
+
+// Structures of the page header that are decoded, all other structures (e.g. Statistics) are skipped
+enum header_struct : uint8_t {
+    PAGE_HEADER,
+    DATA_PAGE_HEADER,
+    DICTIONARY_PAGE_HEADER,
+    DATA_PAGE_HEADER_V2,
+    NUM_HEADER_STRUCTS
+};
+
+// Destinations of decoded fields
+enum header_slot : uint8_t {
+    SLOT_TYPE,
+    SLOT_UNCOMPRESSED_SIZE,
+    SLOT_COMPRESSED_SIZE,
+    SLOT_NUM_VALUES,
+    SLOT_NUM_NULLS,
+    SLOT_NUM_ROWS,
+    SLOT_ENCODING,
+    SLOT_DEF_LEVEL_LENGTH,
+    SLOT_REP_LEVEL_LENGTH,
+    SLOT_IS_COMPRESSED,
+    NUM_SLOTS
+};
+
+enum field_action : uint8_t {
+    SKIP,
+    STORE_I32,
+    STORE_BOOL,
+    DECODE_STRUCT
+};
+
+// What to do with a field of a structure. target is a header_slot for STORE_* and a header_struct for DECODE_STRUCT.
+struct field_rule {
+    field_action action;
+    uint8_t target;
+};
+
+#define SLOT_BIT(slot) (1u << (slot))
+
+const field_rule FIELD_RULES[NUM_HEADER_STRUCTS][MAX_FIELD_ID+1] = {
+    // PageHeader: type, uncompressed_page_size, compressed_page_size, crc, data_page_header, index_page_header,
+    // dictionary_page_header, data_page_header_v2
+    {{SKIP, 0}, {STORE_I32, SLOT_TYPE}, {STORE_I32, SLOT_UNCOMPRESSED_SIZE}, {STORE_I32, SLOT_COMPRESSED_SIZE},
+     {SKIP, 0}, {DECODE_STRUCT, DATA_PAGE_HEADER}, {SKIP, 0}, {DECODE_STRUCT, DICTIONARY_PAGE_HEADER},
+     {DECODE_STRUCT, DATA_PAGE_HEADER_V2}},
+    // DataPageHeader: num_values, encoding, definition_level_encoding, repetition_level_encoding, statistics
+    {{SKIP, 0}, {STORE_I32, SLOT_NUM_VALUES}, {STORE_I32, SLOT_ENCODING}, {SKIP, 0}, {SKIP, 0}, {SKIP, 0}, {SKIP, 0},
+     {SKIP, 0}, {SKIP, 0}},
+    // DictionaryPageHeader: num_values, encoding, is_sorted
+    {{SKIP, 0}, {STORE_I32, SLOT_NUM_VALUES}, {STORE_I32, SLOT_ENCODING}, {SKIP, 0}, {SKIP, 0}, {SKIP, 0}, {SKIP, 0},
+     {SKIP, 0}, {SKIP, 0}},
+    // DataPageHeaderV2: num_values, num_nulls, num_rows, encoding, definition_levels_byte_length,
+    // repetition_levels_byte_length, is_compressed, statistics
+    {{SKIP, 0}, {STORE_I32, SLOT_NUM_VALUES}, {STORE_I32, SLOT_NUM_NULLS}, {STORE_I32, SLOT_NUM_ROWS},
+     {STORE_I32, SLOT_ENCODING}, {STORE_I32, SLOT_DEF_LEVEL_LENGTH}, {STORE_I32, SLOT_REP_LEVEL_LENGTH},
+     {STORE_BOOL, SLOT_IS_COMPRESSED}, {SKIP, 0}}
+};
+
+// Sub-header and fields every page type needs, indexed by page_type
+const header_struct PAGE_SUB_HEADER[] = {DATA_PAGE_HEADER, NUM_HEADER_STRUCTS, DICTIONARY_PAGE_HEADER, DATA_PAGE_HEADER_V2};
+const uint32_t PAGE_REQUIRED_SLOTS[] = {
+    SLOT_BIT(SLOT_NUM_VALUES) | SLOT_BIT(SLOT_ENCODING),
+    0,
+    SLOT_BIT(SLOT_NUM_VALUES) | SLOT_BIT(SLOT_ENCODING),
+    SLOT_BIT(SLOT_NUM_VALUES) | SLOT_BIT(SLOT_NUM_NULLS) | SLOT_BIT(SLOT_NUM_ROWS) | SLOT_BIT(SLOT_ENCODING) |
+        SLOT_BIT(SLOT_DEF_LEVEL_LENGTH) | SLOT_BIT(SLOT_REP_LEVEL_LENGTH)
+};
+const uint32_t HEADER_REQUIRED_SLOTS = SLOT_BIT(SLOT_TYPE) | SLOT_BIT(SLOT_UNCOMPRESSED_SIZE) | SLOT_BIT(SLOT_COMPRESSED_SIZE);
+
+struct decode_state {
+    const uint8_t* limit;
+    int32_t slots[NUM_SLOTS];
+    uint32_t slots_present;
+    uint32_t structs_present;
+};
+
+const uint8_t* skip_value(const uint8_t* ptr, const uint8_t* limit, uint8_t type, int depth);
+
+// Elements of lists, sets and maps. Booleans take a byte here, unlike booleans in structures.
+const uint8_t* skip_element(const uint8_t* ptr, const uint8_t* limit, uint8_t type, int depth) {
+    if(type == CT_BOOLEAN_TRUE || type == CT_BOOLEAN_FALSE){
+        return ptr + 1;
+    }
+    return skip_value(ptr, limit, type, depth);
+}
+
+// Skip a value of the given type, returns nullptr if the value is malformed or does not end before limit
+const uint8_t* skip_value(const uint8_t* ptr, const uint8_t* limit, uint8_t type, int depth) {
+    if(depth > MAX_SKIP_DEPTH){
+        return nullptr;
+    }
+
+    switch(type){
+        case CT_BOOLEAN_TRUE:
+        case CT_BOOLEAN_FALSE:
+            return ptr;
+        case CT_BYTE:
+            return ptr + 1;
+        case CT_I16:
+        case CT_I32:
+        case CT_I64:
+            return ptr < limit ? ptr + skip_varint(ptr) : nullptr;
+        case CT_DOUBLE:
+            return ptr + 8;
+        case CT_BINARY: {
+            if(ptr >= limit){
+                return nullptr;
+            }
+            int64_t length;
+            ptr += decode_varint64(ptr, &length, false);
+            return length >= 0 && length <= limit - ptr ? ptr + length : nullptr;
+        }
+        case CT_LIST:
+        case CT_SET: {
+            if(ptr >= limit){
+                return nullptr;
+            }
+            int64_t size = *ptr >> 4;
+            uint8_t element_type = *ptr & 0x0F;
+            ptr++;
+
+            if(size == 15){
+                if(ptr >= limit){
+                    return nullptr;
+                }
+                ptr += decode_varint64(ptr, &size, false);
+            }
+
+            // Every element takes at least a byte, so size is bounded by the bytes left
+            for(int64_t i=0; i<size; i++){
+                if(ptr >= limit || (ptr = skip_element(ptr, limit, element_type, depth+1)) == nullptr){
+                    return nullptr;
+                }
+            }
+            return ptr;
+        }
+        case CT_MAP: {
+            if(ptr >= limit){
+                return nullptr;
+            }
+            int64_t size;
+            ptr += decode_varint64(ptr, &size, false);
+
+            if(size == 0){
+                return ptr;
+            }
+            if(ptr >= limit){
+                return nullptr;
+            }
+            uint8_t key_type = *ptr >> 4;
+            uint8_t value_type = *ptr & 0x0F;
+            ptr++;
+
+            for(int64_t i=0; i<size; i++){
+                if(ptr >= limit || (ptr = skip_element(ptr, limit, key_type, depth+1)) == nullptr){
+                    return nullptr;
+                }
+                if(ptr >= limit || (ptr = skip_element(ptr, limit, value_type, depth+1)) == nullptr){
+                    return nullptr;
+                }
+            }
+            return ptr;
+        }
+        case CT_STRUCT:
+            while(true){
+                if(ptr >= limit){
+                    return nullptr;
+                }
+
+                uint8_t field_header = *ptr++;
+                if(field_header == CT_STOP){
+                    return ptr;
+                }
+
+                // Long form field header, the field id follows as a varint
+                if((field_header >> 4) == 0){
+                    if(ptr >= limit){
+                        return nullptr;
+                    }
+                    ptr += skip_varint(ptr);
+                }
+
+                if((ptr = skip_value(ptr, limit, field_header & 0x0F, depth+1)) == nullptr){
+                    return nullptr;
+                }
+            }
+        default:
+            return nullptr;
+    }
+}
+
+// Decode the fields of a structure of the page header following the rules of its table. Returns the position after the
+// stop field or nullptr on malformed input.
+const uint8_t* decode_struct(const uint8_t* ptr, header_struct structure, decode_state* state) {
+    const field_rule* rules = FIELD_RULES[structure];
+    int32_t field_id = 0;
+
+    while(true){
+        if(ptr >= state->limit){
+            return nullptr;
+        }
+
+        uint8_t field_header = *ptr++;
+        if(field_header == CT_STOP){
+            return ptr;
+        }
+
+        uint8_t type = field_header & 0x0F;
+        uint8_t delta = field_header >> 4;
+
+        if(delta != 0){
+            field_id += delta;
+        } else {
+            if(ptr >= state->limit){
+                return nullptr;
+            }
+            ptr += decode_varint32(ptr, &field_id, true);
+        }
+
+        field_rule rule = field_id >= 0 && field_id <= MAX_FIELD_ID ? rules[field_id] : field_rule{SKIP, 0};
+
+        switch(rule.action){
+            case STORE_I32:
+                if(type != CT_I32 || ptr >= state->limit){
+                    return nullptr;
+                }
+                ptr += decode_varint32(ptr, &state->slots[rule.target], true);
+                state->slots_present |= SLOT_BIT(rule.target);
+                break;
+            case STORE_BOOL:
+                if(type != CT_BOOLEAN_TRUE && type != CT_BOOLEAN_FALSE){
+                    return nullptr;
+                }
+                state->slots[rule.target] = type == CT_BOOLEAN_TRUE;
+                state->slots_present |= SLOT_BIT(rule.target);
+                break;
+            case DECODE_STRUCT:
+                if(type != CT_STRUCT || (ptr = decode_struct(ptr, (header_struct) rule.target, state)) == nullptr){
+                    return nullptr;
+                }
+                state->structs_present |= 1u << rule.target;
+                break;
+            default:
+                if((ptr = skip_value(ptr, state->limit, type, 0)) == nullptr){
+                    return nullptr;
+                }
+        }
+    }
+}
+
+// Headers of V2 data pages as written by parquet-mr: PageHeader fields 1-3, an optional crc and data_page_header_v2 with
+// fields 1-6 in order and an optional is_compressed, all in short form. Matched byte by byte without table lookups, any
+// other layout is left to decode_struct.
+bool decode_v2_fast(const uint8_t* input, decode_state* state, const uint8_t** end) {
+    const header_slot header_slots[] = {SLOT_TYPE, SLOT_UNCOMPRESSED_SIZE, SLOT_COMPRESSED_SIZE};
+    const header_slot v2_slots[] = {SLOT_NUM_VALUES, SLOT_NUM_NULLS, SLOT_NUM_ROWS, SLOT_ENCODING, SLOT_DEF_LEVEL_LENGTH,
+                                    SLOT_REP_LEVEL_LENGTH};
+    const uint8_t* ptr = input;
+
+    if(state->limit - input < FAST_PATH_MAX_BYTES){
+        return false;
+    }
+
+    for(header_slot slot : header_slots){
+        if(*ptr != (1 << 4 | CT_I32)){
+            return false;
+        }
+        ptr += 1 + decode_varint32(ptr + 1, &state->slots[slot], true);
+    }
+
+    if(state->slots[SLOT_TYPE] != page_type::DATA_PAGE_V2){
+        return false;
+    }
+
+    // Field 8 follows field 3 or the crc (field 4)
+    uint8_t v2_field_header = 5 << 4 | CT_STRUCT;
+    if(*ptr == (1 << 4 | CT_I32)){
+        int32_t crc;
+        ptr += 1 + decode_varint32(ptr + 1, &crc, true);
+        v2_field_header = 4 << 4 | CT_STRUCT;
+    }
+
+    if(*ptr != v2_field_header){
+        return false;
+    }
+    ptr++;
+
+    for(header_slot slot : v2_slots){
+        if(*ptr != (1 << 4 | CT_I32)){
+            return false;
+        }
+        ptr += 1 + decode_varint32(ptr + 1, &state->slots[slot], true);
+    }
+
+    if(*ptr == (1 << 4 | CT_BOOLEAN_TRUE) || *ptr == (1 << 4 | CT_BOOLEAN_FALSE)){
+        state->slots[SLOT_IS_COMPRESSED] = *ptr == (1 << 4 | CT_BOOLEAN_TRUE);
+        state->slots_present |= SLOT_BIT(SLOT_IS_COMPRESSED);
+        ptr++;
+    }
+
+    if(ptr[0] != CT_STOP || ptr[1] != CT_STOP){
+        return false;
+    }
+
+    state->slots_present |= HEADER_REQUIRED_SLOTS | PAGE_REQUIRED_SLOTS[page_type::DATA_PAGE_V2];
+    state->structs_present |= 1u << DATA_PAGE_HEADER_V2;
+    *end = ptr + 2;
+
+    return true;
+}
+
+}
+
+status decode_page_header(const uint8_t* input, const uint8_t* limit, page_header* header) {
+    decode_state state;
+    state.limit = limit;
+    state.slots_present = 0;
+    state.structs_present = 0;
+
+    const uint8_t* end;
+
+    if(!decode_v2_fast(input, &state, &end)){
+        state.slots_present = 0;
+        state.structs_present = 0;
+        end = decode_struct(input, PAGE_HEADER, &state);
+    }
+
+    if(end == nullptr || (state.slots_present & HEADER_REQUIRED_SLOTS) != HEADER_REQUIRED_SLOTS){
+        return status::FAIL;
+    }
+
+    int32_t type = state.slots[SLOT_TYPE];
+    if(type < page_type::DATA_PAGE || type > page_type::DATA_PAGE_V2){
+        return status::FAIL;
+    }
+
+    header_struct sub_header = PAGE_SUB_HEADER[type];
+    if(sub_header != NUM_HEADER_STRUCTS && !(state.structs_present & (1u << sub_header))){
+        return status::FAIL;
+    }
+    if((state.slots_present & PAGE_REQUIRED_SLOTS[type]) != PAGE_REQUIRED_SLOTS[type]){
+        return status::FAIL;
+    }
+
+    header->type = (page_type) type;
+    header->uncompressed_size = state.slots[SLOT_UNCOMPRESSED_SIZE];
+    header->compressed_size = state.slots[SLOT_COMPRESSED_SIZE];
+    header->num_values = 0;
+    header->num_nulls = 0;
+    header->parquet_encoding = 0;
+    header->def_level_length = 0;
+    header->rep_level_length = 0;
+    header->is_compressed = true;
+    header->header_size = end - input;
+
+    if(type != page_type::INDEX_PAGE){
+        header->num_values = state.slots[SLOT_NUM_VALUES];
+        header->parquet_encoding = state.slots[SLOT_ENCODING];
+    }
+    header->num_rows = header->num_values;
+
+    if(type == page_type::DATA_PAGE_V2){
+        header->num_nulls = state.slots[SLOT_NUM_NULLS];
+        header->num_rows = state.slots[SLOT_NUM_ROWS];
+        header->def_level_length = state.slots[SLOT_DEF_LEVEL_LENGTH];
+        header->rep_level_length = state.slots[SLOT_REP_LEVEL_LENGTH];
+
+        if(state.slots_present & SLOT_BIT(SLOT_IS_COMPRESSED)){
+            header->is_compressed = state.slots[SLOT_IS_COMPRESSED];
+        }
+    }
+
+    if(header->uncompressed_size < 0 || header->compressed_size < 0 || header->num_values < 0 || header->num_nulls < 0 ||
+       header->num_rows < 0 || header->def_level_length < 0 || header->rep_level_length < 0 ||
+       (int64_t) header->def_level_length + header->rep_level_length > header->compressed_size){
+        return status::FAIL;
+    }
+
+    return status::OK;
+}
+
+bool is_decodable(const page_header& header, encoding enc, bool without_levels) {
+    int32_t parquet_encoding = PARQUET_PLAIN;
+    if(enc == encoding::DELTA){
+        parquet_encoding = PARQUET_DELTA_BINARY_PACKED;
+    } else if(enc == encoding::DELTA_LENGTH){
+        parquet_encoding = PARQUET_DELTA_LENGTH_BYTE_ARRAY;
+    }
+
+    if(header.type == page_type::DATA_PAGE && !without_levels){
+        return false;
+    }
+
+    return header.compressed_size == header.uncompressed_size && header.parquet_encoding == parquet_encoding &&
+           header.def_level_length == 0 && header.rep_level_length == 0;
+}
+
+}
@@ -0,0 +1,64 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <ptoa.h>
+
+// Encoding enum values of the Parquet format
+#define PARQUET_PLAIN 0
+#define PARQUET_DELTA_BINARY_PACKED 5
+#define PARQUET_DELTA_LENGTH_BYTE_ARRAY 6
+
+namespace ptoa{
+
+/**
+ * Fields of a Parquet PageHeader. Only the sub-header that matches type is decoded: num_values and parquet_encoding are
+ * set for all page types except index pages, the other fields only for V2 data pages. For V1 data pages and dictionary
+ * pages num_nulls is 0, num_rows equals num_values and the level lengths are 0 (V1 pages store their levels as part of
+ * the page data). parquet_encoding is the Encoding enum value of the Parquet format. header_size is the size of the
+ * Thrift structure, the page data follows it.
+ */
+struct page_header {
+    page_type type;
+    int32_t uncompressed_size;
+    int32_t compressed_size;
+    int32_t num_values;
+    int32_t num_nulls;
+    int32_t num_rows;
+    int32_t parquet_encoding;
+    int32_t def_level_length;
+    int32_t rep_level_length;
+    bool is_compressed;
+    int32_t header_size;
+};
+
+/**
+ * Decode the Thrift compact protocol PageHeader at input. Fields are matched on id and type through a table per
+ * structure, fields that are not needed (crc, statistics, level encodings, ...) or unknown to this decoder are skipped.
+ * Fails on a type mismatch for a known field, on missing required fields and if the header does not end before limit,
+ * which makes it usable to detect the end of a list of pages. Reads up to VARINT_LOAD_BYTES-1 bytes past limit.
+ */
+status decode_page_header(const uint8_t* input, const uint8_t* limit, page_header* header);
+
+/**
+ * Whether the decoders of enc can decode the data page: its data has to be uncompressed, encoded with enc and may not
+ * start with levels. The codec of a page is only recorded in the footer, so a page counts as compressed if its compressed
+ * size differs from its uncompressed size, which holds for the output of every codec in practice. V2 pages record the
+ * length of their levels. V1 pages do not, whether they start with levels follows from the maximum levels of the column
+ * in the schema, so they are only decodable if without_levels states that both are 0.
+ */
+bool is_decodable(const page_header& header, encoding enc, bool without_levels);
+
+}
@@ -15,30 +15,206 @@
 #include <fstream>
 #include <cstring>
 #include <algorithm>
-#include <map>
 #include <bitset>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include <SWParquetReader.h>
+#include <PageHeader.h>
+#include <Varint.h>
 #include <ptoa.h>
 
 namespace ptoa {
 
-// Load Parquet file into memory
-SWParquetReader::SWParquetReader(std::string file_path) {
+namespace {
+
+// Size of the mapping of a memory mapped file, at least one zeroed page follows the end of the file
+size_t mapped_size(size_t file_size) {
+    return ((file_size + 4095) & ~(size_t) 4095) + 4096;
+}
+
+}
+
+// Load Parquet file into memory, or map it into memory with ingestion::MMAP
+SWParquetReader::SWParquetReader(std::string file_path, arrow::MemoryPool* pool, ingestion mode) : pool(pool),
+    ingestion_mode(mode), prefetch_distance(DEFAULT_PREFETCH_DISTANCE), max_definition_level(-1), max_repetition_level(-1),
+    direct_fd(-1), o_direct(false) {
+    if(ingestion_mode == ingestion::DIRECT){
+        parquet_data = nullptr;
+        o_direct = true;
+        direct_fd = open(file_path.c_str(), O_RDONLY | O_DIRECT);
+
+        // Some file systems (e.g. tmpfs) do not support O_DIRECT, the ring then drops what it read from the page cache
+        if(direct_fd < 0 && errno == EINVAL){
+            std::cerr << "[WARNING] O_DIRECT is not supported for " << file_path << ", using buffered reads without caching" << std::endl;
+            o_direct = false;
+            direct_fd = open(file_path.c_str(), O_RDONLY);
+        }
+
+        struct stat file_stat;
+
+        if(direct_fd >= 0 && fstat(direct_fd, &file_stat) == 0){
+            file_size = file_stat.st_size;
+            return;
+        }
+
+        if(direct_fd >= 0){
+            close(direct_fd);
+            direct_fd = -1;
+        }
+
+        std::cerr << "[WARNING] Could not open " << file_path << " for direct reading, falling back to buffered reading" << std::endl;
+        ingestion_mode = ingestion::BUFFERED;
+    }
+
+    if(ingestion_mode == ingestion::MMAP){
+        int fd = open(file_path.c_str(), O_RDONLY);
+        struct stat file_stat;
+
+        if(fd >= 0 && fstat(fd, &file_stat) == 0 && file_stat.st_size > 0){
+            file_size = file_stat.st_size;
+
+            // The file is mapped over a larger anonymous mapping, so the loads of the varint decoder past the end of
+            // the file hit zeroed memory instead of an unmapped page
+            void* reserved = mmap(nullptr, mapped_size(file_size), PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            void* mapping = MAP_FAILED;
+
+            if(reserved != MAP_FAILED){
+                mapping = mmap(reserved, file_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+            }
+
+            if(mapping != MAP_FAILED){
+                parquet_data = (uint8_t*) mapping;
+                close(fd);
+                return;
+            }
+
+            if(reserved != MAP_FAILED){
+                munmap(reserved, mapped_size(file_size));
+            }
+        }
+
+        if(fd >= 0){
+            close(fd);
+        }
+
+        std::cerr << "[WARNING] Could not map " << file_path << " into memory, falling back to buffered reading" << std::endl;
+        ingestion_mode = ingestion::BUFFERED;
+    }
+
+    if(ingestion_mode == ingestion::IO_URING){
+        int fd = open(file_path.c_str(), O_RDONLY);
+        struct stat file_stat;
+
+        if(fd >= 0 && fstat(fd, &file_stat) == 0){
+            file_size = file_stat.st_size;
+
+            // Rounded up and zeroed at the end, the bit unpacking kernels read whole words past the end of the data
+            int64_t buffer_size = ((file_size + 4095) & ~4095LL) + 4096;
+            void* buffer;
+
+            if(posix_memalign(&buffer, 4096, buffer_size) == 0){
+                parquet_data = (uint8_t*) buffer;
+                std::memset(parquet_data + file_size, 0, buffer_size - file_size);
+                async_ingestion.reset(new AsyncIngestion(fd, parquet_data, file_size));
+                return;
+            }
+        }
+
+        if(fd >= 0){
+            close(fd);
+        }
+
+        std::cerr << "[WARNING] Could not start asynchronous reading of " << file_path << ", falling back to buffered reading" << std::endl;
+        ingestion_mode = ingestion::BUFFERED;
+    }
+
     std::ifstream parquet_file(file_path, std::ios::binary);
     
     parquet_file.seekg(0, parquet_file.end);
-    file_size = parquet_file.tellg();
+    // tellg fails (-1) if the file could not be opened
+    file_size = std::max((std::streamoff) parquet_file.tellg(), (std::streamoff) 0);
     parquet_file.seekg(0, parquet_file.beg);
 
-    parquet_data = (uint8_t*) malloc(file_size);
+    // Zeroed at the end, the varint decoder loads whole words
+    parquet_data = (uint8_t*) malloc(file_size + VARINT_LOAD_BYTES);
     parquet_file.read((char*) parquet_data, file_size);
+    std::memset(parquet_data + file_size, 0, VARINT_LOAD_BYTES);
 
     parquet_file.close();
 
 }
 
+// parquet_data is never written once the file is in memory
+SWParquetReader::SWParquetReader(const uint8_t* data, size_t size, arrow::MemoryPool* pool) : parquet_data((uint8_t*) data),
+    file_size(size), pool(pool), ingestion_mode(ingestion::MEMORY), prefetch_distance(DEFAULT_PREFETCH_DISTANCE),
+    max_definition_level(-1), max_repetition_level(-1), direct_fd(-1), o_direct(false) {
+}
+
+SWParquetReader::~SWParquetReader() {
+    // Stop writing into parquet_data before it is freed
+    async_ingestion.reset();
+
+    if(ingestion_mode == ingestion::MMAP){
+        munmap(parquet_data, mapped_size(file_size));
+    } else if(ingestion_mode == ingestion::DIRECT){
+        close(direct_fd);
+    } else if(ingestion_mode != ingestion::MEMORY){
+        free(parquet_data);
+    }
+}
+
+status SWParquetReader::wait_ingested() {
+    if(ingestion_mode == ingestion::DIRECT){
+        std::cerr << "[ERROR] Operation not supported with ingestion::DIRECT" << std::endl;
+        return status::FAIL;
+    }
+
+    return wait_resident(parquet_data, file_size);
+}
+
+// Block until length bytes starting at ptr have been read from the file. Pointers outside of parquet_data (e.g. into
+// replicated input) are always resident.
+status SWParquetReader::wait_resident(const uint8_t* ptr, int64_t length) {
+    if(async_ingestion == nullptr || !points_into_file(ptr)){
+        return status::OK;
+    }
+
+    return async_ingestion->wait_resident(std::min((int64_t) (ptr - parquet_data) + length, (int64_t) file_size));
+}
+
+bool SWParquetReader::is_resident(const uint8_t* ptr, int64_t length) {
+    if(async_ingestion == nullptr || !points_into_file(ptr)){
+        return true;
+    }
+
+    return async_ingestion->is_resident(std::min((int64_t) (ptr - parquet_data) + length, (int64_t) file_size));
+}
+
+reader_stats SWParquetReader::get_stats() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return stats;
+}
+
+void SWParquetReader::reset_stats() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    stats.clear();
+}
+
+void SWParquetReader::record_stats(const reader_stats& local) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    stats.merge(local);
+}
+
 status SWParquetReader::read_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc) {
+    if(ingestion_mode == ingestion::DIRECT){
+        return read_prim_direct(prim_width, num_values, file_offset, prim_array, nullptr, enc);
+    }
+
     if(enc == encoding::PLAIN){
         return read_prim_plain(prim_width, num_values, file_offset, prim_array);
     } else if((enc == encoding::DELTA) && (prim_width == 32)){
@@ -52,6 +228,10 @@ status SWParquetReader::read_prim(int32_t prim_width, int64_t num_values, int32_
 }
 
 status SWParquetReader::read_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc) {
+    if(ingestion_mode == ingestion::DIRECT){
+        return read_prim_direct(prim_width, num_values, file_offset, prim_array, arr_buffer, enc);
+    }
+
     if(enc == encoding::PLAIN){
         return read_prim_plain(prim_width, num_values, file_offset, prim_array, arr_buffer);
     } else if((enc == encoding::DELTA) && (prim_width == 32)){
@@ -65,6 +245,11 @@ status SWParquetReader::read_prim(int32_t prim_width, int64_t num_values, int32_
 }
 
 status SWParquetReader::read_string(int64_t num_strings, int64_t num_chars, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, encoding enc) {
+    if(ingestion_mode == ingestion::DIRECT){
+        std::cerr << "[ERROR] Reading strings is not supported with ingestion::DIRECT" << std::endl;
+        return status::FAIL;
+    }
+
     if(enc == encoding::DELTA_LENGTH){
         return read_string_delta_length(num_strings, num_chars, file_offset, string_array);
     } else{
@@ -73,6 +258,11 @@ status SWParquetReader::read_string(int64_t num_strings, int64_t num_chars, int3
     }
 }
 status SWParquetReader::read_string(int64_t num_strings, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer, encoding enc) {
+    if(ingestion_mode == ingestion::DIRECT){
+        std::cerr << "[ERROR] Reading strings is not supported with ingestion::DIRECT" << std::endl;
+        return status::FAIL;
+    }
+
     if(enc == encoding::DELTA_LENGTH){
         return read_string_delta_length(num_strings, file_offset, string_array, off_buffer, val_buffer);
     } else{
@@ -85,40 +275,20 @@ status SWParquetReader::read_string(int64_t num_strings, int32_t file_offset, st
 // Read a number (set by num_values) of either 32 or 64 bit integers (set by prim_width) into prim_array.
 // File_offset is the byte offset in the Parquet file where the first in a contiguous list of Parquet pages is located.
 status SWParquetReader::read_prim_plain(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array) {
-    uint8_t* page_ptr = parquet_data;
-    std::shared_ptr<arrow::Buffer> arr_buffer;
-    arrow::AllocateBuffer(num_values*prim_width/8, &arr_buffer);
-    uint8_t* arr_buf_ptr = arr_buffer->mutable_data();
+    PTOA_INSTRUMENTED(reader_stats local_stats; stage_clock clock;)
 
-    int64_t total_value_counter = 0;
-
-    // Metadata reading variables
-    int32_t uncompressed_size;
-    int32_t compressed_size;
-    int32_t page_num_values;
-    int32_t def_level_length;
-    int32_t rep_level_length;
-    int32_t metadata_size;
-
-    page_ptr += file_offset;
-
-    // Copy values from Parquet pages until max amount of values is reached
-    while(total_value_counter < num_values){
-        if(read_metadata(page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
-            std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
-            std::cerr << page_ptr-parquet_data << std::endl;
-            return status::FAIL;
-        }
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+    arrow::AllocateBuffer(pool, num_values*prim_width/8, &arr_buffer);
 
-        page_ptr += metadata_size;
-    
-        std::memcpy((void*) arr_buf_ptr, (const void*) page_ptr, std::min((int64_t) compressed_size, (num_values-total_value_counter)*prim_width/8));
-    
-        page_ptr += compressed_size;
-        arr_buf_ptr += compressed_size;
-        total_value_counter += page_num_values;
+    PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_ALLOCATION); local_stats.bytes_allocated += num_values*prim_width/8; record_stats(local_stats);)
 
+    return read_prim_plain(prim_width, num_values, file_offset, prim_array, arr_buffer);
+}
 
+// Same as read_prim but with a pre-allocated buffer
+status SWParquetReader::read_prim_plain(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer) {
+    if(decode_prim_plain(parquet_data + file_offset, prim_width, num_values, arr_buffer->mutable_data()) != status::OK){
+        return status::FAIL;
     }
 
     if(prim_width == 64){
@@ -133,10 +303,9 @@ status SWParquetReader::read_prim_plain(int32_t prim_width, int64_t num_values,
 
 }
 
-// Same as read_prim but with a pre-allocated buffer
-status SWParquetReader::read_prim_plain(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer) {
-    uint8_t* page_ptr = parquet_data;
-    uint8_t* arr_buf_ptr = arr_buffer->mutable_data();
+// Copy num_values plain encoded values from the contiguous list of Parquet pages starting at page_ptr into arr_buf_ptr.
+status SWParquetReader::decode_prim_plain(const uint8_t* page_ptr, int32_t prim_width, int64_t num_values, uint8_t* arr_buf_ptr) {
+    const uint8_t* start_ptr = page_ptr;
 
     int64_t total_value_counter = 0;
 
@@ -148,321 +317,183 @@ status SWParquetReader::read_prim_plain(int32_t prim_width, int64_t num_values,
     int32_t rep_level_length;
     int32_t metadata_size;
 
-    page_ptr += file_offset;
+    PTOA_INSTRUMENTED(reader_stats local_stats; stage_clock clock;)
+
+    prefetch_cursor prefetch;
+    prefetch_start(&prefetch, page_ptr, num_values, encoding::PLAIN);
 
     // Copy values from Parquet pages until max amount of values is reached
     while(total_value_counter < num_values){
-        if(read_metadata(page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
+        // Pages may still be arriving with ingestion::IO_URING
+        if(next_metadata(&prefetch, page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
             std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
-            std::cerr << page_ptr-parquet_data << std::endl;
+            std::cerr << page_ptr-start_ptr << std::endl;
+            return status::FAIL;
+        }
+        if(wait_resident(page_ptr, metadata_size + compressed_size) != status::OK){
             return status::FAIL;
         }
 
         page_ptr += metadata_size;
-    
-        std::memcpy((void*) arr_buf_ptr, (const void*) page_ptr, std::min((int64_t) compressed_size, (num_values-total_value_counter)*prim_width/8));
+
+        PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_PAGE_HEADER); local_stats.pages++; local_stats.bytes_in += metadata_size + compressed_size;)
+
+        int64_t copy_size = std::min((int64_t) compressed_size, (num_values-total_value_counter)*prim_width/8);
+        std::memcpy((void*) arr_buf_ptr, (const void*) page_ptr, copy_size);
+
+        PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_PLAIN_COPY); local_stats.bytes_out += copy_size;)
     
         page_ptr += compressed_size;
         arr_buf_ptr += compressed_size;
         total_value_counter += page_num_values;
 
+        prefetch_next(&prefetch);
 
-    }
 
-    if(prim_width == 64){
-        *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int64(), num_values, arr_buffer);
-    } else if (prim_width == 32) {
-        *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int32(), num_values, arr_buffer);
-    } else {
-        std::cerr << "[ERROR] Unsupported prim width " << prim_width << std::endl;
     }
 
+    PTOA_INSTRUMENTED(record_stats(local_stats);)
+
     return status::OK;
 
 }
 
-// Count pages and provide information about their sizes starting with the page at file_offset
+// Count pages and provide information about their sizes starting with the page at file_offset. The inspect benchmark
+// reports the details of every page.
 status SWParquetReader::count_pages(int32_t file_offset) {
-    uint8_t* page_ptr = parquet_data;
-
-    // Metadata reading variables
-    int32_t uncompressed_size;
-    int32_t compressed_size;
-    int32_t page_num_values;
-    int32_t def_level_length;
-    int32_t rep_level_length;
-    int32_t metadata_size;
-
-    page_ptr += file_offset;
-
-    int32_t page_ctr = 0;
-    int32_t column_chunk_size = 0;
-    std::map<int32_t, int32_t> size_map;
-    std::map<int32_t, int32_t> value_map;
-
-    // Read Parquet pages until either the end of the file is reached or a non PageHeader Thrift structure.
-    while((uint64_t)(page_ptr-parquet_data) < file_size){
-        if(read_metadata(page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
-            break;
-        }
+    inspect_options options;
+    options.end_offset = -1;
+    options.byte_array = false;
+    options.compressed = false;
+    options.max_definition_level = 0;
+    options.max_repetition_level = 0;
+    options.headers_only = true;
+    options.num_threads = 1;
+
+    std::vector<page_stats> pages;
+    if(inspect_pages(file_offset, options, &pages) != status::OK){
+        return status::FAIL;
+    }
 
-        page_ptr += metadata_size;    
-        page_ptr += compressed_size;
+    int64_t page_ctr = 0;
+    int64_t total_page_size = 0;
+    int64_t column_chunk_size = 0;
 
-        page_ctr++;
-        auto size_it = size_map.find(compressed_size);
-        if(size_it != size_map.end()) {
-            size_it->second++;
-        } else {
-            size_map.insert(std::make_pair(compressed_size, 1));
+    // Dictionary and index pages count towards the column chunk only, like read_metadata skips them
+    for(const page_stats& page : pages){
+        if(page.type == page_type::DATA_PAGE || page.type == page_type::DATA_PAGE_V2){
+            page_ctr++;
+            total_page_size += page.compressed_size;
         }
-
-        auto value_it = value_map.find(page_num_values);
-        if(value_it != value_map.end()) {
-            value_it->second++;
-        } else {
-            value_map.insert(std::make_pair(page_num_values, 1));
-        }
-
-        column_chunk_size += metadata_size + compressed_size;
+        column_chunk_size += page.header_size + page.compressed_size;
     }
 
-    //std::cout << "Page sizes: " << std::endl;
-    int total_page_size = 0;
-    for(auto it = size_map.begin(); it != size_map.end(); it++){
-        //std::cout << "    Size " << it->first << ": " << it->second <<std::endl;
-        total_page_size += ((it->first)*(it->second));
-    } 
     std::cout << "Amount of pages in file   : " << page_ctr << std::endl;
-    std::cout << "Average page size in file : " << total_page_size/page_ctr << std::endl;
+    std::cout << "Average page size in file : " << (page_ctr > 0 ? total_page_size/page_ctr : 0) << std::endl;
     std::cout << "Total size of column chunk: " << column_chunk_size << std::endl;
 
-    //std::cout << "Number of values per page: " << std::endl;
-    //for(auto it = value_map.begin(); it != value_map.end(); it++){
-    //    std::cout << "    " << it->first << ": " << it->second <<std::endl;
-    //}
-    //std::cout << std::endl;
-
     return status::OK;
 
 }
 
-// Decodes variable length integer pointed to by input and stores it in decoded_int. Returns length of variable length integer in bytes.
-int SWParquetReader::decode_varint32(const uint8_t* input, int32_t* decoded_int, bool zigzag) {
-    int32_t result = 0;
-    int i;
-
-    for (i = 0; i < 5; i++) {
-        result |= (input[i] & 127) << (7 * i);
-
-        if(!(input[i] & 128)) {
-            break;
-        }
-    }
-
-    if(zigzag) {
-        result = ((result >> 1) & 0x7FFFFFFF) ^ (-(result & 1));
-    }
-
-    *decoded_int = result;
-
-    return i+1;
-}
-
-// Decodes variable length integer pointed to by input and stores it in decoded_int. Returns length of variable length integer in bytes.
-int SWParquetReader::decode_varint64(const uint8_t* input, int64_t* decoded_int, bool zigzag) {
-    int64_t result = 0;
-    int i;
-    for (i = 0; i < 10; i++) {
-        result |= (input[i] & 127ULL) << (7 * i);
-
-        if(!(input[i] & 128)) {
-            break;
-        }
-    }
-
-    if(zigzag) {
-        result = ((result >> 1) & 0x7FFFFFFFFFFFFFFF) ^ (-(result & 1ULL));
+status SWParquetReader::inspect_metadata(int32_t file_offset) {
+    if(wait_ingested() != status::OK){
+        return status::FAIL;
     }
 
-    *decoded_int = result;
-
-    return i+1;
-}
+    const char* page_type_names[] = {"DATA_PAGE", "INDEX_PAGE", "DICTIONARY_PAGE", "DATA_PAGE_V2"};
+    page_header header;
 
-status SWParquetReader::inspect_metadata(int32_t file_offset) {
-    // Metadata reading variables
-    int32_t uncompressed_size;
-    int32_t compressed_size;
-    int32_t page_num_values;
-    int32_t def_level_length;
-    int32_t rep_level_length;
-    int32_t metadata_size;
-
-    if(read_metadata(parquet_data + file_offset, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
+    if(file_offset < 0 || (size_t) file_offset >= file_size ||
+       decode_page_header(parquet_data + file_offset, parquet_data + std::min(file_size, (size_t) file_offset + PAGE_HEADER_MAX_BYTES), &header) != status::OK) {
         std::cerr << "[ERROR] Page header at file offset " << file_offset << " corrupted or missing." << std::endl;
         return status::FAIL;
     }
 
     std::cout << "Page header fields at file offset " << file_offset << ":" << std::endl;
-    std::cout << "    Uncompressed size: " << uncompressed_size << std::endl;
-    std::cout << "    Compressed size: " << compressed_size << std::endl;
-    std::cout << "    Page num values: " << page_num_values << std::endl;
-    std::cout << "    Def level length: " << def_level_length << std::endl;
-    std::cout << "    rep_level_length: " << rep_level_length << std::endl;
-    std::cout << "    metadata_size: " << metadata_size << std::endl;
+    std::cout << "    Page type: " << page_type_names[header.type] << std::endl;
+    std::cout << "    Uncompressed size: " << header.uncompressed_size << std::endl;
+    std::cout << "    Compressed size: " << header.compressed_size << std::endl;
+    std::cout << "    Page num values: " << header.num_values << std::endl;
+    std::cout << "    Num nulls: " << header.num_nulls << std::endl;
+    std::cout << "    Num rows: " << header.num_rows << std::endl;
+    std::cout << "    Encoding: " << header.parquet_encoding << std::endl;
+    std::cout << "    Def level length: " << header.def_level_length << std::endl;
+    std::cout << "    rep_level_length: " << header.rep_level_length << std::endl;
+    std::cout << "    Is compressed: " << header.is_compressed << std::endl;
+    std::cout << "    metadata_size: " << header.header_size << std::endl;
     std::cout << std::endl;
     
     return status::OK;
 }
 
-// Read all relevant fields from the Parquet page header pointed to by uint8_t* metadata.
-status SWParquetReader::read_metadata(const uint8_t* metadata, int32_t* uncompressed_size, int32_t* compressed_size, int32_t* num_values, 
+// Read all relevant fields from the header of the Parquet data page pointed to by uint8_t* metadata. Dictionary and
+// index pages in front of the data page hold no values of the column; they are skipped and counted as part of the
+// metadata of the data page. Fails if the data page cannot be decoded as enc, i.e. if it is compressed, uses another
+// encoding (e.g. a dictionary) or starts with levels. V1 data pages store their levels as part of the page data, so they
+// are only decoded once set_max_levels stated that the column has none.
+status SWParquetReader::read_metadata(const uint8_t* metadata, encoding enc, int32_t* uncompressed_size, int32_t* compressed_size, int32_t* num_values, 
                                       int32_t* def_level_length, int32_t* rep_level_length, int32_t* metadata_size) {
 
-    const uint8_t* current_byte = metadata;
-
-    // PageType
-    if(*current_byte != 0x15){
-        //std::cerr<<"PageType error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
-    }
-
-    current_byte++;
-
-    //Uncompressed page size
-    if(*current_byte != 0x15){
-        //std::cerr<<"uncompressed_size error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    current_byte += decode_varint32(current_byte, uncompressed_size, true);
-
-    //Compressed page size
-    if(*current_byte != 0x15){
-        //std::cerr<<"compressed_size error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    current_byte += decode_varint32(current_byte, compressed_size, true);
-
-    //CRC
-    int data_page_v2_field_header = 0x5c;
-
-    if(*current_byte == 0x15){
-        current_byte++;
-
-        while((*current_byte & 0x80) != 0 ){
-           current_byte++;
-        };
-
-        current_byte++;
-        data_page_v2_field_header = 0x4c;
-    }
-
-    //DataPageHeaderV2
-    if(*current_byte != data_page_v2_field_header){
-        //std::cerr<<"datapagev2 error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    //Num values
-    if(*current_byte != 0x15){
-        //std::cerr<<"numval error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    current_byte += decode_varint32(current_byte, num_values, true);
-
-    //Num nulls
-    if(*current_byte != 0x15){
-        //std::cerr<<"num_null error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
-    }
-
-    current_byte++;
+    const uint8_t* page_ptr = metadata;
+    page_header header;
 
-    //Num rows
-    if(*current_byte != 0x15){
-        //std::cerr<<"numrow error"<<std::endl;
-        return status::FAIL;
-    }
-
-    current_byte++;
-
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
-    }
+    // Headers in the file may not extend past its end, copies of pages (replicas, O_DIRECT buffers) are padded
+    bool in_file = points_into_file(metadata);
 
-    current_byte++;
+    while(true){
+        if(read_page_header(page_ptr, in_file, &header) != status::OK){
+            return status::FAIL;
+        }
 
-    //Encoding
-    if(*current_byte != 0x15){
-        //std::cerr<<"enc error"<<std::endl;
-        return status::FAIL;
-    }
+        if(header.type == page_type::DATA_PAGE || header.type == page_type::DATA_PAGE_V2){
+            break;
+        }
 
-    current_byte++;
+        page_ptr += header.header_size + header.compressed_size;
 
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
+        if(wait_resident(page_ptr, PAGE_HEADER_MAX_BYTES) != status::OK){
+            return status::FAIL;
+        }
     }
 
-    current_byte++;
-
-    //Def level byte length
-    if(*current_byte != 0x15){
-        //std::cerr<<"def_level_length error"<<std::endl;
+    if(!is_decodable(header, enc, without_levels())){
+        if(header.compressed_size != header.uncompressed_size){
+            std::cerr << "[ERROR] Compressed data pages are not supported" << std::endl;
+        } else if(header.type == page_type::DATA_PAGE && !without_levels()){
+            std::cerr << "[ERROR] V1 data pages can only be decoded for columns without definition and repetition levels" << std::endl;
+        } else if(header.def_level_length > 0 || header.rep_level_length > 0){
+            std::cerr << "[ERROR] Data pages with definition or repetition levels are not supported" << std::endl;
+        } else {
+            std::cerr << "[ERROR] Data page with Parquet encoding " << header.parquet_encoding << " can not be decoded as the requested encoding" << std::endl;
+        }
         return status::FAIL;
     }
 
-    current_byte++;
-
-    current_byte += decode_varint32(current_byte, def_level_length, true);
+    *uncompressed_size = header.uncompressed_size;
+    *compressed_size = header.compressed_size;
+    *num_values = header.num_values;
+    *def_level_length = header.def_level_length;
+    *rep_level_length = header.rep_level_length;
+    *metadata_size = page_ptr - metadata + header.header_size;
 
-    //rep level byte length
-    if(*current_byte != 0x15){
-        //std::cerr<<"rep_level_length error"<<std::endl;
-        return status::FAIL;
-    }
+    return status::OK;
 
-    current_byte++;
+}
 
-    current_byte += decode_varint32(current_byte, rep_level_length, true);
+// Decode the single page header at page_ptr. For a walk that started in the file (in_file) the header has to end before
+// the end of the file.
+status SWParquetReader::read_page_header(const uint8_t* page_ptr, bool in_file, page_header* header) {
+    const uint8_t* limit = page_ptr + PAGE_HEADER_MAX_BYTES;
 
-    //is_compressed
-    if((*current_byte == 0x11) || (*current_byte == 0x12)) {
-        current_byte++;
+    if(in_file){
+        if(page_ptr >= parquet_data + file_size){
+            return status::FAIL;
+        }
+        limit = std::min(limit, (const uint8_t*) parquet_data + file_size);
     }
 
-    //Skip stop bytes
-    current_byte += 2;
-
-    *metadata_size = current_byte - metadata;
-
-
-    return status::OK;
-
+    return decode_page_header(page_ptr, limit, header);
 }
 
-}
\ No newline at end of file
+}
@@ -14,6 +14,9 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <mutex>
+#include <vector>
 
 #include <arrow/api.h>
 #include <arrow/io/api.h>
@@ -21,28 +24,219 @@
 #include <parquet/types.h>
 
 #include <ptoa.h>
+#include <PageHeader.h>
+#include <AsyncIngestion.h>
+#include <DirectReadRing.h>
+#include <Instrumentation.h>
 
 #define BLOCK_SIZE 128
 #define MINIBLOCKS_IN_BLOCK 4
 
+// Amount of pages the page walkers prefetch ahead of the page being decoded, 0 disables prefetching
+#define DEFAULT_PREFETCH_DISTANCE 4
+// Upper bound on the prefetch distance, the prefetch cursor keeps the parsed metadata of every page it is ahead
+#define MAX_PREFETCH_DISTANCE 64
+// Bytes at the start of a page payload that are prefetched, larger pages are left to the hardware prefetcher
+#define PREFETCH_PAYLOAD_BYTES 1024
+// Size of the regions of a memory mapped file that are advised to the kernel ahead of the page walkers
+#define READAHEAD_BYTES (4*1024*1024)
+// Upper bound on the size of a page header (including optional statistics), page walkers wait for this many bytes before
+// parsing a header
+#define PAGE_HEADER_MAX_BYTES 1024
+// Slots of the histograms of inspect_pages, indexed by a bit length of 0 to 64
+#define INSPECT_BIT_LENGTHS 65
+
 namespace ptoa{
 
+/**
+ * Comparison predicate that can be evaluated while decoding. Values are compared as int64_t for both prim widths.
+ * EQUAL: value == lo, LESS: value < lo, BETWEEN: lo <= value <= hi, IN_SET: value is one of the (few) values in set.
+ */
+struct predicate {
+    predicate_op op;
+    int64_t lo;
+    int64_t hi;
+    std::vector<int64_t> set;
+};
+
+/**
+ * Results of aggregate_prim. Only the aggregates that were requested are valid. The sum wraps around on overflow.
+ */
+struct aggregate_result {
+    int64_t count;
+    int64_t sum;
+    int64_t min;
+    int64_t max;
+};
+
+/**
+ * Location of a single data page found by index_pages. first_value_index is the index of the first value of the page in
+ * the column chunk.
+ */
+struct page_info {
+    int64_t offset;
+    int32_t size;
+    int32_t num_values;
+    int64_t first_value_index;
+};
+
+/**
+ * Statistics of a single page collected by inspect_pages. The fields up to rep_level_length come from the page header,
+ * whose Thrift structure is header_size bytes. The value statistics are only collected if inspected is set, which
+ * requires an uncompressed DELTA_BINARY_PACKED or DELTA_LENGTH_BYTE_ARRAY data page, or a plain data page of byte arrays.
+ * The delta fields hold the block layout of the page, which the decoders expect to be BLOCK_SIZE values in
+ * MINIBLOCKS_IN_BLOCK miniblocks. miniblock_widths counts the miniblocks that hold values by bit width and
+ * min_delta_lengths the blocks by the bit length of their zigzag encoded min_delta, which sets its size in the block
+ * header. The string fields are set for pages of byte arrays, string_lengths counts the strings by the bit length of
+ * their length.
+ */
+struct page_stats {
+    int64_t offset;
+    page_type type;
+    int32_t parquet_encoding;
+    bool is_compressed;
+    int32_t header_size;
+    int32_t compressed_size;
+    int32_t uncompressed_size;
+    int32_t num_values;
+    int32_t num_nulls;
+    int32_t def_level_length;
+    int32_t rep_level_length;
+
+    bool inspected;
+    int32_t delta_block_size;
+    int32_t delta_miniblocks;
+    int64_t blocks;
+    int64_t miniblock_widths[INSPECT_BIT_LENGTHS];
+    int64_t min_delta_min;
+    int64_t min_delta_max;
+    int64_t min_delta_lengths[INSPECT_BIT_LENGTHS];
+    int64_t num_strings;
+    int64_t num_chars;
+    int64_t string_length_min;
+    int64_t string_length_max;
+    int64_t string_lengths[INSPECT_BIT_LENGTHS];
+};
+
+/**
+ * Options for inspect_pages. Pages are walked until end_offset, or a negative end_offset, the end of the file or the
+ * first bytes that are not a page header. Plain pages are only inspected with byte_array set. If compressed is set, the
+ * column chunk has a compression codec and only V2 pages without is_compressed are inspected. V1 data pages store the
+ * repetition and definition levels of the column in front of the values, which are skipped according to the maximum
+ * levels. With headers_only set only the page headers are read. The pages are divided over num_threads threads.
+ */
+struct inspect_options {
+    int64_t end_offset;
+    bool byte_array;
+    bool compressed;
+    int16_t max_definition_level;
+    int16_t max_repetition_level;
+    bool headers_only;
+    int num_threads;
+};
+
+/**
+ * Options for read_prim_parallel. With numa_aware set, the pages are divided over the NUMA nodes and every worker is
+ * pinned to the CPUs of its node. With replicate_input set, every node first copies its part of the file to memory local
+ * to that node before decoding.
+ */
+struct parallel_options {
+    int num_threads;
+    bool numa_aware;
+    bool replicate_input;
+};
+
+/**
+ * Bytes of Parquet pages read and bytes of Arrow values written by every NUMA node during read_prim_parallel, together
+ * with the time the slowest worker of that node took.
+ */
+struct parallel_stats {
+    std::vector<int> node_ids;
+    std::vector<int64_t> node_bytes_in;
+    std::vector<int64_t> node_bytes_out;
+    std::vector<double> node_seconds;
+};
+
+/**
+ * Column chunk read by read_table. The type of field selects the decoder: int32 and int64 columns are read like
+ * read_prim, utf8 columns like read_string, for which num_chars has to be set as well.
+ */
+struct column_spec {
+    std::shared_ptr<arrow::Field> field;
+    int64_t num_values;
+    int64_t num_chars;
+    int32_t file_offset;
+    encoding enc;
+};
+
+/**
+ * Header of a data page parsed by the prefetch cursor. page_ptr and metadata_size include the dictionary and index pages
+ * in front of the data page, like read_metadata.
+ */
+struct prefetched_page {
+    const uint8_t* page_ptr;
+    page_header header;
+    int32_t metadata_size;
+};
+
+/**
+ * Position of the prefetch pipeline in a contiguous list of pages. values_ahead is the amount of values in the pages
+ * between the start of the list and page_ptr, the pipeline stops once it reaches num_values. The headers parsed by the
+ * cursor are queued in parsed until the page walker reaches their page, values_consumed counts the values of the pages
+ * the walker has taken from the cursor. Only pages encoded with enc are queued.
+ */
+struct prefetch_cursor {
+    const uint8_t* page_ptr;
+    int64_t values_ahead;
+    int64_t values_consumed;
+    int64_t num_values;
+    encoding enc;
+    const uint8_t* advised_end;
+    prefetched_page parsed[MAX_PREFETCH_DISTANCE];
+    int first_parsed;
+    int num_parsed;
+};
+
 /**
  * Class that implements as fast as possible Parquet reading functionality equivalent to that of the hardware.
  */
 class SWParquetReader {
   public:
-    SWParquetReader(std::string file_path);
-    ~SWParquetReader(){free(parquet_data);}
+    SWParquetReader(std::string file_path, arrow::MemoryPool* pool = arrow::default_memory_pool(), ingestion mode = ingestion::BUFFERED);
+    // Reads from size bytes at data, which is neither copied nor freed. The decoders load whole words past the end of the
+    // data, so at least VARINT_LOAD_BYTES bytes after it must be readable.
+    SWParquetReader(const uint8_t* data, size_t size, arrow::MemoryPool* pool = arrow::default_memory_pool());
+    ~SWParquetReader();
     status read_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc);
     status read_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc);
     status read_string(int64_t num_strings, int64_t num_chars, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, encoding enc);
     status read_string(int64_t num_strings, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer , std::shared_ptr<arrow::Buffer> val_buffer, encoding enc);
+    status filter_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, const predicate& pred, std::shared_ptr<arrow::Buffer> sel_bitmap, int64_t* num_selected, encoding enc);
+    status filter_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, const predicate& pred, std::shared_ptr<arrow::Buffer> sel_bitmap, int64_t* num_selected, std::shared_ptr<arrow::PrimitiveArray>* selected_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc);
+    status aggregate_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, int aggregates, aggregate_result* result, encoding enc);
+    status read_prim_parallel(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc, const parallel_options& options, parallel_stats* stats);
+    status read_table(const std::vector<column_spec>& columns, std::shared_ptr<arrow::Table>* table, int num_threads = 0);
+    status read_record_batch(const std::vector<column_spec>& columns, std::shared_ptr<arrow::RecordBatch>* batch, int num_threads = 0);
+    status index_pages(int64_t num_values, int64_t file_offset, encoding enc, std::vector<page_info>* pages, int64_t end_offset = -1);
     status inspect_metadata(int32_t file_offset);
+    status inspect_pages(int64_t file_offset, const inspect_options& options, std::vector<page_stats>* pages);
     status count_pages(int32_t file_offset);
+    void set_prefetch_distance(int pages) {prefetch_distance = std::min(std::max(pages, 0), MAX_PREFETCH_DISTANCE);}
+    int get_prefetch_distance() {return prefetch_distance;}
+    // Maximum definition and repetition level of the column, from the schema in the footer. V1 data pages are only decoded
+    // once both are set to 0, otherwise their levels would be read as values.
+    void set_max_levels(int16_t definition, int16_t repetition) {max_definition_level = definition; max_repetition_level = repetition;}
+    ingestion get_ingestion() {return ingestion_mode;}
+    // Block until the whole file is in memory, only has an effect with ingestion::IO_URING
+    status wait_ingested();
+    // Stage counters of read_prim and read_string (and the readers built on them) since construction or the last
+    // reset_stats, all 0 unless built with PTOA_INSTRUMENT
+    reader_stats get_stats();
+    void reset_stats();
 
   private:
-  	status read_metadata(const uint8_t* metadata, int32_t* uncompressed_size, int32_t* compressed_size, int32_t* num_values, int32_t* def_level_length, int32_t* rep_level_length, int32_t* metadata_size);
+  	status read_metadata(const uint8_t* metadata, encoding enc, int32_t* uncompressed_size, int32_t* compressed_size, int32_t* num_values, int32_t* def_level_length, int32_t* rep_level_length, int32_t* metadata_size);
+    status read_page_header(const uint8_t* page_ptr, bool in_file, page_header* header);
     status read_delta_header32(const uint8_t* header, int32_t* first_value, int32_t* header_size);
     status read_block_header32(const uint8_t* header, int32_t* min_delta, uint8_t* bitwidths, int32_t* header_size);
     status read_delta_header64(const uint8_t* header, int64_t* first_value, int32_t* header_size);
@@ -58,12 +252,65 @@ class SWParquetReader {
     status read_string_delta_length(int64_t num_strings, int64_t num_chars, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array);
     status read_string_delta_length(int64_t num_strings, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer);
 
+    status read_columns(const std::vector<column_spec>& columns, int num_threads, std::vector<std::shared_ptr<arrow::Array>>* arrays);
+    status read_column(const column_spec& column, std::shared_ptr<arrow::Array>* array);
 
-    int decode_varint32(const uint8_t* input, int32_t* result, bool zigzag);
-    int decode_varint64(const uint8_t* input, int64_t* result, bool zigzag);
+    status inspect_values(const inspect_options& options, page_stats* page);
+
+    status read_prim_direct(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc);
+
+    // Decoding kernels that work on raw pointers so they can also run on replicated input and on slices of the output
+    status decode_prim_plain(const uint8_t* page_ptr, int32_t prim_width, int64_t num_values, uint8_t* arr_buf_ptr);
+    status decode_prim_delta32(const uint8_t* page_ptr, int64_t num_values, int32_t* arr_buf_ptr);
+    status decode_prim_delta64(const uint8_t* page_ptr, int64_t num_values, int64_t* arr_buf_ptr);
+
+    template<typename T, predicate_op OP>
+    status filter_prim_delta(int64_t num_values, int32_t file_offset, const predicate& pred, uint8_t* sel_bitmap, int64_t* num_selected, T* selected_values);
+    status aggregate_count(int64_t num_values, int32_t file_offset, aggregate_result* result, encoding enc);
+    template<typename T>
+    status aggregate_prim_plain(int64_t num_values, int32_t file_offset, int aggregates, aggregate_result* result);
+    template<typename T>
+    status aggregate_prim_delta(int64_t num_values, int32_t file_offset, int aggregates, aggregate_result* result);
+
+
+    status wait_resident(const uint8_t* ptr, int64_t length);
+    bool is_resident(const uint8_t* ptr, int64_t length);
+    // Whether ptr points into the file in memory, which there is none of with direct ingestion (parquet_data is null)
+    bool points_into_file(const uint8_t* ptr) {return parquet_data != nullptr && ptr >= parquet_data && ptr < parquet_data + file_size;}
+
+    void prefetch_start(prefetch_cursor* cursor, const uint8_t* page_ptr, int64_t num_values, encoding enc);
+    void prefetch_next(prefetch_cursor* cursor);
+    bool prefetch_page(prefetch_cursor* cursor);
+    status next_metadata(prefetch_cursor* cursor, const uint8_t* page_ptr, int32_t* uncompressed_size, int32_t* compressed_size, int32_t* num_values, int32_t* def_level_length, int32_t* rep_level_length, int32_t* metadata_size);
+
+    bool without_levels() {return max_definition_level == 0 && max_repetition_level == 0;}
+
+    // Decoding functions count into a local reader_stats and add it to stats when done, so concurrent decoders only
+    // synchronize once per call
+    void record_stats(const reader_stats& local);
 
   	uint8_t* parquet_data;
   	size_t file_size;
+
+  	// Pool used for all Arrow buffers allocated by the reader itself
+  	arrow::MemoryPool* pool;
+
+  	ingestion ingestion_mode;
+  	int prefetch_distance;
+  	// Set by set_max_levels, -1 while unknown
+  	int16_t max_definition_level;
+  	int16_t max_repetition_level;
+
+  	// Only set with ingestion::IO_URING, parquet_data is filled in the background
+  	std::unique_ptr<AsyncIngestion> async_ingestion;
+
+  	// Only used with ingestion::DIRECT, the file is streamed through a DirectReadRing on every read and parquet_data is
+  	// not used
+  	int direct_fd;
+  	bool o_direct;
+
+  	reader_stats stats;
+  	std::mutex stats_mutex;
 };
 
 }
@@ -0,0 +1,254 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include <SWParquetReader.h>
+#include <LemireBitUnpacking.h>
+#include <ptoa.h>
+
+namespace ptoa {
+
+// Compute the aggregates selected by the aggregate flags in "aggregates" over the first num_values values of the column
+// chunk starting at file_offset, without materializing the values in an Arrow buffer.
+status SWParquetReader::aggregate_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, int aggregates, aggregate_result* result, encoding enc) {
+    if(aggregates == aggregate::COUNT && (enc == encoding::PLAIN || enc == encoding::DELTA) && (prim_width == 32 || prim_width == 64)){
+        return aggregate_count(num_values, file_offset, result, enc);
+    } else if(enc == encoding::PLAIN && prim_width == 32){
+        return aggregate_prim_plain<int32_t>(num_values, file_offset, aggregates, result);
+    } else if(enc == encoding::PLAIN && prim_width == 64){
+        return aggregate_prim_plain<int64_t>(num_values, file_offset, aggregates, result);
+    } else if((enc == encoding::DELTA) && (prim_width == 32)){
+        return aggregate_prim_delta<int32_t>(num_values, file_offset, aggregates, result);
+    } else if((enc == encoding::DELTA) && (prim_width == 64)){
+        return aggregate_prim_delta<int64_t>(num_values, file_offset, aggregates, result);
+    } else{
+        std::cout<<"Unsupported encoding selected" << std::endl;
+        return status::FAIL;
+    }
+}
+
+// COUNT alone does not need the values, so only the page headers are walked to check the chunk holds num_values values
+status SWParquetReader::aggregate_count(int64_t num_values, int32_t file_offset, aggregate_result* result, encoding enc) {
+    // This walker does not wait for individual pages to arrive with ingestion::IO_URING
+    if(wait_ingested() != status::OK){
+        return status::FAIL;
+    }
+
+    uint8_t* page_ptr = parquet_data + file_offset;
+
+    int64_t total_value_counter = 0;
+
+    // Metadata reading variables
+    int32_t uncompressed_size;
+    int32_t compressed_size;
+    int32_t page_num_values;
+    int32_t def_level_length;
+    int32_t rep_level_length;
+    int32_t metadata_size;
+
+    while(total_value_counter < num_values){
+        if(read_metadata(page_ptr, enc, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
+            std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
+            std::cerr << page_ptr-parquet_data << std::endl;
+            return status::FAIL;
+        }
+
+        page_ptr += metadata_size + compressed_size;
+        total_value_counter += page_num_values;
+    }
+
+    result->count = num_values;
+    result->sum = 0;
+    result->min = 0;
+    result->max = 0;
+
+    return status::OK;
+}
+
+template<typename T>
+status SWParquetReader::aggregate_prim_plain(int64_t num_values, int32_t file_offset, int aggregates, aggregate_result* result) {
+    // This walker does not wait for individual pages to arrive with ingestion::IO_URING
+    if(wait_ingested() != status::OK){
+        return status::FAIL;
+    }
+
+    uint8_t* page_ptr = parquet_data;
+
+    int64_t total_value_counter = 0;
+
+    // Metadata reading variables
+    int32_t uncompressed_size;
+    int32_t compressed_size;
+    int32_t page_num_values;
+    int32_t def_level_length;
+    int32_t rep_level_length;
+    int32_t metadata_size;
+
+    uint64_t sum = 0;
+    T min = std::numeric_limits<T>::max();
+    T max = std::numeric_limits<T>::min();
+
+    page_ptr += file_offset;
+
+    while(total_value_counter < num_values){
+        if(read_metadata(page_ptr, encoding::PLAIN, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
+            std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
+            std::cerr << page_ptr-parquet_data << std::endl;
+            return status::FAIL;
+        }
+
+        page_ptr += metadata_size;
+
+        int32_t page_values_to_read = std::min(page_num_values, (int32_t)(num_values-total_value_counter));
+        T value;
+
+        for(int32_t i=0; i<page_values_to_read; i++){
+            std::memcpy(&value, page_ptr + i*sizeof(T), sizeof(T));
+            sum += (uint64_t)(int64_t)value;
+            min = std::min(min, value);
+            max = std::max(max, value);
+        }
+
+        page_ptr += compressed_size;
+        total_value_counter += page_num_values;
+    }
+
+    result->count = (aggregates & aggregate::COUNT) ? num_values : 0;
+    result->sum = (aggregates & aggregate::SUM) ? (int64_t)sum : 0;
+    result->min = (aggregates & aggregate::MINIMUM) ? min : 0;
+    result->max = (aggregates & aggregate::MAXIMUM) ? max : 0;
+
+    return status::OK;
+}
+
+// Every delta of a miniblock with bit width 0 is the min_delta of its block, so its values are an arithmetic sequence.
+// Unless the sequence wraps around T, its sum follows from the value before the miniblock, the min_delta and the amount
+// of values, and its extremes are its first and last value. Such miniblocks are aggregated without unpacking them.
+// Other monotone miniblocks (min_delta >= 0) also have their first and last value as extremes, but that last value is the
+// sum of all their deltas, so they are still unpacked and aggregated value by value.
+template<typename T>
+status SWParquetReader::aggregate_prim_delta(int64_t num_values, int32_t file_offset, int aggregates, aggregate_result* result) {
+    // This walker does not wait for individual pages to arrive with ingestion::IO_URING
+    if(wait_ingested() != status::OK){
+        return status::FAIL;
+    }
+
+    typedef typename std::make_unsigned<T>::type U;
+
+    uint8_t* page_ptr = parquet_data;
+
+    int64_t total_value_counter = 0;
+    int32_t page_value_counter;
+
+    // Metadata reading variables
+    int32_t uncompressed_size;
+    int32_t compressed_size;
+    int32_t page_num_values;
+    int32_t def_level_length;
+    int32_t rep_level_length;
+    int32_t metadata_size;
+
+    // Delta/block header reading variables. 32 bit pages store the same zigzag varints, so the 64 bit readers work for both.
+    int32_t page_values_to_read;
+    uint8_t* block_ptr;
+    int64_t first_value;
+    int64_t min_delta;
+    uint8_t bitwidths[MINIBLOCKS_IN_BLOCK];
+    int32_t header_size;
+    U unpacked_deltas[BLOCK_SIZE/MINIBLOCKS_IN_BLOCK];
+
+    uint64_t sum = 0;
+    T min = std::numeric_limits<T>::max();
+    T max = std::numeric_limits<T>::min();
+
+    page_ptr += file_offset;
+
+    while(total_value_counter < num_values){
+        // Read page metadata
+        if(read_metadata(page_ptr, encoding::DELTA, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
+            std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
+            std::cerr << page_ptr-parquet_data << std::endl;
+            return status::FAIL;
+        }
+        page_ptr += metadata_size;
+        block_ptr = page_ptr;
+        page_values_to_read = std::min(page_num_values, (int32_t)(num_values-total_value_counter));
+
+        // Read delta header
+        if(read_delta_header64(block_ptr, &first_value, &header_size) != status::OK){
+            return status::FAIL;
+        }
+        block_ptr += header_size;
+
+        // Running value path, the values only ever live in registers
+        T current_value = (T)first_value;
+        sum += (uint64_t)(int64_t)current_value;
+        min = std::min(min, current_value);
+        max = std::max(max, current_value);
+        page_value_counter = 1;
+
+        while(page_value_counter < page_values_to_read){
+            if(read_block_header64(block_ptr, &min_delta, bitwidths, &header_size) != status::OK){
+                return status::FAIL;
+            }
+            block_ptr += header_size;
+
+            for(int i=0; i<MINIBLOCKS_IN_BLOCK; i++){
+                uint8_t current_bitwidth = bitwidths[i];
+                int32_t steps = std::min(page_values_to_read-page_value_counter, BLOCK_SIZE/MINIBLOCKS_IN_BLOCK);
+                __int128 last_value = (__int128)current_value + (__int128)steps*min_delta;
+
+                if(current_bitwidth == 0 && last_value >= std::numeric_limits<T>::min() && last_value <= std::numeric_limits<T>::max()){
+                    T next_value = (T)(current_value + min_delta);
+
+                    sum += (uint64_t)steps*(uint64_t)(int64_t)current_value + (uint64_t)min_delta*(uint64_t)(steps*(steps+1)/2);
+                    min = std::min(min, std::min(next_value, (T)last_value));
+                    max = std::max(max, std::max(next_value, (T)last_value));
+                    current_value = (T)last_value;
+                } else {
+                    unpack_miniblock(block_ptr, unpacked_deltas, current_bitwidth);
+
+                    for(int j=0; j<steps; j++){
+                        current_value = (T)((U)current_value + unpacked_deltas[j] + (U)min_delta);
+                        sum += (uint64_t)(int64_t)current_value;
+                        min = std::min(min, current_value);
+                        max = std::max(max, current_value);
+                    }
+                }
+
+                page_value_counter += steps;
+                if(page_value_counter >= page_values_to_read){
+                    break;
+                }
+
+                block_ptr += current_bitwidth*((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)/8);
+            }
+        }
+
+        page_ptr += compressed_size;
+        total_value_counter += page_num_values;
+    }
+
+    result->count = (aggregates & aggregate::COUNT) ? num_values : 0;
+    result->sum = (aggregates & aggregate::SUM) ? (int64_t)sum : 0;
+    result->min = (aggregates & aggregate::MINIMUM) ? min : 0;
+    result->max = (aggregates & aggregate::MAXIMUM) ? max : 0;
+
+    return status::OK;
+}
+
+}
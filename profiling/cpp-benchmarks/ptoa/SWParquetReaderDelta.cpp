@@ -20,6 +20,7 @@
 
 #include <SWParquetReader.h>
 #include <LemireBitUnpacking.h>
+#include <Varint.h>
 #include <ptoa.h>
 
 namespace ptoa {
@@ -28,35 +29,41 @@ namespace ptoa {
 status SWParquetReader::read_prim_delta32(int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array){
     const int32_t prim_width = 32;
 
+    PTOA_INSTRUMENTED(reader_stats local_stats; stage_clock clock;)
+
     std::shared_ptr<arrow::Buffer> arr_buffer;
-    arrow::AllocateBuffer(num_values*prim_width/8, &arr_buffer);
+    arrow::AllocateBuffer(pool, num_values*prim_width/8, &arr_buffer);
 
-    read_prim_delta32(num_values, file_offset, prim_array, arr_buffer);
+    PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_ALLOCATION); local_stats.bytes_allocated += num_values*prim_width/8; record_stats(local_stats);)
 
-    return status::OK;
+    return read_prim_delta32(num_values, file_offset, prim_array, arr_buffer);
 }
 
 status SWParquetReader::read_prim_delta64(int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array){
     const int32_t prim_width = 64;
 
+    PTOA_INSTRUMENTED(reader_stats local_stats; stage_clock clock;)
+
     std::shared_ptr<arrow::Buffer> arr_buffer;
-    arrow::AllocateBuffer(num_values*prim_width/8, &arr_buffer);
+    arrow::AllocateBuffer(pool, num_values*prim_width/8, &arr_buffer);
 
-    read_prim_delta64(num_values, file_offset, prim_array, arr_buffer);
+    PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_ALLOCATION); local_stats.bytes_allocated += num_values*prim_width/8; record_stats(local_stats);)
 
-    return status::OK;
+    return read_prim_delta64(num_values, file_offset, prim_array, arr_buffer);
 }
 
 status SWParquetReader::read_string_delta_length(int64_t num_strings, int64_t num_chars, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array){
+    PTOA_INSTRUMENTED(reader_stats local_stats; stage_clock clock;)
+
     std::shared_ptr<arrow::Buffer> off_buffer;
-    arrow::AllocateBuffer((num_strings+1)*sizeof(int32_t), &off_buffer);
+    arrow::AllocateBuffer(pool, (num_strings+1)*sizeof(int32_t), &off_buffer);
 
     std::shared_ptr<arrow::Buffer> val_buffer;
-    arrow::AllocateBuffer(num_chars, &val_buffer);
+    arrow::AllocateBuffer(pool, num_chars, &val_buffer);
 
-    read_string_delta_length(num_strings, file_offset, string_array, off_buffer, val_buffer);
+    PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_ALLOCATION); local_stats.bytes_allocated += (num_strings+1)*sizeof(int32_t) + num_chars; record_stats(local_stats);)
 
-    return status::OK;
+    return read_string_delta_length(num_strings, file_offset, string_array, off_buffer, val_buffer);
 }
 
 status SWParquetReader::read_string_delta_length(int64_t num_strings, int32_t file_offset, std::shared_ptr<arrow::StringArray>* string_array, std::shared_ptr<arrow::Buffer> off_buffer, std::shared_ptr<arrow::Buffer> val_buffer){
@@ -99,24 +106,44 @@ status SWParquetReader::read_string_delta_length(int64_t num_strings, int32_t fi
 
     page_ptr += file_offset;
 
+    PTOA_INSTRUMENTED(reader_stats local_stats; stage_clock clock;)
+
+    prefetch_cursor prefetch;
+    prefetch_start(&prefetch, page_ptr, num_strings, encoding::DELTA_LENGTH);
+
     // Decode values from Parquet pages until max amount of values is reached
     while(total_value_counter < num_strings){
         page_value_counter = 0;
 
-        // Read page metadata
-        if(read_metadata(page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
+        // Read page metadata, pages may still be arriving with ingestion::IO_URING
+        if(next_metadata(&prefetch, page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
             std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
             std::cerr << page_ptr-parquet_data << std::endl;
+            free(bitwidths);
+            free(unpacked_deltas);
+            return status::FAIL;
+        }
+        if(wait_resident(page_ptr, metadata_size + compressed_size) != status::OK){
+            free(bitwidths);
+            free(unpacked_deltas);
             return status::FAIL;
         }
         page_ptr += metadata_size;
         block_ptr = page_ptr;
         page_values_to_read = std::min(page_num_values, (int32_t)(num_strings-total_value_counter));
 
+        PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_PAGE_HEADER); local_stats.pages++; local_stats.bytes_in += metadata_size + compressed_size;)
+
         // Read delta header
-        read_delta_header32(block_ptr, &string_length, &header_size);
+        if(read_delta_header32(block_ptr, &string_length, &header_size) != status::OK){
+            free(bitwidths);
+            free(unpacked_deltas);
+            return status::FAIL;
+        }
         block_ptr += header_size;
 
+        PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_BLOCK_HEADER);)
+
         // Insert first offset of page into the arrow offset buffer
         current_offset = string_length+current_offset;
         off_buf_ptr[page_value_counter] = current_offset;
@@ -128,11 +155,15 @@ status SWParquetReader::read_string_delta_length(int64_t num_strings, int32_t fi
             // Read block header
             read_block_header32(block_ptr, &min_delta, bitwidths, &header_size);
             block_ptr += header_size;
+
+            PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_BLOCK_HEADER); local_stats.blocks++;)
         
             for(int i=0; i<MINIBLOCKS_IN_BLOCK; i++){
                 uint8_t current_bitwidth = bitwidths[i];
                 fastunpack((uint*) block_ptr, unpacked_deltas, current_bitwidth);
 
+                PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_UNPACK); local_stats.miniblocks[current_bitwidth]++;)
+
                 for(int j=0; j<(BLOCK_SIZE/MINIBLOCKS_IN_BLOCK); j++){
                     string_length = string_length + unpacked_deltas[j] + min_delta;
                     current_offset = string_length + current_offset;
@@ -160,11 +191,15 @@ status SWParquetReader::read_string_delta_length(int64_t num_strings, int32_t fi
                     }
                 }
 
+                PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_PREFIX_SUM);)
+
                 block_ptr += current_bitwidth*((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)/8);
             }
         }
 
         end_of_lengths:
+        PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_PREFIX_SUM);)
+
         // If the last block processed was not the last block in the page we need to keep reading bitwidths to find the first character
         while(page_value_counter<page_num_values){
             read_block_header32(block_ptr, &min_delta, bitwidths, &header_size);
@@ -179,19 +214,33 @@ status SWParquetReader::read_string_delta_length(int64_t num_strings, int32_t fi
             }
         }
 
-        //Copy characters
+        PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_BLOCK_HEADER);)
+
+        //Copy characters, the lengths may add up to more characters than the caller allocated
+        if((int64_t) current_offset > val_buffer->size()){
+            std::cerr << "[ERROR] " << current_offset << " characters do not fit in the values buffer of " << val_buffer->size() << " bytes" << std::endl;
+            free(bitwidths);
+            free(unpacked_deltas);
+            return status::FAIL;
+        }
         chars_to_read = current_offset-prev_page_final_offset;
         std::memcpy((void*) val_buf_ptr, (const void*) block_ptr, chars_to_read);
         val_buf_ptr += chars_to_read;
         prev_page_final_offset = current_offset;
 
+        PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_CHAR_COPY); local_stats.bytes_out += chars_to_read + page_values_to_read*sizeof(int32_t);)
+
         //Prepare for next page
         page_ptr += compressed_size;
         total_value_counter += page_num_values;
+
+        prefetch_next(&prefetch);
     }
 
     *string_array = std::make_shared<arrow::StringArray>(num_strings, off_buffer, val_buffer);
 
+    PTOA_INSTRUMENTED(record_stats(local_stats);)
+
     free(bitwidths);
     free(unpacked_deltas);
 
@@ -199,8 +248,18 @@ status SWParquetReader::read_string_delta_length(int64_t num_strings, int32_t fi
 }
 
 status SWParquetReader::read_prim_delta32(int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer){
-    uint8_t* page_ptr = parquet_data;
-    int32_t* arr_buf_ptr = (int32_t*)arr_buffer->mutable_data();
+    if(decode_prim_delta32(parquet_data + file_offset, num_values, (int32_t*)arr_buffer->mutable_data()) != status::OK){
+        return status::FAIL;
+    }
+
+    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int32(), num_values, arr_buffer);
+
+    return status::OK;
+}
+
+// Decode num_values 32 bit delta encoded values from the contiguous list of Parquet pages starting at page_ptr into arr_buf_ptr.
+status SWParquetReader::decode_prim_delta32(const uint8_t* page_ptr, int64_t num_values, int32_t* arr_buf_ptr){
+    const uint8_t* start_ptr = page_ptr;
 
     int32_t total_value_counter = 0;
     int32_t page_value_counter = 0;
@@ -215,14 +274,17 @@ status SWParquetReader::read_prim_delta32(int64_t num_values, int32_t file_offse
 
     // Delta/block header reading variables
     int32_t page_values_to_read;
-    uint8_t* block_ptr;
+    const uint8_t* block_ptr;
     int32_t first_value;
     int32_t min_delta;
     uint8_t* bitwidths = (uint8_t*)std::malloc(MINIBLOCKS_IN_BLOCK*sizeof(uint8_t));
     int32_t header_size;
     uint32_t* unpacked_deltas = (uint32_t*)std::malloc((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)*sizeof(uint32_t));
 
-    page_ptr += file_offset;
+    PTOA_INSTRUMENTED(reader_stats local_stats; stage_clock clock;)
+
+    prefetch_cursor prefetch;
+    prefetch_start(&prefetch, page_ptr, num_values, encoding::DELTA);
 
     // Decode values from Parquet pages until max amount of values is reached
     while(total_value_counter < num_values){
@@ -231,20 +293,35 @@ status SWParquetReader::read_prim_delta32(int64_t num_values, int32_t file_offse
 
         page_value_counter = 0;
 
-        // Read page metadata
-        if(read_metadata(page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
+        // Read page metadata, pages may still be arriving with ingestion::IO_URING
+        if(next_metadata(&prefetch, page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
             std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
-            std::cerr << page_ptr-parquet_data << std::endl;
+            std::cerr << page_ptr-start_ptr << std::endl;
+            free(bitwidths);
+            free(unpacked_deltas);
+            return status::FAIL;
+        }
+        if(wait_resident(page_ptr, metadata_size + compressed_size) != status::OK){
+            free(bitwidths);
+            free(unpacked_deltas);
             return status::FAIL;
         }
         page_ptr += metadata_size;
         block_ptr = page_ptr;
         page_values_to_read = std::min(page_num_values, (int32_t)(num_values-total_value_counter));
 
+        PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_PAGE_HEADER); local_stats.pages++; local_stats.bytes_in += metadata_size + compressed_size;)
+
         // Read delta header
-        read_delta_header32(block_ptr, &first_value, &header_size);
+        if(read_delta_header32(block_ptr, &first_value, &header_size) != status::OK){
+            free(bitwidths);
+            free(unpacked_deltas);
+            return status::FAIL;
+        }
         block_ptr += header_size;
 
+        PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_BLOCK_HEADER);)
+
         // Insert first value of page into the arrow buffer
         arr_buf_ptr[page_value_counter] = first_value;
         page_value_counter++;
@@ -254,10 +331,14 @@ status SWParquetReader::read_prim_delta32(int64_t num_values, int32_t file_offse
             // Read block header
             read_block_header32(block_ptr, &min_delta, bitwidths, &header_size);
             block_ptr += header_size;
+
+            PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_BLOCK_HEADER); local_stats.blocks++;)
         
             for(int i=0; i<MINIBLOCKS_IN_BLOCK; i++){
                 uint8_t current_bitwidth = bitwidths[i];
-                fastunpack((uint*) block_ptr, unpacked_deltas, current_bitwidth);
+                fastunpack((const uint*) block_ptr, unpacked_deltas, current_bitwidth);
+
+                PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_UNPACK); local_stats.miniblocks[current_bitwidth]++;)
 
                 for(int j=0; j<(BLOCK_SIZE/MINIBLOCKS_IN_BLOCK); j++){
                     arr_buf_ptr[page_value_counter] = unpacked_deltas[j] + min_delta + arr_buf_ptr[page_value_counter-1];
@@ -270,16 +351,22 @@ status SWParquetReader::read_prim_delta32(int64_t num_values, int32_t file_offse
                     }
                 }
 
+                PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_PREFIX_SUM);)
+
                 block_ptr += current_bitwidth*((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)/8);
             }
         }
 
         end_of_page:
+        PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_PREFIX_SUM); local_stats.bytes_out += page_values_to_read*sizeof(*arr_buf_ptr);)
+
         page_ptr += compressed_size;
         total_value_counter += page_num_values;
+
+        prefetch_next(&prefetch);
     }
 
-    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int32(), num_values, arr_buffer);
+    PTOA_INSTRUMENTED(record_stats(local_stats);)
 
     free(bitwidths);
     free(unpacked_deltas);
@@ -287,8 +374,18 @@ status SWParquetReader::read_prim_delta32(int64_t num_values, int32_t file_offse
 }
 
 status SWParquetReader::read_prim_delta64(int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer){
-    uint8_t* page_ptr = parquet_data;
-    int64_t* arr_buf_ptr = (int64_t*)(arr_buffer->mutable_data());
+    if(decode_prim_delta64(parquet_data + file_offset, num_values, (int64_t*)arr_buffer->mutable_data()) != status::OK){
+        return status::FAIL;
+    }
+
+    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int64(), num_values, arr_buffer);
+
+    return status::OK;
+}
+
+// Decode num_values 64 bit delta encoded values from the contiguous list of Parquet pages starting at page_ptr into arr_buf_ptr.
+status SWParquetReader::decode_prim_delta64(const uint8_t* page_ptr, int64_t num_values, int64_t* arr_buf_ptr){
+    const uint8_t* start_ptr = page_ptr;
 
     int32_t total_value_counter = 0;
     int32_t page_value_counter = 0;
@@ -303,14 +400,17 @@ status SWParquetReader::read_prim_delta64(int64_t num_values, int32_t file_offse
 
     // Delta/block header reading variables
     int32_t page_values_to_read;
-    uint8_t* block_ptr;
+    const uint8_t* block_ptr;
     int64_t first_value;
     int64_t min_delta;
     uint8_t* bitwidths = (uint8_t*)std::malloc(MINIBLOCKS_IN_BLOCK*sizeof(uint8_t));
     int32_t header_size;
     uint64_t* unpacked_deltas = (uint64_t*)std::malloc((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)*sizeof(uint64_t));
 
-    page_ptr += file_offset;
+    PTOA_INSTRUMENTED(reader_stats local_stats; stage_clock clock;)
+
+    prefetch_cursor prefetch;
+    prefetch_start(&prefetch, page_ptr, num_values, encoding::DELTA);
 
     // Decode values from Parquet pages until max amount of values is reached
     while(total_value_counter < num_values){
@@ -320,20 +420,35 @@ status SWParquetReader::read_prim_delta64(int64_t num_values, int32_t file_offse
 
         page_value_counter = 0;
 
-        // Read page metadata
-        if(read_metadata(page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
+        // Read page metadata, pages may still be arriving with ingestion::IO_URING
+        if(next_metadata(&prefetch, page_ptr, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
             std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
-            std::cerr << page_ptr-parquet_data << std::endl;
+            std::cerr << page_ptr-start_ptr << std::endl;
+            free(bitwidths);
+            free(unpacked_deltas);
+            return status::FAIL;
+        }
+        if(wait_resident(page_ptr, metadata_size + compressed_size) != status::OK){
+            free(bitwidths);
+            free(unpacked_deltas);
             return status::FAIL;
         }
         page_ptr += metadata_size;
         block_ptr = page_ptr;
         page_values_to_read = std::min(page_num_values, (int32_t)(num_values-total_value_counter));
 
+        PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_PAGE_HEADER); local_stats.pages++; local_stats.bytes_in += metadata_size + compressed_size;)
+
         // Read delta header
-        read_delta_header64(block_ptr, &first_value, &header_size);
+        if(read_delta_header64(block_ptr, &first_value, &header_size) != status::OK){
+            free(bitwidths);
+            free(unpacked_deltas);
+            return status::FAIL;
+        }
         block_ptr += header_size;
 
+        PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_BLOCK_HEADER);)
+
         //std::cout<<std::endl;
         //std::cout<<"Values to read: "<<page_values_to_read<<std::endl;
         //std::cout<<"Delta header size: "<<header_size<<std::endl;
@@ -346,9 +461,15 @@ status SWParquetReader::read_prim_delta64(int64_t num_values, int32_t file_offse
         // Keep on looping through the blocks in the page until exactly page_values_to_read have been processed.
         while(page_value_counter < page_values_to_read){
             // Read block header
-            read_block_header64(block_ptr, &min_delta, bitwidths, &header_size);
+            if(read_block_header64(block_ptr, &min_delta, bitwidths, &header_size) != status::OK){
+                free(bitwidths);
+                free(unpacked_deltas);
+                return status::FAIL;
+            }
             block_ptr += header_size;
 
+            PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_BLOCK_HEADER); local_stats.blocks++;)
+
             //std::cout<<"Min delta: "<<min_delta<<", block header size: "<<header_size<<std::endl;
             //for(int z=0; z<4;z++){
             //    std::cout<<"Bit width "<<z<<": "<<(int)bitwidths[z]<<std::endl;
@@ -357,7 +478,9 @@ status SWParquetReader::read_prim_delta64(int64_t num_values, int32_t file_offse
         
             for(int i=0; i<MINIBLOCKS_IN_BLOCK; i++){
                 uint8_t current_bitwidth = bitwidths[i];
-                int64fastunpack((uint64_t*) block_ptr, unpacked_deltas, current_bitwidth);
+                int64fastunpack((const uint64_t*) block_ptr, unpacked_deltas, current_bitwidth);
+
+                PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_UNPACK); local_stats.miniblocks[current_bitwidth]++;)
 
                 for(int j=0; j<(BLOCK_SIZE/MINIBLOCKS_IN_BLOCK); j++){
                     arr_buf_ptr[page_value_counter] = unpacked_deltas[j] + min_delta + arr_buf_ptr[page_value_counter-1];
@@ -371,13 +494,19 @@ status SWParquetReader::read_prim_delta64(int64_t num_values, int32_t file_offse
                     }
                 }
 
+                PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_PREFIX_SUM);)
+
                 block_ptr += current_bitwidth*((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)/8);
             }
         }
 
         end_of_page:
+        PTOA_INSTRUMENTED(clock.lap(&local_stats, STAGE_PREFIX_SUM); local_stats.bytes_out += page_values_to_read*sizeof(*arr_buf_ptr);)
+
         page_ptr += compressed_size;
         total_value_counter += page_num_values;
+
+        prefetch_next(&prefetch);
     }
 
 
@@ -385,7 +514,7 @@ status SWParquetReader::read_prim_delta64(int64_t num_values, int32_t file_offse
     //for(int l=0; l<200; l++){
     //    std::cout<<(arr_buf_ptr+page_value_counter-100)[l]<<std::endl;
     //}
-    *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int64(), num_values, arr_buffer);
+    PTOA_INSTRUMENTED(record_stats(local_stats);)
 
     free(bitwidths);
     free(unpacked_deltas);
@@ -396,20 +525,18 @@ status SWParquetReader::read_prim_delta64(int64_t num_values, int32_t file_offse
 status SWParquetReader::read_delta_header32(const uint8_t* header, int32_t* first_value, int32_t* header_size){
     const uint8_t* current_byte = header;
 
-    //Skip block_size
+    //Block size and miniblocks in block, as varints. Other writers (e.g. arrow for 64 bit values) may use a block
+    //layout the unpacking kernels can not handle.
     assert(BLOCK_SIZE == 128);
-    current_byte += 2;
-
-    //Skip miniblocks in block
     assert(MINIBLOCKS_IN_BLOCK == 4);
-    current_byte += 1;
-
-    //Total value count
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
+    if(current_byte[0] != 0x80 || current_byte[1] != 0x01 || current_byte[2] != MINIBLOCKS_IN_BLOCK){
+        std::cerr << "[ERROR] Only delta blocks of " << BLOCK_SIZE << " values in " << MINIBLOCKS_IN_BLOCK << " miniblocks are supported" << std::endl;
+        return status::FAIL;
     }
+    current_byte += 3;
 
-    current_byte++;
+    //Total value count
+    current_byte += skip_varint(current_byte);
 
     current_byte += decode_varint32(current_byte, first_value, true);
 
@@ -421,20 +548,18 @@ status SWParquetReader::read_delta_header32(const uint8_t* header, int32_t* firs
 status SWParquetReader::read_delta_header64(const uint8_t* header, int64_t* first_value, int32_t* header_size){
     const uint8_t* current_byte = header;
 
-    //Skip block_size
+    //Block size and miniblocks in block, as varints. Other writers (e.g. arrow for 64 bit values) may use a block
+    //layout the unpacking kernels can not handle.
     assert(BLOCK_SIZE == 128);
-    current_byte += 2;
-
-    //Skip miniblocks in block
     assert(MINIBLOCKS_IN_BLOCK == 4);
-    current_byte += 1;
-
-    //Total value count
-    while((*current_byte & 0x80) != 0 ){
-        current_byte++;
+    if(current_byte[0] != 0x80 || current_byte[1] != 0x01 || current_byte[2] != MINIBLOCKS_IN_BLOCK){
+        std::cerr << "[ERROR] Only delta blocks of " << BLOCK_SIZE << " values in " << MINIBLOCKS_IN_BLOCK << " miniblocks are supported" << std::endl;
+        return status::FAIL;
     }
+    current_byte += 3;
 
-    current_byte++;
+    //Total value count
+    current_byte += skip_varint(current_byte);
 
     current_byte += decode_varint64(current_byte, first_value, true);
 
@@ -467,10 +592,14 @@ status SWParquetReader::read_block_header64(const uint8_t* header, int64_t* min_
     //Min_delta
     current_byte += decode_varint64(current_byte, min_delta, true);
 
-    //Bit widths
+    //Bit widths, more than 64 bits per delta only occur in corrupt pages
     for(int i=0; i<MINIBLOCKS_IN_BLOCK; i++){
         bitwidths[i] = *current_byte;
         current_byte++;
+        if(bitwidths[i] > 64){
+            std::cerr << "[ERROR] Corrupted delta block header with a bit width of " << (int)bitwidths[i] << std::endl;
+            return status::FAIL;
+        }
     }
 
     *header_size = current_byte-header;
@@ -0,0 +1,139 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+#include <SWParquetReader.h>
+#include <DirectReadRing.h>
+#include <PageHeader.h>
+#include <ptoa.h>
+
+namespace ptoa {
+
+// Stream the file through a ring of O_DIRECT buffers and decode the pages that are completely inside the current buffer
+// in one go. A page that straddles the end of a buffer is completed by copying its first part in front of the data of
+// the next buffer.
+status SWParquetReader::read_prim_direct(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc) {
+    if((enc != encoding::PLAIN && enc != encoding::DELTA) || (prim_width != 32 && prim_width != 64)){
+        std::cout<<"Unsupported encoding selected" << std::endl;
+        return status::FAIL;
+    }
+
+    if(arr_buffer == nullptr){
+        arrow::AllocateBuffer(pool, num_values*prim_width/8, &arr_buffer);
+    }
+    uint8_t* arr_buf_ptr = arr_buffer->mutable_data();
+
+    DirectReadRing ring(direct_fd, file_size, file_offset, o_direct);
+    direct_buffer* buffer;
+
+    if(ring.next(&buffer) != status::OK){
+        return status::FAIL;
+    }
+
+    const uint8_t* page_ptr = buffer->data + (file_offset - buffer->file_offset);
+    int64_t total_value_counter = 0;
+
+    page_header header;
+
+    while(total_value_counter < num_values){
+        const uint8_t* buffer_end = buffer->data + buffer->length;
+        bool last_buffer = buffer->file_offset + buffer->length >= (int64_t) file_size;
+
+        // Find the pages that are completely inside this buffer
+        const uint8_t* batch_end = page_ptr;
+        int64_t batch_values = 0;
+
+        while(total_value_counter + batch_values < num_values){
+            // The header itself may straddle the buffer boundary
+            if(!last_buffer && buffer_end - batch_end < PAGE_HEADER_MAX_BYTES){
+                break;
+            }
+
+            // Headers are decoded one page at a time, read_metadata would look past a dictionary page and possibly past
+            // the end of the buffer
+            if(batch_end >= buffer_end || decode_page_header(batch_end, std::min(batch_end + PAGE_HEADER_MAX_BYTES, buffer_end), &header) != status::OK) {
+                std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
+                std::cerr << buffer->file_offset + (batch_end-buffer->data) << std::endl;
+                return status::FAIL;
+            }
+
+            if(buffer_end - batch_end < header.header_size + header.compressed_size){
+                break;
+            }
+
+            batch_end += header.header_size + header.compressed_size;
+
+            // Dictionary and index pages are skipped by the decoding kernels
+            if(header.type == page_type::DATA_PAGE || header.type == page_type::DATA_PAGE_V2){
+                batch_values += header.num_values;
+            }
+        }
+
+        if(batch_values > 0){
+            int64_t values_to_read = std::min(batch_values, num_values - total_value_counter);
+            uint8_t* out_ptr = arr_buf_ptr + total_value_counter*prim_width/8;
+            status result;
+
+            if(enc == encoding::PLAIN){
+                result = decode_prim_plain(page_ptr, prim_width, values_to_read, out_ptr);
+            } else if(prim_width == 32){
+                result = decode_prim_delta32(page_ptr, values_to_read, (int32_t*) out_ptr);
+            } else {
+                result = decode_prim_delta64(page_ptr, values_to_read, (int64_t*) out_ptr);
+            }
+
+            if(result != status::OK){
+                return status::FAIL;
+            }
+
+            total_value_counter += values_to_read;
+            page_ptr = batch_end;
+        }
+
+        if(total_value_counter >= num_values){
+            break;
+        }
+
+        // Carry the start of the straddling page over to the next buffer
+        int64_t carry_size = buffer_end - page_ptr;
+
+        if(carry_size > DIRECT_MAX_PAGE_BYTES){
+            std::cerr << "[ERROR] Parquet page larger than the O_DIRECT buffers (" << DIRECT_MAX_PAGE_BYTES << " bytes)" << std::endl;
+            return status::FAIL;
+        }
+
+        direct_buffer* next_buffer;
+        if(ring.next(&next_buffer) != status::OK){
+            std::cerr << "[ERROR] Unexpected end of Parquet file" << std::endl;
+            return status::FAIL;
+        }
+
+        std::memcpy(next_buffer->data - carry_size, page_ptr, carry_size);
+        page_ptr = next_buffer->data - carry_size;
+
+        ring.release(buffer);
+        buffer = next_buffer;
+    }
+
+    if(prim_width == 64){
+        *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int64(), num_values, arr_buffer);
+    } else {
+        *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int32(), num_values, arr_buffer);
+    }
+
+    return status::OK;
+}
+
+}
@@ -0,0 +1,300 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include <SWParquetReader.h>
+#include <LemireBitUnpacking.h>
+#include <ptoa.h>
+
+namespace ptoa {
+
+namespace {
+
+template<predicate_op OP>
+inline bool matches(int64_t value, int64_t lo, int64_t hi, const int64_t* set, size_t set_size) {
+    switch(OP) {
+        case predicate_op::EQUAL:
+            return value == lo;
+        case predicate_op::LESS:
+            return value < lo;
+        case predicate_op::BETWEEN:
+            return (value >= lo) & (value <= hi);
+        case predicate_op::IN_SET: {
+            bool found = false;
+            for(size_t i=0; i<set_size; i++){
+                found |= (value == set[i]);
+            }
+            return found;
+        }
+    }
+    return false;
+}
+
+// True if any value in [page_min, page_max] could satisfy the predicate
+bool can_match(const predicate& pred, int64_t page_min, int64_t page_max) {
+    switch(pred.op) {
+        case predicate_op::EQUAL:
+            return (pred.lo >= page_min) && (pred.lo <= page_max);
+        case predicate_op::LESS:
+            return page_min < pred.lo;
+        case predicate_op::BETWEEN:
+            return (pred.lo <= page_max) && (pred.hi >= page_min);
+        case predicate_op::IN_SET:
+            for(auto value : pred.set){
+                if((value >= page_min) && (value <= page_max)){
+                    return true;
+                }
+            }
+            return false;
+    }
+    return true;
+}
+
+}
+
+status SWParquetReader::filter_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, const predicate& pred, std::shared_ptr<arrow::Buffer> sel_bitmap, int64_t* num_selected, encoding enc) {
+    if(enc != encoding::DELTA){
+        std::cout<<"Unsupported encoding selected" << std::endl;
+        return status::FAIL;
+    }
+
+    uint8_t* sel_ptr = sel_bitmap->mutable_data();
+
+    if(prim_width == 32){
+        switch(pred.op) {
+            case predicate_op::EQUAL:   return filter_prim_delta<int32_t, predicate_op::EQUAL>(num_values, file_offset, pred, sel_ptr, num_selected, nullptr);
+            case predicate_op::LESS:    return filter_prim_delta<int32_t, predicate_op::LESS>(num_values, file_offset, pred, sel_ptr, num_selected, nullptr);
+            case predicate_op::BETWEEN: return filter_prim_delta<int32_t, predicate_op::BETWEEN>(num_values, file_offset, pred, sel_ptr, num_selected, nullptr);
+            case predicate_op::IN_SET:  return filter_prim_delta<int32_t, predicate_op::IN_SET>(num_values, file_offset, pred, sel_ptr, num_selected, nullptr);
+        }
+    } else if(prim_width == 64){
+        switch(pred.op) {
+            case predicate_op::EQUAL:   return filter_prim_delta<int64_t, predicate_op::EQUAL>(num_values, file_offset, pred, sel_ptr, num_selected, nullptr);
+            case predicate_op::LESS:    return filter_prim_delta<int64_t, predicate_op::LESS>(num_values, file_offset, pred, sel_ptr, num_selected, nullptr);
+            case predicate_op::BETWEEN: return filter_prim_delta<int64_t, predicate_op::BETWEEN>(num_values, file_offset, pred, sel_ptr, num_selected, nullptr);
+            case predicate_op::IN_SET:  return filter_prim_delta<int64_t, predicate_op::IN_SET>(num_values, file_offset, pred, sel_ptr, num_selected, nullptr);
+        }
+    }
+
+    std::cerr << "[ERROR] Unsupported prim width " << prim_width << std::endl;
+    return status::FAIL;
+}
+
+// Same as filter_prim but also copies the matching values into arr_buffer (which must be able to hold num_values values).
+status SWParquetReader::filter_prim(int32_t prim_width, int64_t num_values, int32_t file_offset, const predicate& pred, std::shared_ptr<arrow::Buffer> sel_bitmap, int64_t* num_selected, std::shared_ptr<arrow::PrimitiveArray>* selected_array, std::shared_ptr<arrow::Buffer> arr_buffer, encoding enc) {
+    if(enc != encoding::DELTA){
+        std::cout<<"Unsupported encoding selected" << std::endl;
+        return status::FAIL;
+    }
+
+    uint8_t* sel_ptr = sel_bitmap->mutable_data();
+    status result = status::FAIL;
+
+    if(prim_width == 32){
+        int32_t* arr_buf_ptr = (int32_t*)arr_buffer->mutable_data();
+        switch(pred.op) {
+            case predicate_op::EQUAL:   result = filter_prim_delta<int32_t, predicate_op::EQUAL>(num_values, file_offset, pred, sel_ptr, num_selected, arr_buf_ptr); break;
+            case predicate_op::LESS:    result = filter_prim_delta<int32_t, predicate_op::LESS>(num_values, file_offset, pred, sel_ptr, num_selected, arr_buf_ptr); break;
+            case predicate_op::BETWEEN: result = filter_prim_delta<int32_t, predicate_op::BETWEEN>(num_values, file_offset, pred, sel_ptr, num_selected, arr_buf_ptr); break;
+            case predicate_op::IN_SET:  result = filter_prim_delta<int32_t, predicate_op::IN_SET>(num_values, file_offset, pred, sel_ptr, num_selected, arr_buf_ptr); break;
+        }
+        if(result == status::OK){
+            *selected_array = std::make_shared<arrow::PrimitiveArray>(arrow::int32(), *num_selected, arr_buffer);
+        }
+    } else if(prim_width == 64){
+        int64_t* arr_buf_ptr = (int64_t*)arr_buffer->mutable_data();
+        switch(pred.op) {
+            case predicate_op::EQUAL:   result = filter_prim_delta<int64_t, predicate_op::EQUAL>(num_values, file_offset, pred, sel_ptr, num_selected, arr_buf_ptr); break;
+            case predicate_op::LESS:    result = filter_prim_delta<int64_t, predicate_op::LESS>(num_values, file_offset, pred, sel_ptr, num_selected, arr_buf_ptr); break;
+            case predicate_op::BETWEEN: result = filter_prim_delta<int64_t, predicate_op::BETWEEN>(num_values, file_offset, pred, sel_ptr, num_selected, arr_buf_ptr); break;
+            case predicate_op::IN_SET:  result = filter_prim_delta<int64_t, predicate_op::IN_SET>(num_values, file_offset, pred, sel_ptr, num_selected, arr_buf_ptr); break;
+        }
+        if(result == status::OK){
+            *selected_array = std::make_shared<arrow::PrimitiveArray>(arrow::int64(), *num_selected, arr_buffer);
+        }
+    } else {
+        std::cerr << "[ERROR] Unsupported prim width " << prim_width << std::endl;
+    }
+
+    return result;
+}
+
+// Decode num_values delta encoded values and evaluate pred on each miniblock right after unpacking it.
+// Bit i of sel_bitmap (LSB first, same layout as an Arrow validity bitmap) is set if value i matches.
+// If selected_values is not a nullptr the matching values are also written to it back to back.
+// Before decoding a page, the range of values it can contain is bounded using its first value, the min_delta
+// and bit widths of its blocks. Pages that cannot contain a match are skipped without unpacking.
+template<typename T, predicate_op OP>
+status SWParquetReader::filter_prim_delta(int64_t num_values, int32_t file_offset, const predicate& pred, uint8_t* sel_bitmap, int64_t* num_selected, T* selected_values) {
+    // This walker does not wait for individual pages to arrive with ingestion::IO_URING
+    if(wait_ingested() != status::OK){
+        return status::FAIL;
+    }
+
+    typedef typename std::make_unsigned<T>::type U;
+
+    uint8_t* page_ptr = parquet_data;
+
+    int64_t total_value_counter = 0;
+    int32_t page_value_counter;
+    int64_t selected_counter = 0;
+
+    // Metadata reading variables
+    int32_t uncompressed_size;
+    int32_t compressed_size;
+    int32_t page_num_values;
+    int32_t def_level_length;
+    int32_t rep_level_length;
+    int32_t metadata_size;
+
+    // Delta/block header reading variables. 32 bit pages store the same zigzag varints, so the 64 bit readers work for both.
+    int32_t page_values_to_read;
+    uint8_t* block_ptr;
+    int64_t first_value;
+    int64_t min_delta;
+    uint8_t bitwidths[MINIBLOCKS_IN_BLOCK];
+    int32_t header_size;
+    U unpacked_deltas[BLOCK_SIZE/MINIBLOCKS_IN_BLOCK];
+
+    // Predicate operands, kept in locals so they stay in registers in the inner loop
+    const int64_t lo = pred.lo;
+    const int64_t hi = pred.hi;
+    const int64_t* set = pred.set.data();
+    const size_t set_size = pred.set.size();
+
+    std::memset(sel_bitmap, 0, (num_values+7)/8);
+
+    page_ptr += file_offset;
+
+    while(total_value_counter < num_values){
+        page_value_counter = 0;
+
+        // Read page metadata
+        if(read_metadata(page_ptr, encoding::DELTA, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
+            std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
+            std::cerr << page_ptr-parquet_data << std::endl;
+            return status::FAIL;
+        }
+        page_ptr += metadata_size;
+        block_ptr = page_ptr;
+        page_values_to_read = std::min(page_num_values, (int32_t)(num_values-total_value_counter));
+
+        // Read delta header
+        if(read_delta_header64(block_ptr, &first_value, &header_size) != status::OK){
+            return status::FAIL;
+        }
+        block_ptr += header_size;
+
+        // Bound the values in the page by walking its block headers. Any step may add between min_delta and
+        // min_delta + 2^bitwidth - 1 to the previous value. If the bounds leave the range of T the values
+        // might have wrapped around, in which case the page can not be skipped.
+        {
+            __int128 cur_min = first_value;
+            __int128 cur_max = first_value;
+            __int128 page_min = first_value;
+            __int128 page_max = first_value;
+            const uint8_t* bound_ptr = block_ptr;
+            int32_t remaining = page_num_values-1;
+            bool bounded = true;
+
+            while(remaining > 0){
+                if(read_block_header64(bound_ptr, &min_delta, bitwidths, &header_size) != status::OK){
+                    return status::FAIL;
+                }
+                bound_ptr += header_size;
+
+                for(int i=0; (i<MINIBLOCKS_IN_BLOCK) && (remaining > 0); i++){
+                    int32_t steps = std::min(remaining, BLOCK_SIZE/MINIBLOCKS_IN_BLOCK);
+                    __int128 step_min = min_delta;
+                    __int128 step_max = (__int128)min_delta + ((((__int128)1) << bitwidths[i]) - 1);
+
+                    page_min = std::min(page_min, cur_min + std::min((__int128)0, steps*step_min));
+                    page_max = std::max(page_max, cur_max + std::max((__int128)0, steps*step_max));
+                    cur_min += steps*step_min;
+                    cur_max += steps*step_max;
+
+                    bound_ptr += bitwidths[i]*((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)/8);
+                    remaining -= steps;
+                }
+
+                if((page_min < std::numeric_limits<T>::min()) || (page_max > std::numeric_limits<T>::max())){
+                    bounded = false;
+                    break;
+                }
+            }
+
+            if(bounded && !can_match(pred, (int64_t)page_min, (int64_t)page_max)){
+                page_ptr += compressed_size;
+                total_value_counter += page_num_values;
+                continue;
+            }
+        }
+
+        // Evaluate first value of the page
+        T current_value = (T)first_value;
+        bool match = matches<OP>(current_value, lo, hi, set, set_size);
+        sel_bitmap[total_value_counter>>3] |= (uint8_t)(match << (total_value_counter & 7));
+        if(selected_values != nullptr){
+            selected_values[selected_counter] = current_value;
+        }
+        selected_counter += match;
+        page_value_counter++;
+
+        // Keep on looping through the blocks in the page until exactly page_values_to_read have been processed.
+        while(page_value_counter < page_values_to_read){
+            if(read_block_header64(block_ptr, &min_delta, bitwidths, &header_size) != status::OK){
+                return status::FAIL;
+            }
+            block_ptr += header_size;
+
+            for(int i=0; i<MINIBLOCKS_IN_BLOCK; i++){
+                uint8_t current_bitwidth = bitwidths[i];
+                unpack_miniblock(block_ptr, unpacked_deltas, current_bitwidth);
+
+                for(int j=0; j<(BLOCK_SIZE/MINIBLOCKS_IN_BLOCK); j++){
+                    current_value = (T)((U)current_value + unpacked_deltas[j] + (U)min_delta);
+
+                    int64_t value_index = total_value_counter + page_value_counter;
+                    match = matches<OP>(current_value, lo, hi, set, set_size);
+                    sel_bitmap[value_index>>3] |= (uint8_t)(match << (value_index & 7));
+                    if(selected_values != nullptr){
+                        selected_values[selected_counter] = current_value;
+                    }
+                    selected_counter += match;
+                    page_value_counter++;
+
+                    // Nested loops termination condition
+                    if(page_value_counter >= page_values_to_read){
+                        goto end_of_page;
+                    }
+                }
+
+                block_ptr += current_bitwidth*((BLOCK_SIZE/MINIBLOCKS_IN_BLOCK)/8);
+            }
+        }
+
+        end_of_page:
+        page_ptr += compressed_size;
+        total_value_counter += page_num_values;
+    }
+
+    *num_selected = selected_counter;
+
+    return status::OK;
+}
+
+}
@@ -0,0 +1,300 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include <SWParquetReader.h>
+#include <LemireBitUnpacking.h>
+#include <PageHeader.h>
+#include <Varint.h>
+#include <ptoa.h>
+
+// Values fastunpack unpacks at once
+#define UNPACK_GROUP_SIZE 32
+
+namespace ptoa {
+
+namespace {
+
+int bit_length(uint64_t value) {
+    return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+void add_string_length(page_stats* page, int64_t length) {
+    if(page->num_strings == 0){
+        page->string_length_min = length;
+        page->string_length_max = length;
+    }
+    page->string_length_min = std::min(page->string_length_min, length);
+    page->string_length_max = std::max(page->string_length_max, length);
+    page->string_lengths[bit_length(length)]++;
+    page->num_strings++;
+    page->num_chars += length;
+}
+
+void add_min_delta(page_stats* page, int64_t min_delta) {
+    if(page->blocks == 0){
+        page->min_delta_min = min_delta;
+        page->min_delta_max = min_delta;
+    }
+    page->min_delta_min = std::min(page->min_delta_min, min_delta);
+    page->min_delta_max = std::max(page->min_delta_max, min_delta);
+    page->min_delta_lengths[bit_length(((uint64_t) min_delta << 1) ^ (uint64_t) (min_delta >> 63))]++;
+    page->blocks++;
+}
+
+// Walk the DELTA_BINARY_PACKED values between ptr and end. Unlike the decoders this accepts any block size that the
+// format allows, since the files being inspected need not come from the transcoder. With string_lengths set the values
+// are the lengths of a DELTA_LENGTH_BYTE_ARRAY page, which are decoded to collect their distribution.
+status walk_delta(const uint8_t* ptr, const uint8_t* end, bool string_lengths, page_stats* page) {
+    int64_t block_size;
+    int64_t miniblocks;
+    int64_t total_count;
+    int64_t value;
+
+    ptr += decode_varint64(ptr, &block_size, false);
+    ptr += decode_varint64(ptr, &miniblocks, false);
+    ptr += decode_varint64(ptr, &total_count, false);
+    ptr += decode_varint64(ptr, &value, true);
+
+    if(ptr > end || block_size <= 0 || block_size%128 != 0 || miniblocks <= 0 || block_size%miniblocks != 0 ||
+       (block_size/miniblocks)%UNPACK_GROUP_SIZE != 0 || total_count < 0){
+        return status::FAIL;
+    }
+    int64_t miniblock_size = block_size/miniblocks;
+    page->delta_block_size = block_size;
+    page->delta_miniblocks = miniblocks;
+
+    if(string_lengths && total_count > 0){
+        if(value < 0){
+            return status::FAIL;
+        }
+        add_string_length(page, value);
+    }
+
+    uint32_t unpacked[UNPACK_GROUP_SIZE];
+    int32_t length = (int32_t) value;
+    int64_t remaining = total_count - 1;
+
+    while(remaining > 0){
+        int64_t min_delta;
+        if(ptr >= end){
+            return status::FAIL;
+        }
+        ptr += decode_varint64(ptr, &min_delta, true);
+        const uint8_t* bitwidths = ptr;
+        ptr += miniblocks;
+        if(ptr > end){
+            return status::FAIL;
+        }
+        add_min_delta(page, min_delta);
+
+        // Miniblocks past the last value are not stored
+        for(int64_t m=0; m<miniblocks && remaining > 0; m++){
+            uint8_t bitwidth = bitwidths[m];
+            if(bitwidth > (string_lengths ? 32 : 64) || ptr + bitwidth*miniblock_size/8 > end){
+                return status::FAIL;
+            }
+            page->miniblock_widths[bitwidth]++;
+
+            if(string_lengths){
+                for(int64_t g=0; g<miniblock_size && remaining > 0; g+=UNPACK_GROUP_SIZE){
+                    fastunpack((const uint*) (ptr + bitwidth*g/8), unpacked, bitwidth);
+                    for(int i=0; i<UNPACK_GROUP_SIZE && remaining > 0; i++, remaining--){
+                        length = (int32_t) ((uint32_t) length + (uint32_t) min_delta + unpacked[i]);
+                        if(length < 0){
+                            return status::FAIL;
+                        }
+                        add_string_length(page, length);
+                    }
+                }
+            } else {
+                remaining -= std::min(remaining, miniblock_size);
+            }
+
+            ptr += bitwidth*miniblock_size/8;
+        }
+    }
+
+    return status::OK;
+}
+
+// Walk the lengths of the plain encoded byte arrays between ptr and end
+status walk_plain_byte_arrays(const uint8_t* ptr, const uint8_t* end, page_stats* page) {
+    while(ptr + sizeof(uint32_t) <= end){
+        uint32_t length;
+        std::memcpy(&length, ptr, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+        if(length > (uint64_t) (end - ptr)){
+            return status::FAIL;
+        }
+        add_string_length(page, length);
+        ptr += length;
+    }
+
+    return ptr == end ? status::OK : status::FAIL;
+}
+
+}
+
+// Collect the statistics of all pages from file_offset on. The page headers are walked first, after which the values of
+// the pages are inspected by options.num_threads threads that each take a contiguous range of pages.
+status SWParquetReader::inspect_pages(int64_t file_offset, const inspect_options& options, std::vector<page_stats>* pages) {
+    if(ingestion_mode == ingestion::DIRECT){
+        std::cerr << "[ERROR] Inspecting pages is not supported with ingestion::DIRECT" << std::endl;
+        return status::FAIL;
+    }
+    if(wait_ingested() != status::OK){
+        return status::FAIL;
+    }
+
+    int64_t end_offset = options.end_offset < 0 ? file_size : std::min((int64_t) file_size, options.end_offset);
+    int64_t page_offset = file_offset;
+
+    pages->clear();
+
+    while(page_offset < end_offset){
+        page_header header;
+        const uint8_t* limit = parquet_data + std::min(end_offset, page_offset + PAGE_HEADER_MAX_BYTES);
+
+        if(decode_page_header(parquet_data + page_offset, limit, &header) != status::OK || header.compressed_size < 0 ||
+           page_offset + header.header_size + header.compressed_size > end_offset){
+            break;
+        }
+
+        page_stats page;
+        std::memset(&page, 0, sizeof(page_stats));
+        page.offset = page_offset;
+        page.type = header.type;
+        page.parquet_encoding = header.parquet_encoding;
+        page.is_compressed = header.is_compressed;
+        page.header_size = header.header_size;
+        page.compressed_size = header.compressed_size;
+        page.uncompressed_size = header.uncompressed_size;
+        page.num_values = header.num_values;
+        page.num_nulls = header.num_nulls;
+        page.def_level_length = header.def_level_length;
+        page.rep_level_length = header.rep_level_length;
+        pages->push_back(page);
+
+        page_offset += header.header_size + header.compressed_size;
+    }
+
+    // Without an explicit end the pages simply end where the footer or the end of the file starts
+    if(options.end_offset >= 0 && page_offset != end_offset){
+        std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
+        std::cerr << page_offset << std::endl;
+        return status::FAIL;
+    }
+
+    if(options.headers_only || pages->empty()){
+        return status::OK;
+    }
+
+    int num_threads = std::max(1, std::min(options.num_threads, (int) pages->size()));
+    std::vector<status> results(num_threads, status::OK);
+
+    std::vector<std::thread> workers;
+    for(int w=0; w<num_threads; w++){
+        workers.push_back(std::thread([&, w](){
+            size_t first = pages->size()*w/num_threads;
+            size_t last = pages->size()*(w+1)/num_threads;
+
+            for(size_t p=first; p<last && results[w] == status::OK; p++){
+                results[w] = inspect_values(options, &(*pages)[p]);
+            }
+        }));
+    }
+
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+
+    for(status result : results){
+        if(result != status::OK){
+            return status::FAIL;
+        }
+    }
+
+    return status::OK;
+}
+
+status SWParquetReader::inspect_values(const inspect_options& options, page_stats* page) {
+    const uint8_t* ptr = parquet_data + page->offset + page->header_size;
+    const uint8_t* end = ptr + page->compressed_size;
+
+    if(page->type == page_type::DATA_PAGE_V2){
+        if(options.compressed && page->is_compressed){
+            return status::OK;
+        }
+        ptr += page->rep_level_length + page->def_level_length;
+    } else if(page->type == page_type::DATA_PAGE){
+        if(options.compressed){
+            return status::OK;
+        }
+        // RLE encoded levels, each preceded by their length
+        int levels = (options.max_repetition_level > 0 ? 1 : 0) + (options.max_definition_level > 0 ? 1 : 0);
+        for(int l=0; l<levels; l++){
+            uint32_t levels_size;
+            if(ptr + sizeof(uint32_t) > end){
+                std::cerr << "[ERROR] Levels run past the end of the page at file offset " << page->offset << std::endl;
+                return status::FAIL;
+            }
+            std::memcpy(&levels_size, ptr, sizeof(uint32_t));
+            ptr += sizeof(uint32_t);
+            if(levels_size > (uint64_t) (end - ptr)){
+                std::cerr << "[ERROR] Levels run past the end of the page at file offset " << page->offset << std::endl;
+                return status::FAIL;
+            }
+            ptr += levels_size;
+        }
+    } else {
+        return status::OK;
+    }
+
+    if(ptr > end){
+        std::cerr << "[ERROR] Levels run past the end of the page at file offset " << page->offset << std::endl;
+        return status::FAIL;
+    }
+
+    status result;
+    switch(page->parquet_encoding){
+        case PARQUET_DELTA_BINARY_PACKED:
+            result = walk_delta(ptr, end, false, page);
+            break;
+        case PARQUET_DELTA_LENGTH_BYTE_ARRAY:
+            result = walk_delta(ptr, end, true, page);
+            break;
+        case PARQUET_PLAIN:
+            if(!options.byte_array){
+                return status::OK;
+            }
+            result = walk_plain_byte_arrays(ptr, end, page);
+            break;
+        default:
+            return status::OK;
+    }
+
+    if(result != status::OK){
+        std::cerr << "[ERROR] Corrupted values in the page at file offset " << page->offset << std::endl;
+        return status::FAIL;
+    }
+
+    page->inspected = true;
+
+    return status::OK;
+}
+
+}
@@ -0,0 +1,330 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <SWParquetReader.h>
+#include <Numa.h>
+#include <ptoa.h>
+
+// Zeroed bytes after the last page of a replica
+#define REPLICA_PADDING 64
+
+namespace ptoa {
+
+namespace {
+
+// Split pages[begin, end) into one contiguous range per weight, with an amount of values in every range roughly
+// proportional to its weight. The range of part i is [(*bounds)[i], (*bounds)[i+1]).
+void split_pages(const std::vector<page_info>& pages, size_t begin, size_t end, const std::vector<int>& weights, std::vector<size_t>* bounds) {
+    // An empty range, e.g. no values or a node without pages, gives every part an empty range
+    if(begin >= end){
+        bounds->assign(weights.size()+1, begin);
+        return;
+    }
+
+    int total_weight = 0;
+    for(int weight : weights){
+        total_weight += weight;
+    }
+
+    int64_t first_value = pages[begin].first_value_index;
+    int64_t range_values = pages[end-1].first_value_index + pages[end-1].num_values - first_value;
+
+    bounds->clear();
+    bounds->push_back(begin);
+
+    size_t page = begin;
+    int cumulative_weight = 0;
+    for(size_t part=0; part+1<weights.size(); part++){
+        cumulative_weight += weights[part];
+        int64_t target = first_value + (int64_t)((__int128) range_values*cumulative_weight/total_weight);
+
+        while(page < end && pages[page].first_value_index < target){
+            page++;
+        }
+        bounds->push_back(page);
+    }
+
+    bounds->push_back(end);
+}
+
+}
+
+// Walk the page headers of the column chunk at file_offset until num_values values are covered. With a negative num_values
+// all pages are indexed until end_offset, or without end_offset until the end of the file or the first structure that is
+// not a page header (e.g. the footer). Pages may not extend past end_offset, the end of the column chunk, and all data
+// pages have to be decodable as enc.
+status SWParquetReader::index_pages(int64_t num_values, int64_t file_offset, encoding enc, std::vector<page_info>* pages, int64_t end_offset) {
+    if(ingestion_mode == ingestion::DIRECT){
+        std::cerr << "[ERROR] Indexing pages is not supported with ingestion::DIRECT" << std::endl;
+        return status::FAIL;
+    }
+
+    bool bounded = end_offset >= 0;
+    if(!bounded){
+        end_offset = file_size;
+    } else if(end_offset > (int64_t) file_size){
+        std::cerr << "[ERROR] Column chunk ends at " << end_offset << ", past the end of the file" << std::endl;
+        return status::FAIL;
+    }
+
+    int64_t page_offset = file_offset;
+    int64_t total_value_counter = 0;
+
+    // Metadata reading variables
+    int32_t uncompressed_size;
+    int32_t compressed_size;
+    int32_t page_num_values;
+    int32_t def_level_length;
+    int32_t rep_level_length;
+    int32_t metadata_size;
+
+    bool all_pages = num_values < 0;
+
+    pages->clear();
+
+    while(all_pages || total_value_counter < num_values){
+        if(all_pages && page_offset >= end_offset){
+            break;
+        }
+
+        if(page_offset >= end_offset || wait_resident(parquet_data + page_offset, PAGE_HEADER_MAX_BYTES) != status::OK){
+            std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
+            std::cerr << page_offset << std::endl;
+            return status::FAIL;
+        }
+
+        // Without end_offset the pages end at the first structure that is not a page header
+        page_header header;
+        if(all_pages && !bounded && read_page_header(parquet_data + page_offset, true, &header) != status::OK){
+            break;
+        }
+
+        if(read_metadata(parquet_data + page_offset, enc, &uncompressed_size, &compressed_size, &page_num_values, &def_level_length, &rep_level_length, &metadata_size) != status::OK) {
+            std::cerr << "[ERROR] Corrupted data in Parquet page headers" << std::endl;
+            std::cerr << page_offset << std::endl;
+            return status::FAIL;
+        }
+
+        if(bounded && page_offset + metadata_size + compressed_size > end_offset){
+            std::cerr << "[ERROR] Page at file offset " << page_offset << " extends past the end of its column chunk" << std::endl;
+            return status::FAIL;
+        }
+
+        page_info page;
+        page.offset = page_offset;
+        page.size = metadata_size + compressed_size;
+        page.num_values = page_num_values;
+        page.first_value_index = total_value_counter;
+        pages->push_back(page);
+
+        page_offset += page.size;
+        total_value_counter += page_num_values;
+    }
+
+    return status::OK;
+}
+
+// Decode a column chunk with multiple threads. Pages are first divided over the NUMA nodes and then over the threads of
+// every node. Every worker writes its own slice of the output buffer, which is left untouched until then so its memory
+// pages end up on the node of the worker that writes them (first touch). Only effective if the pool returns fresh
+// memory for the output buffer.
+status SWParquetReader::read_prim_parallel(int32_t prim_width, int64_t num_values, int32_t file_offset, std::shared_ptr<arrow::PrimitiveArray>* prim_array, encoding enc, const parallel_options& options, parallel_stats* stats) {
+    if((enc != encoding::PLAIN && enc != encoding::DELTA) || (prim_width != 32 && prim_width != 64)){
+        std::cout<<"Unsupported encoding selected" << std::endl;
+        return status::FAIL;
+    }
+
+    std::vector<page_info> pages;
+    if(index_pages(num_values, file_offset, enc, &pages) != status::OK){
+        return status::FAIL;
+    }
+
+    numa_topology topology;
+    if(options.numa_aware){
+        detect_numa_topology(&topology);
+    } else {
+        // Single group without pinning
+        topology.node_ids.push_back(-1);
+        topology.node_cpus.push_back(std::vector<int>());
+    }
+
+    // Divide the threads over the nodes, nodes without threads do not take part
+    int num_threads = std::max(options.num_threads, 1);
+    std::vector<int> node_indices;
+    std::vector<int> node_threads;
+    for(int n=0; n<topology.num_nodes(); n++){
+        int threads = num_threads/topology.num_nodes() + (n < num_threads%topology.num_nodes() ? 1 : 0);
+        if(threads > 0){
+            node_indices.push_back(n);
+            node_threads.push_back(threads);
+        }
+    }
+    int num_nodes = node_indices.size();
+
+    std::vector<size_t> node_bounds;
+    split_pages(pages, 0, pages.size(), node_threads, &node_bounds);
+
+    std::shared_ptr<arrow::Buffer> arr_buffer;
+    arrow::AllocateBuffer(pool, num_values*prim_width/8, &arr_buffer);
+    uint8_t* arr_buf_ptr = arr_buffer->mutable_data();
+
+    // Optionally copy the pages of every node into memory local to that node. The copy is done by a thread pinned to
+    // the node so the replica is first touched there.
+    std::vector<uint8_t*> node_input(num_nodes, parquet_data);
+    std::vector<int64_t> node_input_offset(num_nodes, 0);
+    if(options.replicate_input){
+        std::vector<std::thread> copiers;
+        for(int n=0; n<num_nodes; n++){
+            if(node_bounds[n] == node_bounds[n+1]){
+                continue;
+            }
+
+            const page_info& first = pages[node_bounds[n]];
+            const page_info& last = pages[node_bounds[n+1]-1];
+
+            copiers.push_back(std::thread([&, n, first, last](){
+                if(options.numa_aware){
+                    pin_thread_to_cpus(topology.node_cpus[node_indices[n]]);
+                }
+
+                // The bit unpacking kernels read whole words, which may extend past the end of the last page
+                int64_t size = last.offset + last.size - first.offset;
+                uint8_t* replica = (uint8_t*) std::malloc(size + REPLICA_PADDING);
+
+                // On failure the workers decode from parquet_data and report the error themselves
+                if(wait_resident(parquet_data + first.offset, size) != status::OK){
+                    std::free(replica);
+                    return;
+                }
+
+                std::memcpy(replica, parquet_data + first.offset, size);
+                std::memset(replica + size, 0, REPLICA_PADDING);
+                node_input[n] = replica;
+                node_input_offset[n] = first.offset;
+            }));
+        }
+
+        for(std::thread& copier : copiers){
+            copier.join();
+        }
+    }
+
+    struct worker_range {
+        int node;
+        size_t first_page;
+        size_t end_page;
+        status result;
+        double seconds;
+    };
+
+    std::vector<worker_range> ranges;
+    for(int n=0; n<num_nodes; n++){
+        std::vector<size_t> thread_bounds;
+        std::vector<int> thread_weights(node_threads[n], 1);
+
+        if(node_bounds[n] == node_bounds[n+1]){
+            continue;
+        }
+        split_pages(pages, node_bounds[n], node_bounds[n+1], thread_weights, &thread_bounds);
+
+        for(int t=0; t<node_threads[n]; t++){
+            if(thread_bounds[t] < thread_bounds[t+1]){
+                ranges.push_back({n, thread_bounds[t], thread_bounds[t+1], status::OK, 0});
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    for(size_t w=0; w<ranges.size(); w++){
+        workers.push_back(std::thread([&, w](){
+            worker_range& range = ranges[w];
+            const page_info& first = pages[range.first_page];
+            const page_info& last = pages[range.end_page-1];
+
+            if(options.numa_aware){
+                pin_thread_to_cpus(topology.node_cpus[node_indices[range.node]]);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+
+            const uint8_t* page_ptr = node_input[range.node] + (first.offset - node_input_offset[range.node]);
+            int64_t range_values = std::min(last.first_value_index + last.num_values, num_values) - first.first_value_index;
+            uint8_t* out_ptr = arr_buf_ptr + first.first_value_index*prim_width/8;
+
+            if(enc == encoding::PLAIN){
+                range.result = decode_prim_plain(page_ptr, prim_width, range_values, out_ptr);
+            } else if(prim_width == 32){
+                range.result = decode_prim_delta32(page_ptr, range_values, (int32_t*) out_ptr);
+            } else {
+                range.result = decode_prim_delta64(page_ptr, range_values, (int64_t*) out_ptr);
+            }
+
+            range.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }));
+    }
+
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+
+    if(options.replicate_input){
+        for(int n=0; n<num_nodes; n++){
+            if(node_input[n] != parquet_data){
+                std::free(node_input[n]);
+            }
+        }
+    }
+
+    if(stats != nullptr){
+        stats->node_ids.assign(num_nodes, 0);
+        stats->node_bytes_in.assign(num_nodes, 0);
+        stats->node_bytes_out.assign(num_nodes, 0);
+        stats->node_seconds.assign(num_nodes, 0);
+
+        for(int n=0; n<num_nodes; n++){
+            stats->node_ids[n] = topology.node_ids[node_indices[n]];
+        }
+
+        for(const worker_range& range : ranges){
+            const page_info& first = pages[range.first_page];
+            const page_info& last = pages[range.end_page-1];
+            int64_t range_values = std::min(last.first_value_index + last.num_values, num_values) - first.first_value_index;
+
+            stats->node_bytes_in[range.node] += last.offset + last.size - first.offset;
+            stats->node_bytes_out[range.node] += range_values*prim_width/8;
+            stats->node_seconds[range.node] = std::max(stats->node_seconds[range.node], range.seconds);
+        }
+    }
+
+    for(const worker_range& range : ranges){
+        if(range.result != status::OK){
+            return status::FAIL;
+        }
+    }
+
+    if(prim_width == 64){
+        *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int64(), num_values, arr_buffer);
+    } else {
+        *prim_array = std::make_shared<arrow::PrimitiveArray>(arrow::int32(), num_values, arr_buffer);
+    }
+
+    return status::OK;
+}
+
+}
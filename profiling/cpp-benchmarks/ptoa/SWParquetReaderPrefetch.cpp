@@ -0,0 +1,158 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include <sys/mman.h>
+
+#include <SWParquetReader.h>
+#include <ptoa.h>
+
+#define CACHE_LINE_SIZE 64
+#define OS_PAGE_SIZE 4096
+
+namespace ptoa {
+
+// Start a prefetch pipeline for the page walker at page_ptr. The cursor runs prefetch_distance pages ahead, every call to
+// prefetch_next brings it back to that distance.
+void SWParquetReader::prefetch_start(prefetch_cursor* cursor, const uint8_t* page_ptr, int64_t num_values, encoding enc) {
+    cursor->page_ptr = page_ptr;
+    cursor->values_ahead = 0;
+    cursor->values_consumed = 0;
+    cursor->num_values = num_values;
+    cursor->enc = enc;
+    cursor->advised_end = page_ptr;
+    cursor->first_parsed = 0;
+    cursor->num_parsed = 0;
+
+    prefetch_next(cursor);
+}
+
+// Queue pages until the cursor is prefetch_distance pages ahead of the walker. That is one page per consumed page, but
+// after the cursor was reset by next_metadata or had to wait for ingestion it catches up with every page that arrived.
+void SWParquetReader::prefetch_next(prefetch_cursor* cursor) {
+    while(cursor->num_parsed < prefetch_distance && prefetch_page(cursor)){
+    }
+}
+
+// Parse the header at the cursor, prefetch the start of its payload and the header of the page after it. The header at
+// the cursor was prefetched by the previous call so parsing it does not stall the walker, and it is queued for the walker
+// so every header is only parsed once. Headers are only parsed for pages that the walker will decode anyway, so the
+// cursor never reads past the end of the column chunk. Returns whether a page was queued.
+bool SWParquetReader::prefetch_page(prefetch_cursor* cursor) {
+    if(prefetch_distance == 0 || cursor->values_ahead >= cursor->num_values || cursor->num_parsed == MAX_PREFETCH_DISTANCE){
+        return false;
+    }
+
+    bool in_file = points_into_file(cursor->page_ptr);
+    const uint8_t* header_ptr = cursor->page_ptr;
+    page_header header;
+
+    // Skip dictionary and index pages like read_metadata, but never block on asynchronous ingestion. The cursor catches
+    // up on later calls.
+    while(true){
+        if(!is_resident(header_ptr, PAGE_HEADER_MAX_BYTES)){
+            return false;
+        }
+
+        if(read_page_header(header_ptr, in_file, &header) != status::OK){
+            // Leave error reporting to the walker
+            cursor->values_ahead = cursor->num_values;
+            return false;
+        }
+
+        if(header.type == page_type::DATA_PAGE || header.type == page_type::DATA_PAGE_V2){
+            break;
+        }
+
+        header_ptr += header.header_size + header.compressed_size;
+    }
+
+    if(!is_decodable(header, cursor->enc, without_levels())){
+        // Leave error reporting to the walker
+        cursor->values_ahead = cursor->num_values;
+        return false;
+    }
+
+    prefetched_page& page = cursor->parsed[(cursor->first_parsed + cursor->num_parsed) % MAX_PREFETCH_DISTANCE];
+    page.page_ptr = cursor->page_ptr;
+    page.header = header;
+    page.metadata_size = header_ptr - cursor->page_ptr + header.header_size;
+    cursor->num_parsed++;
+
+    int32_t compressed_size = header.compressed_size;
+    const uint8_t* payload_ptr = cursor->page_ptr + page.metadata_size;
+    int32_t prefetch_bytes = std::min(compressed_size, PREFETCH_PAYLOAD_BYTES);
+
+    for(int32_t offset=0; offset<prefetch_bytes; offset+=CACHE_LINE_SIZE){
+        __builtin_prefetch(payload_ptr + offset, 0, 3);
+    }
+
+    cursor->page_ptr = payload_ptr + compressed_size;
+    cursor->values_ahead += header.num_values;
+
+    if(cursor->values_ahead < cursor->num_values){
+        __builtin_prefetch(cursor->page_ptr, 0, 3);
+    }
+
+    // Have the kernel read ahead of the cursor for mapped files, in large regions to keep the amount of system calls low.
+    // The cursor may also walk a copy of the pages (e.g. replicated input), which is not part of the mapping.
+    if(ingestion_mode == ingestion::MMAP && points_into_file(cursor->page_ptr) && cursor->page_ptr + READAHEAD_BYTES/2 > cursor->advised_end){
+        const uint8_t* advise_start = std::max(cursor->advised_end, cursor->page_ptr);
+        advise_start = (const uint8_t*) ((uintptr_t) advise_start & ~((uintptr_t) OS_PAGE_SIZE - 1));
+        int64_t advise_length = std::min((int64_t) READAHEAD_BYTES, (int64_t) (parquet_data + file_size - advise_start));
+
+        madvise((void*) advise_start, advise_length, MADV_WILLNEED);
+        cursor->advised_end = advise_start + advise_length;
+    }
+
+    return true;
+}
+
+// Metadata of the page at page_ptr for a page walker that runs the prefetch cursor, with the same outputs as
+// read_metadata. Headers the cursor already parsed are taken from it. Otherwise the cursor is not ahead of the walker,
+// because prefetching is disabled or the page had not arrived yet, and the header is parsed here, waiting for the page to
+// arrive. The cursor then continues after it, and the next prefetch_next refills it to prefetch_distance pages.
+status SWParquetReader::next_metadata(prefetch_cursor* cursor, const uint8_t* page_ptr, int32_t* uncompressed_size, int32_t* compressed_size,
+                                      int32_t* num_values, int32_t* def_level_length, int32_t* rep_level_length, int32_t* metadata_size) {
+    if(cursor->num_parsed > 0 && cursor->parsed[cursor->first_parsed].page_ptr == page_ptr){
+        const prefetched_page& page = cursor->parsed[cursor->first_parsed];
+
+        *uncompressed_size = page.header.uncompressed_size;
+        *compressed_size = page.header.compressed_size;
+        *num_values = page.header.num_values;
+        *def_level_length = page.header.def_level_length;
+        *rep_level_length = page.header.rep_level_length;
+        *metadata_size = page.metadata_size;
+
+        cursor->first_parsed = (cursor->first_parsed + 1) % MAX_PREFETCH_DISTANCE;
+        cursor->num_parsed--;
+        cursor->values_consumed += page.header.num_values;
+        return status::OK;
+    }
+
+    if(wait_resident(page_ptr, PAGE_HEADER_MAX_BYTES) != status::OK){
+        return status::FAIL;
+    }
+    if(read_metadata(page_ptr, cursor->enc, uncompressed_size, compressed_size, num_values, def_level_length, rep_level_length, metadata_size) != status::OK){
+        return status::FAIL;
+    }
+
+    cursor->page_ptr = page_ptr + *metadata_size + *compressed_size;
+    cursor->values_consumed += *num_values;
+    cursor->values_ahead = cursor->values_consumed;
+    cursor->first_parsed = 0;
+    cursor->num_parsed = 0;
+    return status::OK;
+}
+
+}
@@ -0,0 +1,152 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <SWParquetReader.h>
+#include <ptoa.h>
+
+namespace ptoa {
+
+namespace {
+
+// Bytes of Arrow data a column decodes into, used to start the most expensive columns first
+int64_t estimated_column_bytes(const column_spec& column) {
+    switch(column.field->type()->id()){
+        case arrow::Type::STRING:
+            return column.num_chars + (column.num_values+1)*sizeof(int32_t);
+        case arrow::Type::INT64:
+            return column.num_values*sizeof(int64_t);
+        default:
+            return column.num_values*sizeof(int32_t);
+    }
+}
+
+}
+
+status SWParquetReader::read_table(const std::vector<column_spec>& columns, std::shared_ptr<arrow::Table>* table, int num_threads) {
+    std::vector<std::shared_ptr<arrow::Array>> arrays;
+    if(read_columns(columns, num_threads, &arrays) != status::OK){
+        return status::FAIL;
+    }
+
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    for(const column_spec& column : columns){
+        fields.push_back(column.field);
+    }
+
+    *table = arrow::Table::Make(arrow::schema(fields), arrays);
+
+    return status::OK;
+}
+
+status SWParquetReader::read_record_batch(const std::vector<column_spec>& columns, std::shared_ptr<arrow::RecordBatch>* batch, int num_threads) {
+    std::vector<std::shared_ptr<arrow::Array>> arrays;
+    if(read_columns(columns, num_threads, &arrays) != status::OK){
+        return status::FAIL;
+    }
+
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    for(const column_spec& column : columns){
+        fields.push_back(column.field);
+    }
+
+    *batch = arrow::RecordBatch::Make(arrow::schema(fields), columns.empty() ? 0 : columns[0].num_values, arrays);
+
+    return status::OK;
+}
+
+// Decode every column with its own task. Columns are started from largest to smallest (by decoded size) by up to
+// num_threads workers, so the large string column of a table does not end up being decoded last while the other workers
+// are idle. With num_threads 0 every column gets a worker. The calling thread is one of the workers.
+status SWParquetReader::read_columns(const std::vector<column_spec>& columns, int num_threads, std::vector<std::shared_ptr<arrow::Array>>* arrays) {
+    for(const column_spec& column : columns){
+        if(column.num_values != columns[0].num_values){
+            std::cerr << "[ERROR] Column " << column.field->name() << " has " << column.num_values << " values instead of " << columns[0].num_values << std::endl;
+            return status::FAIL;
+        }
+    }
+
+    std::vector<size_t> order(columns.size());
+    for(size_t c=0; c<columns.size(); c++){
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){
+        return estimated_column_bytes(columns[a]) > estimated_column_bytes(columns[b]);
+    });
+
+    arrays->assign(columns.size(), nullptr);
+    std::vector<status> results(columns.size(), status::OK);
+    std::atomic<size_t> next_column(0);
+
+    auto worker = [&](){
+        size_t index;
+        while((index = next_column++) < order.size()){
+            size_t c = order[index];
+            results[c] = read_column(columns[c], &(*arrays)[c]);
+        }
+    };
+
+    int num_workers = num_threads > 0 ? std::min((size_t) num_threads, columns.size()) : columns.size();
+
+    std::vector<std::thread> workers;
+    for(int w=1; w<num_workers; w++){
+        workers.push_back(std::thread(worker));
+    }
+    worker();
+
+    for(std::thread& thread : workers){
+        thread.join();
+    }
+
+    for(size_t c=0; c<columns.size(); c++){
+        if(results[c] != status::OK){
+            std::cerr << "[ERROR] Could not read column " << columns[c].field->name() << std::endl;
+            return status::FAIL;
+        }
+    }
+
+    return status::OK;
+}
+
+status SWParquetReader::read_column(const column_spec& column, std::shared_ptr<arrow::Array>* array) {
+    switch(column.field->type()->id()){
+        case arrow::Type::INT32:
+        case arrow::Type::INT64: {
+            std::shared_ptr<arrow::PrimitiveArray> prim_array;
+            int32_t prim_width = column.field->type()->id() == arrow::Type::INT64 ? 64 : 32;
+
+            if(read_prim(prim_width, column.num_values, column.file_offset, &prim_array, column.enc) != status::OK){
+                return status::FAIL;
+            }
+            *array = prim_array;
+            return status::OK;
+        }
+        case arrow::Type::STRING: {
+            std::shared_ptr<arrow::StringArray> string_array;
+
+            if(read_string(column.num_values, column.num_chars, column.file_offset, &string_array, column.enc) != status::OK){
+                return status::FAIL;
+            }
+            *array = string_array;
+            return status::OK;
+        }
+        default:
+            std::cerr << "[ERROR] Unsupported type " << column.field->type()->ToString() << " for column " << column.field->name() << std::endl;
+            return status::FAIL;
+    }
+}
+
+}
@@ -0,0 +1,147 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+// Bytes the varint decoders load at once. Up to VARINT_LOAD_BYTES-1 bytes after the last byte of a varint are read, so
+// buffers holding Parquet data need that many readable bytes after the end of the file.
+#define VARINT_LOAD_BYTES 8
+
+namespace ptoa{
+
+namespace varint{
+
+const uint64_t CONTINUATION_BITS = 0x8080808080808080ULL;
+const uint64_t PAYLOAD_BITS = 0x7F7F7F7F7F7F7F7FULL;
+
+inline uint64_t load_word(const uint8_t* input) {
+    uint64_t word;
+    memcpy(&word, input, sizeof(word));
+    return word;
+}
+
+// Mask of the bytes of the varint at the start of word, 0 if it is longer than VARINT_LOAD_BYTES bytes
+inline uint64_t varint_mask(uint64_t word) {
+    uint64_t stop_bits = ~word & CONTINUATION_BITS;
+    return stop_bits == 0 ? 0 : stop_bits ^ (stop_bits - 1);
+}
+
+// Gather the 7 bit groups of the masked varint bytes into one integer
+inline uint64_t gather_payload(uint64_t masked_word) {
+#ifdef __BMI2__
+    return _pext_u64(masked_word, PAYLOAD_BITS);
+#else
+    uint64_t x = masked_word & PAYLOAD_BITS;
+    x = (x & 0x007F007F007F007FULL) | ((x & 0x7F007F007F007F00ULL) >> 1);
+    x = (x & 0x00003FFF00003FFFULL) | ((x & 0x3FFF00003FFF0000ULL) >> 2);
+    x = (x & 0x000000000FFFFFFFULL) | ((x & 0x0FFFFFFF00000000ULL) >> 4);
+    return x;
+#endif
+}
+
+inline uint64_t unzigzag(uint64_t value) {
+    return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+}
+
+// Decodes variable length integer pointed to by input and stores it in decoded_int. Returns length of variable length
+// integer in bytes. Varints of up to 8 bytes, which covers every header field, are decoded with a single load and no
+// data dependent branches; longer (or malformed) varints take the byte at a time loop.
+inline int decode_varint32(const uint8_t* input, int32_t* decoded_int, bool zigzag) {
+    uint64_t word = varint::load_word(input);
+    uint64_t mask = varint::varint_mask(word);
+    uint64_t result;
+    int length;
+
+    if(__builtin_expect(mask != 0 && mask <= 0xFFFFFFFFFFULL, 1)) {
+        result = varint::gather_payload(word & mask);
+        length = (64 - __builtin_clzll(mask)) >> 3;
+    } else {
+        result = 0;
+        for (length = 0; length < 5; length++) {
+            result |= (uint64_t) (input[length] & 127) << (7 * length);
+
+            if(!(input[length] & 128)) {
+                break;
+            }
+        }
+        length++;
+    }
+
+    result = (uint32_t) result;
+    if(zigzag) {
+        result = (uint32_t) varint::unzigzag(result);
+    }
+
+    *decoded_int = (int32_t) result;
+
+    return length;
+}
+
+// Decodes variable length integer pointed to by input and stores it in decoded_int. Returns length of variable length
+// integer in bytes.
+inline int decode_varint64(const uint8_t* input, int64_t* decoded_int, bool zigzag) {
+    uint64_t word = varint::load_word(input);
+    uint64_t mask = varint::varint_mask(word);
+    uint64_t result;
+    int length;
+
+    if(__builtin_expect(mask != 0, 1)) {
+        result = varint::gather_payload(word & mask);
+        length = (64 - __builtin_clzll(mask)) >> 3;
+    } else {
+        // The first 8 bytes hold 56 bits of the value
+        result = varint::gather_payload(word);
+        for (length = 8; length < 10; length++) {
+            result |= (uint64_t) (input[length] & 127) << (7 * length);
+
+            if(!(input[length] & 128)) {
+                break;
+            }
+        }
+        length++;
+    }
+
+    if(zigzag) {
+        result = varint::unzigzag(result);
+    }
+
+    *decoded_int = (int64_t) result;
+
+    return length;
+}
+
+// Length in bytes of the variable length integer pointed to by input
+inline int skip_varint(const uint8_t* input) {
+    uint64_t mask = varint::varint_mask(varint::load_word(input));
+
+    if(__builtin_expect(mask != 0, 1)) {
+        return (64 - __builtin_clzll(mask)) >> 3;
+    }
+
+    int length = VARINT_LOAD_BYTES;
+    while((input[length] & 0x80) != 0){
+        length++;
+    }
+
+    return length+1;
+}
+
+}
@@ -0,0 +1,133 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+
+#include <WorkStealingPool.h>
+
+namespace ptoa {
+
+namespace {
+
+// Identifies the worker the calling thread belongs to, if any
+thread_local WorkStealingPool* current_pool = nullptr;
+thread_local int current_worker = -1;
+
+}
+
+WorkStealingPool::WorkStealingPool(int num_threads) : queued(0), pending(0), next_queue(0), stop(false) {
+    num_threads = std::max(num_threads, 1);
+
+    for(int i=0; i<num_threads; i++){
+        queues.push_back(std::unique_ptr<worker_queue>(new worker_queue()));
+    }
+
+    for(int i=0; i<num_threads; i++){
+        threads.push_back(std::thread(&WorkStealingPool::worker_loop, this, i));
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stop = true;
+    }
+    sleep_cv.notify_all();
+
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    int index;
+
+    if(current_pool == this){
+        index = current_worker;
+    } else {
+        index = next_queue++ % queues.size();
+    }
+
+    pending++;
+
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        queued++;
+    }
+    sleep_cv.notify_one();
+}
+
+void WorkStealingPool::wait_idle() {
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    idle_cv.wait(lock, [&](){return pending == 0;});
+}
+
+// Take the newest task of the own deque, or else the oldest task of another worker
+bool WorkStealingPool::take_task(int index, std::function<void()>* task) {
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        if(!queues[index]->tasks.empty()){
+            *task = std::move(queues[index]->tasks.back());
+            queues[index]->tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+
+    for(size_t offset=1; offset<queues.size(); offset++){
+        worker_queue& victim = *queues[(index + offset)%queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if(!victim.tasks.empty()){
+            *task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void WorkStealingPool::worker_loop(int index) {
+    current_pool = this;
+    current_worker = index;
+
+    std::function<void()> task;
+
+    while(true){
+        if(take_task(index, &task)){
+            task();
+            task = nullptr;
+
+            if(--pending == 0){
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+                idle_cv.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleep_cv.wait(lock, [&](){return stop || queued > 0;});
+
+        if(stop && queued == 0){
+            return;
+        }
+    }
+}
+
+}
@@ -0,0 +1,67 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ptoa{
+
+/**
+ * Thread pool with a task deque per worker. Workers take tasks from the back of their own deque and, once it is empty,
+ * steal from the front of the deques of other workers. Tasks submitted from a worker go to its own deque, so a task that
+ * splits its work into subtasks keeps processing them in order while idle workers steal the remainder.
+ */
+class WorkStealingPool {
+  public:
+    WorkStealingPool(int num_threads);
+    // Runs all remaining tasks before joining the workers
+    ~WorkStealingPool();
+
+    void submit(std::function<void()> task);
+    // Block until all submitted tasks (and the tasks they submitted) have finished
+    void wait_idle();
+
+    int get_num_threads() {return threads.size();}
+
+  private:
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void worker_loop(int index);
+    bool take_task(int index, std::function<void()>* task);
+
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::vector<std::thread> threads;
+
+    // Tasks waiting in the deques and tasks that have not finished yet
+    std::atomic<int64_t> queued;
+    std::atomic<int64_t> pending;
+    std::atomic<int64_t> next_queue;
+    bool stop;
+
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    std::condition_variable idle_cv;
+};
+
+}
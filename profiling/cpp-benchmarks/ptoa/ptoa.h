@@ -28,4 +28,41 @@ enum encoding{
 	DELTA_LENGTH
 };
 
+enum predicate_op{
+	EQUAL,
+	LESS,
+	BETWEEN,
+	IN_SET
+};
+
+enum aggregate{
+	COUNT = 1,
+	SUM = 2,
+	MINIMUM = 4,
+	MAXIMUM = 8
+};
+
+enum page_backing{
+	REGULAR_PAGES,
+	HUGE_PAGES_2MB,
+	HUGE_PAGES_1GB
+};
+
+// Values match the PageType enum of the Parquet format
+enum page_type{
+	DATA_PAGE = 0,
+	INDEX_PAGE = 1,
+	DICTIONARY_PAGE = 2,
+	DATA_PAGE_V2 = 3
+};
+
+enum ingestion{
+	BUFFERED,
+	MMAP,
+	IO_URING,
+	DIRECT,
+	// Data that is already in memory and owned by the caller
+	MEMORY
+};
+
 }
\ No newline at end of file
@@ -16,7 +16,10 @@
 #include <parquet/arrow/reader.h>
 
 #include <SWParquetReader.h>
+#include <MemoryPool.h>
 #include <timer.h>
+#include <pagecache.h>
+#include <report.h>
 
 //Use standard Arrow library functions to read Arrow array from Parquet file
 //Only works for Parquet version 1 style files.
@@ -33,12 +36,18 @@ std::shared_ptr<arrow::Array> readArray(std::string hw_input_file_path) {
   return array;
 }
 
+const char* ingestion_names[] = {"buffered", "mmap", "io_uring", "direct"};
+
 int main(int argc, char **argv) {
     int num_strings;
     char* hw_input_file_path;
     char* reference_parquet_file_path;
     int iterations;
     bool verify_output;
+    int prefetch_distance = DEFAULT_PREFETCH_DISTANCE;
+    ptoa::ingestion ingestion_mode = ptoa::ingestion::BUFFERED;
+    int warmup_iterations = 0;
+    std::string report_path;
 
     Timer t;
 
@@ -55,14 +64,40 @@ int main(int argc, char **argv) {
         std::cerr << "Invalid argument. Option \"verify\" should be \"y\" or \"n\"" << std::endl;
         return 1;
       }
+      if(argc > 6) {
+        prefetch_distance = (uint32_t) std::strtoul(argv[6], nullptr, 10);
+      }
+      if(argc > 7) {
+        if(std::string(argv[7]) == "buffered") {
+          ingestion_mode = ptoa::ingestion::BUFFERED;
+        } else if(std::string(argv[7]) == "mmap") {
+          ingestion_mode = ptoa::ingestion::MMAP;
+        } else if(std::string(argv[7]) == "io_uring") {
+          ingestion_mode = ptoa::ingestion::IO_URING;
+        } else {
+          std::cerr << "Invalid argument. Option \"ingestion\" should be \"buffered\", \"mmap\" or \"io_uring\"" << std::endl;
+          return 1;
+        }
+      }
+      if(argc > 8) {
+        warmup_iterations = (uint32_t) std::strtoul(argv[8], nullptr, 10);
+      }
+      if(argc > 9) {
+        report_path = argv[9];
+      }
     } else {
-      std::cerr << "Usage: str parquet_hw_input_file_path reference_parquet_file_path num_strings iterations verify(y or n)" << std::endl;
+      std::cerr << "Usage: str parquet_hw_input_file_path reference_parquet_file_path num_strings iterations verify(y or n) [prefetch_distance] [ingestion(buffered, mmap or io_uring)] [warmup_iterations] [report_path]" << std::endl;
       return 1;
     }
 
-    ptoa::SWParquetReader reader(hw_input_file_path);
+    // Recycles the buffers of the "not pre-allocated" benchmark between iterations
+    ptoa::MemoryPool pool;
+
+    ptoa::SWParquetReader reader(hw_input_file_path, &pool, ingestion_mode);
+    reader.set_prefetch_distance(prefetch_distance);
     //reader.inspect_metadata(4);
     reader.count_pages(4);
+    std::cout << "Prefetch distance: " << reader.get_prefetch_distance() << " pages, ingestion: " << ingestion_names[reader.get_ingestion()] << std::endl;
 
     // Read correct array from reference file
     auto correct_array = std::dynamic_pointer_cast<arrow::StringArray>(readArray(std::string(reference_parquet_file_path)));
@@ -70,6 +105,26 @@ int main(int argc, char **argv) {
     // Get total amount of characters from string array for buffer allocation
     int num_chars = correct_array->value_offset(num_strings);
 
+    // Statistics of every run, written to report_path.csv and report_path.json if a report path is given. Output bytes
+    // are those of the offsets and characters written.
+    BenchmarkReport report("str", warmup_iterations);
+    report.set_parameter("file", hw_input_file_path);
+    report.set_parameter("num_strings", std::to_string(num_strings));
+    report.set_parameter("num_chars", std::to_string(num_chars));
+    report.set_parameter("prefetch_distance", std::to_string(prefetch_distance));
+    report.set_parameter("ingestion", ingestion_names[ingestion_mode]);
+    int64_t input_bytes = file_size_bytes(hw_input_file_path);
+    int64_t output_bytes = (int64_t) (num_strings+1)*sizeof(int32_t) + num_chars;
+
+    // Hardware event counts are printed below the statistics if perf_event_open is permitted
+    t.enable_counters();
+    auto report_run = [&](const std::string& name) {
+      BenchmarkReport::print(std::cout, report.add_run(name, t.get_history(), num_strings, input_bytes, output_bytes));
+      if(t.counters_enabled()) {
+        std::cout << "    " << t.counter_summary(num_strings, output_bytes) << std::endl;
+      }
+    };
+
     std::shared_ptr<arrow::StringArray> result_array;
     std::shared_ptr<arrow::Buffer> off_buffer;
     std::shared_ptr<arrow::Buffer> val_buffer;
@@ -80,33 +135,75 @@ int main(int argc, char **argv) {
     arrow::AllocateBuffer(num_chars, &val_buffer);
     std::memset((void*)(val_buffer->mutable_data()), 0, num_chars);
     
-    for(int i=0; i<iterations; i++){
+    for(int i=0; i<warmup_iterations+iterations; i++){
         t.start();
         // Reading the Parquet file. The interesting bit.
         if(reader.read_string(num_strings, 4, &result_array, off_buffer, val_buffer, ptoa::encoding::DELTA_LENGTH) != ptoa::status::OK){
             return 1;
         }
         t.stop();
-        t.record();
+        if(i >= warmup_iterations){
+            t.record();
+        }
     }
 
     std::cout << "Read " << num_strings << " strings" << std::endl;
     std::cout << "Average time in seconds (pre-allocated): " << t.average() << std::endl;
+    report_run("pre_allocated");
 
     t.clear_history();
 
-    for(int i=0; i<iterations; i++){
+    for(int i=0; i<warmup_iterations+iterations; i++){
         t.start();
         // Reading the Parquet file. The interesting bit.
         if(reader.read_string(num_strings, num_chars, 4, &result_array, ptoa::encoding::DELTA_LENGTH) != ptoa::status::OK){
             return 1;
         }
         t.stop();
-        t.record();
+        if(i >= warmup_iterations){
+            t.record();
+        }
     }
 
     std::cout << "Read " << num_strings << " strings" << std::endl;
     std::cout << "Average time in seconds (not pre-allocated): " << t.average() << std::endl;
+    report_run("not_pre_allocated");
+    std::cout << "Memory pool OS allocations: " << pool.os_allocations() << ", bytes reserved: " << pool.bytes_reserved() << std::endl;
+
+    // Only counted when built with -DPTOA_INSTRUMENT=ON, covers both benchmarks above
+    ptoa::reader_stats stage_stats = reader.get_stats();
+    if(stage_stats.instrumented) {
+      std::cout << "Decoding stage counters: " << stage_stats.to_json() << std::endl;
+    }
+
+    // Includes getting the file into memory from a cold page cache, so ingestion modes that overlap I/O with decoding or
+    // bypass the page cache can be compared
+    t.clear_history();
+
+    for(int i=0; i<warmup_iterations+iterations; i++){
+        evict_page_cache(hw_input_file_path);
+        t.start();
+        ptoa::SWParquetReader reader_cold(hw_input_file_path, &pool, ingestion_mode);
+        reader_cold.set_prefetch_distance(prefetch_distance);
+        if(reader_cold.read_string(num_strings, num_chars, 4, &result_array, ptoa::encoding::DELTA_LENGTH) != ptoa::status::OK){
+            return 1;
+        }
+        t.stop();
+        if(i >= warmup_iterations){
+            t.record();
+        }
+    }
+
+    std::cout << "Average time in seconds (ingest and read, " << ingestion_names[ingestion_mode] << "): " << t.average() << std::endl;
+    report_run(std::string("cold_") + ingestion_names[ingestion_mode]);
+    std::cout << "Page cache footprint of input file after reading: " << page_cache_resident_bytes(hw_input_file_path) << " bytes" << std::endl;
+
+    if(!report_path.empty()) {
+      if(!report.write_csv(report_path + ".csv") || !report.write_json(report_path + ".json")) {
+        return 1;
+      }
+      std::cout << "Wrote " << report_path << ".csv and " << report_path << ".json" << std::endl;
+    }
 
     if(verify_output) {
         //std::cout<<"Num chars: "<<num_chars<<std::endl;
@@ -0,0 +1,583 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/properties.h>
+
+#include <SWParquetReader.h>
+#include <MemoryPool.h>
+#include <timer.h>
+#include <report.h>
+#include <hwpages.h>
+#include <datagen.h>
+#include <options.h>
+#include <verify.h>
+
+struct sweep_options {
+    std::vector<std::string> types = {"int32", "int64", "string"};
+    std::vector<std::string> encodings = {"plain", "delta"};
+    std::vector<int64_t> num_values = {1000000};
+    std::vector<int64_t> page_values = {10000};
+    std::vector<std::string> bit_widths = {"4", "16", "mixed"};
+    std::vector<int64_t> threads = {1};
+    std::vector<std::string> allocs = {"preallocated", "fresh"};
+    std::vector<std::string> ops = {"read", "filter", "aggregate"};
+    int64_t iterations = 5;
+    int64_t warmup_iterations = 1;
+    int64_t string_length = 16;
+    uint64_t seed = 42;
+    std::string dir = ".";
+    std::string report_path = "sweep";
+    bool keep_files = false;
+    bool verify = true;
+};
+
+void print_usage() {
+    std::cerr << "Usage: sweep [--option=value[,value...]]..." << std::endl
+              << "  --types          int32, int64 and/or string (default int32,int64,string)" << std::endl
+              << "  --encodings      plain and/or delta, strings are always delta length encoded (default plain,delta)" << std::endl
+              << "  --num_values     values per column (default 1000000)" << std::endl
+              << "  --page_values    values per page (default 10000)" << std::endl
+              << "  --bit_widths     bit width of the deltas between values, or mixed for a random width per miniblock (default 4,16,mixed)" << std::endl
+              << "  --threads        decoding threads, more than 1 uses read_prim_parallel (default 1)" << std::endl
+              << "  --alloc          preallocated, fresh and/or pooled output buffers (default preallocated,fresh)" << std::endl
+              << "  --ops            read, filter (delta encoded integers) and/or aggregate (integers) (default read,filter,aggregate)" << std::endl
+              << "  --iterations     timed iterations per run (default 5)" << std::endl
+              << "  --warmup         untimed iterations before every run (default 1)" << std::endl
+              << "  --string_length  maximum length of the generated strings (default 16)" << std::endl
+              << "  --seed           seed of the data generator (default 42)" << std::endl
+              << "  --dir            directory for the generated files (default .)" << std::endl
+              << "  --report         path of the report, written to <report>.csv and <report>.json (default sweep)" << std::endl
+              << "  --keep_files     do not remove the generated files" << std::endl
+              << "  --no_verify      do not compare the decoded values with the generated ones" << std::endl;
+}
+
+bool parse_options(int argc, char** argv, sweep_options* options) {
+    for(int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+        if(arg.compare(0, 2, "--") != 0) {
+            std::cerr << "[ERROR] Unexpected argument " << arg << std::endl;
+            return false;
+        }
+
+        size_t equals = arg.find('=');
+        std::string name = arg.substr(2, equals == std::string::npos ? std::string::npos : equals - 2);
+        std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+        bool valid;
+
+        if(name == "types") {
+            valid = parse_choices(name, value, {"int32", "int64", "string"}, &options->types);
+        } else if(name == "encodings") {
+            valid = parse_choices(name, value, {"plain", "delta"}, &options->encodings);
+        } else if(name == "num_values") {
+            valid = parse_numbers(name, value, 1, &options->num_values);
+        } else if(name == "page_values") {
+            valid = parse_numbers(name, value, 1, &options->page_values);
+        } else if(name == "bit_widths") {
+            options->bit_widths = split_list(value);
+            valid = !options->bit_widths.empty();
+            for(const std::string& width : options->bit_widths) {
+                if(width != "mixed" && (width.find_first_not_of("0123456789") != std::string::npos || std::stoi(width) > 64)) {
+                    std::cerr << "[ERROR] Invalid value \"" << width << "\" for option --bit_widths, expected 0 to 64 or mixed" << std::endl;
+                    valid = false;
+                }
+            }
+        } else if(name == "threads") {
+            valid = parse_numbers(name, value, 1, &options->threads);
+        } else if(name == "alloc") {
+            valid = parse_choices(name, value, {"preallocated", "fresh", "pooled"}, &options->allocs);
+        } else if(name == "ops") {
+            valid = parse_choices(name, value, {"read", "filter", "aggregate"}, &options->ops);
+        } else if(name == "iterations") {
+            valid = parse_number(name, value, 1, &options->iterations);
+        } else if(name == "warmup") {
+            // Zero warmup iterations is allowed
+            valid = parse_number(name, value, 0, &options->warmup_iterations);
+        } else if(name == "string_length") {
+            valid = parse_number(name, value, 1, &options->string_length);
+        } else if(name == "seed") {
+            options->seed = std::strtoull(value.c_str(), nullptr, 10);
+            valid = true;
+        } else if(name == "dir") {
+            options->dir = value;
+            valid = !value.empty();
+        } else if(name == "report") {
+            options->report_path = value;
+            valid = !value.empty();
+        } else if(name == "keep_files") {
+            options->keep_files = true;
+            valid = true;
+        } else if(name == "no_verify") {
+            options->verify = false;
+            valid = true;
+        } else {
+            std::cerr << "[ERROR] Unknown option --" << name << std::endl;
+            valid = false;
+        }
+
+        if(!valid) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Values whose consecutive deltas are random with the given bit width, or with a random bit width per miniblock of pages
+// of page_values values. Strings get random lengths up to string_length.
+column_spec sweep_column(const std::string& type, const std::string& bit_width, int64_t string_length, int64_t page_values) {
+    column_spec spec;
+    spec.name = "values";
+
+    if(type == "string") {
+        spec.type = arrow::Type::STRING;
+        spec.distribution = UNIFORM;
+        spec.min = 0;
+        spec.max = string_length;
+        return spec;
+    }
+
+    int max_width = type == "int32" ? 32 : 64;
+    spec.type = type == "int32" ? arrow::Type::INT32 : arrow::Type::INT64;
+    spec.distribution = BIT_WIDTHS;
+    spec.run_length = DELTA_MINIBLOCK_SIZE;
+    spec.page_values = page_values;
+    spec.bit_widths.clear();
+
+    if(bit_width == "mixed") {
+        for(int width=0; width<=max_width; width++) {
+            spec.bit_widths.push_back(width);
+        }
+    } else {
+        spec.bit_widths.push_back(std::min(std::stoi(bit_width), max_width));
+    }
+
+    return spec;
+}
+
+/**
+ * Writes a file in the layout the hardware and SWParquetReader read: the magic number followed by V2 data pages of
+ * page_values values each, without footer.
+ */
+bool write_hw_file(const std::string& path, const std::string& type, const std::string& enc, const std::shared_ptr<arrow::Array>& column, int64_t page_values) {
+    std::vector<uint8_t> file = {'P', 'A', 'R', '1'};
+    std::vector<uint8_t> page;
+    int64_t num_values = column->length();
+
+    for(int64_t first=0; first<num_values; first+=page_values) {
+        int64_t count = std::min(page_values, num_values - first);
+        int32_t encoding;
+        page.clear();
+
+        if(type == "string") {
+            auto strings = std::static_pointer_cast<arrow::StringArray>(column);
+            const uint8_t* chars = strings->value_data()->data();
+            std::vector<int32_t> lengths(count);
+            for(int64_t i=0; i<count; i++) {
+                lengths[i] = strings->value_length(first+i);
+            }
+            append_delta(&page, lengths.data(), count);
+            page.insert(page.end(), chars + strings->value_offset(first), chars + strings->value_offset(first+count));
+            encoding = PARQUET_DELTA_LENGTH_BYTE_ARRAY;
+        } else if(enc == "delta") {
+            const uint8_t* values = std::static_pointer_cast<arrow::PrimitiveArray>(column)->values()->data();
+            if(type == "int32") {
+                append_delta(&page, (const int32_t*) values + first, count);
+            } else {
+                append_delta(&page, (const int64_t*) values + first, count);
+            }
+            encoding = PARQUET_DELTA_BINARY_PACKED;
+        } else {
+            int64_t value_bytes = type == "int32" ? sizeof(int32_t) : sizeof(int64_t);
+            const uint8_t* values = std::static_pointer_cast<arrow::PrimitiveArray>(column)->values()->data() + first*value_bytes;
+            page.insert(page.end(), values, values + count*value_bytes);
+            encoding = PARQUET_PLAIN;
+        }
+
+        append_page_header(&file, page.size(), count, encoding);
+        file.insert(file.end(), page.begin(), page.end());
+    }
+
+    std::ofstream out(path, std::ios::binary);
+    if(!out.write((const char*) file.data(), file.size())) {
+        std::cerr << "[ERROR] Could not write " << path << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+// Regular Parquet file of the same values for arrow's FileReader. parquet-cpp only writes plain and dictionary encoded
+// pages, so the reference is plain encoded with dictionary encoding disabled, with pages of about page_values values.
+void write_reference_file(const std::string& path, const std::string& type, const std::shared_ptr<arrow::Array>& column, int64_t page_values) {
+    int64_t num_values = column->length();
+    int64_t value_bytes;
+
+    if(type == "int32") {
+        value_bytes = sizeof(int32_t);
+    } else if(type == "int64") {
+        value_bytes = sizeof(int64_t);
+    } else {
+        int64_t num_chars = std::static_pointer_cast<arrow::StringArray>(column)->value_offset(num_values);
+        value_bytes = sizeof(int32_t) + num_chars/std::max(num_values, (int64_t) 1);
+    }
+
+    auto schema = arrow::schema({arrow::field("values", column->type(), false)});
+    auto table = arrow::Table::Make(schema, {column});
+
+    parquet::WriterProperties::Builder properties;
+    properties.disable_dictionary();
+    properties.data_pagesize(page_values*value_bytes);
+
+    std::shared_ptr<arrow::io::FileOutputStream> outfile;
+    PARQUET_THROW_NOT_OK(arrow::io::FileOutputStream::Open(path, &outfile));
+    PARQUET_THROW_NOT_OK(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), outfile, num_values, properties.build()));
+    PARQUET_THROW_NOT_OK(outfile->Close());
+}
+
+bool verify_strings(const std::shared_ptr<arrow::StringArray>& array, const std::shared_ptr<arrow::Array>& expected) {
+    auto expected_strings = std::static_pointer_cast<arrow::StringArray>(expected);
+
+    if(array->length() != expected->length()) {
+        return false;
+    }
+    for(int64_t i=0; i<expected->length(); i++) {
+        if(array->GetString(i) != expected_strings->GetString(i)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool has_op(const sweep_options& options, const std::string& op) {
+    return std::find(options.ops.begin(), options.ops.end(), op) != options.ops.end();
+}
+
+// Time the warmup and timed iterations of run, only recording the latter
+bool time_iterations(Timer* t, const sweep_options& options, const std::function<ptoa::status()>& run) {
+    t->clear_history();
+    for(int i=0; i<options.warmup_iterations+options.iterations; i++) {
+        t->start();
+        ptoa::status result = run();
+        t->stop();
+        if(result != ptoa::status::OK) {
+            return false;
+        }
+        if(i >= options.warmup_iterations) {
+            t->record();
+        }
+    }
+
+    return true;
+}
+
+void report_op_run(Timer* t, BenchmarkReport* report, const std::string& name, const std::vector<std::pair<std::string, std::string>>& parameters,
+                   int64_t num_values, int64_t input_bytes, int64_t output_bytes) {
+    std::cout << name << std::endl;
+    BenchmarkReport::print(std::cout, report->add_run(name, t->get_history(), num_values, input_bytes, output_bytes, parameters));
+    if(t->counters_enabled()) {
+        std::cout << "    " << t->counter_summary(num_values, output_bytes) << std::endl;
+    }
+}
+
+// Fused BETWEEN filter over the delta decoder. The bounds are two values of the column, so at least one value is
+// selected.
+bool run_filter(Timer* t, const sweep_options& options, BenchmarkReport* report, const std::string& hw_path, const std::string& config,
+                std::vector<std::pair<std::string, std::string>> parameters, const std::shared_ptr<arrow::Array>& column, int32_t prim_width,
+                int64_t input_bytes, int* failures) {
+    int64_t num_values = column->length();
+    if(num_values == 0) {
+        return true;
+    }
+
+    const uint8_t* values = std::static_pointer_cast<arrow::PrimitiveArray>(column)->values()->data();
+    int64_t a = prim_width == 32 ? ((const int32_t*) values)[num_values/4] : ((const int64_t*) values)[num_values/4];
+    int64_t b = prim_width == 32 ? ((const int32_t*) values)[num_values/2] : ((const int64_t*) values)[num_values/2];
+    ptoa::predicate pred = {ptoa::predicate_op::BETWEEN, std::min(a, b), std::max(a, b), {}};
+
+    ptoa::SWParquetReader reader(hw_path);
+    std::shared_ptr<arrow::Buffer> sel_bitmap;
+    std::shared_ptr<arrow::Buffer> sel_buffer;
+    std::shared_ptr<arrow::PrimitiveArray> selected_array;
+    int64_t num_selected = 0;
+    arrow::AllocateBuffer((num_values+7)/8, &sel_bitmap);
+    arrow::AllocateBuffer(num_values*(prim_width/8), &sel_buffer);
+
+    if(!time_iterations(t, options, [&]() {
+        return reader.filter_prim(prim_width, num_values, 4, pred, sel_bitmap, &num_selected, &selected_array, sel_buffer, ptoa::encoding::DELTA);
+    })) {
+        return false;
+    }
+
+    parameters.insert(parameters.end(), {{"reader", "ptoa"}, {"op", "filter"}, {"encoding", "delta"}, {"threads", "1"}, {"alloc", "preallocated"}});
+    report_op_run(t, report, "ptoa_" + config + "_delta_filter", parameters, num_values, input_bytes, (num_values+7)/8 + num_selected*(prim_width/8));
+    std::cout << "    selected " << num_selected << " values between " << pred.lo << " and " << pred.hi << std::endl;
+
+    if(options.verify && !verify_between(column, pred.lo, pred.hi, sel_bitmap->data(), selected_array)) {
+        std::cout << "    Test failed, the selection differs from a scalar filter" << std::endl;
+        (*failures)++;
+    }
+
+    return true;
+}
+
+// Count, sum, minimum and maximum straight from the pages, no output array is written
+bool run_aggregate(Timer* t, const sweep_options& options, BenchmarkReport* report, const std::string& hw_path, const std::string& config,
+                   std::vector<std::pair<std::string, std::string>> parameters, const std::shared_ptr<arrow::Array>& column, const std::string& enc_name,
+                   int32_t prim_width, int64_t input_bytes, int* failures) {
+    const int aggregates = ptoa::aggregate::COUNT | ptoa::aggregate::SUM | ptoa::aggregate::MINIMUM | ptoa::aggregate::MAXIMUM;
+    ptoa::encoding enc = enc_name == "delta" ? ptoa::encoding::DELTA : ptoa::encoding::PLAIN;
+    ptoa::aggregate_result result = {0, 0, 0, 0};
+    ptoa::SWParquetReader reader(hw_path);
+
+    if(!time_iterations(t, options, [&]() { return reader.aggregate_prim(prim_width, column->length(), 4, aggregates, &result, enc); })) {
+        return false;
+    }
+
+    parameters.insert(parameters.end(), {{"reader", "ptoa"}, {"op", "aggregate"}, {"encoding", enc_name}, {"threads", "1"}, {"alloc", "none"}});
+    report_op_run(t, report, "ptoa_" + config + "_" + enc_name + "_aggregate", parameters, column->length(), input_bytes, sizeof(result));
+
+    if(options.verify && !verify_aggregates(column, result.count, result.sum, result.min, result.max)) {
+        std::cout << "    Test failed, the aggregates differ from the generated values" << std::endl;
+        (*failures)++;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    sweep_options options;
+
+    if(!parse_options(argc, argv, &options)) {
+        print_usage();
+        return 1;
+    }
+
+    Timer t;
+    t.enable_counters();
+    int generate_threads = std::max(std::thread::hardware_concurrency(), 1U);
+    uint64_t column_seed = options.seed;
+
+    // One run per reader and configuration, the configuration is stored with every run so the CSV holds the matrix
+    BenchmarkReport report("sweep", options.warmup_iterations);
+    report.set_parameter("iterations", std::to_string(options.iterations));
+    report.set_parameter("seed", std::to_string(options.seed));
+    report.set_parameter("string_length", std::to_string(options.string_length));
+
+    ptoa::MemoryPool pool;
+    int failures = 0;
+
+    for(const std::string& type : options.types) {
+        int32_t prim_width = type == "int32" ? 32 : 64;
+
+        for(int64_t num_values : options.num_values) {
+            // Strings are generated with random lengths, the bit width of their deltas is not controlled
+            std::vector<std::string> bit_widths = type == "string" ? std::vector<std::string>{"random"} : options.bit_widths;
+
+            for(const std::string& bit_width : bit_widths) {
+                for(int64_t page_values : options.page_values) {
+                    // Every generated column gets its own seed, the data does not depend on the generating threads. The
+                    // bit width runs line up with the miniblocks of the pages, so every page size gets its own column.
+                    std::shared_ptr<arrow::Array> column;
+                    if(!generate_column(sweep_column(type, bit_width, options.string_length, page_values), num_values, column_seed++, generate_threads, &column)) {
+                        return 1;
+                    }
+
+                    int64_t num_chars = type == "string" ? std::static_pointer_cast<arrow::StringArray>(column)->value_offset(num_values) : 0;
+                    int64_t output_bytes = type == "string" ? (num_values+1)*sizeof(int32_t) + num_chars : num_values*(prim_width/8);
+
+                    std::string config = type + "_n" + std::to_string(num_values) + "_p" + std::to_string(page_values) + "_b" + bit_width;
+                    std::vector<std::pair<std::string, std::string>> parameters = {
+                        {"type", type}, {"page_values", std::to_string(page_values)}, {"bit_width", bit_width}};
+
+                    std::string reference_path = options.dir + "/sweep_" + config + "_reference.parquet";
+                    write_reference_file(reference_path, type, column, page_values);
+
+                    // arrow's FileReader, single threaded like the ptoa runs with one thread
+                    std::shared_ptr<arrow::io::ReadableFile> infile;
+                    PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(reference_path, arrow::default_memory_pool(), &infile));
+                    std::unique_ptr<parquet::arrow::FileReader> arrow_reader;
+                    PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &arrow_reader));
+                    arrow_reader->set_use_threads(false);
+
+                    t.clear_history();
+                    for(int i=0; i<options.warmup_iterations+options.iterations; i++) {
+                        std::shared_ptr<arrow::Array> array;
+                        t.start();
+                        PARQUET_THROW_NOT_OK(arrow_reader->ReadColumn(0, &array));
+                        t.stop();
+                        if(i >= options.warmup_iterations) {
+                            t.record();
+                        }
+                    }
+
+                    auto arrow_parameters = parameters;
+                    arrow_parameters.insert(arrow_parameters.end(), {{"reader", "arrow"}, {"op", "read"}, {"encoding", "plain"}, {"threads", "1"}, {"alloc", "fresh"}});
+                    std::cout << "arrow_" << config << std::endl;
+                    const run_summary& arrow_run = report.add_run("arrow_" + config, t.get_history(), num_values, file_size_bytes(reference_path.c_str()), output_bytes, arrow_parameters);
+                    BenchmarkReport::print(std::cout, arrow_run);
+                    double arrow_median = arrow_run.median;
+
+                    for(const std::string& enc_name : options.encodings) {
+                        // The reader only supports delta length encoded strings
+                        if(type == "string" && enc_name != "delta") {
+                            continue;
+                        }
+                        ptoa::encoding enc = type == "string" ? ptoa::encoding::DELTA_LENGTH : (enc_name == "delta" ? ptoa::encoding::DELTA : ptoa::encoding::PLAIN);
+
+                        std::string hw_path = options.dir + "/sweep_" + config + "_" + enc_name + ".prq";
+                        if(!write_hw_file(hw_path, type, enc_name, column, page_values)) {
+                            return 1;
+                        }
+                        int64_t input_bytes = file_size_bytes(hw_path.c_str());
+
+                        if(has_op(options, "read")) {
+                            for(int64_t threads : options.threads) {
+                                // There is no parallel string reader
+                                if(type == "string" && threads > 1) {
+                                    continue;
+                                }
+
+                                for(const std::string& alloc : options.allocs) {
+                                    // read_prim_parallel always allocates its output
+                                    if(threads > 1 && alloc == "preallocated") {
+                                        continue;
+                                    }
+
+                                    arrow::MemoryPool* reader_pool = alloc == "pooled" ? (arrow::MemoryPool*) &pool : arrow::default_memory_pool();
+                                    ptoa::SWParquetReader reader(hw_path, reader_pool);
+
+                                    std::shared_ptr<arrow::Buffer> arr_buffer;
+                                    std::shared_ptr<arrow::Buffer> off_buffer;
+                                    std::shared_ptr<arrow::Buffer> val_buffer;
+                                    if(alloc == "preallocated") {
+                                        if(type == "string") {
+                                            arrow::AllocateBuffer((num_values+1)*sizeof(int32_t), &off_buffer);
+                                            std::memset((void*)(off_buffer->mutable_data()), 0, (num_values+1)*sizeof(int32_t));
+                                            arrow::AllocateBuffer(num_chars, &val_buffer);
+                                            std::memset((void*)(val_buffer->mutable_data()), 0, num_chars);
+                                        } else {
+                                            arrow::AllocateBuffer(num_values*(prim_width/8), &arr_buffer);
+                                            std::memset((void*)(arr_buffer->mutable_data()), 0, num_values*(prim_width/8));
+                                        }
+                                    }
+
+                                    ptoa::parallel_options parallel = {(int) threads, true, false};
+                                    ptoa::parallel_stats stats;
+                                    std::shared_ptr<arrow::PrimitiveArray> prim_array;
+                                    std::shared_ptr<arrow::StringArray> string_array;
+
+                                    t.clear_history();
+                                    for(int i=0; i<options.warmup_iterations+options.iterations; i++) {
+                                        ptoa::status result;
+                                        t.start();
+                                        if(type == "string") {
+                                            if(alloc == "preallocated") {
+                                                result = reader.read_string(num_values, 4, &string_array, off_buffer, val_buffer, enc);
+                                            } else {
+                                                result = reader.read_string(num_values, num_chars, 4, &string_array, enc);
+                                            }
+                                        } else if(threads > 1) {
+                                            result = reader.read_prim_parallel(prim_width, num_values, 4, &prim_array, enc, parallel, &stats);
+                                        } else if(alloc == "preallocated") {
+                                            result = reader.read_prim(prim_width, num_values, 4, &prim_array, arr_buffer, enc);
+                                        } else {
+                                            result = reader.read_prim(prim_width, num_values, 4, &prim_array, enc);
+                                        }
+                                        t.stop();
+                                        if(result != ptoa::status::OK) {
+                                            return 1;
+                                        }
+                                        if(i >= options.warmup_iterations) {
+                                            t.record();
+                                        }
+                                    }
+
+                                    std::string name = "ptoa_" + config + "_" + enc_name + "_t" + std::to_string(threads) + "_" + alloc;
+                                    auto run_parameters = parameters;
+                                    run_parameters.insert(run_parameters.end(), {{"reader", "ptoa"}, {"op", "read"}, {"encoding", enc_name}, {"threads", std::to_string(threads)}, {"alloc", alloc}});
+                                    std::cout << name << std::endl;
+                                    const run_summary& run = report.add_run(name, t.get_history(), num_values, input_bytes, output_bytes, run_parameters);
+                                    BenchmarkReport::print(std::cout, run);
+                                    if(t.counters_enabled()) {
+                                        std::cout << "    " << t.counter_summary(num_values, output_bytes) << std::endl;
+                                    }
+                                    if(run.median > 0) {
+                                        std::cout << "    speedup over arrow: " << arrow_median/run.median << std::endl;
+                                    }
+
+                                    if(options.verify) {
+                                        bool correct = type == "string" ? verify_strings(string_array, column) : count_mismatches(prim_array, column, 0) == 0;
+                                        if(!correct) {
+                                            std::cout << "    Test failed, decoded values differ from the generated ones" << std::endl;
+                                            failures++;
+                                        }
+                                    }
+                                }
+                            }
+                        }
+
+                        if(type != "string" && enc == ptoa::encoding::DELTA && has_op(options, "filter")) {
+                            if(!run_filter(&t, options, &report, hw_path, config, parameters, column, prim_width, input_bytes, &failures)) {
+                                return 1;
+                            }
+                        }
+
+                        if(type != "string" && has_op(options, "aggregate")) {
+                            if(!run_aggregate(&t, options, &report, hw_path, config, parameters, column, enc_name, prim_width, input_bytes, &failures)) {
+                                return 1;
+                            }
+                        }
+
+                        if(!options.keep_files) {
+                            std::remove(hw_path.c_str());
+                        }
+                    }
+
+                    if(!options.keep_files) {
+                        std::remove(reference_path.c_str());
+                    }
+                }
+            }
+        }
+    }
+
+    if(!report.write_csv(options.report_path + ".csv") || !report.write_json(options.report_path + ".json")) {
+        return 1;
+    }
+    std::cout << "Wrote " << report.runs().size() << " runs to " << options.report_path << ".csv and " << options.report_path << ".json" << std::endl;
+
+    if(options.verify) {
+        if(failures == 0) {
+            std::cout << "Test passed!" << std::endl;
+        } else {
+            std::cout << "Test failed for " << failures << " runs" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
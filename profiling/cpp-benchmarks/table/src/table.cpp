@@ -0,0 +1,174 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <iomanip>
+
+#include <parquet/arrow/reader.h>
+
+#include <SWParquetReader.h>
+#include <timer.h>
+
+//Use standard Arrow library functions to read Arrow array from Parquet file
+//Only works for Parquet version 1 style files.
+std::shared_ptr<arrow::Array> readArray(std::string hw_input_file_path, int column) {
+  std::shared_ptr<arrow::io::ReadableFile> infile;
+  PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(hw_input_file_path, arrow::default_memory_pool(), &infile));
+
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+
+  std::shared_ptr<arrow::Array> array;
+  PARQUET_THROW_NOT_OK(reader->ReadColumn(column, &array));
+
+  return array;
+}
+
+//Read the whole table with the multithreaded Arrow reader, the baseline for read_table
+std::shared_ptr<arrow::Table> readTable(std::string hw_input_file_path) {
+  std::shared_ptr<arrow::io::ReadableFile> infile;
+  PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(hw_input_file_path, arrow::default_memory_pool(), &infile));
+
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+  reader->set_use_threads(true);
+
+  std::shared_ptr<arrow::Table> table;
+  PARQUET_THROW_NOT_OK(reader->ReadTable(&table));
+
+  return table;
+}
+
+int main(int argc, char **argv) {
+    int num_values;
+    char* hw_input_file_path;
+    char* reference_parquet_file_path;
+    int32_t str_offset;
+    int iterations;
+    bool verify_output;
+    ptoa::encoding int_enc;
+    int num_threads = 0;
+
+    Timer t;
+
+    if (argc > 7) {
+      hw_input_file_path = argv[1];
+      reference_parquet_file_path = argv[2];
+      num_values = (uint32_t) std::strtoul(argv[3], nullptr, 10);
+      str_offset = (uint32_t) std::strtoul(argv[4], nullptr, 10);
+      iterations = (uint32_t) std::strtoul(argv[5], nullptr, 10);
+      if(argv[6][0] == 'y') {
+        verify_output = true;
+      } else if (argv[6][0] == 'n') {
+        verify_output = false;
+      } else {
+        std::cerr << "Invalid argument. Option \"verify\" should be \"y\" or \"n\"" << std::endl;
+        return 1;
+      }
+      if(argv[7][0] == 'y') {
+        int_enc = ptoa::encoding::DELTA;
+      } else if (argv[7][0] == 'n') {
+        int_enc = ptoa::encoding::PLAIN;
+      } else {
+        std::cerr << "Invalid argument. Option \"delta_encoded\" should be \"y\" or \"n\"" << std::endl;
+        return 1;
+      }
+      if(argc > 8) {
+        num_threads = (uint32_t) std::strtoul(argv[8], nullptr, 10);
+      }
+    } else {
+      std::cerr << "Usage: table parquet_hw_input_file_path reference_parquet_file_path num_values str_column_offset iterations verify(y or n) int_delta_encoded(y or n) [num_threads]" << std::endl;
+      return 1;
+    }
+
+    // The reference file holds the int64 and string table of generate_int64_str_table, the hardware file the same
+    // columns with the int64 column chunk at offset 4 and the string column chunk at str_offset
+    auto correct_int_array = std::dynamic_pointer_cast<arrow::Int64Array>(readArray(std::string(reference_parquet_file_path), 0));
+    auto correct_str_array = std::dynamic_pointer_cast<arrow::StringArray>(readArray(std::string(reference_parquet_file_path), 1));
+
+    // Get total amount of characters from string array for buffer allocation
+    int num_chars = correct_str_array->value_offset(num_values);
+
+    std::vector<ptoa::column_spec> columns = {
+        {arrow::field("int", arrow::int64(), false), num_values, 0, 4, int_enc},
+        {arrow::field("str", arrow::utf8(), false), num_values, num_chars, str_offset, ptoa::encoding::DELTA_LENGTH}};
+
+    ptoa::SWParquetReader reader(hw_input_file_path);
+    std::shared_ptr<arrow::Table> table;
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        // Reading the Parquet file. The interesting bit.
+        if(reader.read_table(columns, &table, num_threads) != ptoa::status::OK){
+            return 1;
+        }
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Read " << num_values << " rows" << std::endl;
+    std::cout << "Average time in seconds (read_table): " << t.average() << std::endl;
+
+    // Includes loading the file, like the Arrow reader below
+    t.clear_history();
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        ptoa::SWParquetReader reader_open(hw_input_file_path);
+        if(reader_open.read_table(columns, &table, num_threads) != ptoa::status::OK){
+            return 1;
+        }
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Average time in seconds (open and read_table): " << t.average() << std::endl;
+
+    t.clear_history();
+
+    for(int i=0; i<iterations; i++){
+        t.start();
+        readTable(std::string(reference_parquet_file_path));
+        t.stop();
+        t.record();
+    }
+
+    std::cout << "Average time in seconds (Arrow FileReader::ReadTable, use_threads): " << t.average() << std::endl;
+
+    if(verify_output) {
+        std::shared_ptr<arrow::RecordBatch> batch;
+        if(reader.read_record_batch(columns, &batch, num_threads) != ptoa::status::OK){
+            return 1;
+        }
+
+        auto result_int_array = std::static_pointer_cast<arrow::Int64Array>(batch->column(0));
+        auto result_str_array = std::static_pointer_cast<arrow::StringArray>(batch->column(1));
+
+        // Verify result
+        int error_count = 0;
+
+        for(int i=0; i<num_values; i++) {
+            if(result_int_array->Value(i) != correct_int_array->Value(i) || result_str_array->GetString(i) != correct_str_array->GetString(i)) {
+              error_count++;
+              if(error_count<20) {
+                std::cout<<i<<std::endl;
+              }
+            }
+        }
+
+        if(error_count == 0) {
+          std::cout << "Test passed!" << std::endl;
+        } else {
+          std::cout << "Test failed. Found " << error_count << " errors in the output Arrow table" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,164 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <iostream>
+#include <string>
+#include <algorithm>
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <parquet/api/reader.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/properties.h>
+
+#include <SWParquetReader.h>
+#include <ptoa.h>
+
+// Writes small int64 files with parquet-cpp and checks that SWParquetReader decodes the pages it supports and rejects
+// the ones it does not (compressed pages, pages with another encoding and pages with levels) instead of decoding them as
+// garbage. parquet-cpp writes V1 data pages, which are only decoded once the reader is told the column has no levels.
+
+#define NUM_VALUES 100000
+#define DISTINCT_VALUES 1000
+
+int64_t test_value(int64_t i) {
+    return (i*7919) % DISTINCT_VALUES - DISTINCT_VALUES/2;
+}
+
+// Nullable columns get a null in every DISTINCT_VALUES values, so their V1 pages start with definition levels
+void write_file(const std::string& path, bool dictionary, parquet::Compression::type compression, bool nullable) {
+    arrow::Int64Builder builder;
+    for(int64_t i=0; i<NUM_VALUES; i++){
+        if(nullable && i % DISTINCT_VALUES == 0){
+            PARQUET_THROW_NOT_OK(builder.AppendNull());
+        } else {
+            PARQUET_THROW_NOT_OK(builder.Append(test_value(i)));
+        }
+    }
+
+    std::shared_ptr<arrow::Array> array;
+    PARQUET_THROW_NOT_OK(builder.Finish(&array));
+
+    std::shared_ptr<arrow::Schema> schema = arrow::schema({arrow::field("int", arrow::int64(), nullable)});
+    std::shared_ptr<arrow::Table> table = arrow::Table::Make(schema, {array});
+
+    parquet::WriterProperties::Builder properties;
+    if(!dictionary){
+        properties.disable_dictionary();
+    }
+    properties.compression(compression);
+    // Several pages per column chunk
+    properties.data_pagesize(64*1024);
+
+    std::shared_ptr<arrow::io::FileOutputStream> outfile;
+    PARQUET_THROW_NOT_OK(arrow::io::FileOutputStream::Open(path, &outfile));
+    PARQUET_THROW_NOT_OK(parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), outfile, NUM_VALUES, properties.build()));
+    PARQUET_THROW_NOT_OK(outfile->Close());
+}
+
+// File offset of the first page of the only column chunk, the dictionary page if there is one
+int64_t chunk_offset(const std::string& path) {
+    std::unique_ptr<parquet::ParquetFileReader> file_reader = parquet::ParquetFileReader::OpenFile(path);
+    std::unique_ptr<parquet::ColumnChunkMetaData> column_chunk = file_reader->metadata()->RowGroup(0)->ColumnChunk(0);
+
+    int64_t offset = column_chunk->data_page_offset();
+    if(column_chunk->has_dictionary_page() && column_chunk->dictionary_page_offset() > 0){
+        offset = std::min(offset, column_chunk->dictionary_page_offset());
+    }
+
+    return offset;
+}
+
+bool check_values(const std::shared_ptr<arrow::PrimitiveArray>& array) {
+    const int64_t* values = (const int64_t*) array->values()->data();
+
+    for(int64_t i=0; i<NUM_VALUES; i++){
+        if(values[i] != test_value(i)){
+            std::cout << "Value " << i << " is " << values[i] << ", expected " << test_value(i) << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Read the file through the sequential, prefetching and parallel decoders and expect either the test values or FAIL.
+// The maximum levels are passed to the reader unless max_definition_level is negative.
+bool check_file(const std::string& path, ptoa::encoding enc, int16_t max_definition_level, bool expect_ok) {
+    int64_t file_offset = chunk_offset(path);
+    bool passed = true;
+
+    for(int prefetch_distance : {0, 4}){
+        ptoa::SWParquetReader reader(path);
+        reader.set_prefetch_distance(prefetch_distance);
+        if(max_definition_level >= 0){
+            reader.set_max_levels(max_definition_level, 0);
+        }
+
+        std::shared_ptr<arrow::PrimitiveArray> array;
+        ptoa::status result = reader.read_prim(64, NUM_VALUES, file_offset, &array, enc);
+
+        if(expect_ok ? (result != ptoa::status::OK || !check_values(array)) : result != ptoa::status::FAIL){
+            std::cout << path << " with prefetch distance " << prefetch_distance << (expect_ok ? " was not decoded" : " was not rejected") << std::endl;
+            passed = false;
+        }
+    }
+
+    ptoa::SWParquetReader reader(path);
+    if(max_definition_level >= 0){
+        reader.set_max_levels(max_definition_level, 0);
+    }
+    ptoa::parallel_options options = {2, false, false};
+
+    std::shared_ptr<arrow::PrimitiveArray> array;
+    ptoa::status result = reader.read_prim_parallel(64, NUM_VALUES, file_offset, &array, enc, options, nullptr);
+
+    if(expect_ok ? (result != ptoa::status::OK || !check_values(array)) : result != ptoa::status::FAIL){
+        std::cout << path << " with the parallel reader" << (expect_ok ? " was not decoded" : " was not rejected") << std::endl;
+        passed = false;
+    }
+
+    return passed;
+}
+
+int main(int argc, char **argv) {
+    std::string plain_path = "reader_test_plain.parquet";
+    std::string snappy_path = "reader_test_snappy.parquet";
+    std::string dictionary_path = "reader_test_dictionary.parquet";
+    std::string nullable_path = "reader_test_nullable.parquet";
+
+    write_file(plain_path, false, parquet::Compression::UNCOMPRESSED, false);
+    write_file(snappy_path, false, parquet::Compression::SNAPPY, false);
+    write_file(dictionary_path, true, parquet::Compression::UNCOMPRESSED, false);
+    write_file(nullable_path, false, parquet::Compression::UNCOMPRESSED, true);
+
+    bool passed = true;
+
+    passed &= check_file(plain_path, ptoa::encoding::PLAIN, 0, true);
+    // V1 pages are not decoded while the levels of the column are unknown
+    passed &= check_file(plain_path, ptoa::encoding::PLAIN, -1, false);
+    // Plain pages can not be decoded as delta pages
+    passed &= check_file(plain_path, ptoa::encoding::DELTA, 0, false);
+    passed &= check_file(snappy_path, ptoa::encoding::PLAIN, 0, false);
+    passed &= check_file(dictionary_path, ptoa::encoding::PLAIN, 0, false);
+    // The definition levels in front of the values of an optional column would be decoded as values
+    passed &= check_file(nullable_path, ptoa::encoding::PLAIN, -1, false);
+    passed &= check_file(nullable_path, ptoa::encoding::PLAIN, 1, false);
+
+    if(passed){
+        std::cout << "Test passed!" << std::endl;
+    } else {
+        std::cout << "Test failed..." << std::endl;
+    }
+
+    return passed ? 0 : 1;
+}
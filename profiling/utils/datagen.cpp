@@ -0,0 +1,488 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <type_traits>
+
+#include "datagen.h"
+
+namespace {
+
+// splitmix64, fast and good enough for benchmark data, and any 64 bit state is a valid seed
+struct random_stream {
+  uint64_t state;
+
+  explicit random_stream(uint64_t seed) : state(seed) {}
+
+  uint64_t next() {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27))*0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  // Uniform in [0, bound), the whole 64 bit range for a bound of 0
+  uint64_t below(uint64_t bound) {
+    return bound == 0 ? next() : (uint64_t) (((unsigned __int128) next()*bound) >> 64);
+  }
+
+  // Uniform in [0, 1)
+  double uniform() {
+    return (next() >> 11)*(1.0/9007199254740992.0);
+  }
+};
+
+uint64_t mix(uint64_t value) {
+  return random_stream(value).next();
+}
+
+// Stream of a task, purpose separates the streams one task needs
+random_stream task_stream(uint64_t seed, int64_t task, uint64_t purpose) {
+  return random_stream(mix(seed ^ mix(task*4 + purpose)));
+}
+
+/**
+ * Zipf sampler by rejection-inversion (Hörmann and Derflinger, as in Apache Commons RNG). Constant time per sample and
+ * no tables, so it works for domains of any size.
+ */
+class zipf_sampler {
+  public:
+    zipf_sampler(uint64_t n, double exponent) : n(std::max(n, (uint64_t) 1)), s(exponent) {
+      h_integral_x1 = h_integral(1.5) - 1.0;
+      h_integral_n = h_integral(this->n + 0.5);
+      threshold = 2.0 - h_integral_inverse(h_integral(2.5) - h(2.0));
+    }
+
+    // Rank in [1, n]
+    uint64_t sample(random_stream* rng) const {
+      while(true) {
+        double u = h_integral_n + rng->uniform()*(h_integral_x1 - h_integral_n);
+        double x = h_integral_inverse(u);
+        double k = std::floor(x + 0.5);
+        k = std::min(std::max(k, 1.0), (double) n);
+
+        if(k - x <= threshold || u >= h_integral(k + 0.5) - h(k)) {
+          return (uint64_t) k;
+        }
+      }
+    }
+
+  private:
+    static double helper1(double x) {
+      return std::abs(x) > 1e-8 ? std::log1p(x)/x : 1.0 - x*(0.5 - x*(1.0/3.0 - 0.25*x));
+    }
+
+    static double helper2(double x) {
+      return std::abs(x) > 1e-8 ? std::expm1(x)/x : 1.0 + x*0.5*(1.0 + x*(1.0/3.0)*(1.0 + 0.25*x));
+    }
+
+    double h(double x) const {
+      return std::exp(-s*std::log(x));
+    }
+
+    double h_integral(double x) const {
+      double log_x = std::log(x);
+      return helper2((1.0 - s)*log_x)*log_x;
+    }
+
+    double h_integral_inverse(double x) const {
+      double t = std::max(x*(1.0 - s), -1.0);
+      return std::exp(helper1(t)*x);
+    }
+
+    uint64_t n;
+    double s;
+    double h_integral_x1;
+    double h_integral_n;
+    double threshold;
+};
+
+// Runs task(t) for t in [0, num_tasks) on the given number of threads
+template<typename F>
+void run_tasks(int64_t num_tasks, int threads, const F& task) {
+  std::atomic<int64_t> next_task(0);
+  auto work = [&]() {
+    for(int64_t t = next_task++; t < num_tasks; t = next_task++) {
+      task(t);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for(int i=1; i<std::min((int64_t) threads, num_tasks); i++) {
+    workers.emplace_back(work);
+  }
+  work();
+  for(auto& worker : workers) {
+    worker.join();
+  }
+}
+
+// Draws the values of the distributions that do not depend on the previous value
+class value_sampler {
+  public:
+    explicit value_sampler(const column_spec& spec) : spec(spec), range((uint64_t) spec.max - (uint64_t) spec.min + 1),
+        zipf(range, spec.exponent), run_left(0), run_value(0) {}
+
+    int64_t sample(random_stream* rng) {
+      if(spec.distribution == ZIPF) {
+        return spec.min + (int64_t) (zipf.sample(rng) - 1);
+      }
+      if(spec.distribution == RUNS) {
+        if(run_left == 0) {
+          run_value = spec.min + (int64_t) rng->below(range);
+          run_left = 1 + (int64_t) (-std::log(1.0 - rng->uniform())*(spec.run_length - 1));
+        }
+        run_left--;
+        return run_value;
+      }
+      return spec.min + (int64_t) rng->below(range);
+    }
+
+  private:
+    const column_spec& spec;
+    uint64_t range;
+    zipf_sampler zipf;
+    int64_t run_left;
+    int64_t run_value;
+};
+
+// Delta to the previous value of the increasing distributions, index is the index of the value in the column
+class delta_sampler {
+  public:
+    delta_sampler(const column_spec& spec, uint64_t seed) : spec(spec), seed(seed), run_start(-1), mask(0) {}
+
+    uint64_t sample(random_stream* rng, int64_t index) {
+      if(spec.distribution == SORTED) {
+        return rng->below(spec.step + 1);
+      }
+      if(spec.distribution == TIMESTAMP) {
+        int64_t shortest = std::max(spec.interval - spec.jitter, (int64_t) 0);
+        uint64_t delta = shortest + rng->below(spec.interval + spec.jitter - shortest + 1);
+        if(rng->uniform() < spec.gap_probability) {
+          delta += rng->below(spec.gap*spec.interval + 1);
+        }
+        return delta;
+      }
+
+      // The first value of a page is stored as is, the runs start at the value after it like the miniblocks
+      int64_t page_index = spec.page_values > 0 ? index % spec.page_values : index;
+      int64_t start = page_index == 0 ? index : index - (page_index - 1) % spec.run_length;
+      if(start != run_start) {
+        // The width only depends on where the run starts, so a run spanning the values of two tasks keeps its width
+        random_stream width_rng = task_stream(seed, start, 2);
+        int width = spec.bit_widths[width_rng.below(spec.bit_widths.size())];
+        mask = width >= 64 ? ~0ULL : (1ULL << width) - 1;
+        run_start = start;
+      }
+      return rng->next() & mask;
+    }
+
+  private:
+    const column_spec& spec;
+    uint64_t seed;
+    int64_t run_start;
+    uint64_t mask;
+};
+
+bool is_increasing(value_distribution distribution) {
+  return distribution == SORTED || distribution == TIMESTAMP || distribution == BIT_WIDTHS;
+}
+
+/**
+ * Increasing distributions take two passes: the tasks first store their deltas and sum them up, then every task adds
+ * its deltas to the sum of the tasks before it. Values wrap around like the deltas of DELTA_BINARY_PACKED do.
+ */
+template<typename T>
+void generate_values(const column_spec& spec, int64_t num_values, uint64_t seed, int threads, T* values) {
+  typedef typename std::make_unsigned<T>::type U;
+  int64_t num_tasks = (num_values + DATAGEN_TASK_VALUES - 1)/DATAGEN_TASK_VALUES;
+  std::vector<U> task_sums(num_tasks);
+
+  run_tasks(num_tasks, threads, [&](int64_t t) {
+    random_stream rng = task_stream(seed, t, 0);
+    int64_t end = std::min((t + 1)*DATAGEN_TASK_VALUES, num_values);
+
+    if(is_increasing(spec.distribution)) {
+      delta_sampler sampler(spec, seed);
+      U sum = 0;
+      for(int64_t i=t*DATAGEN_TASK_VALUES; i<end; i++) {
+        values[i] = (T) (U) sampler.sample(&rng, i);
+        sum += (U) values[i];
+      }
+      task_sums[t] = sum;
+    } else {
+      value_sampler sampler(spec);
+      for(int64_t i=t*DATAGEN_TASK_VALUES; i<end; i++) {
+        values[i] = (T) sampler.sample(&rng);
+      }
+    }
+  });
+
+  if(!is_increasing(spec.distribution)) {
+    return;
+  }
+
+  U base = (U) spec.min;
+  for(int64_t t=0; t<num_tasks; t++) {
+    U sum = task_sums[t];
+    task_sums[t] = base;
+    base += sum;
+  }
+
+  run_tasks(num_tasks, threads, [&](int64_t t) {
+    U value = task_sums[t];
+    int64_t end = std::min((t + 1)*DATAGEN_TASK_VALUES, num_values);
+    for(int64_t i=t*DATAGEN_TASK_VALUES; i<end; i++) {
+      value += (U) values[i];
+      values[i] = (T) value;
+    }
+  });
+}
+
+// Lengths go into the offsets first, the second pass turns them into offsets and writes the characters
+bool generate_strings(const column_spec& spec, int64_t num_strings, uint64_t seed, int threads, std::shared_ptr<arrow::Array>* out) {
+  int64_t num_tasks = (num_strings + DATAGEN_TASK_VALUES - 1)/DATAGEN_TASK_VALUES;
+  std::vector<int64_t> task_chars(num_tasks);
+  std::shared_ptr<arrow::Buffer> offset_buffer;
+  std::shared_ptr<arrow::Buffer> char_buffer;
+
+  if(!arrow::AllocateBuffer((num_strings + 1)*sizeof(int32_t), &offset_buffer).ok()) {
+    std::cerr << "[ERROR] Could not allocate the offsets of column " << spec.name << std::endl;
+    return false;
+  }
+  int32_t* offsets = (int32_t*) offset_buffer->mutable_data();
+
+  run_tasks(num_tasks, threads, [&](int64_t t) {
+    random_stream rng = task_stream(seed, t, 0);
+    value_sampler sampler(spec);
+    int64_t end = std::min((t + 1)*DATAGEN_TASK_VALUES, num_strings);
+    int64_t chars = 0;
+    for(int64_t i=t*DATAGEN_TASK_VALUES; i<end; i++) {
+      offsets[i+1] = (int32_t) std::max(sampler.sample(&rng), (int64_t) 0);
+      chars += offsets[i+1];
+    }
+    task_chars[t] = chars;
+  });
+
+  int64_t num_chars = 0;
+  for(int64_t t=0; t<num_tasks; t++) {
+    int64_t chars = task_chars[t];
+    task_chars[t] = num_chars;
+    num_chars += chars;
+  }
+  if(num_chars > std::numeric_limits<int32_t>::max()) {
+    std::cerr << "[ERROR] Column " << spec.name << " would have " << num_chars << " characters, more than 32 bit offsets can address" << std::endl;
+    return false;
+  }
+
+  if(!arrow::AllocateBuffer(num_chars, &char_buffer).ok()) {
+    std::cerr << "[ERROR] Could not allocate the characters of column " << spec.name << std::endl;
+    return false;
+  }
+  uint8_t* chars = char_buffer->mutable_data();
+  offsets[0] = 0;
+
+  run_tasks(num_tasks, threads, [&](int64_t t) {
+    random_stream rng = task_stream(seed, t, 1);
+    int64_t end = std::min((t + 1)*DATAGEN_TASK_VALUES, num_strings);
+    int32_t offset = (int32_t) task_chars[t];
+    for(int64_t i=t*DATAGEN_TASK_VALUES; i<end; i++) {
+      int32_t length = offsets[i+1];
+      for(int32_t c=0; c<length; c++) {
+        chars[offset + c] = (uint8_t) ('a' + rng.below(26));
+      }
+      offset += length;
+      offsets[i+1] = offset;
+    }
+  });
+
+  *out = std::make_shared<arrow::StringArray>(num_strings, offset_buffer, char_buffer);
+
+  return true;
+}
+
+bool parse_distribution(const std::string& name, value_distribution* distribution) {
+  static const std::vector<std::string> names = {"uniform", "zipf", "sorted", "timestamp", "runs", "bit_widths"};
+
+  auto found = std::find(names.begin(), names.end(), name);
+  if(found == names.end()) {
+    return false;
+  }
+  *distribution = (value_distribution) (found - names.begin());
+
+  return true;
+}
+
+bool parse_setting(const std::string& key, const std::string& value, column_spec* spec) {
+  char* end;
+
+  if(key == "bit_widths") {
+    spec->bit_widths.clear();
+    size_t start = 0;
+    while(start < value.size()) {
+      size_t slash = std::min(value.find('/', start), value.size());
+      std::string item = value.substr(start, slash - start);
+      int width = (int) std::strtol(item.c_str(), &end, 10);
+      if(*end != '\0' || slash == start || width < 0 || width > 64) {
+        return false;
+      }
+      spec->bit_widths.push_back(width);
+      start = slash + 1;
+    }
+    return !spec->bit_widths.empty();
+  }
+
+  if(key == "exponent" || key == "gap_probability") {
+    double number = std::strtod(value.c_str(), &end);
+    if(value.empty() || *end != '\0' || number < 0) {
+      return false;
+    }
+    (key == "exponent" ? spec->exponent : spec->gap_probability) = number;
+    return true;
+  }
+
+  int64_t number = std::strtoll(value.c_str(), &end, 10);
+  if(value.empty() || *end != '\0') {
+    return false;
+  }
+
+  if(key == "min") {
+    spec->min = number;
+  } else if(key == "max") {
+    spec->max = number;
+  } else if(key == "step" && number >= 0) {
+    spec->step = number;
+  } else if(key == "interval" && number >= 0) {
+    spec->interval = number;
+  } else if(key == "jitter" && number >= 0) {
+    spec->jitter = number;
+  } else if(key == "gap" && number >= 0) {
+    spec->gap = number;
+  } else if(key == "run_length" && number > 0) {
+    spec->run_length = number;
+  } else if(key == "page_values" && number >= 0) {
+    spec->page_values = number;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+}
+
+bool parse_column_spec(const std::string& text, column_spec* spec) {
+  std::vector<std::string> parts;
+  size_t start = 0;
+  for(int i=0; i<3; i++) {
+    size_t colon = text.find(':', start);
+    parts.push_back(text.substr(start, colon == std::string::npos ? std::string::npos : colon - start));
+    start = colon == std::string::npos ? text.size() + 1 : colon + 1;
+  }
+  std::string settings = start <= text.size() ? text.substr(start) : "";
+
+  *spec = column_spec();
+  spec->name = parts[0];
+
+  if(parts[1] == "int32") {
+    spec->type = arrow::Type::INT32;
+  } else if(parts[1] == "int64") {
+    spec->type = arrow::Type::INT64;
+  } else if(parts[1] == "string") {
+    spec->type = arrow::Type::STRING;
+    spec->max = 16;
+  } else {
+    std::cerr << "[ERROR] Invalid type \"" << parts[1] << "\" in column " << text << ", expected int32, int64 or string" << std::endl;
+    return false;
+  }
+
+  if(spec->name.empty() || !parse_distribution(parts[2], &spec->distribution)) {
+    std::cerr << "[ERROR] Invalid column " << text << ", expected name:type:distribution[:key=value,...]" << std::endl;
+    return false;
+  }
+  if(spec->type == arrow::Type::STRING && is_increasing(spec->distribution)) {
+    std::cerr << "[ERROR] String lengths can only be uniform, zipf or runs distributed" << std::endl;
+    return false;
+  }
+
+  start = 0;
+  while(start < settings.size()) {
+    size_t comma = std::min(settings.find(',', start), settings.size());
+    std::string setting = settings.substr(start, comma - start);
+    size_t equals = setting.find('=');
+
+    if(equals == std::string::npos || !parse_setting(setting.substr(0, equals), setting.substr(equals + 1), spec)) {
+      std::cerr << "[ERROR] Invalid setting \"" << setting << "\" in column " << text << std::endl;
+      return false;
+    }
+    start = comma + 1;
+  }
+
+  if(spec->max < spec->min) {
+    std::cerr << "[ERROR] Column " << spec->name << " has a max below its min" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool generate_column(const column_spec& spec, int64_t num_values, uint64_t seed, int threads, std::shared_ptr<arrow::Array>* out) {
+  threads = std::max(threads, 1);
+
+  if(spec.type == arrow::Type::STRING) {
+    return generate_strings(spec, num_values, seed, threads, out);
+  }
+
+  int width = spec.type == arrow::Type::INT32 ? sizeof(int32_t) : sizeof(int64_t);
+  std::shared_ptr<arrow::Buffer> buffer;
+  if(!arrow::AllocateBuffer(num_values*width, &buffer).ok()) {
+    std::cerr << "[ERROR] Could not allocate the values of column " << spec.name << std::endl;
+    return false;
+  }
+
+  if(spec.type == arrow::Type::INT32) {
+    generate_values(spec, num_values, seed, threads, (int32_t*) buffer->mutable_data());
+    *out = std::make_shared<arrow::PrimitiveArray>(arrow::int32(), num_values, buffer);
+  } else {
+    generate_values(spec, num_values, seed, threads, (int64_t*) buffer->mutable_data());
+    *out = std::make_shared<arrow::PrimitiveArray>(arrow::int64(), num_values, buffer);
+  }
+
+  return true;
+}
+
+bool generate_table(const std::vector<column_spec>& specs, int64_t num_rows, uint64_t seed, int threads, std::shared_ptr<arrow::Table>* out) {
+  std::vector<std::shared_ptr<arrow::Field>> fields;
+  std::vector<std::shared_ptr<arrow::Array>> arrays(specs.size());
+
+  for(size_t c=0; c<specs.size(); c++) {
+    if(!generate_column(specs[c], num_rows, mix(seed + c), threads, &arrays[c])) {
+      return false;
+    }
+    fields.push_back(arrow::field(specs[c].name, arrays[c]->type(), false));
+  }
+
+  *out = arrow::Table::Make(arrow::schema(fields), arrays);
+
+  return true;
+}
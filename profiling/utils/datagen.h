@@ -0,0 +1,78 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+
+// Values per generation task. Every task draws from its own random stream, so the data only depends on the seed and
+// not on the number of threads.
+#define DATAGEN_TASK_VALUES (64*1024)
+
+/**
+ * Shape of a generated integer column. String columns use the distribution for the lengths of their strings, which
+ * have random lowercase characters, and only support UNIFORM, ZIPF and RUNS.
+ */
+enum value_distribution {
+  // Uniform in [min, max]
+  UNIFORM,
+  // min + rank - 1 with rank in [1, max - min + 1] zipf distributed with the given exponent, min is the most frequent
+  ZIPF,
+  // Non-decreasing from min, deltas uniform in [0, step]
+  SORTED,
+  // Increasing from min by interval +- jitter, with an idle gap of up to gap intervals at a rate of gap_probability
+  TIMESTAMP,
+  // Runs of values uniform in [min, max], run lengths are geometric with a mean of run_length
+  RUNS,
+  // Increasing from min by deltas of a bit width drawn from bit_widths for every run_length values. The runs start at
+  // the second value of every page of page_values values, so with run_length 32 every miniblock of DELTA_BINARY_PACKED
+  // has deltas of a single drawn bit width.
+  BIT_WIDTHS
+};
+
+struct column_spec {
+  std::string name;
+  arrow::Type::type type = arrow::Type::INT64;
+  value_distribution distribution = UNIFORM;
+  int64_t min = 0;
+  int64_t max = 1000000;
+  double exponent = 1.0;
+  int64_t step = 16;
+  int64_t interval = 1000;
+  int64_t jitter = 100;
+  int64_t gap = 1000;
+  double gap_probability = 0.001;
+  int64_t run_length = 32;
+  std::vector<int> bit_widths = {8};
+  // Values per page the runs of BIT_WIDTHS line up with, 0 for a single page
+  int64_t page_values = 0;
+};
+
+// Parses name:type:distribution[:key=value,...], e.g. ts:int64:timestamp:interval=1000,jitter=10. The keys are the
+// fields of column_spec, bit_widths separated by slashes. String columns default to lengths in [0, 16].
+bool parse_column_spec(const std::string& text, column_spec* spec);
+
+// Generates num_values values on the given number of threads straight into the buffers of an Arrow array
+bool generate_column(const column_spec& spec, int64_t num_values, uint64_t seed, int threads, std::shared_ptr<arrow::Array>* out);
+
+// Table of non-nullable columns, every column gets its own seed derived from seed
+bool generate_table(const std::vector<column_spec>& specs, int64_t num_rows, uint64_t seed, int threads, std::shared_ptr<arrow::Table>* out);
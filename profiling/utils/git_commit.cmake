@@ -0,0 +1,52 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# Records the commit a benchmark is built from in git_commit.h, for the JSON benchmark reports (report.cpp). Included
+# from a CMakeLists.txt this file defines add_git_commit(target). Run as a script (cmake -P) it writes the header.
+
+if(CMAKE_SCRIPT_MODE_FILE)
+	execute_process(COMMAND git rev-parse --short HEAD WORKING_DIRECTORY ${SOURCE_DIR} OUTPUT_VARIABLE GIT_COMMIT OUTPUT_STRIP_TRAILING_WHITESPACE ERROR_QUIET)
+	if(NOT GIT_COMMIT)
+		set(GIT_COMMIT "unknown")
+	endif()
+
+	# Only rewritten when the commit changed, so report.cpp is not recompiled on every build
+	set(CONTENT "#define GIT_COMMIT \"${GIT_COMMIT}\"\n")
+	if(EXISTS ${OUTPUT})
+		file(READ ${OUTPUT} OLD_CONTENT)
+	endif()
+	if(NOT CONTENT STREQUAL OLD_CONTENT)
+		file(WRITE ${OUTPUT} ${CONTENT})
+	endif()
+
+	return()
+endif()
+
+set(GIT_COMMIT_SCRIPT ${CMAKE_CURRENT_LIST_FILE})
+
+# Regenerate git_commit.h in the build directory of target on every build, instead of capturing the commit once at
+# configure time, so a rebuild after a new commit does not report a stale hash.
+function(add_git_commit target)
+	add_custom_target(${target}_git_commit
+		COMMAND ${CMAKE_COMMAND} -DSOURCE_DIR=${CMAKE_CURRENT_SOURCE_DIR} -DOUTPUT=${CMAKE_CURRENT_BINARY_DIR}/git_commit.h -P ${GIT_COMMIT_SCRIPT}
+		BYPRODUCTS ${CMAKE_CURRENT_BINARY_DIR}/git_commit.h
+		COMMENT "Recording the git commit")
+
+	add_dependencies(${target} ${target}_git_commit)
+	target_include_directories(${target} PRIVATE ${CMAKE_CURRENT_BINARY_DIR})
+	target_compile_definitions(${target} PRIVATE HAVE_GIT_COMMIT_H)
+endfunction()
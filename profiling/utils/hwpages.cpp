@@ -0,0 +1,136 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include "hwpages.h"
+
+// PageType of the Parquet format
+#define PARQUET_DATA_PAGE_V2 3
+
+void append_varint(std::vector<uint8_t>* out, uint64_t value) {
+  while(value >= 0x80) {
+    out->push_back((uint8_t) (value | 0x80));
+    value >>= 7;
+  }
+  out->push_back((uint8_t) value);
+}
+
+void append_zigzag(std::vector<uint8_t>* out, int64_t value) {
+  append_varint(out, ((uint64_t) value << 1) ^ (uint64_t) (value >> 63));
+}
+
+int bit_length(uint64_t value) {
+  return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+void append_page_header(std::vector<uint8_t>* out, int32_t page_size, int32_t num_values, int32_t encoding) {
+  out->push_back(0x15);
+  append_zigzag(out, PARQUET_DATA_PAGE_V2);
+  out->push_back(0x15);
+  append_zigzag(out, page_size);
+  out->push_back(0x15);
+  append_zigzag(out, page_size);
+  // data_page_header_v2 (field 8, struct)
+  out->push_back(0x5c);
+  out->push_back(0x15);
+  append_zigzag(out, num_values);
+  out->push_back(0x15);
+  append_zigzag(out, 0);
+  out->push_back(0x15);
+  append_zigzag(out, num_values);
+  out->push_back(0x15);
+  append_zigzag(out, encoding);
+  out->push_back(0x15);
+  append_zigzag(out, 0);
+  out->push_back(0x15);
+  append_zigzag(out, 0);
+  // is_compressed, true
+  out->push_back(0x11);
+  out->push_back(0x00);
+  out->push_back(0x00);
+}
+
+void append_packed(std::vector<uint8_t>* out, const uint64_t* values, int bit_width) {
+  size_t start = out->size();
+  out->resize(start + bit_width*DELTA_MINIBLOCK_SIZE/8, 0);
+  uint8_t* packed = out->data() + start;
+  int64_t bit = 0;
+
+  for(int i=0; i<DELTA_MINIBLOCK_SIZE; i++) {
+    for(int b=0; b<bit_width; b++, bit++) {
+      if((values[i] >> b) & 1) {
+        packed[bit/8] |= 1 << (bit%8);
+      }
+    }
+  }
+}
+
+template<typename T>
+void append_delta_values(std::vector<uint8_t>* out, const T* values, int64_t num_values, int64_t* width_counts) {
+  typedef typename std::make_unsigned<T>::type U;
+
+  append_varint(out, DELTA_BLOCK_SIZE);
+  append_varint(out, DELTA_MINIBLOCKS);
+  append_varint(out, num_values);
+  append_zigzag(out, num_values > 0 ? values[0] : 0);
+
+  for(int64_t block_start=1; block_start<num_values; block_start+=DELTA_BLOCK_SIZE) {
+    int64_t block_values = std::min((int64_t) DELTA_BLOCK_SIZE, num_values - block_start);
+    T deltas[DELTA_BLOCK_SIZE];
+    T min_delta = std::numeric_limits<T>::max();
+
+    for(int64_t i=0; i<block_values; i++) {
+      deltas[i] = (T) ((U) values[block_start+i] - (U) values[block_start+i-1]);
+      min_delta = std::min(min_delta, deltas[i]);
+    }
+    append_zigzag(out, min_delta);
+
+    uint64_t relative[DELTA_BLOCK_SIZE] = {0};
+    for(int64_t i=0; i<block_values; i++) {
+      relative[i] = (U) ((U) deltas[i] - (U) min_delta);
+    }
+
+    int used_miniblocks = (block_values + DELTA_MINIBLOCK_SIZE - 1)/DELTA_MINIBLOCK_SIZE;
+    uint8_t bit_widths[DELTA_MINIBLOCKS] = {0};
+    for(int m=0; m<used_miniblocks; m++) {
+      uint64_t bits = 0;
+      for(int i=0; i<DELTA_MINIBLOCK_SIZE; i++) {
+        bits |= relative[m*DELTA_MINIBLOCK_SIZE+i];
+      }
+      bit_widths[m] = bit_length(bits);
+      if(width_counts != nullptr) {
+        width_counts[bit_widths[m]]++;
+      }
+    }
+    out->insert(out->end(), bit_widths, bit_widths + DELTA_MINIBLOCKS);
+
+    for(int m=0; m<used_miniblocks; m++) {
+      append_packed(out, &relative[m*DELTA_MINIBLOCK_SIZE], bit_widths[m]);
+    }
+  }
+}
+
+void append_delta(std::vector<uint8_t>* out, const int32_t* values, int64_t num_values, int64_t* width_counts) {
+  append_delta_values(out, values, num_values, width_counts);
+}
+
+void append_delta(std::vector<uint8_t>* out, const int64_t* values, int64_t num_values, int64_t* width_counts) {
+  append_delta_values(out, values, num_values, width_counts);
+}
@@ -0,0 +1,53 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// Parquet Encoding enum values written to the page headers
+#define PARQUET_PLAIN 0
+#define PARQUET_DELTA_BINARY_PACKED 5
+#define PARQUET_DELTA_LENGTH_BYTE_ARRAY 6
+
+// Values per DELTA_BINARY_PACKED block and miniblocks per block, as written by parquet-mr
+#define DELTA_BLOCK_SIZE 128
+#define DELTA_MINIBLOCKS 4
+#define DELTA_MINIBLOCK_SIZE (DELTA_BLOCK_SIZE/DELTA_MINIBLOCKS)
+
+// Slots of a histogram of miniblock bit widths, 0 to 64
+#define DELTA_BIT_WIDTHS 65
+
+// Building blocks of files in the layout the hardware and SWParquetReader read: the magic number followed by V2 data
+// pages. They favour simplicity over speed, software/cpp has the fast writer.
+
+void append_varint(std::vector<uint8_t>* out, uint64_t value);
+void append_zigzag(std::vector<uint8_t>* out, int64_t value);
+
+int bit_length(uint64_t value);
+
+// Compact Thrift V2 page header in the field order of parquet-mr: uncompressed, without levels and without statistics
+void append_page_header(std::vector<uint8_t>* out, int32_t page_size, int32_t num_values, int32_t encoding);
+
+// Packs a miniblock least significant bit first, like the Parquet bit packing the readers expect
+void append_packed(std::vector<uint8_t>* out, const uint64_t* values, int bit_width);
+
+// DELTA_BINARY_PACKED encoding of the values of one page. Miniblocks that hold no values get bit width 0. If
+// width_counts is set, the miniblocks that hold values are counted into it by bit width.
+void append_delta(std::vector<uint8_t>* out, const int32_t* values, int64_t num_values, int64_t* width_counts = nullptr);
+void append_delta(std::vector<uint8_t>* out, const int64_t* values, int64_t num_values, int64_t* width_counts = nullptr);
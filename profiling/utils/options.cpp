@@ -0,0 +1,93 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include "options.h"
+
+std::vector<std::string> split_list(const std::string& value) {
+  std::vector<std::string> items;
+  size_t start = 0;
+
+  while(start <= value.size()) {
+    size_t end = value.find(',', start);
+    if(end == std::string::npos) {
+      end = value.size();
+    }
+    if(end > start) {
+      items.push_back(value.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+
+  return items;
+}
+
+bool parse_numbers(const std::string& name, const std::string& value, int64_t minimum, std::vector<int64_t>* numbers) {
+  numbers->clear();
+
+  for(const std::string& item : split_list(value)) {
+    char* end;
+    int64_t number = std::strtoll(item.c_str(), &end, 10);
+    if(*end != '\0' || number < minimum) {
+      std::cerr << "[ERROR] Invalid value \"" << item << "\" for option --" << name << ", expected a number of at least " << minimum << std::endl;
+      return false;
+    }
+    numbers->push_back(number);
+  }
+
+  if(numbers->empty()) {
+    std::cerr << "[ERROR] Missing value for option --" << name << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool parse_number(const std::string& name, const std::string& value, int64_t minimum, int64_t* number) {
+  std::vector<int64_t> numbers;
+  if(!parse_numbers(name, value, minimum, &numbers)) {
+    return false;
+  }
+  if(numbers.size() != 1) {
+    std::cerr << "[ERROR] Invalid value \"" << value << "\" for option --" << name << ", expected a single number" << std::endl;
+    return false;
+  }
+  *number = numbers[0];
+
+  return true;
+}
+
+bool parse_choices(const std::string& name, const std::string& value, const std::vector<std::string>& allowed, std::vector<std::string>* choices) {
+  *choices = split_list(value);
+
+  for(const std::string& choice : *choices) {
+    if(std::find(allowed.begin(), allowed.end(), choice) == allowed.end()) {
+      std::cerr << "[ERROR] Invalid value \"" << choice << "\" for option --" << name << std::endl;
+      return false;
+    }
+  }
+
+  if(choices->empty()) {
+    std::cerr << "[ERROR] Missing value for option --" << name << std::endl;
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,35 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Parsing of --name=value options shared by the benchmark tools. The parse functions report invalid values on
+// std::cerr as [ERROR] and return false.
+
+// Comma separated items of value, empty items are skipped
+std::vector<std::string> split_list(const std::string& value);
+
+// Comma separated numbers of at least minimum for option --name
+bool parse_numbers(const std::string& name, const std::string& value, int64_t minimum, std::vector<int64_t>* numbers);
+// A single number of at least minimum for option --name
+bool parse_number(const std::string& name, const std::string& value, int64_t minimum, int64_t* number);
+// Comma separated choices for option --name, all of them in allowed
+bool parse_choices(const std::string& name, const std::string& value, const std::vector<std::string>& allowed, std::vector<std::string>* choices);
@@ -0,0 +1,79 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pagecache.h"
+
+int64_t page_cache_resident_bytes(const char* file_path) {
+  int fd = open(file_path, O_RDONLY);
+  if(fd < 0) {
+    return -1;
+  }
+
+  struct stat file_stat;
+  if(fstat(fd, &file_stat) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  if(file_stat.st_size == 0) {
+    close(fd);
+    return 0;
+  }
+
+  // Mapping the file does not fault in any pages, mincore reports which ones are cached
+  void* mapping = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if(mapping == MAP_FAILED) {
+    return -1;
+  }
+
+  long page_size = sysconf(_SC_PAGESIZE);
+  std::vector<unsigned char> residency((file_stat.st_size + page_size - 1)/page_size);
+  int64_t resident_bytes = -1;
+
+  if(mincore(mapping, file_stat.st_size, residency.data()) == 0) {
+    resident_bytes = 0;
+    for(size_t i=0; i<residency.size(); i++) {
+      if(residency[i] & 1) {
+        resident_bytes += page_size;
+      }
+    }
+  }
+
+  munmap(mapping, file_stat.st_size);
+
+  return resident_bytes;
+}
+
+void evict_page_cache(const char* file_path) {
+  int fd = open(file_path, O_RDONLY);
+  if(fd < 0) {
+    return;
+  }
+
+  fdatasync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+}
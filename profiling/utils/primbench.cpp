@@ -0,0 +1,287 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include <SWParquetReader.h>
+#include <MemoryPool.h>
+
+#include "primbench.h"
+#include "options.h"
+#include "pagecache.h"
+#include "report.h"
+#include "timer.h"
+#include "verify.h"
+
+namespace {
+
+const char* ingestion_names[] = {"buffered", "mmap", "io_uring", "direct"};
+
+struct prim_options {
+  std::string hw_input_file_path;
+  std::string reference_parquet_file_path;
+  int64_t num_values;
+  int64_t iterations;
+  bool verify_output;
+  ptoa::encoding enc;
+  int64_t num_threads = 0;
+  int64_t prefetch_distance = DEFAULT_PREFETCH_DISTANCE;
+  ptoa::ingestion ingestion_mode = ptoa::ingestion::BUFFERED;
+  int64_t warmup_iterations = 0;
+  std::string report_path;
+};
+
+void print_usage(const std::string& name) {
+  std::cerr << "Usage: " << name << " parquet_hw_input_file_path reference_parquet_file_path num_values iterations verify(y or n) delta_encoded(y or n) [--option=value]..." << std::endl
+            << "  --threads    threads of the NUMA aware parallel reader, 0 skips it (default 0)" << std::endl
+            << "  --prefetch   pages the page walkers prefetch ahead (default " << DEFAULT_PREFETCH_DISTANCE << ")" << std::endl
+            << "  --ingestion  buffered, mmap, io_uring or direct (default buffered)" << std::endl
+            << "  --warmup     untimed iterations before every run (default 0)" << std::endl
+            << "  --report     path of the report, written to <report>.csv and <report>.json" << std::endl;
+}
+
+bool parse_yes_no(const char* value, const std::string& option, bool* result) {
+  if(value[0] == 'y') {
+    *result = true;
+  } else if(value[0] == 'n') {
+    *result = false;
+  } else {
+    std::cerr << "Invalid argument. Option \"" << option << "\" should be \"y\" or \"n\"" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool parse_options(int argc, char** argv, prim_options* options) {
+  if(argc < 7) {
+    return false;
+  }
+
+  options->hw_input_file_path = argv[1];
+  options->reference_parquet_file_path = argv[2];
+  bool delta_encoded;
+  if(!parse_number("num_values", argv[3], 0, &options->num_values) || !parse_number("iterations", argv[4], 0, &options->iterations) ||
+     !parse_yes_no(argv[5], "verify", &options->verify_output) || !parse_yes_no(argv[6], "delta_encoded", &delta_encoded)) {
+    return false;
+  }
+  options->enc = delta_encoded ? ptoa::encoding::DELTA : ptoa::encoding::PLAIN;
+
+  for(int i=7; i<argc; i++) {
+    std::string arg = argv[i];
+    if(arg.compare(0, 2, "--") != 0) {
+      std::cerr << "[ERROR] Unexpected argument " << arg << std::endl;
+      return false;
+    }
+
+    size_t equals = arg.find('=');
+    std::string name = arg.substr(2, equals == std::string::npos ? std::string::npos : equals - 2);
+    std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+    bool valid;
+
+    if(name == "threads") {
+      valid = parse_number(name, value, 0, &options->num_threads);
+    } else if(name == "prefetch") {
+      valid = parse_number(name, value, 0, &options->prefetch_distance);
+    } else if(name == "ingestion") {
+      std::vector<std::string> mode;
+      valid = parse_choices(name, value, {"buffered", "mmap", "io_uring", "direct"}, &mode) && mode.size() == 1;
+      if(valid) {
+        options->ingestion_mode = (ptoa::ingestion) (std::find(ingestion_names, ingestion_names + 4, mode[0]) - ingestion_names);
+      }
+    } else if(name == "warmup") {
+      valid = parse_number(name, value, 0, &options->warmup_iterations);
+    } else if(name == "report") {
+      options->report_path = value;
+      valid = !value.empty();
+    } else {
+      std::cerr << "[ERROR] Unknown option --" << name << std::endl;
+      valid = false;
+    }
+
+    if(!valid) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Time warmup_iterations + iterations calls of decode, recording only the latter
+bool time_runs(Timer* t, const prim_options& options, const std::function<ptoa::status()>& decode) {
+  t->clear_history();
+
+  for(int i=0; i<options.warmup_iterations+options.iterations; i++) {
+    t->start();
+    if(decode() != ptoa::status::OK) {
+      return false;
+    }
+    t->stop();
+    if(i >= options.warmup_iterations) {
+      t->record();
+    }
+  }
+
+  return true;
+}
+
+}
+
+int prim_benchmark(const std::string& name, int32_t prim_width, int argc, char** argv) {
+  prim_options options;
+  if(!parse_options(argc, argv, &options)) {
+    print_usage(name);
+    return 1;
+  }
+
+  const char* hw_input_file_path = options.hw_input_file_path.c_str();
+  int64_t num_values = options.num_values;
+  ptoa::encoding enc = options.enc;
+  ptoa::ingestion ingestion_mode = options.ingestion_mode;
+  Timer t;
+
+  // Recycles the buffers of the "not pre-allocated" benchmark between iterations
+  ptoa::MemoryPool pool;
+
+  ptoa::SWParquetReader reader(hw_input_file_path, &pool, ingestion_mode);
+  reader.set_prefetch_distance(options.prefetch_distance);
+  if(ingestion_mode != ptoa::ingestion::DIRECT) {
+    reader.count_pages(4);
+  }
+  std::cout << "Prefetch distance: " << reader.get_prefetch_distance() << " pages, ingestion: " << ingestion_names[reader.get_ingestion()] << std::endl;
+
+  // Statistics of every run, written to report_path.csv and report_path.json if a report path is given
+  BenchmarkReport report(name, options.warmup_iterations);
+  report.set_parameter("file", hw_input_file_path);
+  report.set_parameter("num_values", std::to_string(num_values));
+  report.set_parameter("encoding", enc == ptoa::encoding::DELTA ? "delta" : "plain");
+  report.set_parameter("num_threads", std::to_string(options.num_threads));
+  report.set_parameter("prefetch_distance", std::to_string(options.prefetch_distance));
+  report.set_parameter("ingestion", ingestion_names[reader.get_ingestion()]);
+  int64_t input_bytes = file_size_bytes(hw_input_file_path);
+  int64_t output_bytes = num_values*(prim_width/8);
+
+  // Hardware event counts are printed below the statistics if perf_event_open is permitted
+  t.enable_counters();
+  auto report_run = [&](const std::string& run_name) {
+    BenchmarkReport::print(std::cout, report.add_run(run_name, t.get_history(), num_values, input_bytes, output_bytes));
+    if(t.counters_enabled()) {
+      std::cout << "    " << t.counter_summary(num_values, output_bytes) << std::endl;
+    }
+  };
+
+  std::shared_ptr<arrow::PrimitiveArray> array;
+  std::shared_ptr<arrow::Buffer> arr_buffer;
+
+  // Only relevant for the benchmark with pre-allocated (and memset) buffer
+  arrow::AllocateBuffer(output_bytes, &arr_buffer);
+  std::memset((void*)(arr_buffer->mutable_data()), 0, output_bytes);
+
+  if(!time_runs(&t, options, [&]() { return reader.read_prim(prim_width, num_values, 4, &array, arr_buffer, enc); })) {
+    return 1;
+  }
+
+  std::cout << "Read " << num_values << " values" << std::endl;
+  std::cout << "Average time in seconds (pre-allocated): " << t.average() << std::endl;
+  report_run("pre_allocated");
+
+  if(!time_runs(&t, options, [&]() { return reader.read_prim(prim_width, num_values, 4, &array, enc); })) {
+    return 1;
+  }
+
+  std::cout << "Read " << num_values << " values" << std::endl;
+  std::cout << "Average time in seconds (not pre-allocated): " << t.average() << std::endl;
+  report_run("not_pre_allocated");
+  std::cout << "Memory pool OS allocations: " << pool.os_allocations() << ", bytes reserved: " << pool.bytes_reserved() << std::endl;
+
+  // Only counted when built with -DPTOA_INSTRUMENT=ON, covers both benchmarks above
+  ptoa::reader_stats stage_stats = reader.get_stats();
+  if(stage_stats.instrumented) {
+    std::cout << "Decoding stage counters: " << stage_stats.to_json() << std::endl;
+  }
+
+  // Includes getting the file into memory from a cold page cache, so ingestion modes that overlap I/O with decoding or
+  // bypass the page cache can be compared
+  std::shared_ptr<arrow::PrimitiveArray> cold_array;
+  t.clear_history();
+
+  for(int i=0; i<options.warmup_iterations+options.iterations; i++) {
+    evict_page_cache(hw_input_file_path);
+    t.start();
+    ptoa::SWParquetReader reader_cold(hw_input_file_path, &pool, ingestion_mode);
+    reader_cold.set_prefetch_distance(options.prefetch_distance);
+    if(reader_cold.read_prim(prim_width, num_values, 4, &cold_array, enc) != ptoa::status::OK) {
+      return 1;
+    }
+    t.stop();
+    if(i >= options.warmup_iterations) {
+      t.record();
+    }
+  }
+
+  std::cout << "Average time in seconds (ingest and read, " << ingestion_names[ingestion_mode] << "): " << t.average() << std::endl;
+  report_run(std::string("cold_") + ingestion_names[ingestion_mode]);
+  std::cout << "Page cache footprint of input file after reading: " << page_cache_resident_bytes(hw_input_file_path) << " bytes" << std::endl;
+
+  if(options.num_threads > 0) {
+    // Separate reader on the default pool, so every iteration gets an untouched output buffer for first touch. It
+    // needs the whole file in memory, so direct ingestion is replaced by buffered reading.
+    ptoa::SWParquetReader parallel_reader(hw_input_file_path, arrow::default_memory_pool(), ingestion_mode == ptoa::ingestion::DIRECT ? ptoa::ingestion::BUFFERED : ingestion_mode);
+    parallel_reader.set_prefetch_distance(options.prefetch_distance);
+    ptoa::parallel_options parallel = {(int) options.num_threads, true, false};
+    ptoa::parallel_stats stats;
+    std::shared_ptr<arrow::PrimitiveArray> parallel_array;
+
+    for(int replicate=0; replicate<2; replicate++) {
+      parallel.replicate_input = replicate;
+
+      if(!time_runs(&t, options, [&]() { return parallel_reader.read_prim_parallel(prim_width, num_values, 4, &parallel_array, enc, parallel, &stats); })) {
+        return 1;
+      }
+
+      std::cout << "Average time in seconds (" << options.num_threads << " threads, NUMA aware" << (replicate ? ", replicated input" : "") << "): " << t.average() << std::endl;
+      report_run(replicate ? "parallel_replicated" : "parallel");
+      for(size_t n=0; n<stats.node_ids.size(); n++) {
+        std::cout << "    Node " << stats.node_ids[n] << ": " << stats.node_bytes_in[n]/stats.node_seconds[n]/1e9 << " GB/s in, "
+                  << stats.node_bytes_out[n]/stats.node_seconds[n]/1e9 << " GB/s out (last iteration)" << std::endl;
+      }
+    }
+  }
+
+  if(!options.report_path.empty()) {
+    if(!report.write_csv(options.report_path + ".csv") || !report.write_json(options.report_path + ".json")) {
+      return 1;
+    }
+    std::cout << "Wrote " << options.report_path << ".csv and " << options.report_path << ".json" << std::endl;
+  }
+
+  if(options.verify_output) {
+    int64_t error_count = count_mismatches(array, read_reference_column(options.reference_parquet_file_path), 20);
+
+    if(error_count == 0) {
+      std::cout << "Test passed!" << std::endl;
+    } else {
+      std::cout << "Test failed. Found " << error_count << " errors in the output Arrow array" << std::endl;
+    }
+  }
+
+  return 0;
+}
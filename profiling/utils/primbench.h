@@ -0,0 +1,32 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * The decoding benchmark of the prim, prim32 and prim64 binaries, for a column of prim_width bit integers in a file in
+ * the hardware layout. Takes the command line of the binary:
+ *
+ *   name hw_input_file reference_file num_values iterations verify(y or n) delta_encoded(y or n) [--option=value]...
+ *
+ * The column is read by SWParquetReader into a preallocated and into fresh buffers, from a cold page cache and, with
+ * --threads, by the NUMA aware parallel reader. The filter and aggregate kernels are benchmarked by sweep.
+ */
+int prim_benchmark(const std::string& name, int32_t prim_width, int argc, char** argv);
@@ -0,0 +1,270 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "report.h"
+
+// Generated at build time by git_commit.cmake with the commit the benchmark was built from
+#ifdef HAVE_GIT_COMMIT_H
+#include "git_commit.h"
+#endif
+#ifndef GIT_COMMIT
+#define GIT_COMMIT "unknown"
+#endif
+
+namespace {
+
+std::string json_string(const std::string& value) {
+  std::string escaped = "\"";
+
+  for(char c : value) {
+    if(c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if((unsigned char) c < 0x20) {
+      escaped += ' ';
+    } else {
+      escaped += c;
+    }
+  }
+
+  return escaped + "\"";
+}
+
+std::string cpu_model() {
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+
+  while(std::getline(cpuinfo, line)) {
+    if(line.compare(0, 10, "model name") == 0 && line.find(':') != std::string::npos) {
+      return line.substr(line.find(':') + 2);
+    }
+  }
+
+  return "unknown";
+}
+
+std::string host_name() {
+  char name[256];
+
+  if(gethostname(name, sizeof(name)) != 0) {
+    return "unknown";
+  }
+  name[sizeof(name)-1] = '\0';
+
+  return name;
+}
+
+}
+
+double percentile(std::vector<double> seconds, double p) {
+  if(seconds.empty()) {
+    return 0;
+  }
+
+  std::sort(seconds.begin(), seconds.end());
+  size_t rank = (size_t) std::ceil(p/100*seconds.size());
+
+  return seconds[std::min(std::max(rank, (size_t) 1), seconds.size()) - 1];
+}
+
+double median(std::vector<double> seconds) {
+  if(seconds.empty()) {
+    return 0;
+  }
+
+  std::sort(seconds.begin(), seconds.end());
+  size_t middle = seconds.size()/2;
+
+  return seconds.size() % 2 ? seconds[middle] : (seconds[middle-1] + seconds[middle])/2;
+}
+
+double stddev(const std::vector<double>& seconds) {
+  if(seconds.size() < 2) {
+    return 0;
+  }
+
+  double mean = 0;
+  for(double s : seconds) {
+    mean += s;
+  }
+  mean /= seconds.size();
+
+  double sum_squares = 0;
+  for(double s : seconds) {
+    sum_squares += (s - mean)*(s - mean);
+  }
+
+  return std::sqrt(sum_squares/(seconds.size() - 1));
+}
+
+int64_t file_size_bytes(const char* file_path) {
+  struct stat file_stat;
+
+  if(stat(file_path, &file_stat) != 0) {
+    return -1;
+  }
+
+  return file_stat.st_size;
+}
+
+BenchmarkReport::BenchmarkReport(std::string benchmark, int warmup_iterations) : benchmark_(benchmark),
+  warmup_iterations_(warmup_iterations) {}
+
+void BenchmarkReport::set_parameter(const std::string& key, const std::string& value) {
+  for(auto& parameter : parameters_) {
+    if(parameter.first == key) {
+      parameter.second = value;
+      return;
+    }
+  }
+
+  parameters_.push_back(std::make_pair(key, value));
+}
+
+const run_summary& BenchmarkReport::add_run(const std::string& name, const std::vector<double>& seconds, int64_t num_values, int64_t input_bytes, int64_t output_bytes,
+                                           const std::vector<std::pair<std::string, std::string>>& parameters) {
+  run_summary run;
+  run.name = name;
+  run.parameters = parameters;
+  run.iterations = seconds.size();
+  run.warmup_iterations = warmup_iterations_;
+  run.num_values = num_values;
+  run.input_bytes = input_bytes;
+  run.output_bytes = output_bytes;
+  run.min = seconds.empty() ? 0 : *std::min_element(seconds.begin(), seconds.end());
+  run.median = median(seconds);
+  run.p90 = percentile(seconds, 90);
+  run.p99 = percentile(seconds, 99);
+  run.mean = 0;
+  for(double s : seconds) {
+    run.mean += s;
+  }
+  run.mean = seconds.empty() ? 0 : run.mean/seconds.size();
+  run.stddev = stddev(seconds);
+  run.values_per_second = run.median > 0 ? num_values/run.median : 0;
+  run.input_gbps = run.median > 0 ? input_bytes/run.median/1e9 : 0;
+  run.output_gbps = run.median > 0 ? output_bytes/run.median/1e9 : 0;
+
+  runs_.push_back(run);
+
+  return runs_.back();
+}
+
+void BenchmarkReport::print(std::ostream& out, const run_summary& run) {
+  out << "    min " << run.min << ", median " << run.median << ", p90 " << run.p90 << ", p99 " << run.p99
+      << ", stddev " << run.stddev << " s over " << run.iterations << " iterations (" << run.warmup_iterations << " warmup), "
+      << run.values_per_second << " values/s, ";
+  if(run.input_bytes > 0) {
+    out << run.input_gbps << " GB/s in, ";
+  }
+  out << run.output_gbps << " GB/s out" << std::endl;
+}
+
+bool BenchmarkReport::write_csv(const std::string& path) {
+  std::ofstream csv(path);
+  if(!csv) {
+    std::cerr << "[ERROR] Could not open " << path << " for writing" << std::endl;
+    return false;
+  }
+
+  std::vector<std::string> keys;
+  for(const run_summary& run : runs_) {
+    for(const auto& parameter : run.parameters) {
+      if(std::find(keys.begin(), keys.end(), parameter.first) == keys.end()) {
+        keys.push_back(parameter.first);
+      }
+    }
+  }
+
+  csv << "benchmark,run,iterations,warmup,num_values,input_bytes,output_bytes,min,median,p90,p99,mean,stddev,values_per_second,input_gbps,output_gbps";
+  for(const std::string& key : keys) {
+    csv << "," << key;
+  }
+  csv << std::endl;
+
+  for(const run_summary& run : runs_) {
+    csv << benchmark_ << "," << run.name << "," << run.iterations << "," << run.warmup_iterations << "," << run.num_values << ","
+        << run.input_bytes << "," << run.output_bytes << "," << run.min << "," << run.median << "," << run.p90 << ","
+        << run.p99 << "," << run.mean << "," << run.stddev << "," << run.values_per_second << "," << run.input_gbps << ","
+        << run.output_gbps;
+    for(const std::string& key : keys) {
+      csv << ",";
+      for(const auto& parameter : run.parameters) {
+        if(parameter.first == key) {
+          csv << parameter.second;
+        }
+      }
+    }
+    csv << std::endl;
+  }
+
+  return true;
+}
+
+bool BenchmarkReport::write_json(const std::string& path) {
+  std::ofstream json(path);
+  if(!json) {
+    std::cerr << "[ERROR] Could not open " << path << " for writing" << std::endl;
+    return false;
+  }
+
+  json << std::setprecision(9);
+  json << "{" << std::endl;
+  json << "  \"benchmark\": " << json_string(benchmark_) << "," << std::endl;
+  json << "  \"commit\": " << json_string(GIT_COMMIT) << "," << std::endl;
+  json << "  \"timestamp\": " << std::time(nullptr) << "," << std::endl;
+  json << "  \"machine\": {\"host\": " << json_string(host_name()) << ", \"cpu\": " << json_string(cpu_model())
+       << ", \"online_cpus\": " << sysconf(_SC_NPROCESSORS_ONLN) << "}," << std::endl;
+
+  json << "  \"parameters\": {";
+  for(size_t i=0; i<parameters_.size(); i++) {
+    json << (i > 0 ? ", " : "") << json_string(parameters_[i].first) << ": " << json_string(parameters_[i].second);
+  }
+  json << "}," << std::endl;
+
+  json << "  \"runs\": [";
+  for(size_t i=0; i<runs_.size(); i++) {
+    const run_summary& run = runs_[i];
+    json << (i > 0 ? "," : "") << std::endl;
+    json << "    {\"name\": " << json_string(run.name) << ", \"iterations\": " << run.iterations << ", \"warmup\": " << run.warmup_iterations
+         << ", \"num_values\": " << run.num_values << ", \"input_bytes\": " << run.input_bytes << ", \"output_bytes\": " << run.output_bytes
+         << ", \"seconds\": {\"min\": " << run.min << ", \"median\": " << run.median << ", \"p90\": " << run.p90 << ", \"p99\": " << run.p99
+         << ", \"mean\": " << run.mean << ", \"stddev\": " << run.stddev << "}, \"values_per_second\": " << run.values_per_second
+         << ", \"input_gbps\": " << run.input_gbps << ", \"output_gbps\": " << run.output_gbps;
+    if(!run.parameters.empty()) {
+      json << ", \"parameters\": {";
+      for(size_t j=0; j<run.parameters.size(); j++) {
+        json << (j > 0 ? ", " : "") << json_string(run.parameters[j].first) << ": " << json_string(run.parameters[j].second);
+      }
+      json << "}";
+    }
+    json << "}";
+  }
+  json << std::endl << "  ]" << std::endl << "}" << std::endl;
+
+  return true;
+}
@@ -0,0 +1,84 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Statistics of the timed (non-warmup) iterations of one benchmark run. Throughput figures are based on the median.
+struct run_summary {
+  std::string name;
+  int iterations;
+  int warmup_iterations;
+  int64_t num_values;
+  int64_t input_bytes;
+  int64_t output_bytes;
+  double min;
+  double median;
+  double p90;
+  double p99;
+  double mean;
+  double stddev;
+  double values_per_second;
+  double input_gbps;
+  double output_gbps;
+  // Configuration of a run within a parameter sweep, empty for benchmarks that only vary the run name
+  std::vector<std::pair<std::string, std::string>> parameters;
+};
+
+// Percentile (0 to 100) of the given seconds by nearest rank, the median averages the two middle values
+double percentile(std::vector<double> seconds, double p);
+double median(std::vector<double> seconds);
+// Sample standard deviation, 0 for less than two values
+double stddev(const std::vector<double>& seconds);
+// Size of a file in bytes, -1 if it could not be inspected
+int64_t file_size_bytes(const char* file_path);
+
+/**
+ * Collects the runs of a benchmark binary and writes them as CSV (one row per run, like results.csv) and as JSON together
+ * with the parameters of the benchmark and a description of the machine, for comparison across commits and machines.
+ */
+class BenchmarkReport {
+  public:
+    BenchmarkReport(std::string benchmark, int warmup_iterations);
+
+    int warmup_iterations() { return warmup_iterations_; }
+    void set_parameter(const std::string& key, const std::string& value);
+
+    // Summarize the recorded seconds of a run, which should not include the warmup iterations. input_bytes is 0 for runs
+    // that do not read any input.
+    const run_summary& add_run(const std::string& name, const std::vector<double>& seconds, int64_t num_values, int64_t input_bytes, int64_t output_bytes,
+                               const std::vector<std::pair<std::string, std::string>>& parameters = {});
+    const std::vector<run_summary>& runs() { return runs_; }
+
+    // Human readable statistics of a run on a single line, without input throughput for runs without input
+    static void print(std::ostream& out, const run_summary& run);
+
+    // Runs with parameters get one extra column per parameter key, in order of first appearance
+    bool write_csv(const std::string& path);
+    bool write_json(const std::string& path);
+
+  private:
+    std::string benchmark_;
+    int warmup_iterations_;
+    std::vector<std::pair<std::string, std::string>> parameters_;
+    std::vector<run_summary> runs_;
+};
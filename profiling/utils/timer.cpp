@@ -19,9 +19,174 @@
 
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #include "timer.h"
 
+namespace {
+
+struct event_config {
+  uint32_t type;
+  uint64_t config;
+  const char* name;
+};
+
+#define CACHE_READ_MISS(cache) ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+// Indexed by counter_event
+const event_config EVENT_CONFIGS[NUM_COUNTER_EVENTS] = {
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+  {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D), "L1D misses"},
+  {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL), "LLC misses"},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "branch misses"},
+  {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB), "dTLB misses"}
+};
+
+int open_event(const event_config& event, int group_fd) {
+  struct perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = event.type;
+  attr.config = event.config;
+  attr.disabled = group_fd < 0;
+  // Worker threads started and joined between start and stop are added to the counts when they exit
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+}
+
+Timer::Timer() {
+  for(int e=0; e<NUM_COUNTER_EVENTS; e++){
+    counter_fds[e] = -1;
+  }
+}
+
+Timer::~Timer() {
+  for(int e=0; e<NUM_COUNTER_EVENTS; e++){
+    if(counter_fds[e] >= 0){
+      close(counter_fds[e]);
+    }
+  }
+}
+
+void Timer::record() {
+  history.push_back(this->seconds());
+  if(group_fd >= 0){
+    counter_history.push_back(sample_);
+  }
+}
+
+void Timer::clear_history() {
+  history.clear();
+  counter_history.clear();
+}
+
+bool Timer::enable_counters() {
+  if(group_fd >= 0){
+    return true;
+  }
+
+  int open_errors[NUM_COUNTER_EVENTS];
+
+  for(int e=0; e<NUM_COUNTER_EVENTS; e++){
+    counter_fds[e] = open_event(EVENT_CONFIGS[e], group_fd);
+    open_errors[e] = errno;
+
+    if(counter_fds[e] >= 0 && group_fd < 0){
+      group_fd = counter_fds[e];
+    }
+  }
+
+  if(group_fd < 0){
+    std::cerr << "[WARNING] Performance counters are not available: " << std::strerror(open_errors[CYCLES]) << std::endl;
+    return false;
+  }
+
+  for(int e=0; e<NUM_COUNTER_EVENTS; e++){
+    if(counter_fds[e] < 0){
+      std::cerr << "[WARNING] Could not open performance counter for " << EVENT_CONFIGS[e].name << ": " << std::strerror(open_errors[e]) << std::endl;
+    }
+  }
+
+  return true;
+}
+
+void Timer::start_counters() {
+  ioctl(group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void Timer::stop_counters() {
+  ioctl(group_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+  for(int e=0; e<NUM_COUNTER_EVENTS; e++){
+    // value, time enabled, time running
+    uint64_t data[3];
+    sample_.valid[e] = counter_fds[e] >= 0 && read(counter_fds[e], data, sizeof(data)) == sizeof(data) && data[2] > 0;
+    sample_.values[e] = sample_.valid[e] ? (double) data[0] * data[1] / data[2] : 0;
+  }
+}
+
+counter_sample Timer::average_counters() {
+  counter_sample average;
+
+  for(int e=0; e<NUM_COUNTER_EVENTS; e++){
+    average.values[e] = 0;
+    average.valid[e] = !counter_history.empty();
+
+    for(const counter_sample& sample : counter_history){
+      average.values[e] += sample.values[e];
+      average.valid[e] = average.valid[e] && sample.valid[e];
+    }
+
+    if(!counter_history.empty()){
+      average.values[e] /= counter_history.size();
+    }
+  }
+
+  return average;
+}
+
+std::string Timer::counter_summary(int64_t num_values, int64_t num_bytes) {
+  counter_sample average = average_counters();
+  std::ostringstream summary;
+  summary << std::fixed << std::setprecision(2);
+
+  if(average.valid[CYCLES] && average.valid[INSTRUCTIONS] && average.values[CYCLES] > 0){
+    summary << "IPC " << average.values[INSTRUCTIONS]/average.values[CYCLES] << ", ";
+  }
+  if(average.valid[CYCLES] && average.values[CYCLES] > 0){
+    summary << average.values[CYCLES]/num_values << " cycles/value, " << num_bytes/average.values[CYCLES] << " bytes/cycle";
+  } else {
+    summary << "cycles not counted";
+  }
+
+  summary << ", per 1000 values:";
+  for(int e=L1D_MISSES; e<NUM_COUNTER_EVENTS; e++){
+    summary << " " << EVENT_CONFIGS[e].name << " ";
+    if(average.valid[e]){
+      summary << average.values[e]*1000/num_values;
+    } else {
+      summary << "n/a";
+    }
+  }
+
+  return summary.str();
+}
+
 double Timer::seconds() {
   duration diff = stop_ - start_;
 
@@ -20,30 +20,79 @@
 #pragma once
 
 #include <chrono>
+#include <stdint.h>
+#include <string>
 #include <vector>
 
+// Hardware events counted around every timed interval once counters are enabled
+enum counter_event {
+  CYCLES,
+  INSTRUCTIONS,
+  L1D_MISSES,
+  LLC_MISSES,
+  BRANCH_MISSES,
+  DTLB_MISSES,
+  NUM_COUNTER_EVENTS
+};
+
+// Event counts of a single interval, scaled up if the kernel had to multiplex the events. Events that could not be
+// opened or were never scheduled are not valid.
+struct counter_sample {
+  double values[NUM_COUNTER_EVENTS];
+  bool valid[NUM_COUNTER_EVENTS];
+};
+
 class Timer {
-  using system_clock = std::chrono::system_clock;
-  using nanoseconds = std::chrono::nanoseconds;
-  using time_point = std::chrono::time_point<system_clock, nanoseconds>;
+  using steady_clock = std::chrono::steady_clock;
+  using time_point = std::chrono::time_point<steady_clock>;
   using duration = std::chrono::duration<double>;
 
   private:
     std::vector<double> history;
+    std::vector<counter_sample> counter_history;
   
     time_point start_{};
     time_point stop_{};
+
+    // perf_event_open file descriptors, -1 for events that are not counted. The first opened event leads the group, so
+    // all events are scheduled on the PMU together.
+    int counter_fds[NUM_COUNTER_EVENTS];
+    int group_fd = -1;
+    counter_sample sample_{};
+
+    void start_counters();
+    void stop_counters();
   
   public:
-    Timer() = default;
+    Timer();
+    ~Timer();
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
   
-    inline void start() { start_ = std::chrono::high_resolution_clock::now(); }
-    inline void stop() { stop_ = std::chrono::high_resolution_clock::now(); }
+    inline void start() {
+      if(group_fd >= 0) start_counters();
+      start_ = steady_clock::now();
+    }
+    inline void stop() {
+      stop_ = steady_clock::now();
+      if(group_fd >= 0) stop_counters();
+    }
   
-    inline void record() { history.push_back(this->seconds()); }
-    inline void clear_history() { history.clear(); }
+    void record();
+    void clear_history();
   
     double seconds();
     double average();
     double total();
+    // Seconds of every recorded interval
+    const std::vector<double>& get_history() { return history; }
+
+    // Count hardware events of the calling thread (and threads it starts and joins) between start and stop. Returns
+    // false if no event could be opened, e.g. due to kernel.perf_event_paranoid or a missing PMU in a virtual machine.
+    bool enable_counters();
+    bool counters_enabled() { return group_fd >= 0; }
+    // Average event counts over the recorded intervals
+    counter_sample average_counters();
+    // IPC, cycles per value, bytes per cycle and misses per 1000 values of the recorded intervals in one line
+    std::string counter_summary(int64_t num_values, int64_t num_bytes);
 };
@@ -0,0 +1,117 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#include <arrow/io/api.h>
+#include <parquet/arrow/reader.h>
+
+#include "verify.h"
+
+namespace {
+
+int64_t value_at(const arrow::Array& array, int64_t i) {
+  const uint8_t* values = static_cast<const arrow::PrimitiveArray&>(array).values()->data();
+  int64_t index = array.offset() + i;
+
+  if(array.type()->id() == arrow::Type::INT32) {
+    return ((const int32_t*) values)[index];
+  }
+  return ((const int64_t*) values)[index];
+}
+
+}
+
+std::shared_ptr<arrow::Array> read_reference_column(const std::string& file_path) {
+  std::shared_ptr<arrow::io::ReadableFile> infile;
+  PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(file_path, arrow::default_memory_pool(), &infile));
+
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+
+  std::shared_ptr<arrow::Array> array;
+  PARQUET_THROW_NOT_OK(reader->ReadColumn(0, &array));
+
+  return array;
+}
+
+int64_t count_mismatches(const std::shared_ptr<arrow::Array>& result, const std::shared_ptr<arrow::Array>& expected, int64_t max_reported) {
+  int64_t length = std::min(result->length(), expected->length());
+  int64_t errors = std::max(result->length(), expected->length()) - length;
+
+  for(int64_t i=0; i<length; i++) {
+    int64_t value = value_at(*result, i);
+    int64_t expected_value = value_at(*expected, i);
+
+    if(value != expected_value) {
+      if(errors < max_reported) {
+        std::cout << i << ": " << value << " " << expected_value << std::endl;
+      }
+      errors++;
+    }
+  }
+
+  return errors;
+}
+
+bool verify_between(const std::shared_ptr<arrow::Array>& expected, int64_t lo, int64_t hi, const uint8_t* sel_bitmap, const std::shared_ptr<arrow::Array>& selected) {
+  int64_t num_selected = selected->length();
+  int64_t expected_selected = 0;
+
+  for(int64_t i=0; i<expected->length(); i++) {
+    int64_t value = value_at(*expected, i);
+    bool match = value >= lo && value <= hi;
+    bool is_selected = (sel_bitmap[i >> 3] >> (i & 7)) & 1;
+
+    if(is_selected != match) {
+      return false;
+    }
+    if(match) {
+      if(expected_selected >= num_selected || value_at(*selected, expected_selected) != value) {
+        return false;
+      }
+      expected_selected++;
+    }
+  }
+
+  return expected_selected == num_selected;
+}
+
+bool verify_aggregates(const std::shared_ptr<arrow::Array>& expected, int64_t count, int64_t sum, int64_t min, int64_t max) {
+  uint64_t expected_sum = 0;
+  int64_t expected_min = std::numeric_limits<int64_t>::max();
+  int64_t expected_max = std::numeric_limits<int64_t>::min();
+
+  for(int64_t i=0; i<expected->length(); i++) {
+    int64_t value = value_at(*expected, i);
+    expected_sum += (uint64_t) value;
+    expected_min = std::min(expected_min, value);
+    expected_max = std::max(expected_max, value);
+  }
+
+  bool correct = count == expected->length() && sum == (int64_t) expected_sum &&
+                 (expected->length() == 0 || (min == expected_min && max == expected_max));
+
+  if(!correct) {
+    std::cout << "Expected count " << expected->length() << ", sum " << (int64_t) expected_sum << ", min " << expected_min
+              << ", max " << expected_max << std::endl;
+  }
+
+  return correct;
+}
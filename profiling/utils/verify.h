@@ -0,0 +1,40 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements. See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership. The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License. You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include <arrow/api.h>
+
+// Checks of the output of the decoders against a reference column, shared by the benchmarks. Integer columns are int32
+// or int64 arrays, their values are compared as int64_t.
+
+// Column 0 of a Parquet file, read with arrow's FileReader
+std::shared_ptr<arrow::Array> read_reference_column(const std::string& file_path);
+
+// Amount of values that differ from the reference, the first max_reported of them are printed
+int64_t count_mismatches(const std::shared_ptr<arrow::Array>& result, const std::shared_ptr<arrow::Array>& expected, int64_t max_reported);
+
+// Whether the selection bitmap and the selected values match a scalar lo <= value <= hi filter over the reference
+bool verify_between(const std::shared_ptr<arrow::Array>& expected, int64_t lo, int64_t hi, const uint8_t* sel_bitmap, const std::shared_ptr<arrow::Array>& selected);
+
+// Whether the aggregates match the reference. The sum wraps around on overflow, min and max are not checked for an empty
+// column.
+bool verify_aggregates(const std::shared_ptr<arrow::Array>& expected, int64_t count, int64_t sum, int64_t min, int64_t max);
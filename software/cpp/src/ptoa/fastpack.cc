@@ -0,0 +1,479 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "fastpack.h"
+
+namespace ptoa {
+
+namespace {
+
+template<typename U, int BIT_WIDTH>
+struct low_bits {
+    static const U mask = BIT_WIDTH >= (int) sizeof(U)*8 ? ~(U) 0 : (U) (((U) 1 << (BIT_WIDTH % (sizeof(U)*8))) - 1);
+};
+
+/**
+ * Packs 32 values into words of the value type. Since BIT_WIDTH is a constant the loop is unrolled completely and every
+ * shift amount and word boundary is known at compile time. The accumulator is twice as wide as a word, so a value
+ * never has to be split over two stores. Bits above the bit width are masked off, parquet-mr packs left over values of
+ * earlier blocks in the padding of the last miniblock.
+ */
+template<typename U, int BIT_WIDTH>
+struct shift_packer {
+    static void pack(const U* in, uint8_t* out) {
+        typedef typename std::conditional<sizeof(U) == 4, uint64_t, unsigned __int128>::type accumulator;
+        const int WORD_BITS = sizeof(U)*8;
+
+        accumulator acc = 0;
+        int filled = 0;
+
+        for(int i=0; i<DELTA_MINIBLOCK_SIZE; i++){
+            acc |= (accumulator) (in[i] & low_bits<U, BIT_WIDTH>::mask) << filled;
+            filled += BIT_WIDTH;
+            if(filled >= WORD_BITS){
+                U word = (U) acc;
+                std::memcpy(out, &word, sizeof(U));
+                out += sizeof(U);
+                acc >>= WORD_BITS;
+                filled -= WORD_BITS;
+            }
+        }
+
+        // 32 values always take a multiple of 32 bits, so at most half a 64 bit word remains
+        if(filled > 0){
+            uint32_t word = (uint32_t) acc;
+            std::memcpy(out, &word, sizeof(uint32_t));
+        }
+    }
+};
+
+#ifdef __BMI2__
+// Widths up to 8: the low bytes of 8 values hold all their bits, one pext packs them into BIT_WIDTH bytes
+template<int BIT_WIDTH>
+void pext_pack_bytes(const uint32_t* in, uint8_t* out) {
+    const uint64_t mask = 0x0101010101010101ULL*((1ULL << BIT_WIDTH) - 1);
+    uint8_t bytes[DELTA_MINIBLOCK_SIZE];
+
+    for(int i=0; i<DELTA_MINIBLOCK_SIZE; i++){
+        bytes[i] = (uint8_t) in[i];
+    }
+    for(int g=0; g<DELTA_MINIBLOCK_SIZE/8; g++){
+        uint64_t word;
+        std::memcpy(&word, bytes + g*8, sizeof(uint64_t));
+        uint64_t packed = _pext_u64(word, mask);
+        std::memcpy(out + g*BIT_WIDTH, &packed, sizeof(uint64_t));
+    }
+}
+
+// Widths up to 16: two pexts over 16 bit lanes pack 8 values into BIT_WIDTH bytes
+template<int BIT_WIDTH>
+void pext_pack_shorts(const uint32_t* in, uint8_t* out) {
+    const uint64_t mask = 0x0001000100010001ULL*((1ULL << BIT_WIDTH) - 1);
+    const int HALF_BITS = 4*BIT_WIDTH;
+    uint16_t shorts[DELTA_MINIBLOCK_SIZE];
+
+    for(int i=0; i<DELTA_MINIBLOCK_SIZE; i++){
+        shorts[i] = (uint16_t) in[i];
+    }
+    for(int g=0; g<DELTA_MINIBLOCK_SIZE/8; g++){
+        uint64_t words[2];
+        std::memcpy(words, shorts + g*8, sizeof(words));
+        uint64_t low = _pext_u64(words[0], mask);
+        uint64_t high = _pext_u64(words[1], mask);
+        uint64_t packed[2] = {HALF_BITS == 64 ? low : low | high << (HALF_BITS % 64), HALF_BITS == 64 ? high : high >> ((64 - HALF_BITS) % 64)};
+        std::memcpy(out + g*BIT_WIDTH, packed, sizeof(packed));
+    }
+}
+
+// Widths below 32: one pext packs 2 values, the results are streamed out through an accumulator
+template<int BIT_WIDTH>
+void pext_pack_words(const uint32_t* in, uint8_t* out) {
+    const uint64_t mask = 0x0000000100000001ULL*((1ULL << BIT_WIDTH) - 1);
+    unsigned __int128 acc = 0;
+    int filled = 0;
+
+    for(int i=0; i<DELTA_MINIBLOCK_SIZE; i+=2){
+        uint64_t word;
+        std::memcpy(&word, in + i, sizeof(uint64_t));
+        acc |= (unsigned __int128) _pext_u64(word, mask) << filled;
+        filled += 2*BIT_WIDTH;
+        if(filled >= 64){
+            uint64_t packed = (uint64_t) acc;
+            std::memcpy(out, &packed, sizeof(uint64_t));
+            out += sizeof(uint64_t);
+            acc >>= 64;
+            filled -= 64;
+        }
+    }
+
+    if(filled > 0){
+        uint32_t packed = (uint32_t) acc;
+        std::memcpy(out, &packed, sizeof(uint32_t));
+    }
+}
+#endif
+
+inline const uint32_t* low_words(const uint32_t* in, uint32_t*) {
+    return in;
+}
+
+// 64 bit values narrower than 33 bits are packed by the 32 bit kernels
+inline const uint32_t* low_words(const uint64_t* in, uint32_t* words) {
+    for(int i=0; i<DELTA_MINIBLOCK_SIZE; i++){
+        words[i] = (uint32_t) in[i];
+    }
+    return words;
+}
+
+enum pack_method{
+    PACK_NOTHING,
+    PACK_SHIFT,
+    PACK_PEXT_BYTES,
+    PACK_PEXT_SHORTS,
+    PACK_PEXT_WORDS
+};
+
+template<int BIT_WIDTH>
+struct method_of {
+#ifdef __BMI2__
+    static const int value = BIT_WIDTH == 0 ? PACK_NOTHING : (BIT_WIDTH <= 8 ? PACK_PEXT_BYTES : (BIT_WIDTH <= 16 ? PACK_PEXT_SHORTS : (BIT_WIDTH < 32 ? PACK_PEXT_WORDS : PACK_SHIFT)));
+#else
+    static const int value = BIT_WIDTH == 0 ? PACK_NOTHING : PACK_SHIFT;
+#endif
+};
+
+template<int BIT_WIDTH, typename U>
+void pack_with(const U*, uint8_t*, std::integral_constant<int, PACK_NOTHING>) {}
+
+template<int BIT_WIDTH, typename U>
+void pack_with(const U* in, uint8_t* out, std::integral_constant<int, PACK_SHIFT>) {
+    shift_packer<U, BIT_WIDTH>::pack(in, out);
+}
+
+#ifdef __BMI2__
+template<int BIT_WIDTH, typename U>
+void pack_with(const U* in, uint8_t* out, std::integral_constant<int, PACK_PEXT_BYTES>) {
+    uint32_t words[DELTA_MINIBLOCK_SIZE];
+    pext_pack_bytes<BIT_WIDTH>(low_words(in, words), out);
+}
+
+template<int BIT_WIDTH, typename U>
+void pack_with(const U* in, uint8_t* out, std::integral_constant<int, PACK_PEXT_SHORTS>) {
+    uint32_t words[DELTA_MINIBLOCK_SIZE];
+    pext_pack_shorts<BIT_WIDTH>(low_words(in, words), out);
+}
+
+template<int BIT_WIDTH, typename U>
+void pack_with(const U* in, uint8_t* out, std::integral_constant<int, PACK_PEXT_WORDS>) {
+    uint32_t words[DELTA_MINIBLOCK_SIZE];
+    pext_pack_words<BIT_WIDTH>(low_words(in, words), out);
+}
+#endif
+
+template<typename U, int BIT_WIDTH>
+struct packer {
+    static void pack(const U* in, uint8_t* out) {
+        pack_with<BIT_WIDTH>(in, out, std::integral_constant<int, method_of<BIT_WIDTH>::value>());
+    }
+};
+
+template<typename U>
+using pack_kernel = void (*)(const U*, uint8_t*);
+
+template<typename U, int BIT_WIDTH>
+struct fill_kernels {
+    static void fill(pack_kernel<U>* kernels) {
+        kernels[BIT_WIDTH] = &packer<U, BIT_WIDTH>::pack;
+        fill_kernels<U, BIT_WIDTH-1>::fill(kernels);
+    }
+};
+
+template<typename U>
+struct fill_kernels<U, -1> {
+    static void fill(pack_kernel<U>*) {}
+};
+
+template<typename U>
+struct kernel_table {
+    pack_kernel<U> kernels[sizeof(U)*8 + 1];
+
+    kernel_table() {
+        fill_kernels<U, sizeof(U)*8>::fill(kernels);
+    }
+};
+
+const kernel_table<uint32_t> kernels32;
+const kernel_table<uint64_t> kernels64;
+
+inline void pack(const uint32_t* values, int bit_width, uint8_t* out) {
+    kernels32.kernels[bit_width](values, out);
+}
+
+inline void pack(const uint64_t* values, int bit_width, uint8_t* out) {
+    kernels64.kernels[bit_width](values, out);
+}
+
+// Deltas between the values of a block and their predecessors, returns the smallest delta
+template<typename T, typename U>
+T block_deltas(const T* block, U* deltas, int64_t block_values) {
+    T min_delta = std::numeric_limits<T>::max();
+
+    for(int64_t i=0; i<block_values; i++){
+        deltas[i] = (U) block[i] - (U) block[i-1];
+        min_delta = std::min(min_delta, (T) deltas[i]);
+    }
+
+    return min_delta;
+}
+
+// Makes the deltas relative to the smallest one and sets the bit widths of the miniblocks that hold values. Only the
+// deltas of the block take part, the ones after it are left as they are.
+template<typename U>
+void relative_deltas(U* deltas, U min_delta, int64_t block_values, uint8_t* bit_widths) {
+    for(int64_t i=0; i<block_values; i++){
+        deltas[i] -= min_delta;
+    }
+
+    for(int64_t m=0; m*DELTA_MINIBLOCK_SIZE<block_values; m++){
+        U bits = 0;
+        for(int64_t i=m*DELTA_MINIBLOCK_SIZE; i<std::min((m+1)*DELTA_MINIBLOCK_SIZE, block_values); i++){
+            bits |= deltas[i];
+        }
+        bit_widths[m] = bit_length(bits);
+    }
+}
+
+#ifdef __AVX2__
+// Full blocks, the same as the templates above but 8 or 4 deltas at a time
+
+int32_t full_block_deltas(const int32_t* block, uint32_t* deltas) {
+    __m256i min = _mm256_set1_epi32(std::numeric_limits<int32_t>::max());
+
+    for(int i=0; i<DELTA_BLOCK_SIZE; i+=8){
+        __m256i current = _mm256_loadu_si256((const __m256i*) (block + i));
+        __m256i previous = _mm256_loadu_si256((const __m256i*) (block + i - 1));
+        __m256i delta = _mm256_sub_epi32(current, previous);
+        _mm256_storeu_si256((__m256i*) (deltas + i), delta);
+        min = _mm256_min_epi32(min, delta);
+    }
+
+    __m128i half = _mm_min_epi32(_mm256_castsi256_si128(min), _mm256_extracti128_si256(min, 1));
+    half = _mm_min_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_min_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtsi128_si32(half);
+}
+
+int64_t full_block_deltas(const int64_t* block, uint64_t* deltas) {
+    __m256i min = _mm256_set1_epi64x(std::numeric_limits<int64_t>::max());
+
+    for(int i=0; i<DELTA_BLOCK_SIZE; i+=4){
+        __m256i current = _mm256_loadu_si256((const __m256i*) (block + i));
+        __m256i previous = _mm256_loadu_si256((const __m256i*) (block + i - 1));
+        __m256i delta = _mm256_sub_epi64(current, previous);
+        _mm256_storeu_si256((__m256i*) (deltas + i), delta);
+        min = _mm256_blendv_epi8(min, delta, _mm256_cmpgt_epi64(min, delta));
+    }
+
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i*) lanes, min);
+
+    return std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+}
+
+void full_relative_deltas(uint32_t* deltas, uint32_t min_delta, uint8_t* bit_widths) {
+    __m256i min = _mm256_set1_epi32(min_delta);
+
+    for(int m=0; m<DELTA_MINIBLOCKS; m++){
+        __m256i bits = _mm256_setzero_si256();
+        for(int i=m*DELTA_MINIBLOCK_SIZE; i<(m+1)*DELTA_MINIBLOCK_SIZE; i+=8){
+            __m256i delta = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*) (deltas + i)), min);
+            _mm256_storeu_si256((__m256i*) (deltas + i), delta);
+            bits = _mm256_or_si256(bits, delta);
+        }
+
+        __m128i half = _mm_or_si128(_mm256_castsi256_si128(bits), _mm256_extracti128_si256(bits, 1));
+        half = _mm_or_si128(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+        half = _mm_or_si128(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+        bit_widths[m] = bit_length((uint32_t) _mm_cvtsi128_si32(half));
+    }
+}
+
+void full_relative_deltas(uint64_t* deltas, uint64_t min_delta, uint8_t* bit_widths) {
+    __m256i min = _mm256_set1_epi64x(min_delta);
+
+    for(int m=0; m<DELTA_MINIBLOCKS; m++){
+        __m256i bits = _mm256_setzero_si256();
+        for(int i=m*DELTA_MINIBLOCK_SIZE; i<(m+1)*DELTA_MINIBLOCK_SIZE; i+=4){
+            __m256i delta = _mm256_sub_epi64(_mm256_loadu_si256((const __m256i*) (deltas + i)), min);
+            _mm256_storeu_si256((__m256i*) (deltas + i), delta);
+            bits = _mm256_or_si256(bits, delta);
+        }
+
+        __m128i half = _mm_or_si128(_mm256_castsi256_si128(bits), _mm256_extracti128_si256(bits, 1));
+        half = _mm_or_si128(half, _mm_unpackhi_epi64(half, half));
+        bit_widths[m] = bit_length((uint64_t) _mm_cvtsi128_si64(half));
+    }
+}
+#else
+template<typename T, typename U>
+T full_block_deltas(const T* block, U* deltas) {
+    return block_deltas(block, deltas, DELTA_BLOCK_SIZE);
+}
+
+template<typename U>
+void full_relative_deltas(U* deltas, U min_delta, uint8_t* bit_widths) {
+    relative_deltas(deltas, min_delta, DELTA_BLOCK_SIZE, bit_widths);
+}
+#endif
+
+// Fills the state with the relative deltas and bit widths of a block, returns its min delta. Deltas wrap around like in
+// parquet-mr and the readers, so they are computed on the unsigned type.
+template<typename T, typename U>
+T delta_block(const T* block, int64_t block_values, delta_state<U>* state) {
+    T min_delta;
+
+    if(block_values == DELTA_BLOCK_SIZE){
+        min_delta = full_block_deltas(block, state->deltas);
+        full_relative_deltas(state->deltas, (U) min_delta, state->bit_widths);
+    } else {
+        min_delta = block_deltas(block, state->deltas, block_values);
+        relative_deltas(state->deltas, (U) min_delta, block_values, state->bit_widths);
+    }
+
+    return min_delta;
+}
+
+template<typename T, typename U>
+void append_delta(std::vector<uint8_t>* out, const T* values, int64_t num_values, delta_state<U>* state) {
+    append_varint(out, DELTA_BLOCK_SIZE);
+    append_varint(out, DELTA_MINIBLOCKS);
+    append_varint(out, num_values);
+    append_zigzag(out, num_values > 0 ? values[0] : 0);
+
+    for(int64_t block_start=1; block_start<num_values; block_start+=DELTA_BLOCK_SIZE){
+        int64_t block_values = std::min((int64_t) DELTA_BLOCK_SIZE, num_values - block_start);
+        T min_delta = delta_block(values + block_start, block_values, state);
+
+        append_zigzag(out, min_delta);
+
+        int used_miniblocks = (block_values + DELTA_MINIBLOCK_SIZE - 1)/DELTA_MINIBLOCK_SIZE;
+        size_t packed_size = 0;
+        for(int m=0; m<used_miniblocks; m++){
+            packed_size += state->bit_widths[m]*DELTA_MINIBLOCK_SIZE/8;
+        }
+
+        size_t position = out->size();
+        out->resize(position + DELTA_MINIBLOCKS + packed_size + PACK_SLACK_BYTES);
+        uint8_t* dst = out->data() + position;
+
+        // Like parquet-mr, the widths of unused miniblocks are whatever an earlier block left behind
+        std::memcpy(dst, state->bit_widths, DELTA_MINIBLOCKS);
+        dst += DELTA_MINIBLOCKS;
+
+        for(int m=0; m<used_miniblocks; m++){
+            pack(&state->deltas[m*DELTA_MINIBLOCK_SIZE], state->bit_widths[m], dst);
+            dst += state->bit_widths[m]*DELTA_MINIBLOCK_SIZE/8;
+        }
+
+        out->resize(position + DELTA_MINIBLOCKS + packed_size);
+    }
+}
+
+// A full block overwrites the whole state, so only the last full block and the partial block after it matter
+template<typename T, typename U>
+void skip_delta(const T* values, int64_t num_values, delta_state<U>* state) {
+    int64_t full_blocks = num_values > 0 ? (num_values - 1)/DELTA_BLOCK_SIZE : 0;
+
+    for(int64_t block_start=1 + std::max(full_blocks - 1, (int64_t) 0)*DELTA_BLOCK_SIZE; block_start<num_values; block_start+=DELTA_BLOCK_SIZE){
+        delta_block(values + block_start, std::min((int64_t) DELTA_BLOCK_SIZE, num_values - block_start), state);
+    }
+}
+
+}
+
+void pack32(const uint32_t* values, int bit_width, uint8_t* out) {
+    pack(values, bit_width, out);
+}
+
+void pack64(const uint64_t* values, int bit_width, uint8_t* out) {
+    pack(values, bit_width, out);
+}
+
+int bit_length(uint64_t value) {
+    return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+void append_varint(std::vector<uint8_t>* out, uint64_t value) {
+    while(value >= 0x80){
+        out->push_back((uint8_t) (value | 0x80));
+        value >>= 7;
+    }
+    out->push_back((uint8_t) value);
+}
+
+void append_zigzag(std::vector<uint8_t>* out, int64_t value) {
+    append_varint(out, ((uint64_t) value << 1) ^ (uint64_t) (value >> 63));
+}
+
+void append_delta32(std::vector<uint8_t>* out, const int32_t* values, int64_t num_values, delta_state32* state) {
+    append_delta(out, values, num_values, state);
+}
+
+void append_delta64(std::vector<uint8_t>* out, const int64_t* values, int64_t num_values, delta_state64* state) {
+    append_delta(out, values, num_values, state);
+}
+
+void skip_delta32(const int32_t* values, int64_t num_values, delta_state32* state) {
+    skip_delta(values, num_values, state);
+}
+
+void skip_delta64(const int64_t* values, int64_t num_values, delta_state64* state) {
+    skip_delta(values, num_values, state);
+}
+
+void append_dictionary_indices(std::vector<uint8_t>* out, const uint32_t* indices, int64_t num_values, int bit_width) {
+    // Bit-packed runs are counted in groups of 8 values, the last group is padded with zeros
+    int64_t num_groups = (num_values + 7)/8;
+
+    out->push_back((uint8_t) bit_width);
+    append_varint(out, (uint64_t) num_groups << 1 | 1);
+
+    // The kernels pack 32 values at a time, the bytes beyond the last group are dropped again
+    size_t position = out->size();
+    out->resize(position + (num_values + DELTA_MINIBLOCK_SIZE - 1)/DELTA_MINIBLOCK_SIZE*bit_width*4 + PACK_SLACK_BYTES);
+    uint8_t* dst = out->data() + position;
+
+    int64_t i = 0;
+    for(; i + DELTA_MINIBLOCK_SIZE <= num_values; i += DELTA_MINIBLOCK_SIZE){
+        pack32(indices + i, bit_width, dst);
+        dst += bit_width*4;
+    }
+    if(i < num_values){
+        uint32_t tail[DELTA_MINIBLOCK_SIZE] = {0};
+        std::copy(indices + i, indices + num_values, tail);
+        pack32(tail, bit_width, dst);
+    }
+
+    out->resize(position + num_groups*bit_width);
+}
+
+}
@@ -0,0 +1,73 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+// Values per DELTA_BINARY_PACKED block and miniblocks per block, as written by parquet-mr and expected by the hardware
+#define DELTA_BLOCK_SIZE 128
+#define DELTA_MINIBLOCKS 4
+#define DELTA_MINIBLOCK_SIZE (DELTA_BLOCK_SIZE/DELTA_MINIBLOCKS)
+
+// Bytes the packing kernels may write after the packed values, buffers they write to need that much room to spare
+#define PACK_SLACK_BYTES 8
+
+namespace ptoa {
+
+/**
+ * Block buffer and miniblock bit widths of a DELTA_BINARY_PACKED encoder. parquet-mr never clears them between the
+ * blocks and pages of a column chunk, so the bit widths of the unused miniblocks of a last block, and the bits that pad
+ * its last miniblock, are left over from earlier blocks. Passing the same state to all pages of a column chunk
+ * reproduces that, which makes the output byte-identical to parquet-mr.
+ */
+template<typename U>
+struct delta_state {
+    U deltas[DELTA_BLOCK_SIZE];
+    uint8_t bit_widths[DELTA_MINIBLOCKS];
+
+    delta_state() {
+        memset(deltas, 0, sizeof(deltas));
+        memset(bit_widths, 0, sizeof(bit_widths));
+    }
+};
+
+typedef delta_state<uint32_t> delta_state32;
+typedef delta_state<uint64_t> delta_state64;
+
+/**
+ * Packs the low bit_width bits of 32 values, least significant bit first, into bit_width*4 bytes at out, and may write
+ * up to PACK_SLACK_BYTES bytes more. Every bit width has its own kernel: with BMI2 widths up to 32 gather the bits of
+ * several values with one pext, wider values use a fully unrolled shift and or kernel like Lemire's fastpack.
+ */
+void pack32(const uint32_t* values, int bit_width, uint8_t* out);
+void pack64(const uint64_t* values, int bit_width, uint8_t* out);
+
+int bit_length(uint64_t value);
+
+void append_varint(std::vector<uint8_t>* out, uint64_t value);
+void append_zigzag(std::vector<uint8_t>* out, int64_t value);
+
+// DELTA_BINARY_PACKED encoding of all values of a page, state is shared by the pages of a column chunk
+void append_delta32(std::vector<uint8_t>* out, const int32_t* values, int64_t num_values, delta_state32* state);
+void append_delta64(std::vector<uint8_t>* out, const int64_t* values, int64_t num_values, delta_state64* state);
+
+// Leaves state as append_delta would have left it, without encoding anything. Lets pages be encoded out of order.
+void skip_delta32(const int32_t* values, int64_t num_values, delta_state32* state);
+void skip_delta64(const int64_t* values, int64_t num_values, delta_state64* state);
+
+// Bit width byte followed by the indices as a single bit-packed run of the RLE/bit-packing hybrid encoding
+void append_dictionary_indices(std::vector<uint8_t>* out, const uint32_t* indices, int64_t num_values, int bit_width);
+
+}
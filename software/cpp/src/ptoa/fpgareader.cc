@@ -0,0 +1,557 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include "fpgareader.h"
+#include "thriftcompact.h"
+
+// Values of the enums of the Parquet format
+#define PARQUET_DATA_PAGE_V2 3
+
+namespace ptoa {
+
+namespace {
+
+// The fields of a page header that are needed to find the pages of a column chunk
+struct page_extent {
+    int32_t type;
+    int64_t header_size;
+    int64_t compressed_size;
+    int64_t num_values;
+};
+
+status read_page_header(const uint8_t* data, int64_t size, page_extent* page) {
+    CompactReader header(data, size);
+    int16_t field_id;
+    compact_type type;
+
+    page->type = -1;
+    page->compressed_size = -1;
+    page->num_values = 0;
+
+    while(header.next_field(&field_id, &type)){
+        if(field_id == 1 && type == COMPACT_I32){
+            header.read_i32(&page->type);
+        } else if(field_id == 3 && type == COMPACT_I32){
+            int32_t compressed_size;
+            header.read_i32(&compressed_size);
+            page->compressed_size = compressed_size;
+        } else if(field_id == 8 && type == COMPACT_STRUCT){
+            // data_page_header_v2, of which only num_values (1) is needed
+            header.begin_struct();
+            while(header.next_field(&field_id, &type)){
+                if(field_id == 1 && type == COMPACT_I32){
+                    int32_t num_values;
+                    header.read_i32(&num_values);
+                    page->num_values = num_values;
+                } else {
+                    header.skip(type);
+                }
+            }
+            header.end_struct();
+        } else {
+            header.skip(type);
+        }
+    }
+
+    page->header_size = header.position();
+
+    return header.failed() || page->compressed_size < 0 || page->num_values < 0 ? status::FAIL : status::OK;
+}
+
+// Progress of a pipelined read, in segments. Segment i uses the device buffers of slot i%PTOA_PIPELINE_SLOTS.
+struct pipeline {
+    std::mutex mutex;
+    std::condition_variable progress;
+    int64_t copied = 0;
+    int64_t processed = 0;
+    int64_t read_back = 0;
+    bool failed = false;
+
+    // Wait until ready holds or a stage failed, returns false in the latter case
+    template<typename Predicate>
+    bool wait(Predicate ready) {
+        std::unique_lock<std::mutex> lock(mutex);
+        progress.wait(lock, [&](){ return failed || ready(); });
+        return !failed;
+    }
+
+    void advance(int64_t* counter) {
+        std::lock_guard<std::mutex> lock(mutex);
+        (*counter)++;
+        progress.notify_all();
+    }
+
+    void fail() {
+        std::lock_guard<std::mutex> lock(mutex);
+        failed = true;
+        progress.notify_all();
+    }
+};
+
+}
+
+FpgaReader::FpgaReader() {
+    segment_size = 0;
+
+    for(int slot=0; slot<PTOA_PIPELINE_SLOTS; slot++){
+        device_parquet[slot] = {0, 0};
+        device_values[slot] = {0, 0};
+        device_offsets[slot] = {0, 0};
+    }
+}
+
+FpgaReader::~FpgaReader() {
+    if(platform){
+        for(int slot=0; slot<PTOA_PIPELINE_SLOTS; slot++){
+            for(device_buffer* buffer : {&device_parquet[slot], &device_values[slot], &device_offsets[slot]}){
+                if(buffer->capacity > 0){
+                    platform->deviceFree(buffer->address);
+                }
+            }
+        }
+    }
+}
+
+status FpgaReader::init(const std::string& platform_name) {
+    if(platform){
+        std::cerr << "[ERROR] FpgaReader is already initialized" << std::endl;
+        return status::FAIL;
+    }
+
+    std::string name = platform_name;
+    if(name.empty() && getenv(PTOA_PLATFORM_ENV) != nullptr){
+        name = getenv(PTOA_PLATFORM_ENV);
+    }
+
+    fletcher::Status result = name.empty() ? fletcher::Platform::Make(&platform) : fletcher::Platform::Make(name, &platform);
+    if(!result.ok() || !platform->init().ok()){
+        std::cerr << "[ERROR] Could not create platform " << name << std::endl;
+        platform.reset();
+        return status::FAIL;
+    }
+
+    if(!fletcher::Context::Make(&context, platform).ok()){
+        std::cerr << "[ERROR] Could not create context" << std::endl;
+        return status::FAIL;
+    }
+
+    usercore = std::make_shared<fletcher::UserCore>(context);
+    if(!usercore->reset().ok()){
+        std::cerr << "[ERROR] Could not reset the kernel" << std::endl;
+        return status::FAIL;
+    }
+
+    return status::OK;
+}
+
+std::shared_ptr<fletcher::Platform> FpgaReader::get_platform() {
+    return platform;
+}
+
+void FpgaReader::set_segment_size(int64_t segment_size) {
+    this->segment_size = std::max(segment_size, (int64_t) 0);
+}
+
+// Make sure the device buffer holds at least size bytes. Buffers only grow, so after the largest read no more device
+// memory is allocated. Device buffers of size 0 are not allocated, so at least a byte is reserved to get a valid address.
+status FpgaReader::reserve(device_buffer* buffer, int64_t size) {
+    size = std::max(size, (int64_t) 1);
+    if(size <= buffer->capacity){
+        return status::OK;
+    }
+
+    if(buffer->capacity > 0){
+        platform->deviceFree(buffer->address);
+        buffer->capacity = 0;
+    }
+
+    if(!platform->deviceMalloc(&buffer->address, size).ok()){
+        std::cerr << "[ERROR] Could not allocate " << size << " bytes of device memory" << std::endl;
+        return status::FAIL;
+    }
+    buffer->capacity = size;
+
+    return status::OK;
+}
+
+void FpgaReader::set_arguments(uint32_t num_values, uint64_t max_size, da_t page_address, da_t values_address,
+                               da_t offsets_address) {
+    dau_t mmio64_writer;
+
+    platform->writeMMIO(PTOA_REG_NUM_VAL, num_values);
+
+    mmio64_writer.full = page_address;
+    platform->writeMMIO(PTOA_REG_PAGE_ADDR, mmio64_writer.lo);
+    platform->writeMMIO(PTOA_REG_PAGE_ADDR + 1, mmio64_writer.hi);
+
+    mmio64_writer.full = max_size;
+    platform->writeMMIO(PTOA_REG_MAX_SIZE, mmio64_writer.lo);
+    platform->writeMMIO(PTOA_REG_MAX_SIZE + 1, mmio64_writer.hi);
+
+    mmio64_writer.full = values_address;
+    platform->writeMMIO(PTOA_REG_VAL_ADDR, mmio64_writer.lo);
+    platform->writeMMIO(PTOA_REG_VAL_ADDR + 1, mmio64_writer.hi);
+
+    mmio64_writer.full = offsets_address;
+    platform->writeMMIO(PTOA_REG_OFF_ADDR, mmio64_writer.lo);
+    platform->writeMMIO(PTOA_REG_OFF_ADDR + 1, mmio64_writer.hi);
+}
+
+status FpgaReader::run_kernel(uint32_t num_values, uint64_t max_size, da_t page_address, da_t values_address,
+                               da_t offsets_address) {
+    if(!usercore->reset().ok()){
+        std::cerr << "[ERROR] Could not reset the kernel" << std::endl;
+        return status::FAIL;
+    }
+    set_arguments(num_values, max_size, page_address, values_address, offsets_address);
+    usercore->start();
+
+    if(!usercore->waitForFinish(PTOA_POLL_INTERVAL).ok()){
+        std::cerr << "[ERROR] Kernel did not finish" << std::endl;
+        return status::FAIL;
+    }
+
+    uint32_t kernel_status;
+    if(!platform->readMMIO(PTOA_REG_STATUS, &kernel_status).ok() || (kernel_status & PTOA_STATUS_FAILED)){
+        std::cerr << "[ERROR] Kernel failed" << std::endl;
+        return status::FAIL;
+    }
+
+    return status::OK;
+}
+
+status FpgaReader::read(const uint8_t* file_data, int64_t file_size, const column_descriptor& column,
+                        std::shared_ptr<arrow::Array>* array, job_timing* timing) {
+    if(!platform){
+        std::cerr << "[ERROR] FpgaReader is not initialized" << std::endl;
+        return status::FAIL;
+    }
+
+    arrow::Type::type type = column.field->type()->id();
+    bool strings = type == arrow::Type::STRING;
+    int64_t value_size;
+
+    if(type == arrow::Type::INT32){
+        value_size = sizeof(int32_t);
+    } else if(type == arrow::Type::INT64){
+        value_size = sizeof(int64_t);
+    } else if(strings){
+        value_size = 0;
+    } else {
+        std::cerr << "[ERROR] Column " << column.field->name() << " has type " << column.field->type()->ToString() << ", only int32, int64 and utf8 columns can be read" << std::endl;
+        return status::FAIL;
+    }
+
+    if(strings ? column.enc != encoding::DELTA_LENGTH : column.enc == encoding::DELTA_LENGTH){
+        std::cerr << "[ERROR] Encoding not supported for this type" << std::endl;
+        return status::FAIL;
+    }
+
+    if(column.num_values < 0 || column.num_values > std::numeric_limits<uint32_t>::max() || column.num_chars < 0 ||
+       (strings && column.num_chars > std::numeric_limits<int32_t>::max())){
+        std::cerr << "[ERROR] Column " << column.field->name() << " is too large for the kernel" << std::endl;
+        return status::FAIL;
+    }
+
+    int64_t chunk_size = column.chunk_size < 0 ? file_size - column.file_offset : column.chunk_size;
+    if(column.file_offset < 0 || chunk_size <= 0 || column.file_offset + chunk_size > file_size){
+        std::cerr << "[ERROR] Column chunk lies outside the file" << std::endl;
+        return status::FAIL;
+    }
+
+    int64_t values_size = strings ? column.num_chars : value_size*column.num_values;
+    int64_t offsets_size = strings ? sizeof(int32_t)*(column.num_values + 1) : 0;
+
+    std::shared_ptr<arrow::Buffer> values;
+    std::shared_ptr<arrow::Buffer> offsets;
+
+    if(!arrow::AllocateBuffer(arrow::default_memory_pool(), values_size, &values).ok() ||
+       (strings && !arrow::AllocateBuffer(arrow::default_memory_pool(), offsets_size, &offsets).ok())){
+        std::cerr << "[ERROR] Could not allocate the buffers of column " << column.field->name() << std::endl;
+        return status::FAIL;
+    }
+
+    job_timing local_timing;
+    fletcher::Timer t;
+
+    t.start();
+    status result;
+    if(segment_size > 0){
+        result = read_pipelined(file_data + column.file_offset, chunk_size, column, value_size, values->mutable_data(),
+                                strings ? offsets->mutable_data() : nullptr, &local_timing);
+    } else {
+        result = read_serial(file_data + column.file_offset, chunk_size, column, values_size, values->mutable_data(),
+                             strings ? offsets->mutable_data() : nullptr, &local_timing);
+    }
+    t.stop();
+
+    if(result != status::OK){
+        return status::FAIL;
+    }
+
+    local_timing.total = t.seconds();
+    if(timing != nullptr){
+        *timing = local_timing;
+    }
+
+    if(type == arrow::Type::INT32){
+        *array = std::make_shared<arrow::Int32Array>(column.field->type(), column.num_values, values);
+    } else if(type == arrow::Type::INT64){
+        *array = std::make_shared<arrow::Int64Array>(column.field->type(), column.num_values, values);
+    } else {
+        *array = std::make_shared<arrow::StringArray>(column.num_values, offsets, values);
+    }
+
+    return status::OK;
+}
+
+// Copy the whole column chunk to the device, run the kernel once and copy all results back
+status FpgaReader::read_serial(const uint8_t* chunk_data, int64_t chunk_size, const column_descriptor& column,
+                               int64_t values_size, uint8_t* values, uint8_t* offsets, job_timing* timing) {
+    int64_t offsets_size = offsets != nullptr ? sizeof(int32_t)*(column.num_values + 1) : 0;
+
+    if(reserve(&device_parquet[0], chunk_size) != status::OK || reserve(&device_values[0], values_size) != status::OK ||
+       (offsets != nullptr && reserve(&device_offsets[0], offsets_size) != status::OK)){
+        return status::FAIL;
+    }
+
+    fletcher::Timer t;
+
+    t.start();
+    if(!platform->copyHostToDevice(const_cast<uint8_t*>(chunk_data), device_parquet[0].address, chunk_size).ok()){
+        std::cerr << "[ERROR] Could not copy the column chunk to the device" << std::endl;
+        return status::FAIL;
+    }
+    t.stop();
+    timing->copy_to_device = t.seconds();
+
+    t.start();
+    if(run_kernel(column.num_values, chunk_size, device_parquet[0].address, device_values[0].address,
+                  offsets != nullptr ? device_offsets[0].address : 0) != status::OK){
+        return status::FAIL;
+    }
+    t.stop();
+    timing->process = t.seconds();
+
+    t.start();
+    if(offsets != nullptr && !platform->copyDeviceToHost(device_offsets[0].address, offsets, offsets_size).ok()){
+        std::cerr << "[ERROR] Could not copy column " << column.field->name() << " from the device" << std::endl;
+        return status::FAIL;
+    }
+
+    // With too small a num_chars the kernel ran past the end of the values buffer
+    if(offsets != nullptr){
+        int64_t chars = ((const int32_t*) offsets)[column.num_values];
+        if(chars < 0 || chars > column.num_chars){
+            std::cerr << "[ERROR] Column " << column.field->name() << " has more characters than num_chars" << std::endl;
+            return status::FAIL;
+        }
+    }
+
+    if(!platform->copyDeviceToHost(device_values[0].address, values, values_size).ok()){
+        std::cerr << "[ERROR] Could not copy column " << column.field->name() << " from the device" << std::endl;
+        return status::FAIL;
+    }
+    t.stop();
+    timing->copy_to_host = t.seconds();
+
+    return status::OK;
+}
+
+// Group the pages of the column chunk into segments of at most segment_size bytes that hold num_values values together
+status FpgaReader::split_segments(const uint8_t* chunk_data, int64_t chunk_size, int64_t file_offset, int64_t num_values,
+                                  std::vector<segment>* segments) {
+    segments->clear();
+
+    int64_t pos = 0;
+    int64_t values = 0;
+    segment current = {0, 0, 0, 0};
+
+    while(values < num_values){
+        page_extent page;
+
+        if(pos >= chunk_size || read_page_header(chunk_data + pos, chunk_size - pos, &page) != status::OK ||
+           page.compressed_size > chunk_size - pos - page.header_size){
+            std::cerr << "[ERROR] Corrupted page header at file offset " << file_offset + pos << std::endl;
+            return status::FAIL;
+        }
+        if(page.type != PARQUET_DATA_PAGE_V2){
+            std::cerr << "[ERROR] Page at file offset " << file_offset + pos << " is not a V2 data page, which the kernel cannot read" << std::endl;
+            return status::FAIL;
+        }
+
+        int64_t page_size = page.header_size + page.compressed_size;
+        if(current.size > 0 && current.size + page_size > segment_size){
+            segments->push_back(current);
+            current = {pos, 0, 0, values};
+        }
+
+        int64_t page_values = std::min(page.num_values, num_values - values);
+        current.size += page_size;
+        current.num_values += page_values;
+        values += page_values;
+        pos += page_size;
+    }
+
+    if(current.size > 0){
+        segments->push_back(current);
+    }
+
+    return status::OK;
+}
+
+// Run the segments through three stages that overlap: this thread runs the kernel, one thread copies segments to the
+// device and one copies the results back. A stage waits for the stage before it to finish a segment, and for the stage
+// after it to free the device buffers of the segment PTOA_PIPELINE_SLOTS before.
+status FpgaReader::read_pipelined(const uint8_t* chunk_data, int64_t chunk_size, const column_descriptor& column,
+                                  int64_t value_size, uint8_t* values, uint8_t* offsets, job_timing* timing) {
+    std::vector<segment> segments;
+
+    if(split_segments(chunk_data, chunk_size, column.file_offset, column.num_values, &segments) != status::OK){
+        return status::FAIL;
+    }
+
+    bool strings = offsets != nullptr;
+    int64_t max_size = 0;
+    int64_t max_values = 0;
+
+    for(const segment& seg : segments){
+        max_size = std::max(max_size, seg.size);
+        max_values = std::max(max_values, seg.num_values);
+    }
+
+    // The characters of a segment are stored as they are in its pages, so they take less space than the segment
+    for(int slot=0; slot<PTOA_PIPELINE_SLOTS; slot++){
+        if(reserve(&device_parquet[slot], max_size) != status::OK ||
+           reserve(&device_values[slot], strings ? max_size : value_size*max_values) != status::OK ||
+           (strings && reserve(&device_offsets[slot], sizeof(int32_t)*(max_values + 1)) != status::OK)){
+            return status::FAIL;
+        }
+    }
+
+    pipeline progress;
+    int64_t num_segments = segments.size();
+
+    timing->copy_to_device = 0;
+    timing->process = 0;
+    timing->copy_to_host = 0;
+
+    std::thread to_device([&](){
+        fletcher::Timer t;
+
+        for(int64_t i=0; i<num_segments; i++){
+            if(!progress.wait([&](){ return progress.processed >= i + 1 - PTOA_PIPELINE_SLOTS; })){
+                return;
+            }
+
+            t.start();
+            if(!platform->copyHostToDevice(const_cast<uint8_t*>(chunk_data + segments[i].offset),
+                                           device_parquet[i%PTOA_PIPELINE_SLOTS].address, segments[i].size).ok()){
+                std::cerr << "[ERROR] Could not copy the column chunk to the device" << std::endl;
+                progress.fail();
+                return;
+            }
+            t.stop();
+            timing->copy_to_device += t.seconds();
+
+            progress.advance(&progress.copied);
+        }
+    });
+
+    std::thread to_host([&](){
+        fletcher::Timer t;
+        int64_t chars = 0;
+
+        for(int64_t i=0; i<num_segments; i++){
+            if(!progress.wait([&](){ return progress.processed >= i + 1; })){
+                return;
+            }
+
+            const segment& seg = segments[i];
+            int slot = i%PTOA_PIPELINE_SLOTS;
+            bool copied;
+
+            t.start();
+            if(strings){
+                // The kernel starts the offsets of every segment at 0, so they are moved behind the characters of the
+                // segments before. Its first offset overwrites the last one of the segment before, which is the same.
+                int32_t* segment_offsets = (int32_t*) offsets + seg.first_value;
+                copied = platform->copyDeviceToHost(device_offsets[slot].address, (uint8_t*) segment_offsets,
+                                                    sizeof(int32_t)*(seg.num_values + 1)).ok();
+
+                int64_t segment_chars = copied ? segment_offsets[seg.num_values] : 0;
+                if(segment_chars < 0 || segment_chars > device_values[slot].capacity ||
+                   chars + segment_chars > column.num_chars){
+                    std::cerr << "[ERROR] Column " << column.field->name() << " has more characters than num_chars" << std::endl;
+                    progress.fail();
+                    return;
+                }
+
+                copied = copied && platform->copyDeviceToHost(device_values[slot].address, values + chars, segment_chars).ok();
+                for(int64_t v=0; v<=seg.num_values; v++){
+                    segment_offsets[v] += chars;
+                }
+                chars += segment_chars;
+            } else {
+                copied = platform->copyDeviceToHost(device_values[slot].address, values + value_size*seg.first_value,
+                                                    value_size*seg.num_values).ok();
+            }
+            t.stop();
+            timing->copy_to_host += t.seconds();
+
+            if(!copied){
+                std::cerr << "[ERROR] Could not copy column " << column.field->name() << " from the device" << std::endl;
+                progress.fail();
+                return;
+            }
+
+            progress.advance(&progress.read_back);
+        }
+    });
+
+    fletcher::Timer t;
+
+    for(int64_t i=0; i<num_segments; i++){
+        if(!progress.wait([&](){ return progress.copied >= i + 1 && progress.read_back >= i + 1 - PTOA_PIPELINE_SLOTS; })){
+            break;
+        }
+
+        int slot = i%PTOA_PIPELINE_SLOTS;
+
+        t.start();
+        if(run_kernel(segments[i].num_values, segments[i].size, device_parquet[slot].address,
+                      device_values[slot].address, strings ? device_offsets[slot].address : 0) != status::OK){
+            progress.fail();
+            break;
+        }
+        t.stop();
+        timing->process += t.seconds();
+
+        progress.advance(&progress.processed);
+    }
+
+    to_device.join();
+    to_host.join();
+
+    return progress.failed ? status::FAIL : status::OK;
+}
+
+}
@@ -0,0 +1,150 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+#include <fletcher/api.h>
+
+#include "ptoa.h"
+
+// MMIO registers of the Ptoa kernel (hardware/vhdl/ptoa_wrapper.vhd), 0 and 1 are the Fletcher control and status
+// registers. The 64 bit arguments take two registers, low word first.
+#define PTOA_REG_NUM_VAL 2
+#define PTOA_REG_PAGE_ADDR 3
+#define PTOA_REG_MAX_SIZE 5
+#define PTOA_REG_VAL_ADDR 7
+#define PTOA_REG_OFF_ADDR 9
+
+// Fletcher status register, and the bit of it the emulator (platforms/emu) sets when a kernel run failed. The hardware
+// kernel never sets it.
+#define PTOA_REG_STATUS 1
+#define PTOA_STATUS_FAILED (1u << 3)
+
+// Environment variable with the name of the platform to use when init is not given one, e.g. emu for the emulator in
+// platforms/emu
+#define PTOA_PLATFORM_ENV "PTOA_PLATFORM"
+
+// Interval in microseconds at which the status register is polled while the kernel runs
+#define PTOA_POLL_INTERVAL 100
+
+// Device buffers of each kind the pipelined mode alternates between
+#define PTOA_PIPELINE_SLOTS 2
+
+namespace ptoa {
+
+/**
+ * A column chunk in a hardware compatible Parquet file (see ParquetWriter). file_offset is the offset of its first page
+ * header, which is 4 for the first column. Without a chunk_size the chunk is taken to run to the end of the file.
+ * String columns need the total length of their strings in num_chars, as the values buffer is sized before the kernel
+ * runs.
+ */
+struct column_descriptor {
+    std::shared_ptr<arrow::Field> field;
+    encoding enc;
+    int64_t num_values;
+    int64_t num_chars;
+    int64_t file_offset;
+    int64_t chunk_size;
+
+    column_descriptor(std::shared_ptr<arrow::Field> field, encoding enc, int64_t num_values, int64_t num_chars = 0,
+                      int64_t file_offset = 4, int64_t chunk_size = -1)
+        : field(field), enc(enc), num_values(num_values), num_chars(num_chars), file_offset(file_offset),
+          chunk_size(chunk_size) {}
+};
+
+// Seconds spent in the phases of a single read. In the pipelined mode the phases overlap, they are the time the link and
+// the kernel were busy and total is less than their sum.
+struct job_timing {
+    double copy_to_device;
+    double process;
+    double copy_to_host;
+    double total;
+};
+
+// Device memory that is kept between reads, capacity is 0 until it is allocated
+struct device_buffer {
+    da_t address;
+    int64_t capacity;
+};
+
+// Consecutive pages of a column chunk that the pipelined mode processes in one kernel run. offset is relative to the
+// start of the column chunk, first_value is the index of the first value of the segment in the column.
+struct segment {
+    int64_t offset;
+    int64_t size;
+    int64_t num_values;
+    int64_t first_value;
+};
+
+/**
+ * Runs the Ptoa kernel on column chunks. The Fletcher platform, context and user core are created once by init and
+ * kept for the lifetime of the reader, after which any number of reads can be submitted. The device buffers holding
+ * the Parquet data and the Arrow output are kept between reads as well and only reallocated when a read needs more
+ * space than the largest one before it. The loaded bitstream decides which columns can be read: int32 and int64
+ * columns need a primitive kernel of the same width, utf8 columns the string kernel.
+ *
+ * By default a read copies the whole column chunk to the device, runs the kernel and copies the results back, one after
+ * the other. With a segment size set, reads are pipelined instead: the column chunk is split at page boundaries into
+ * segments of at most that many bytes, and the copy of segment i+1 to the device overlaps with the kernel running on
+ * segment i and with the copy of the results of segment i-1 to the host. Two device buffers of each kind are used in
+ * turns. The platform then has to accept copies from other threads while the kernel runs.
+ */
+class FpgaReader {
+  public:
+    FpgaReader();
+    ~FpgaReader();
+
+    // Creates the platform, the one named by PTOA_PLATFORM or else the first one found if platform_name is empty, and
+    // resets the kernel
+    status init(const std::string& platform_name = "");
+    // Reads the column chunk described by column from the file in memory into a new array
+    status read(const uint8_t* file_data, int64_t file_size, const column_descriptor& column,
+                std::shared_ptr<arrow::Array>* array, job_timing* timing = nullptr);
+
+    // Bytes of Parquet data per segment in the pipelined mode, a page larger than this is a segment of its own. 0, the
+    // default, disables pipelining.
+    void set_segment_size(int64_t segment_size);
+
+    std::shared_ptr<fletcher::Platform> get_platform();
+
+  private:
+    status read_serial(const uint8_t* chunk_data, int64_t chunk_size, const column_descriptor& column,
+                       int64_t values_size, uint8_t* values, uint8_t* offsets, job_timing* timing);
+    status read_pipelined(const uint8_t* chunk_data, int64_t chunk_size, const column_descriptor& column,
+                          int64_t value_size, uint8_t* values, uint8_t* offsets, job_timing* timing);
+    status split_segments(const uint8_t* chunk_data, int64_t chunk_size, int64_t file_offset, int64_t num_values,
+                          std::vector<segment>* segments);
+    status reserve(device_buffer* buffer, int64_t size);
+    status run_kernel(uint32_t num_values, uint64_t max_size, da_t page_address, da_t values_address,
+                      da_t offsets_address);
+    void set_arguments(uint32_t num_values, uint64_t max_size, da_t page_address, da_t values_address,
+                       da_t offsets_address);
+
+    std::shared_ptr<fletcher::Platform> platform;
+    std::shared_ptr<fletcher::Context> context;
+    std::shared_ptr<fletcher::UserCore> usercore;
+
+    int64_t segment_size;
+
+    // The serial mode only uses the first buffer of each kind
+    device_buffer device_parquet[PTOA_PIPELINE_SLOTS];
+    device_buffer device_values[PTOA_PIPELINE_SLOTS];
+    device_buffer device_offsets[PTOA_PIPELINE_SLOTS];
+};
+
+}
@@ -0,0 +1,959 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+
+#include "fastpack.h"
+#include "parquetwriter.h"
+#include "thriftcompact.h"
+
+// Values of the enums of the Parquet format
+#define PARQUET_TYPE_INT32 1
+#define PARQUET_TYPE_INT64 2
+#define PARQUET_TYPE_BYTE_ARRAY 6
+#define PARQUET_CONVERTED_UTF8 0
+#define PARQUET_REQUIRED 0
+#define PARQUET_UNCOMPRESSED 0
+#define PARQUET_DICTIONARY_PAGE 2
+#define PARQUET_DATA_PAGE_V2 3
+#define PARQUET_ENCODING_PLAIN 0
+#define PARQUET_ENCODING_DELTA_BINARY_PACKED 5
+#define PARQUET_ENCODING_DELTA_LENGTH_BYTE_ARRAY 6
+#define PARQUET_ENCODING_RLE_DICTIONARY 8
+
+#define CREATED_BY "ptoa version 0.0.1"
+
+// Encoded pages per thread that may wait to be written, bounds the memory of multi-threaded writes
+#define PAGES_IN_FLIGHT_PER_THREAD 4
+
+namespace ptoa {
+
+/**
+ * Contiguous values of a column. Columns of a single record batch point into the Arrow buffers, columns that are spread
+ * over multiple batches are copied into the owned vectors first. offsets index chars and do not have to start at 0.
+ */
+struct column_values {
+    std::shared_ptr<arrow::Field> field;
+    int64_t num_values;
+    int32_t width;
+    const uint8_t* fixed;
+    const int32_t* offsets;
+    const uint8_t* chars;
+    std::vector<uint8_t> owned_fixed;
+    std::vector<int32_t> owned_offsets;
+    std::vector<uint8_t> owned_chars;
+};
+
+// Everything the footer needs to know about a written column chunk
+struct chunk_metadata {
+    std::string name;
+    int32_t physical_type;
+    bool utf8;
+    std::vector<int32_t> encodings;
+    int64_t num_values;
+    int64_t total_size;
+    int64_t chunk_offset;
+    int64_t data_page_offset;
+    int64_t dictionary_page_offset;
+};
+
+namespace {
+
+status gather_column(const std::vector<std::shared_ptr<arrow::RecordBatch>>& batches, int c, column_values* values) {
+    arrow::Type::type type = values->field->type()->id();
+
+    values->num_values = 0;
+    values->fixed = nullptr;
+    values->offsets = nullptr;
+    values->chars = nullptr;
+
+    for(const auto& batch : batches){
+        if(batch->column(c)->null_count() != 0){
+            std::cerr << "[ERROR] Column " << values->field->name() << " contains nulls, which cannot be written without definition levels" << std::endl;
+            return status::FAIL;
+        }
+        values->num_values += batch->num_rows();
+    }
+
+    if(type == arrow::Type::INT32 || type == arrow::Type::INT64){
+        values->width = type == arrow::Type::INT32 ? sizeof(int32_t) : sizeof(int64_t);
+
+        for(const auto& batch : batches){
+            auto array = batch->column(c);
+            const uint8_t* data = type == arrow::Type::INT32 ?
+                (const uint8_t*) std::static_pointer_cast<arrow::Int32Array>(array)->raw_values() :
+                (const uint8_t*) std::static_pointer_cast<arrow::Int64Array>(array)->raw_values();
+
+            if(batches.size() == 1){
+                values->fixed = data;
+            } else {
+                values->owned_fixed.insert(values->owned_fixed.end(), data, data + array->length()*values->width);
+            }
+        }
+
+        if(batches.size() != 1){
+            values->fixed = values->owned_fixed.data();
+        }
+    } else if(type == arrow::Type::STRING || type == arrow::Type::BINARY){
+        values->width = 0;
+
+        for(const auto& batch : batches){
+            auto array = std::static_pointer_cast<arrow::BinaryArray>(batch->column(c));
+            const int32_t* offsets = array->raw_value_offsets();
+            const uint8_t* chars = array->value_data() ? array->value_data()->data() : nullptr;
+
+            if(batches.size() == 1){
+                values->offsets = offsets;
+                values->chars = chars;
+            } else {
+                if(values->owned_offsets.empty()){
+                    values->owned_offsets.push_back(0);
+                }
+                for(int64_t i=0; i<array->length(); i++){
+                    values->owned_chars.insert(values->owned_chars.end(), chars + offsets[i], chars + offsets[i+1]);
+                    values->owned_offsets.push_back(values->owned_chars.size());
+                }
+            }
+        }
+
+        if(batches.size() != 1){
+            values->owned_offsets.resize(std::max(values->owned_offsets.size(), (size_t) 1));
+            values->offsets = values->owned_offsets.data();
+            values->chars = values->owned_chars.data();
+        }
+    } else {
+        std::cerr << "[ERROR] Column " << values->field->name() << " has type " << values->field->type()->ToString() << ", only int32, int64, utf8 and binary columns can be written" << std::endl;
+        return status::FAIL;
+    }
+
+    return status::OK;
+}
+
+void data_page_header(std::vector<uint8_t>* out, int32_t page_size, int32_t num_values, int32_t encoding) {
+    out->clear();
+    CompactWriter header(out);
+
+    header.write_i32(1, PARQUET_DATA_PAGE_V2);
+    header.write_i32(2, page_size);
+    header.write_i32(3, page_size);
+    header.begin_struct(8);
+    header.write_i32(1, num_values);
+    header.write_i32(2, 0);
+    header.write_i32(3, num_values);
+    header.write_i32(4, encoding);
+    header.write_i32(5, 0);
+    header.write_i32(6, 0);
+    // The pages are not compressed, but parquet-mr writes the default of true and the hardware expects its headers
+    header.write_bool(7, true);
+    header.end_struct();
+    header.end();
+}
+
+void dictionary_page_header(std::vector<uint8_t>* out, int32_t page_size, int32_t num_values) {
+    out->clear();
+    CompactWriter header(out);
+
+    header.write_i32(1, PARQUET_DICTIONARY_PAGE);
+    header.write_i32(2, page_size);
+    header.write_i32(3, page_size);
+    header.begin_struct(7);
+    header.write_i32(1, num_values);
+    header.write_i32(2, PARQUET_ENCODING_PLAIN);
+    header.end_struct();
+    header.end();
+}
+
+inline void append_delta(std::vector<uint8_t>* out, const int32_t* values, int64_t num_values, delta_state32* state) {
+    append_delta32(out, values, num_values, state);
+}
+
+inline void append_delta(std::vector<uint8_t>* out, const int64_t* values, int64_t num_values, delta_state64* state) {
+    append_delta64(out, values, num_values, state);
+}
+
+inline void skip_delta(const int32_t* values, int64_t num_values, delta_state32* state) {
+    skip_delta32(values, num_values, state);
+}
+
+inline void skip_delta(const int64_t* values, int64_t num_values, delta_state64* state) {
+    skip_delta64(values, num_values, state);
+}
+
+template<typename T>
+void append_plain(std::vector<uint8_t>* out, const std::vector<T>& values) {
+    const uint8_t* data = (const uint8_t*) values.data();
+    out->insert(out->end(), data, data + values.size()*sizeof(T));
+}
+
+void append_plain_string(std::vector<uint8_t>* out, const uint8_t* chars, int32_t length) {
+    uint8_t prefix[sizeof(int32_t)];
+    std::memcpy(prefix, &length, sizeof(int32_t));
+    out->insert(out->end(), prefix, prefix + sizeof(int32_t));
+    out->insert(out->end(), chars, chars + length);
+}
+
+void append_plain(std::vector<uint8_t>* out, const std::vector<std::string>& values) {
+    for(const std::string& value : values){
+        append_plain_string(out, (const uint8_t*) value.data(), value.size());
+    }
+}
+
+// Dictionary of a column in order of first occurrence. Fails as soon as the plain encoded dictionary exceeds max_bytes.
+template<typename T>
+bool build_dictionary(const column_values& values, int64_t max_bytes, std::vector<T>* dictionary, std::vector<uint32_t>* indices) {
+    const T* data = (const T*) values.fixed;
+    std::unordered_map<T, uint32_t> ids;
+
+    indices->resize(values.num_values);
+    for(int64_t i=0; i<values.num_values; i++){
+        auto id = ids.find(data[i]);
+        if(id == ids.end()){
+            if((int64_t) ((dictionary->size() + 1)*sizeof(T)) > max_bytes){
+                return false;
+            }
+            id = ids.emplace(data[i], dictionary->size()).first;
+            dictionary->push_back(data[i]);
+        }
+        (*indices)[i] = id->second;
+    }
+
+    return true;
+}
+
+bool build_string_dictionary(const column_values& values, int64_t max_bytes, std::vector<std::string>* dictionary, std::vector<uint32_t>* indices) {
+    std::unordered_map<std::string, uint32_t> ids;
+    int64_t dictionary_bytes = 0;
+
+    indices->resize(values.num_values);
+    for(int64_t i=0; i<values.num_values; i++){
+        std::string value((const char*) values.chars + values.offsets[i], values.offsets[i+1] - values.offsets[i]);
+        auto id = ids.find(value);
+        if(id == ids.end()){
+            dictionary_bytes += sizeof(int32_t) + value.size();
+            if(dictionary_bytes > max_bytes){
+                return false;
+            }
+            id = ids.emplace(value, dictionary->size()).first;
+            dictionary->push_back(value);
+        }
+        (*indices)[i] = id->second;
+    }
+
+    return true;
+}
+
+/**
+ * Page encoders append the page with the given index to out. firsts holds the first value of every page followed by the
+ * number of values. Every thread encodes with its own copy of the encoder.
+ */
+template<typename T>
+struct plain_page_encoder {
+    const T* data;
+    const std::vector<int64_t>* firsts;
+
+    void encode(size_t page, std::vector<uint8_t>* out) {
+        out->insert(out->end(), (const uint8_t*) (data + (*firsts)[page]), (const uint8_t*) (data + (*firsts)[page+1]));
+    }
+};
+
+struct plain_string_page_encoder {
+    const column_values* values;
+    const std::vector<int64_t>* firsts;
+
+    void encode(size_t page, std::vector<uint8_t>* out) {
+        const int32_t* offsets = values->offsets;
+        for(int64_t i=(*firsts)[page]; i<(*firsts)[page+1]; i++){
+            append_plain_string(out, values->chars + offsets[i], offsets[i+1] - offsets[i]);
+        }
+    }
+};
+
+// The delta state of a page is what the pages before it left. A page with a full block overwrites all of it, so a page
+// encoded out of order replays the pages from the last one with a full block.
+inline size_t first_replayed_page(const std::vector<int64_t>& firsts, size_t page) {
+    while(page > 0){
+        page--;
+        if(firsts[page+1] - firsts[page] > DELTA_BLOCK_SIZE){
+            break;
+        }
+    }
+
+    return page;
+}
+
+// initial is the state the pages before the first one left, skip_to(firsts->size() - 1) gives the state after the last
+template<typename T>
+struct delta_page_encoder {
+    typedef delta_state<typename std::make_unsigned<T>::type> state_type;
+
+    const T* data;
+    const std::vector<int64_t>* firsts;
+    state_type initial;
+    state_type state;
+    size_t next_page;
+
+    delta_page_encoder(const T* data, const std::vector<int64_t>* firsts, const state_type& initial) : data(data), firsts(firsts), initial(initial), state(initial), next_page(0) {}
+
+    void skip_to(size_t page) {
+        state = initial;
+        for(size_t replayed=first_replayed_page(*firsts, page); replayed<page; replayed++){
+            skip_delta(data + (*firsts)[replayed], (*firsts)[replayed+1] - (*firsts)[replayed], &state);
+        }
+        next_page = page;
+    }
+
+    void encode(size_t page, std::vector<uint8_t>* out) {
+        if(page != next_page){
+            skip_to(page);
+        }
+
+        append_delta(out, data + (*firsts)[page], (*firsts)[page+1] - (*firsts)[page], &state);
+        next_page = page + 1;
+    }
+};
+
+struct delta_length_page_encoder {
+    const column_values* values;
+    const std::vector<int64_t>* firsts;
+    delta_state32 initial;
+    delta_state32 state;
+    std::vector<int32_t> lengths;
+    size_t next_page;
+
+    delta_length_page_encoder(const column_values* values, const std::vector<int64_t>* firsts, const delta_state32& initial) : values(values), firsts(firsts), initial(initial), state(initial), next_page(0) {}
+
+    void page_lengths(size_t page) {
+        const int32_t* offsets = values->offsets + (*firsts)[page];
+        lengths.resize((*firsts)[page+1] - (*firsts)[page]);
+        for(size_t i=0; i<lengths.size(); i++){
+            lengths[i] = offsets[i+1] - offsets[i];
+        }
+    }
+
+    void skip_to(size_t page) {
+        state = initial;
+        for(size_t replayed=first_replayed_page(*firsts, page); replayed<page; replayed++){
+            page_lengths(replayed);
+            skip_delta32(lengths.data(), lengths.size(), &state);
+        }
+        next_page = page;
+    }
+
+    void encode(size_t page, std::vector<uint8_t>* out) {
+        if(page != next_page){
+            skip_to(page);
+        }
+
+        page_lengths(page);
+        append_delta32(out, lengths.data(), lengths.size(), &state);
+
+        const int32_t* offsets = values->offsets;
+        out->insert(out->end(), values->chars + offsets[(*firsts)[page]], values->chars + offsets[(*firsts)[page+1]]);
+        next_page = page + 1;
+    }
+};
+
+struct dictionary_page_encoder {
+    const uint32_t* indices;
+    int bit_width;
+    const std::vector<int64_t>* firsts;
+
+    void encode(size_t page, std::vector<uint8_t>* out) {
+        append_dictionary_indices(out, indices + (*firsts)[page], (*firsts)[page+1] - (*firsts)[page], bit_width);
+    }
+};
+
+// Page of a multi-threaded write in the ring of pages waiting to be written
+struct encoded_page {
+    std::vector<uint8_t> header;
+    std::vector<uint8_t> data;
+    bool ready;
+
+    encoded_page() : ready(false) {}
+};
+
+bool supported_type(arrow::Type::type type) {
+    return type == arrow::Type::INT32 || type == arrow::Type::INT64 || type == arrow::Type::STRING || type == arrow::Type::BINARY;
+}
+
+void begin_chunk(const std::shared_ptr<arrow::Field>& field, int64_t file_pos, chunk_metadata* metadata) {
+    arrow::Type::type type = field->type()->id();
+
+    metadata->name = field->name();
+    metadata->physical_type = type == arrow::Type::INT32 ? PARQUET_TYPE_INT32 : (type == arrow::Type::INT64 ? PARQUET_TYPE_INT64 : PARQUET_TYPE_BYTE_ARRAY);
+    metadata->utf8 = type == arrow::Type::STRING;
+    metadata->encodings.clear();
+    metadata->num_values = 0;
+    metadata->total_size = 0;
+    metadata->chunk_offset = file_pos;
+    metadata->data_page_offset = file_pos;
+    metadata->dictionary_page_offset = -1;
+}
+
+}
+
+/**
+ * File being written. A streamed column keeps the values that do not complete a page yet in the owned buffers of
+ * pending, together with the delta state its written pages left.
+ */
+struct output_file {
+    std::string path;
+    std::ofstream file;
+    int64_t file_pos;
+    std::vector<chunk_metadata> chunks;
+
+    bool column_open;
+    column_values pending;
+    delta_state32 state32;
+    delta_state64 state64;
+};
+
+ParquetWriter::ParquetWriter() : dictionary_enabled(false), int_encoding(encoding::DELTA), string_encoding(encoding::DELTA_LENGTH),
+    page_size(DEFAULT_PAGE_SIZE), rows_per_page(DEFAULT_ROWS_PER_PAGE), dictionary_page_size(DEFAULT_DICTIONARY_PAGE_SIZE), threads(1) {}
+
+ParquetWriter::~ParquetWriter() {}
+
+void ParquetWriter::enable_dictionary() {
+    dictionary_enabled = true;
+}
+
+void ParquetWriter::disable_dictionary() {
+    dictionary_enabled = false;
+}
+
+status ParquetWriter::set_encoding(arrow::Type::type type, encoding enc) {
+    if((type == arrow::Type::INT32 || type == arrow::Type::INT64) && enc != encoding::DELTA_LENGTH){
+        int_encoding = enc;
+    } else if((type == arrow::Type::STRING || type == arrow::Type::BINARY) && enc != encoding::DELTA){
+        string_encoding = enc;
+    } else {
+        std::cerr << "[ERROR] Encoding not supported for this type" << std::endl;
+        return status::FAIL;
+    }
+
+    return status::OK;
+}
+
+void ParquetWriter::set_page_size(int64_t page_size) {
+    this->page_size = std::max(page_size, (int64_t) 1);
+}
+
+void ParquetWriter::set_rows_per_page(int64_t rows_per_page) {
+    this->rows_per_page = std::max(rows_per_page, (int64_t) 1);
+}
+
+void ParquetWriter::set_dictionary_page_size(int64_t dictionary_page_size) {
+    this->dictionary_page_size = dictionary_page_size;
+}
+
+void ParquetWriter::set_threads(int threads) {
+    this->threads = std::max(threads, 1);
+}
+
+status ParquetWriter::write(std::shared_ptr<arrow::Table> table, std::string file_path) {
+    std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+    arrow::TableBatchReader batch_reader(*table);
+
+    while(true){
+        std::shared_ptr<arrow::RecordBatch> batch;
+        if(!batch_reader.ReadNext(&batch).ok()){
+            std::cerr << "[ERROR] Could not read the record batches of the table" << std::endl;
+            return status::FAIL;
+        }
+        if(!batch){
+            break;
+        }
+        batches.push_back(batch);
+    }
+
+    if(open(file_path) != status::OK){
+        return status::FAIL;
+    }
+
+    for(int c=0; c<table->num_columns(); c++){
+        column_values values;
+        values.field = table->schema()->field(c);
+        out->chunks.emplace_back();
+
+        if(gather_column(batches, c, &values) != status::OK || write_column(out->file, &out->file_pos, values, &out->chunks.back()) != status::OK){
+            out.reset();
+            return status::FAIL;
+        }
+    }
+
+    return close();
+}
+
+status ParquetWriter::open(std::string file_path) {
+    if(out){
+        std::cerr << "[ERROR] " << out->path << " is still open" << std::endl;
+        return status::FAIL;
+    }
+
+    out.reset(new output_file());
+    out->path = file_path;
+    out->file.open(file_path, std::ios::binary | std::ios::trunc);
+    if(!out->file){
+        std::cerr << "[ERROR] Could not open " << file_path << " for writing" << std::endl;
+        out.reset();
+        return status::FAIL;
+    }
+
+    out->file.write("PAR1", 4);
+    out->file_pos = 4;
+    out->column_open = false;
+
+    return status::OK;
+}
+
+status ParquetWriter::begin_column(std::shared_ptr<arrow::Field> field) {
+    if(!out || out->column_open){
+        std::cerr << "[ERROR] A column can only be started in an open file after the previous column ended" << std::endl;
+        return status::FAIL;
+    }
+    if(!supported_type(field->type()->id())){
+        std::cerr << "[ERROR] Column " << field->name() << " has type " << field->type()->ToString() << ", only int32, int64, utf8 and binary columns can be written" << std::endl;
+        return status::FAIL;
+    }
+
+    out->chunks.emplace_back();
+    begin_chunk(field, out->file_pos, &out->chunks.back());
+    out->chunks.back().encodings.push_back(data_page_encoding(field->type()->id()));
+
+    arrow::Type::type type = field->type()->id();
+    column_values& pending = out->pending;
+    pending.field = field;
+    pending.width = type == arrow::Type::INT32 ? sizeof(int32_t) : (type == arrow::Type::INT64 ? sizeof(int64_t) : 0);
+    pending.owned_fixed.clear();
+    pending.owned_offsets.assign(1, 0);
+    pending.owned_chars.clear();
+    out->state32 = delta_state32();
+    out->state64 = delta_state64();
+    out->column_open = true;
+
+    return status::OK;
+}
+
+status ParquetWriter::append_column(std::shared_ptr<arrow::Array> array) {
+    if(!out || !out->column_open){
+        std::cerr << "[ERROR] No column has been started" << std::endl;
+        return status::FAIL;
+    }
+
+    column_values& pending = out->pending;
+    if(!array->type()->Equals(pending.field->type())){
+        std::cerr << "[ERROR] Values of type " << array->type()->ToString() << " cannot be appended to column " << pending.field->name() << std::endl;
+        return status::FAIL;
+    }
+    if(array->null_count() != 0){
+        std::cerr << "[ERROR] Column " << pending.field->name() << " contains nulls, which cannot be written without definition levels" << std::endl;
+        return status::FAIL;
+    }
+
+    if(pending.width > 0){
+        const uint8_t* data = pending.width == sizeof(int32_t) ?
+            (const uint8_t*) std::static_pointer_cast<arrow::Int32Array>(array)->raw_values() :
+            (const uint8_t*) std::static_pointer_cast<arrow::Int64Array>(array)->raw_values();
+        pending.owned_fixed.insert(pending.owned_fixed.end(), data, data + array->length()*pending.width);
+    } else {
+        auto strings = std::static_pointer_cast<arrow::BinaryArray>(array);
+        const int32_t* offsets = strings->raw_value_offsets();
+        const uint8_t* chars = strings->value_data() ? strings->value_data()->data() : nullptr;
+        int32_t base = pending.owned_chars.size() - offsets[0];
+
+        pending.owned_chars.insert(pending.owned_chars.end(), chars + offsets[0], chars + offsets[array->length()]);
+        for(int64_t i=1; i<=array->length(); i++){
+            pending.owned_offsets.push_back(base + offsets[i]);
+        }
+    }
+
+    out->chunks.back().num_values += array->length();
+
+    return flush_pages(false);
+}
+
+status ParquetWriter::end_column() {
+    if(!out || !out->column_open){
+        std::cerr << "[ERROR] No column has been started" << std::endl;
+        return status::FAIL;
+    }
+
+    out->column_open = false;
+
+    return flush_pages(true);
+}
+
+status ParquetWriter::close() {
+    if(!out || out->column_open){
+        std::cerr << "[ERROR] A file can only be closed after its last column ended" << std::endl;
+        return status::FAIL;
+    }
+
+    int64_t num_rows = out->chunks.empty() ? 0 : out->chunks[0].num_values;
+    for(const chunk_metadata& chunk : out->chunks){
+        if(chunk.num_values != num_rows){
+            std::cerr << "[ERROR] Column " << chunk.name << " has " << chunk.num_values << " values instead of " << num_rows << std::endl;
+            out.reset();
+            return status::FAIL;
+        }
+    }
+
+    std::vector<uint8_t> metadata = footer(out->chunks, num_rows);
+    uint32_t metadata_size = metadata.size();
+    out->file.write((const char*) metadata.data(), metadata.size());
+    out->file.write((const char*) &metadata_size, sizeof(uint32_t));
+    out->file.write("PAR1", 4);
+
+    out->file.close();
+    bool written = (bool) out->file;
+    std::string path = out->path;
+    out.reset();
+
+    if(!written){
+        std::cerr << "[ERROR] Could not write " << path << std::endl;
+        return status::FAIL;
+    }
+
+    return status::OK;
+}
+
+// Writes the complete pages of the pending values of the streamed column, or all of them once the column ends
+status ParquetWriter::flush_pages(bool last) {
+    column_values& pending = out->pending;
+    pending.num_values = pending.width > 0 ? pending.owned_fixed.size()/pending.width : pending.owned_offsets.size() - 1;
+    pending.fixed = pending.owned_fixed.data();
+    pending.offsets = pending.owned_offsets.data();
+    pending.chars = pending.owned_chars.data();
+
+    // More values may still be appended to the last page
+    std::vector<int64_t> firsts = page_firsts(pending);
+    if(!last){
+        firsts.pop_back();
+    }
+    if(firsts.size() < 2){
+        return status::OK;
+    }
+
+    chunk_metadata* metadata = &out->chunks.back();
+    arrow::Type::type type = pending.field->type()->id();
+    if(type == arrow::Type::INT32){
+        write_prim_pages(out->file, &out->file_pos, (const int32_t*) pending.fixed, firsts, metadata, &out->state32);
+    } else if(type == arrow::Type::INT64){
+        write_prim_pages(out->file, &out->file_pos, (const int64_t*) pending.fixed, firsts, metadata, &out->state64);
+    } else {
+        write_string_pages(out->file, &out->file_pos, pending, firsts, metadata, &out->state32);
+    }
+
+    int64_t written = firsts.back();
+    if(pending.width > 0){
+        pending.owned_fixed.erase(pending.owned_fixed.begin(), pending.owned_fixed.begin() + written*pending.width);
+    } else {
+        int32_t written_chars = pending.owned_offsets[written];
+        pending.owned_chars.erase(pending.owned_chars.begin(), pending.owned_chars.begin() + written_chars);
+        pending.owned_offsets.erase(pending.owned_offsets.begin(), pending.owned_offsets.begin() + written);
+        for(int32_t& offset : pending.owned_offsets){
+            offset -= written_chars;
+        }
+    }
+
+    if(!out->file){
+        std::cerr << "[ERROR] Could not write " << out->path << std::endl;
+        return status::FAIL;
+    }
+
+    return status::OK;
+}
+
+status ParquetWriter::write_column(std::ofstream& file, int64_t* file_pos, const column_values& values, chunk_metadata* metadata) {
+    arrow::Type::type type = values.field->type()->id();
+
+    begin_chunk(values.field, *file_pos, metadata);
+    metadata->num_values = values.num_values;
+
+    // Falls back to the configured encoding if the dictionary does not fit in a dictionary page
+    if(dictionary_enabled){
+        std::vector<uint32_t> indices;
+
+        if(type == arrow::Type::INT32){
+            std::vector<int32_t> dictionary;
+            if(build_dictionary(values, dictionary_page_size, &dictionary, &indices)){
+                write_dictionary_pages(file, file_pos, dictionary, indices, values, metadata);
+                return status::OK;
+            }
+        } else if(type == arrow::Type::INT64){
+            std::vector<int64_t> dictionary;
+            if(build_dictionary(values, dictionary_page_size, &dictionary, &indices)){
+                write_dictionary_pages(file, file_pos, dictionary, indices, values, metadata);
+                return status::OK;
+            }
+        } else {
+            std::vector<std::string> dictionary;
+            if(build_string_dictionary(values, dictionary_page_size, &dictionary, &indices)){
+                write_dictionary_pages(file, file_pos, dictionary, indices, values, metadata);
+                return status::OK;
+            }
+        }
+    }
+
+    std::vector<int64_t> firsts = page_firsts(values);
+    metadata->encodings.push_back(data_page_encoding(type));
+
+    if(type == arrow::Type::INT32){
+        delta_state32 state;
+        write_prim_pages(file, file_pos, (const int32_t*) values.fixed, firsts, metadata, &state);
+    } else if(type == arrow::Type::INT64){
+        delta_state64 state;
+        write_prim_pages(file, file_pos, (const int64_t*) values.fixed, firsts, metadata, &state);
+    } else {
+        delta_state32 state;
+        write_string_pages(file, file_pos, values, firsts, metadata, &state);
+    }
+
+    return status::OK;
+}
+
+// Writes the pages starting at firsts, state is the delta state of the column chunk before and after them
+template<typename T>
+void ParquetWriter::write_prim_pages(std::ofstream& file, int64_t* file_pos, const T* data, const std::vector<int64_t>& firsts, chunk_metadata* metadata, delta_state<typename std::make_unsigned<T>::type>* state) {
+    if(int_encoding == encoding::DELTA){
+        delta_page_encoder<T> encoder(data, &firsts, *state);
+        write_data_pages(file, file_pos, encoder, firsts, PARQUET_ENCODING_DELTA_BINARY_PACKED, metadata);
+        encoder.skip_to(firsts.size() - 1);
+        *state = encoder.state;
+    } else {
+        write_data_pages(file, file_pos, plain_page_encoder<T>{data, &firsts}, firsts, PARQUET_ENCODING_PLAIN, metadata);
+    }
+}
+
+void ParquetWriter::write_string_pages(std::ofstream& file, int64_t* file_pos, const column_values& values, const std::vector<int64_t>& firsts, chunk_metadata* metadata, delta_state32* state) {
+    if(string_encoding == encoding::DELTA_LENGTH){
+        delta_length_page_encoder encoder(&values, &firsts, *state);
+        write_data_pages(file, file_pos, encoder, firsts, PARQUET_ENCODING_DELTA_LENGTH_BYTE_ARRAY, metadata);
+        encoder.skip_to(firsts.size() - 1);
+        *state = encoder.state;
+    } else {
+        write_data_pages(file, file_pos, plain_string_page_encoder{&values, &firsts}, firsts, PARQUET_ENCODING_PLAIN, metadata);
+    }
+}
+
+template<typename K>
+void ParquetWriter::write_dictionary_pages(std::ofstream& file, int64_t* file_pos, const std::vector<K>& dictionary, const std::vector<uint32_t>& indices, const column_values& values, chunk_metadata* metadata) {
+    metadata->encodings.push_back(PARQUET_ENCODING_PLAIN);
+    metadata->encodings.push_back(PARQUET_ENCODING_RLE_DICTIONARY);
+    metadata->dictionary_page_offset = *file_pos;
+
+    page_buffer.clear();
+    append_plain(&page_buffer, dictionary);
+    dictionary_page_header(&header_buffer, page_buffer.size(), dictionary.size());
+    write_page(file, file_pos, metadata);
+
+    metadata->data_page_offset = *file_pos;
+    int bit_width = bit_length(dictionary.empty() ? 0 : dictionary.size() - 1);
+    std::vector<int64_t> firsts = page_firsts(values);
+
+    write_data_pages(file, file_pos, dictionary_page_encoder{indices.data(), bit_width, &firsts}, firsts, PARQUET_ENCODING_RLE_DICTIONARY, metadata);
+}
+
+/**
+ * Encodes the data pages of a column chunk and writes them with their headers. With more than one thread the workers
+ * take the pages in order and encode them into a ring of buffers, while this thread writes them out in order as soon
+ * as the next one is ready. A worker only starts a page once its slot in the ring has been written.
+ */
+template<typename Encoder>
+void ParquetWriter::write_data_pages(std::ofstream& file, int64_t* file_pos, const Encoder& encoder, const std::vector<int64_t>& firsts, int32_t parquet_encoding, chunk_metadata* metadata) {
+    size_t num_pages = firsts.size() - 1;
+
+    if(threads == 1 || num_pages <= 1){
+        Encoder sequential = encoder;
+        for(size_t page=0; page<num_pages; page++){
+            page_buffer.clear();
+            sequential.encode(page, &page_buffer);
+            data_page_header(&header_buffer, page_buffer.size(), firsts[page+1] - firsts[page], parquet_encoding);
+            write_page(file, file_pos, metadata);
+        }
+        return;
+    }
+
+    size_t num_workers = std::min((size_t) threads, num_pages);
+    std::vector<encoded_page> ring(num_workers*PAGES_IN_FLIGHT_PER_THREAD);
+    std::mutex ring_mutex;
+    std::condition_variable ring_cv;
+    size_t next_page = 0;
+    size_t written_pages = 0;
+
+    auto encode_pages = [&]() {
+        Encoder worker = encoder;
+        std::unique_lock<std::mutex> lock(ring_mutex);
+
+        while(next_page < num_pages){
+            size_t page = next_page++;
+            ring_cv.wait(lock, [&](){return page < written_pages + ring.size();});
+            lock.unlock();
+
+            encoded_page& slot = ring[page % ring.size()];
+            slot.data.clear();
+            worker.encode(page, &slot.data);
+            data_page_header(&slot.header, slot.data.size(), firsts[page+1] - firsts[page], parquet_encoding);
+
+            lock.lock();
+            slot.ready = true;
+            ring_cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for(size_t w=0; w<num_workers; w++){
+        workers.emplace_back(encode_pages);
+    }
+
+    for(size_t page=0; page<num_pages; page++){
+        encoded_page& slot = ring[page % ring.size()];
+        {
+            std::unique_lock<std::mutex> lock(ring_mutex);
+            ring_cv.wait(lock, [&](){return slot.ready;});
+        }
+
+        page_buffer.swap(slot.data);
+        header_buffer.swap(slot.header);
+        write_page(file, file_pos, metadata);
+        page_buffer.swap(slot.data);
+        header_buffer.swap(slot.header);
+
+        std::lock_guard<std::mutex> lock(ring_mutex);
+        slot.ready = false;
+        written_pages++;
+        ring_cv.notify_all();
+    }
+
+    for(auto& worker : workers){
+        worker.join();
+    }
+}
+
+// Values in the page starting at value first, limited by rows_per_page and by the plain encoded size of the values
+int64_t ParquetWriter::page_values(const column_values& values, int64_t first) {
+    int64_t count = std::min(rows_per_page, values.num_values - first);
+
+    if(values.width > 0){
+        return std::max(std::min(count, page_size/values.width), (int64_t) 1);
+    }
+
+    const int32_t* offsets = values.offsets + first;
+    int64_t bytes = 0;
+    for(int64_t i=0; i<count; i++){
+        bytes += sizeof(int32_t) + offsets[i+1] - offsets[i];
+        if(bytes > page_size && i > 0){
+            return i;
+        }
+    }
+
+    return count;
+}
+
+int32_t ParquetWriter::data_page_encoding(arrow::Type::type type) {
+    if(type == arrow::Type::INT32 || type == arrow::Type::INT64){
+        return int_encoding == encoding::DELTA ? PARQUET_ENCODING_DELTA_BINARY_PACKED : PARQUET_ENCODING_PLAIN;
+    }
+
+    return string_encoding == encoding::DELTA_LENGTH ? PARQUET_ENCODING_DELTA_LENGTH_BYTE_ARRAY : PARQUET_ENCODING_PLAIN;
+}
+
+std::vector<int64_t> ParquetWriter::page_firsts(const column_values& values) {
+    std::vector<int64_t> firsts;
+
+    for(int64_t first=0; first<values.num_values; first+=page_values(values, first)){
+        firsts.push_back(first);
+    }
+    firsts.push_back(values.num_values);
+
+    return firsts;
+}
+
+// Writes header_buffer followed by page_buffer
+void ParquetWriter::write_page(std::ofstream& file, int64_t* file_pos, chunk_metadata* metadata) {
+    file.write((const char*) header_buffer.data(), header_buffer.size());
+    file.write((const char*) page_buffer.data(), page_buffer.size());
+
+    *file_pos += header_buffer.size() + page_buffer.size();
+    metadata->total_size += header_buffer.size() + page_buffer.size();
+}
+
+// FileMetaData with a single row group and a flat schema of required columns
+std::vector<uint8_t> ParquetWriter::footer(const std::vector<chunk_metadata>& chunks, int64_t num_rows) {
+    std::vector<uint8_t> out;
+    CompactWriter metadata(&out);
+    int64_t total_size = 0;
+
+    metadata.write_i32(1, 1);
+
+    metadata.begin_list(2, COMPACT_STRUCT, chunks.size() + 1);
+    metadata.list_struct();
+    metadata.write_string(4, "schema");
+    metadata.write_i32(5, chunks.size());
+    metadata.end_struct();
+    for(const chunk_metadata& chunk : chunks){
+        metadata.list_struct();
+        metadata.write_i32(1, chunk.physical_type);
+        metadata.write_i32(3, PARQUET_REQUIRED);
+        metadata.write_string(4, chunk.name);
+        if(chunk.utf8){
+            metadata.write_i32(6, PARQUET_CONVERTED_UTF8);
+        }
+        metadata.end_struct();
+        total_size += chunk.total_size;
+    }
+
+    metadata.write_i64(3, num_rows);
+
+    metadata.begin_list(4, COMPACT_STRUCT, 1);
+    metadata.list_struct();
+    metadata.begin_list(1, COMPACT_STRUCT, chunks.size());
+    for(const chunk_metadata& chunk : chunks){
+        metadata.list_struct();
+        metadata.write_i64(2, chunk.chunk_offset);
+        metadata.begin_struct(3);
+        metadata.write_i32(1, chunk.physical_type);
+        metadata.begin_list(2, COMPACT_I32, chunk.encodings.size());
+        for(int32_t enc : chunk.encodings){
+            metadata.list_i32(enc);
+        }
+        metadata.begin_list(3, COMPACT_BINARY, 1);
+        metadata.list_string(chunk.name);
+        metadata.write_i32(4, PARQUET_UNCOMPRESSED);
+        metadata.write_i64(5, chunk.num_values);
+        metadata.write_i64(6, chunk.total_size);
+        metadata.write_i64(7, chunk.total_size);
+        metadata.write_i64(9, chunk.data_page_offset);
+        if(chunk.dictionary_page_offset >= 0){
+            metadata.write_i64(11, chunk.dictionary_page_offset);
+        }
+        metadata.end_struct();
+        metadata.end_struct();
+    }
+    metadata.write_i64(2, total_size);
+    metadata.write_i64(3, num_rows);
+    metadata.end_struct();
+
+    metadata.write_string(6, CREATED_BY);
+    metadata.end();
+
+    return out;
+}
+
+}
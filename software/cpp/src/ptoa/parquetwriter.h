@@ -0,0 +1,107 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <arrow/api.h>
+
+#include "fastpack.h"
+#include "ptoa.h"
+
+// Defaults of parquet-mr
+#define DEFAULT_PAGE_SIZE (1024*1024)
+#define DEFAULT_ROWS_PER_PAGE 20000
+#define DEFAULT_DICTIONARY_PAGE_SIZE (1024*1024)
+
+namespace ptoa {
+
+struct column_values;
+struct chunk_metadata;
+struct output_file;
+
+/**
+ * Writes Arrow tables to Parquet files the hardware can read: a single row group of uncompressed V2 data pages without
+ * definition or repetition levels, so all columns are written as required and must not contain nulls. The first column
+ * chunk starts right after the magic number at offset 4. int32 and int64 columns are PLAIN or DELTA_BINARY_PACKED
+ * encoded, utf8 and binary columns PLAIN or DELTA_LENGTH_BYTE_ARRAY encoded. With the dictionary enabled, columns whose
+ * dictionary fits in the dictionary page size are dictionary encoded instead, which only software readers support.
+ * A page ends once it holds rows_per_page values or once its values would exceed page_size bytes in plain encoding.
+ * With more than one thread the pages of a column are encoded concurrently, the file is the same for any thread count.
+ */
+class ParquetWriter {
+  public:
+    ParquetWriter();
+    ~ParquetWriter();
+    status write(std::shared_ptr<arrow::Table> table, std::string file_path);
+
+    /**
+     * Writes columns that do not fit in memory: open a file, write every column with begin_column, any number of
+     * append_column calls and end_column, and finish with close. Pages are written as soon as they are complete, only
+     * the values of an unfinished page are kept. The settings are taken at begin_column, so every column can have its
+     * own encoding and page size. Streamed columns are never dictionary encoded, the dictionary page would have to be
+     * written before the values it is built from.
+     */
+    status open(std::string file_path);
+    status begin_column(std::shared_ptr<arrow::Field> field);
+    status append_column(std::shared_ptr<arrow::Array> array);
+    status end_column();
+    status close();
+
+    void enable_dictionary();
+    void disable_dictionary();
+    // Encoding of the integer (INT32 and INT64) or the string (STRING and BINARY) columns, DELTA and DELTA_LENGTH by default
+    status set_encoding(arrow::Type::type type, encoding enc);
+    void set_page_size(int64_t page_size);
+    void set_rows_per_page(int64_t rows_per_page);
+    void set_dictionary_page_size(int64_t dictionary_page_size);
+    // Threads encoding the data pages of a column, 1 by default
+    void set_threads(int threads);
+
+  private:
+    status write_column(std::ofstream& file, int64_t* file_pos, const column_values& values, chunk_metadata* metadata);
+    status flush_pages(bool last);
+    template<typename T>
+    void write_prim_pages(std::ofstream& file, int64_t* file_pos, const T* data, const std::vector<int64_t>& firsts, chunk_metadata* metadata, delta_state<typename std::make_unsigned<T>::type>* state);
+    void write_string_pages(std::ofstream& file, int64_t* file_pos, const column_values& values, const std::vector<int64_t>& firsts, chunk_metadata* metadata, delta_state32* state);
+    template<typename Encoder>
+    void write_data_pages(std::ofstream& file, int64_t* file_pos, const Encoder& encoder, const std::vector<int64_t>& firsts, int32_t parquet_encoding, chunk_metadata* metadata);
+    template<typename K>
+    void write_dictionary_pages(std::ofstream& file, int64_t* file_pos, const std::vector<K>& dictionary, const std::vector<uint32_t>& indices, const column_values& values, chunk_metadata* metadata);
+    int32_t data_page_encoding(arrow::Type::type type);
+    int64_t page_values(const column_values& values, int64_t first);
+    std::vector<int64_t> page_firsts(const column_values& values);
+    void write_page(std::ofstream& file, int64_t* file_pos, chunk_metadata* metadata);
+    std::vector<uint8_t> footer(const std::vector<chunk_metadata>& chunks, int64_t num_rows);
+
+    bool dictionary_enabled;
+    encoding int_encoding;
+    encoding string_encoding;
+    int64_t page_size;
+    int64_t rows_per_page;
+    int64_t dictionary_page_size;
+    int threads;
+
+    std::unique_ptr<output_file> out;
+
+    // Reused between pages
+    std::vector<uint8_t> page_buffer;
+    std::vector<uint8_t> header_buffer;
+};
+
+}
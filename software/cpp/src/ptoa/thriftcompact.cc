@@ -0,0 +1,294 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "fastpack.h"
+#include "thriftcompact.h"
+
+namespace ptoa {
+
+CompactWriter::CompactWriter(std::vector<uint8_t>* out) : out(out), last_field_id(0) {}
+
+void CompactWriter::field_header(int16_t field_id, compact_type type) {
+    int16_t delta = field_id - last_field_id;
+
+    if(delta > 0 && delta <= 15){
+        out->push_back((uint8_t) (delta << 4 | type));
+    } else {
+        out->push_back((uint8_t) type);
+        append_zigzag(out, field_id);
+    }
+
+    last_field_id = field_id;
+}
+
+void CompactWriter::write_i32(int16_t field_id, int32_t value) {
+    field_header(field_id, COMPACT_I32);
+    append_zigzag(out, value);
+}
+
+void CompactWriter::write_i64(int16_t field_id, int64_t value) {
+    field_header(field_id, COMPACT_I64);
+    append_zigzag(out, value);
+}
+
+// Booleans are stored in the type of the field header
+void CompactWriter::write_bool(int16_t field_id, bool value) {
+    field_header(field_id, value ? COMPACT_BOOLEAN_TRUE : COMPACT_BOOLEAN_FALSE);
+}
+
+void CompactWriter::write_string(int16_t field_id, const std::string& value) {
+    field_header(field_id, COMPACT_BINARY);
+    list_string(value);
+}
+
+void CompactWriter::begin_struct(int16_t field_id) {
+    field_header(field_id, COMPACT_STRUCT);
+    field_id_stack.push_back(last_field_id);
+    last_field_id = 0;
+}
+
+void CompactWriter::end_struct() {
+    out->push_back(0);
+    last_field_id = field_id_stack.back();
+    field_id_stack.pop_back();
+}
+
+void CompactWriter::begin_list(int16_t field_id, compact_type element_type, int32_t size) {
+    field_header(field_id, COMPACT_LIST);
+
+    if(size < 15){
+        out->push_back((uint8_t) (size << 4 | element_type));
+    } else {
+        out->push_back((uint8_t) (0xf0 | element_type));
+        append_varint(out, size);
+    }
+}
+
+void CompactWriter::list_i32(int32_t value) {
+    append_zigzag(out, value);
+}
+
+void CompactWriter::list_string(const std::string& value) {
+    append_varint(out, value.size());
+    out->insert(out->end(), value.begin(), value.end());
+}
+
+void CompactWriter::list_struct() {
+    field_id_stack.push_back(last_field_id);
+    last_field_id = 0;
+}
+
+void CompactWriter::end() {
+    out->push_back(0);
+}
+
+// Nesting deeper than this is taken to be corrupted data
+#define COMPACT_MAX_DEPTH 64
+
+CompactReader::CompactReader(const uint8_t* data, int64_t size) : data(data), size(size), pos(0), error(false),
+    last_field_id(0) {}
+
+status CompactReader::read_byte(uint8_t* value) {
+    if(error || pos >= size){
+        error = true;
+        return status::FAIL;
+    }
+    *value = data[pos++];
+    return status::OK;
+}
+
+status CompactReader::read_varint(uint64_t* value) {
+    *value = 0;
+
+    for(int shift=0; shift<64; shift+=7){
+        uint8_t byte;
+        if(read_byte(&byte) != status::OK){
+            return status::FAIL;
+        }
+        *value |= (uint64_t) (byte & 0x7f) << shift;
+        if((byte & 0x80) == 0){
+            return status::OK;
+        }
+    }
+
+    error = true;
+    return status::FAIL;
+}
+
+status CompactReader::skip_bytes(int64_t count) {
+    if(error || count < 0 || count > size - pos){
+        error = true;
+        return status::FAIL;
+    }
+    pos += count;
+    return status::OK;
+}
+
+bool CompactReader::next_field(int16_t* field_id, compact_type* type) {
+    uint8_t byte;
+
+    if(read_byte(&byte) != status::OK || byte == 0){
+        return false;
+    }
+
+    *type = (compact_type) (byte & 0x0f);
+
+    if((byte >> 4) == 0){
+        uint64_t zigzag;
+        if(read_varint(&zigzag) != status::OK){
+            return false;
+        }
+        last_field_id = (int16_t) ((zigzag >> 1) ^ -(zigzag & 1));
+    } else {
+        last_field_id += byte >> 4;
+    }
+
+    *field_id = last_field_id;
+    return true;
+}
+
+status CompactReader::read_i32(int32_t* value) {
+    int64_t value64;
+
+    if(read_i64(&value64) != status::OK || value64 < INT32_MIN || value64 > INT32_MAX){
+        error = true;
+        return status::FAIL;
+    }
+    *value = (int32_t) value64;
+
+    return status::OK;
+}
+
+status CompactReader::read_i64(int64_t* value) {
+    uint64_t zigzag;
+
+    if(read_varint(&zigzag) != status::OK){
+        return status::FAIL;
+    }
+    *value = (int64_t) ((zigzag >> 1) ^ -(zigzag & 1));
+
+    return status::OK;
+}
+
+status CompactReader::skip(compact_type type) {
+    // Booleans of fields are stored in the type of the field header
+    if(type == COMPACT_BOOLEAN_TRUE || type == COMPACT_BOOLEAN_FALSE){
+        return error ? status::FAIL : status::OK;
+    }
+
+    return skip_element(type, 0);
+}
+
+// Skip a value, where booleans (as list elements) take a byte
+status CompactReader::skip_element(compact_type type, int depth) {
+    uint64_t value;
+    uint8_t byte;
+
+    if(depth > COMPACT_MAX_DEPTH){
+        error = true;
+        return status::FAIL;
+    }
+
+    switch(type){
+        case COMPACT_BOOLEAN_TRUE:
+        case COMPACT_BOOLEAN_FALSE:
+        case COMPACT_BYTE:
+            return skip_bytes(1);
+        case COMPACT_I16:
+        case COMPACT_I32:
+        case COMPACT_I64:
+            return read_varint(&value);
+        case COMPACT_DOUBLE:
+            return skip_bytes(8);
+        case COMPACT_BINARY:
+            if(read_varint(&value) != status::OK || value > (uint64_t) size){
+                error = true;
+                return status::FAIL;
+            }
+            return skip_bytes(value);
+        case COMPACT_LIST:
+        case COMPACT_SET: {
+            if(read_byte(&byte) != status::OK){
+                return status::FAIL;
+            }
+            uint64_t elements = byte >> 4;
+            if(elements == 15 && read_varint(&elements) != status::OK){
+                return status::FAIL;
+            }
+            for(uint64_t e=0; e<elements; e++){
+                if(skip_element((compact_type) (byte & 0x0f), depth + 1) != status::OK){
+                    return status::FAIL;
+                }
+            }
+            return status::OK;
+        }
+        case COMPACT_MAP: {
+            uint64_t elements;
+            if(read_varint(&elements) != status::OK){
+                return status::FAIL;
+            }
+            if(elements == 0){
+                return status::OK;
+            }
+            if(read_byte(&byte) != status::OK){
+                return status::FAIL;
+            }
+            for(uint64_t e=0; e<elements; e++){
+                if(skip_element((compact_type) (byte >> 4), depth + 1) != status::OK ||
+                   skip_element((compact_type) (byte & 0x0f), depth + 1) != status::OK){
+                    return status::FAIL;
+                }
+            }
+            return status::OK;
+        }
+        case COMPACT_STRUCT: {
+            int16_t field_id;
+            compact_type field_type;
+            begin_struct();
+            while(next_field(&field_id, &field_type)){
+                if(field_type == COMPACT_BOOLEAN_TRUE || field_type == COMPACT_BOOLEAN_FALSE){
+                    continue;
+                }
+                if(skip_element(field_type, depth + 1) != status::OK){
+                    return status::FAIL;
+                }
+            }
+            end_struct();
+            return error ? status::FAIL : status::OK;
+        }
+        default:
+            error = true;
+            return status::FAIL;
+    }
+}
+
+void CompactReader::begin_struct() {
+    field_id_stack.push_back(last_field_id);
+    last_field_id = 0;
+}
+
+void CompactReader::end_struct() {
+    if(!field_id_stack.empty()){
+        last_field_id = field_id_stack.back();
+        field_id_stack.pop_back();
+    }
+}
+
+int64_t CompactReader::position() {
+    return pos;
+}
+
+bool CompactReader::failed() {
+    return error;
+}
+
+}
@@ -0,0 +1,115 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "ptoa.h"
+
+namespace ptoa {
+
+// Type ids of the Thrift compact protocol
+enum compact_type{
+	COMPACT_BOOLEAN_TRUE = 1,
+	COMPACT_BOOLEAN_FALSE = 2,
+	COMPACT_BYTE = 3,
+	COMPACT_I16 = 4,
+	COMPACT_I32 = 5,
+	COMPACT_I64 = 6,
+	COMPACT_DOUBLE = 7,
+	COMPACT_BINARY = 8,
+	COMPACT_LIST = 9,
+	COMPACT_SET = 10,
+	COMPACT_MAP = 11,
+	COMPACT_STRUCT = 12
+};
+
+/**
+ * Serializes Thrift structs in the compact protocol, which is how Parquet stores page headers and the file footer.
+ * Fields have to be written in increasing field id order, like generated Thrift code does, so the field headers use
+ * the short form with the id delta whenever possible.
+ */
+class CompactWriter {
+  public:
+    CompactWriter(std::vector<uint8_t>* out);
+
+    void write_i32(int16_t field_id, int32_t value);
+    void write_i64(int16_t field_id, int64_t value);
+    void write_bool(int16_t field_id, bool value);
+    void write_string(int16_t field_id, const std::string& value);
+
+    // Nested struct, ended by end_struct
+    void begin_struct(int16_t field_id);
+    void end_struct();
+
+    // List of size elements that are added with the list_ functions below
+    void begin_list(int16_t field_id, compact_type element_type, int32_t size);
+    void list_i32(int32_t value);
+    void list_string(const std::string& value);
+    // Struct element of a list, ended by end_struct
+    void list_struct();
+
+    // Field stop of the outermost struct
+    void end();
+
+  private:
+    void field_header(int16_t field_id, compact_type type);
+
+    std::vector<uint8_t>* out;
+    int16_t last_field_id;
+    std::vector<int16_t> field_id_stack;
+};
+
+/**
+ * Deserializes Thrift structs in the compact protocol, the counterpart of CompactWriter for the parts of Parquet files
+ * the host has to look into, like page headers. Callers loop over the fields of a struct with next_field, read the ones
+ * they need and skip the others. All reads are bounds checked against the size given at construction, after the first
+ * failure every call fails.
+ */
+class CompactReader {
+  public:
+    CompactReader(const uint8_t* data, int64_t size);
+
+    // Header of the next field of the current struct, false at its field stop
+    bool next_field(int16_t* field_id, compact_type* type);
+    status read_i32(int32_t* value);
+    status read_i64(int64_t* value);
+    // Skip the value of a field of the given type, including nested structs and containers
+    status skip(compact_type type);
+
+    // Fields of a nested struct are read after begin_struct until next_field returns false, then end_struct continues
+    // with the enclosing struct
+    void begin_struct();
+    void end_struct();
+
+    // Bytes read so far
+    int64_t position();
+    bool failed();
+
+  private:
+    status read_byte(uint8_t* value);
+    status read_varint(uint64_t* value);
+    status skip_bytes(int64_t count);
+    status skip_element(compact_type type, int depth);
+
+    const uint8_t* data;
+    int64_t size;
+    int64_t pos;
+    bool error;
+    int16_t last_field_id;
+    std::vector<int16_t> field_id_stack;
+};
+
+}
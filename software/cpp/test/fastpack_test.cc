@@ -0,0 +1,113 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+#include <string.h>
+#include <iostream>
+#include <random>
+
+#include "../src/ptoa/fastpack.h"
+
+// Round trip of the packing kernels for every bit width. Built twice by CMakeLists.txt, with and without BMI2, so both
+// the pext kernels and the shift kernels are covered.
+
+#define GUARD_BYTE 0xA5
+
+// Value i of 32 values packed least significant bit first
+uint64_t unpack_value(const uint8_t* packed, int bit_width, int i) {
+    uint64_t value = 0;
+
+    for(int b=0; b<bit_width; b++){
+        int64_t bit = (int64_t) i*bit_width + b;
+        value |= (uint64_t) ((packed[bit/8] >> (bit%8)) & 1) << b;
+    }
+
+    return value;
+}
+
+uint64_t low_bits(uint64_t value, int bit_width) {
+    return bit_width >= 64 ? value : value & ((1ULL << bit_width) - 1);
+}
+
+// Packs random values, with random bits above the bit width that have to be ignored, and unpacks them again. Nothing
+// may be written past the packed values and PACK_SLACK_BYTES.
+template<typename U>
+bool check_round_trip(void (*pack)(const U*, int, uint8_t*), int max_bit_width, std::mt19937_64* random) {
+    bool passed = true;
+
+    for(int bit_width=0; bit_width<=max_bit_width; bit_width++){
+        for(int iteration=0; iteration<100; iteration++){
+            U values[DELTA_MINIBLOCK_SIZE];
+            for(int i=0; i<DELTA_MINIBLOCK_SIZE; i++){
+                values[i] = (U) (*random)();
+            }
+            // Exercise the extremes of the bit width too
+            values[0] = (U) low_bits(~0ULL, bit_width);
+            values[1] = 0;
+
+            uint8_t packed[64*4 + PACK_SLACK_BYTES + 16];
+            memset(packed, GUARD_BYTE, sizeof(packed));
+            pack(values, bit_width, packed);
+
+            for(int i=0; i<DELTA_MINIBLOCK_SIZE; i++){
+                uint64_t unpacked = unpack_value(packed, bit_width, i);
+                if(unpacked != low_bits(values[i], bit_width)){
+                    std::cout << "Width " << bit_width << " of " << sizeof(U)*8 << " bit values: value " << i << " is " << unpacked
+                              << ", expected " << low_bits(values[i], bit_width) << std::endl;
+                    passed = false;
+                    break;
+                }
+            }
+
+            for(size_t b=bit_width*4 + PACK_SLACK_BYTES; b<sizeof(packed); b++){
+                if(packed[b] != GUARD_BYTE){
+                    std::cout << "Width " << bit_width << " of " << sizeof(U)*8 << " bit values: byte " << b << " was written" << std::endl;
+                    passed = false;
+                    break;
+                }
+            }
+
+            if(!passed){
+                return false;
+            }
+        }
+    }
+
+    return passed;
+}
+
+int main() {
+#ifdef __BMI2__
+    // The pext kernels can only be tested on a CPU that has them
+    if(!__builtin_cpu_supports("bmi2")){
+        std::cout << "No BMI2 support, test skipped" << std::endl;
+        return 0;
+    }
+    std::cout << "Testing the BMI2 kernels" << std::endl;
+#else
+    std::cout << "Testing the scalar kernels" << std::endl;
+#endif
+
+    std::mt19937_64 random(42);
+    bool passed = true;
+
+    passed &= check_round_trip<uint32_t>(&ptoa::pack32, 32, &random);
+    passed &= check_round_trip<uint64_t>(&ptoa::pack64, 64, &random);
+
+    if(passed){
+        std::cout << "Test passed!" << std::endl;
+    } else {
+        std::cout << "Test failed..." << std::endl;
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+#include <parquet/exception.h>
+
+#include "../src/ptoa/fpgareader.h"
+#include "../src/ptoa/parquetwriter.h"
+#include "../src/ptoa/ptoa.h"
+
+// Reads columns written by ptoa::ParquetWriter with FpgaReader on the emulator platform (platforms/emu), which decodes
+// them in software like the kernels would. libfletcher_emu.so has to be where the Fletcher runtime finds platforms,
+// e.g. on LD_LIBRARY_PATH. Pipelined reads have to return the same arrays as serial reads, for segments smaller than a
+// page, segments of several pages and a single segment holding the whole chunk. Reads the kernel cannot do have to fail
+// instead of returning a partially written array.
+
+#define NUM_ROWS 20000
+#define ROWS_PER_PAGE 1000
+
+// Environment variable selecting the kernel of the emulated bitstream, see platforms/emu/src/fletcher_emu.h
+#define EMU_ENV_KERNEL "PTOA_EMU_KERNEL"
+
+// Column of a kernel of the emulator
+struct kernel_column {
+    std::string kernel;
+    std::shared_ptr<arrow::Field> field;
+    std::shared_ptr<arrow::Array> array;
+    ptoa::encoding enc;
+};
+
+template<typename Builder>
+std::shared_ptr<arrow::Array> generate_ints() {
+    std::mt19937_64 random(13);
+    Builder builder;
+
+    // Deltas of varying width, so the pages differ in size
+    int64_t value = 0;
+    for(int i=0; i<NUM_ROWS; i++){
+        value += (int64_t) (random() % (1ULL << (i/ROWS_PER_PAGE % 20))) - 100;
+        PARQUET_THROW_NOT_OK(builder.Append((typename Builder::value_type) value));
+    }
+
+    std::shared_ptr<arrow::Array> array;
+    PARQUET_THROW_NOT_OK(builder.Finish(&array));
+    return array;
+}
+
+std::shared_ptr<arrow::Array> generate_strings() {
+    std::mt19937_64 random(11);
+    arrow::StringBuilder builder;
+
+    for(int i=0; i<NUM_ROWS; i++){
+        PARQUET_THROW_NOT_OK(builder.Append(std::string(random() % 30, 'a' + i % 26)));
+    }
+
+    std::shared_ptr<arrow::Array> array;
+    PARQUET_THROW_NOT_OK(builder.Finish(&array));
+    return array;
+}
+
+// The column written to a file of its own and read back into memory
+std::vector<uint8_t> write_column(std::shared_ptr<arrow::Field> field, std::shared_ptr<arrow::Array> array, std::string file_path) {
+    ptoa::ParquetWriter writer;
+    writer.set_rows_per_page(ROWS_PER_PAGE);
+    if(writer.write(arrow::Table::Make(arrow::schema({field}), {array}), file_path) != ptoa::OK){
+        return std::vector<uint8_t>();
+    }
+
+    std::ifstream file(file_path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+ptoa::status init_reader(std::string kernel, ptoa::FpgaReader* reader) {
+    // The emulator takes the kernel when the platform is initialized
+    setenv(EMU_ENV_KERNEL, kernel.c_str(), 1);
+
+    if(reader->init("emu") != ptoa::OK){
+        std::cout << "The emulator platform could not be initialized" << std::endl;
+        return ptoa::FAIL;
+    }
+
+    return ptoa::OK;
+}
+
+// Read with a new reader, so the device buffers are exactly as large as this read needs
+ptoa::status read_column(std::string kernel, const std::vector<uint8_t>& file, const ptoa::column_descriptor& column,
+                         int64_t segment_size, std::shared_ptr<arrow::Array>* array) {
+    ptoa::FpgaReader reader;
+    if(init_reader(kernel, &reader) != ptoa::OK){
+        return ptoa::FAIL;
+    }
+    reader.set_segment_size(segment_size);
+
+    return reader.read(file.data(), file.size(), column, array);
+}
+
+// Read the column serially and pipelined with several segment sizes, all reads have to return the column
+bool check_pipelined(const kernel_column& column) {
+    std::vector<uint8_t> file = write_column(column.field, column.array, "./test_emu_" + column.kernel + ".prq");
+    int64_t num_chars = 0;
+    if(column.enc == ptoa::DELTA_LENGTH){
+        num_chars = std::static_pointer_cast<arrow::StringArray>(column.array)->value_offset(NUM_ROWS);
+    }
+    ptoa::column_descriptor descriptor(column.field, column.enc, NUM_ROWS, num_chars);
+
+    // The chunk runs from offset 4 to the footer, which is small next to the pages. 1 byte puts every page in a segment
+    // of its own.
+    int64_t page_size = file.size()/(NUM_ROWS/ROWS_PER_PAGE);
+    std::vector<int64_t> segment_sizes = {0, 1, page_size/2, 3*page_size + page_size/2, 2*(int64_t) file.size()};
+    bool passed = !file.empty();
+
+    for(int64_t segment_size : segment_sizes){
+        std::shared_ptr<arrow::Array> array;
+        if(read_column(column.kernel, file, descriptor, segment_size, &array) != ptoa::OK || !array->Equals(column.array)){
+            std::cout << "The " << column.kernel << " column read with segments of " << segment_size << " bytes differs" << std::endl;
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+int main() {
+    std::shared_ptr<arrow::Field> field = arrow::field("str", arrow::utf8(), false);
+    std::shared_ptr<arrow::Array> strings = generate_strings();
+    std::vector<kernel_column> columns = {
+        {"prim32_delta", arrow::field("int32", arrow::int32(), false), generate_ints<arrow::Int32Builder>(), ptoa::DELTA},
+        {"prim64_delta", arrow::field("int64", arrow::int64(), false), generate_ints<arrow::Int64Builder>(), ptoa::DELTA},
+        {"strings", field, strings, ptoa::DELTA_LENGTH}
+    };
+    bool passed = true;
+
+    for(const kernel_column& column : columns){
+        passed = check_pipelined(column) && passed;
+    }
+
+    std::vector<uint8_t> file = write_column(field, strings, "./test_emu_strings.prq");
+    int64_t num_chars = std::static_pointer_cast<arrow::StringArray>(strings)->value_offset(NUM_ROWS);
+    std::shared_ptr<arrow::Array> array;
+    if(file.empty()){
+        passed = false;
+    }
+
+    // The kernel runs out of values buffer, which only the emulator notices
+    if(read_column("strings", file, ptoa::column_descriptor(field, ptoa::DELTA_LENGTH, NUM_ROWS, num_chars - 1), 0, &array) == ptoa::OK){
+        std::cout << "Reading the strings into " << num_chars - 1 << " characters did not fail" << std::endl;
+        passed = false;
+    }
+
+    // Device buffers only grow, so after a larger read the kernel has room for the characters and only the host notices.
+    // The emulator has a single device, so the reader is gone before the next one is created.
+    {
+        ptoa::FpgaReader reader;
+        if(init_reader("strings", &reader) != ptoa::OK ||
+           reader.read(file.data(), file.size(), ptoa::column_descriptor(field, ptoa::DELTA_LENGTH, NUM_ROWS, num_chars), &array) != ptoa::OK ||
+           reader.read(file.data(), file.size(), ptoa::column_descriptor(field, ptoa::DELTA_LENGTH, NUM_ROWS, num_chars - 1), &array) == ptoa::OK){
+            std::cout << "Reading the strings into " << num_chars - 1 << " characters after a larger read did not fail" << std::endl;
+            passed = false;
+        }
+    }
+
+    // The kernel runs out of pages
+    if(read_column("strings", file, ptoa::column_descriptor(field, ptoa::DELTA_LENGTH, NUM_ROWS + 1, num_chars), 0, &array) == ptoa::OK){
+        std::cout << "Reading " << NUM_ROWS + 1 << " strings from a column of " << NUM_ROWS << " did not fail" << std::endl;
+        passed = false;
+    }
+
+    if(passed){
+        std::cout << "Test passed!" << std::endl;
+    } else {
+        std::cout << "Test failed..." << std::endl;
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,441 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/exception.h>
+
+#include "../src/ptoa/parquetwriter.h"
+#include "../src/ptoa/ptoa.h"
+#include "../src/ptoa/thriftcompact.h"
+
+// The files of ptoa::ParquetWriter are read back. PLAIN and dictionary encoded files are read with parquet::arrow. The
+// DELTA_BINARY_PACKED and DELTA_LENGTH_BYTE_ARRAY pages are decoded by the reference decoder below, which reads the
+// values bit by bit and shares no code with the writer. The delta encoded pages are also compared byte by byte with the
+// pages parquet-mr wrote for the same strings, in the first row group of the file given as the first argument.
+
+#ifndef PARQUET_MR_FIXTURE
+#define PARQUET_MR_FIXTURE "../../../profiling/parquet-mr-custom/example_two_column_n_rowgroup.prq"
+#endif
+
+#define NUM_ROWS 50000
+
+// Values of the enums of the Parquet format
+#define PARQUET_DICTIONARY_PAGE 2
+#define PARQUET_DATA_PAGE_V2 3
+#define PARQUET_ENCODING_DELTA_BINARY_PACKED 5
+#define PARQUET_ENCODING_DELTA_LENGTH_BYTE_ARRAY 6
+
+// A page of a file in memory, values points to its values after the levels
+struct page {
+    int32_t type;
+    int32_t encoding;
+    int64_t num_values;
+    const uint8_t* values;
+    int64_t values_size;
+};
+
+std::shared_ptr<arrow::Table> generate_table(std::vector<std::shared_ptr<arrow::Array>>* arrays) {
+    std::mt19937_64 random(7);
+    arrow::Int32Builder int32_builder;
+    arrow::Int64Builder int64_builder;
+    arrow::StringBuilder string_builder;
+
+    // Runs of repeated values, small deltas and deltas that wrap around, and the extremes of the types
+    int64_t value = 0;
+    for(int i=0; i<NUM_ROWS; i++){
+        int run = (i/500) % 3;
+        if(run == 1){
+            value = (int64_t) ((uint64_t) value + random() % 64 - 32);
+        } else if(run == 2){
+            value = (int64_t) random();
+        }
+        if(i % 4999 == 0){
+            value = i % 2 ? std::numeric_limits<int64_t>::min() : std::numeric_limits<int64_t>::max();
+        }
+
+        PARQUET_THROW_NOT_OK(int32_builder.Append((int32_t) value));
+        PARQUET_THROW_NOT_OK(int64_builder.Append(value));
+        PARQUET_THROW_NOT_OK(string_builder.Append(std::string(run == 0 ? 0 : random() % 20, 'a' + value % 26 + (value < 0 ? 25 : 0))));
+    }
+
+    std::shared_ptr<arrow::Array> int32_array, int64_array, string_array;
+    PARQUET_THROW_NOT_OK(int32_builder.Finish(&int32_array));
+    PARQUET_THROW_NOT_OK(int64_builder.Finish(&int64_array));
+    PARQUET_THROW_NOT_OK(string_builder.Finish(&string_array));
+
+    std::shared_ptr<arrow::Schema> schema = arrow::schema({arrow::field("int32", arrow::int32(), false),
+                                                           arrow::field("int64", arrow::int64(), false),
+                                                           arrow::field("str", arrow::utf8(), false)});
+
+    *arrays = {int32_array, int64_array, string_array};
+    return arrow::Table::Make(schema, *arrays);
+}
+
+std::vector<uint8_t> read_file(std::string file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Header of the page at *pos, which is moved to the next page
+ptoa::status read_page(const std::vector<uint8_t>& file, int64_t* pos, page* out) {
+    if(*pos >= (int64_t) file.size()){
+        return ptoa::FAIL;
+    }
+
+    ptoa::CompactReader header(file.data() + *pos, file.size() - *pos);
+    int16_t field_id;
+    ptoa::compact_type type;
+    int32_t compressed_size = -1;
+    int32_t levels_size = 0;
+
+    out->type = -1;
+    out->encoding = -1;
+    out->num_values = 0;
+
+    while(header.next_field(&field_id, &type)){
+        if(field_id == 1 && type == ptoa::COMPACT_I32){
+            header.read_i32(&out->type);
+        } else if(field_id == 3 && type == ptoa::COMPACT_I32){
+            header.read_i32(&compressed_size);
+        } else if((field_id == 7 || field_id == 8) && type == ptoa::COMPACT_STRUCT){
+            // dictionary_page_header (num_values 1, encoding 2) or data_page_header_v2 (num_values 1, encoding 4,
+            // definition_levels_byte_length 5 and repetition_levels_byte_length 6)
+            int16_t page_header_id = field_id;
+            header.begin_struct();
+            while(header.next_field(&field_id, &type)){
+                int32_t value;
+                if(type != ptoa::COMPACT_I32){
+                    header.skip(type);
+                    continue;
+                }
+                header.read_i32(&value);
+                if(field_id == 1){
+                    out->num_values = value;
+                } else if(field_id == (page_header_id == 7 ? 2 : 4)){
+                    out->encoding = value;
+                } else if(page_header_id == 8 && (field_id == 5 || field_id == 6)){
+                    levels_size += value;
+                }
+            }
+            header.end_struct();
+        } else {
+            header.skip(type);
+        }
+    }
+
+    if(header.failed() || compressed_size < levels_size || compressed_size > (int64_t) file.size() - *pos - header.position()){
+        return ptoa::FAIL;
+    }
+
+    out->values = file.data() + *pos + header.position() + levels_size;
+    out->values_size = compressed_size - levels_size;
+    *pos += header.position() + compressed_size;
+
+    return ptoa::OK;
+}
+
+bool read_varint(const uint8_t* data, int64_t size, int64_t* pos, uint64_t* value) {
+    *value = 0;
+    for(int shift=0; shift<64; shift+=7){
+        if(*pos >= size){
+            return false;
+        }
+        uint8_t byte = data[(*pos)++];
+        *value |= (uint64_t) (byte & 0x7f) << shift;
+        if((byte & 0x80) == 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+bool read_zigzag(const uint8_t* data, int64_t size, int64_t* pos, int64_t* value) {
+    uint64_t zigzag;
+    if(!read_varint(data, size, pos, &zigzag)){
+        return false;
+    }
+    *value = (int64_t) ((zigzag >> 1) ^ -(zigzag & 1));
+    return true;
+}
+
+// DELTA_BINARY_PACKED values at data, appended to values as int64_t. *pos is moved past the last miniblock that holds
+// values, where DELTA_LENGTH_BYTE_ARRAY continues with the characters.
+bool decode_delta(const uint8_t* data, int64_t size, int64_t* pos, std::vector<int64_t>* values) {
+    uint64_t block_size, miniblocks, total;
+    int64_t first_value;
+    if(!read_varint(data, size, pos, &block_size) || !read_varint(data, size, pos, &miniblocks) ||
+       !read_varint(data, size, pos, &total) || !read_zigzag(data, size, pos, &first_value) ||
+       miniblocks == 0 || block_size % miniblocks != 0 || (block_size/miniblocks) % 8 != 0){
+        return false;
+    }
+
+    uint64_t miniblock_size = block_size/miniblocks;
+    uint64_t value = (uint64_t) first_value;
+    uint64_t decoded = 0;
+
+    if(total > 0){
+        values->push_back(first_value);
+        decoded++;
+    }
+
+    while(decoded < total){
+        int64_t min_delta;
+        if(!read_zigzag(data, size, pos, &min_delta) || *pos + (int64_t) miniblocks > size){
+            return false;
+        }
+        const uint8_t* bit_widths = data + *pos;
+        *pos += miniblocks;
+
+        // The bit widths of miniblocks after the last value are arbitrary and the miniblocks themselves are left out
+        for(uint64_t m=0; m<miniblocks && decoded<total; m++){
+            int bit_width = bit_widths[m];
+            int64_t miniblock_bytes = bit_width*miniblock_size/8;
+            if(bit_width > 64 || *pos + miniblock_bytes > size){
+                return false;
+            }
+
+            for(uint64_t i=0; i<miniblock_size && decoded<total; i++){
+                uint64_t delta = 0;
+                for(int b=0; b<bit_width; b++){
+                    uint64_t bit = i*bit_width + b;
+                    delta |= (uint64_t) ((data[*pos + bit/8] >> (bit%8)) & 1) << b;
+                }
+                value += (uint64_t) min_delta + delta;
+                values->push_back((int64_t) value);
+                decoded++;
+            }
+            *pos += miniblock_bytes;
+        }
+    }
+
+    return true;
+}
+
+// DELTA_LENGTH_BYTE_ARRAY strings of a page: the lengths DELTA_BINARY_PACKED, followed by all characters
+bool decode_delta_length(const uint8_t* data, int64_t size, std::vector<std::string>* strings) {
+    int64_t pos = 0;
+    std::vector<int64_t> lengths;
+    if(!decode_delta(data, size, &pos, &lengths)){
+        return false;
+    }
+
+    for(int64_t length : lengths){
+        if(length < 0 || length > size - pos){
+            return false;
+        }
+        strings->push_back(std::string((const char*) data + pos, length));
+        pos += length;
+    }
+
+    return pos == size;
+}
+
+// Write the table and read it back with parquet::arrow, checking that the first page of every column has the expected
+// type: a dictionary page if dictionary is set
+bool check_arrow_round_trip(std::shared_ptr<arrow::Table> table, bool dictionary, std::string file_path) {
+    ptoa::ParquetWriter writer;
+    writer.set_encoding(arrow::Type::INT32, ptoa::PLAIN);
+    writer.set_encoding(arrow::Type::STRING, ptoa::PLAIN);
+    writer.set_rows_per_page(777);
+    if(dictionary){
+        writer.enable_dictionary();
+    }
+
+    if(writer.write(table, file_path) != ptoa::OK){
+        return false;
+    }
+
+    std::vector<uint8_t> file = read_file(file_path);
+    int64_t pos = 4;
+    for(int c=0; c<table->num_columns(); c++){
+        int64_t values = 0;
+        page p;
+        for(int64_t i=0; values<table->num_rows(); i++){
+            if(read_page(file, &pos, &p) != ptoa::OK){
+                return false;
+            }
+            if(i == 0 && (p.type == PARQUET_DICTIONARY_PAGE) != dictionary){
+                std::cout << "Column " << c << (dictionary ? " is not" : " is") << " dictionary encoded" << std::endl;
+                return false;
+            }
+            if(p.type == PARQUET_DATA_PAGE_V2){
+                values += p.num_values;
+            }
+        }
+    }
+
+    std::shared_ptr<arrow::io::ReadableFile> infile;
+    PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(file_path, arrow::default_memory_pool(), &infile));
+
+    std::unique_ptr<parquet::arrow::FileReader> reader;
+    PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+
+    std::shared_ptr<arrow::Table> read_table;
+    PARQUET_THROW_NOT_OK(reader->ReadTable(&read_table));
+
+    return read_table->Equals(*table);
+}
+
+// Write the arrays with the delta encodings and decode the pages with the reference decoder
+bool check_delta_round_trip(std::shared_ptr<arrow::Table> table, const std::vector<std::shared_ptr<arrow::Array>>& arrays, std::string file_path) {
+    ptoa::ParquetWriter writer;
+    writer.set_rows_per_page(777);
+
+    if(writer.write(table, file_path) != ptoa::OK){
+        return false;
+    }
+
+    std::vector<uint8_t> file = read_file(file_path);
+    int64_t pos = 4;
+
+    for(int c=0; c<table->num_columns(); c++){
+        bool is_string = arrays[c]->type_id() == arrow::Type::STRING;
+        std::vector<int64_t> values;
+        std::vector<std::string> strings;
+        int64_t page_pos;
+        page p;
+
+        while((int64_t) (is_string ? strings.size() : values.size()) < table->num_rows()){
+            if(read_page(file, &pos, &p) != ptoa::OK || p.type != PARQUET_DATA_PAGE_V2 ||
+               p.encoding != (is_string ? PARQUET_ENCODING_DELTA_LENGTH_BYTE_ARRAY : PARQUET_ENCODING_DELTA_BINARY_PACKED)){
+                std::cout << "Column " << c << " has an unexpected page" << std::endl;
+                return false;
+            }
+
+            page_pos = 0;
+            size_t decoded = is_string ? strings.size() : values.size();
+            if(is_string ? !decode_delta_length(p.values, p.values_size, &strings) : !decode_delta(p.values, p.values_size, &page_pos, &values)){
+                std::cout << "Column " << c << " has a page that cannot be decoded" << std::endl;
+                return false;
+            }
+            if((int64_t) ((is_string ? strings.size() : values.size()) - decoded) != p.num_values){
+                std::cout << "Column " << c << " has a page with " << p.num_values << " values in its header and "
+                          << (is_string ? strings.size() : values.size()) - decoded << " encoded" << std::endl;
+                return false;
+            }
+        }
+
+        for(int64_t i=0; i<table->num_rows(); i++){
+            bool equal;
+            if(is_string){
+                equal = std::static_pointer_cast<arrow::StringArray>(arrays[c])->GetString(i) == strings[i];
+            } else if(arrays[c]->type_id() == arrow::Type::INT32){
+                equal = std::static_pointer_cast<arrow::Int32Array>(arrays[c])->Value(i) == (int32_t) values[i];
+            } else {
+                equal = std::static_pointer_cast<arrow::Int64Array>(arrays[c])->Value(i) == values[i];
+            }
+            if(!equal){
+                std::cout << "Column " << c << " differs at value " << i << std::endl;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// The string column of the first row group of the parquet-mr file is optional, so its pages start with definition
+// levels. They are written without nulls in pages of 100 values, which the writer is set up to reproduce.
+bool check_parquet_mr_pages(std::string fixture_path, std::string file_path) {
+    std::vector<uint8_t> fixture = read_file(fixture_path);
+    if(fixture.size() < 8){
+        std::cout << "Could not read " << fixture_path << std::endl;
+        return false;
+    }
+
+    // Skip the dictionary encoded int column, the next page starts the string column
+    int64_t pos = 4;
+    page p;
+    std::vector<page> fixture_pages;
+    std::vector<std::string> strings;
+    while(read_page(fixture, &pos, &p) == ptoa::OK){
+        if(p.encoding == PARQUET_ENCODING_DELTA_LENGTH_BYTE_ARRAY){
+            fixture_pages.push_back(p);
+            if(!decode_delta_length(p.values, p.values_size, &strings)){
+                std::cout << "The reference decoder cannot decode the strings of " << fixture_path << std::endl;
+                return false;
+            }
+        } else if(!fixture_pages.empty()){
+            break;
+        }
+    }
+
+    arrow::StringBuilder builder;
+    PARQUET_THROW_NOT_OK(builder.AppendValues(strings));
+    std::shared_ptr<arrow::Array> array;
+    PARQUET_THROW_NOT_OK(builder.Finish(&array));
+    std::shared_ptr<arrow::Table> table = arrow::Table::Make(arrow::schema({arrow::field("str", arrow::utf8(), false)}), {array});
+
+    ptoa::ParquetWriter writer;
+    writer.set_rows_per_page(100);
+    if(fixture_pages.empty() || writer.write(table, file_path) != ptoa::OK){
+        return false;
+    }
+
+    std::vector<uint8_t> file = read_file(file_path);
+    pos = 4;
+    for(size_t i=0; i<fixture_pages.size(); i++){
+        if(read_page(file, &pos, &p) != ptoa::OK || p.num_values != fixture_pages[i].num_values ||
+           p.values_size != fixture_pages[i].values_size || memcmp(p.values, fixture_pages[i].values, p.values_size) != 0){
+            std::cout << "Page " << i << " of the strings differs from parquet-mr's" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::string fixture_path = argc > 1 ? argv[1] : PARQUET_MR_FIXTURE;
+    std::vector<std::shared_ptr<arrow::Array>> arrays;
+    std::shared_ptr<arrow::Table> table = generate_table(&arrays);
+    bool passed = true;
+
+    if(!check_arrow_round_trip(table, false, "./test_roundtrip_plain.prq")){
+        std::cout << "The PLAIN encoded file differs from the table" << std::endl;
+        passed = false;
+    }
+
+    if(!check_arrow_round_trip(table, true, "./test_roundtrip_dictionary.prq")){
+        std::cout << "The dictionary encoded file differs from the table" << std::endl;
+        passed = false;
+    }
+
+    if(!check_delta_round_trip(table, arrays, "./test_roundtrip_delta.prq")){
+        std::cout << "The delta encoded file differs from the table" << std::endl;
+        passed = false;
+    }
+
+    if(!check_parquet_mr_pages(fixture_path, "./test_roundtrip_parquet_mr.prq")){
+        passed = false;
+    }
+
+    if(passed){
+        std::cout << "Test passed!" << std::endl;
+    } else {
+        std::cout << "Test failed..." << std::endl;
+    }
+
+    return passed ? 0 : 1;
+}
@@ -78,7 +78,7 @@ int main(int argc, char **argv) {
 
   writer->write(test_table, "./test_yesdict.prq");
 
-  format::DictionaryPageHeader dict_page_header;
+  parquet::format::DictionaryPageHeader dict_page_header;
 
 
   return 0;
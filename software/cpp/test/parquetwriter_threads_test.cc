@@ -0,0 +1,173 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <arrow/api.h>
+#include <parquet/exception.h>
+
+#include "../src/ptoa/parquetwriter.h"
+#include "../src/ptoa/ptoa.h"
+
+// The threaded and the streaming writer have to produce the same file as a single threaded write() of the table. Every
+// writer configuration is written with 1, 2 and all hardware threads, and streamed in irregular batches, and the files
+// are compared byte by byte.
+
+#define NUM_ROWS 100000
+
+std::shared_ptr<arrow::Table> generate_table(std::vector<std::shared_ptr<arrow::Array>>* arrays) {
+    std::mt19937_64 random(42);
+    arrow::Int32Builder int32_builder;
+    arrow::Int64Builder int64_builder;
+    arrow::StringBuilder string_builder;
+
+    // Runs of narrow and wide deltas, so the miniblocks of a page get different bit widths
+    int64_t value = 0;
+    for(int i=0; i<NUM_ROWS; i++){
+        int bit_width = (i/1000) % 2 ? random() % 40 : random() % 8;
+        value += random() & ((1ULL << bit_width) - 1);
+
+        PARQUET_THROW_NOT_OK(int32_builder.Append((int32_t) value));
+        PARQUET_THROW_NOT_OK(int64_builder.Append(value));
+        PARQUET_THROW_NOT_OK(string_builder.Append(std::string(random() % (bit_width + 1), 'a' + i % 26)));
+    }
+
+    std::shared_ptr<arrow::Array> int32_array, int64_array, string_array;
+    PARQUET_THROW_NOT_OK(int32_builder.Finish(&int32_array));
+    PARQUET_THROW_NOT_OK(int64_builder.Finish(&int64_array));
+    PARQUET_THROW_NOT_OK(string_builder.Finish(&string_array));
+
+    std::shared_ptr<arrow::Schema> schema = arrow::schema({arrow::field("int32", arrow::int32(), false),
+                                                           arrow::field("int64", arrow::int64(), false),
+                                                           arrow::field("str", arrow::utf8(), false)});
+
+    *arrays = {int32_array, int64_array, string_array};
+    return arrow::Table::Make(schema, *arrays);
+}
+
+void configure(ptoa::ParquetWriter* writer, int config, int threads) {
+    writer->set_threads(threads);
+
+    if(config == 0){
+        // Pages of 129 values end one value into a new block
+        writer->set_rows_per_page(129);
+    } else if(config == 1){
+        writer->set_page_size(700);
+    } else if(config == 2){
+        writer->set_encoding(arrow::Type::INT64, ptoa::PLAIN);
+        writer->set_encoding(arrow::Type::STRING, ptoa::PLAIN);
+        writer->set_rows_per_page(333);
+    } else if(config == 3){
+        writer->enable_dictionary();
+        writer->set_rows_per_page(1000);
+    }
+}
+
+// Streamed columns are never dictionary encoded
+bool is_streamable(int config) {
+    return config != 3;
+}
+
+ptoa::status write_streaming(ptoa::ParquetWriter* writer, std::shared_ptr<arrow::Schema> schema, const std::vector<std::shared_ptr<arrow::Array>>& arrays, std::string file_path) {
+    if(writer->open(file_path) != ptoa::OK){
+        return ptoa::FAIL;
+    }
+
+    for(int c=0; c<schema->num_fields(); c++){
+        const std::shared_ptr<arrow::Array>& array = arrays[c];
+        if(writer->begin_column(schema->field(c)) != ptoa::OK){
+            return ptoa::FAIL;
+        }
+
+        // Batches that do not line up with the pages or blocks
+        int64_t offset = 0;
+        for(int64_t batch=1; offset<array->length(); batch=batch*3 + 7){
+            int64_t length = std::min(batch, array->length() - offset);
+            if(writer->append_column(array->Slice(offset, length)) != ptoa::OK){
+                return ptoa::FAIL;
+            }
+            offset += length;
+        }
+
+        if(writer->end_column() != ptoa::OK){
+            return ptoa::FAIL;
+        }
+    }
+
+    return writer->close();
+}
+
+std::vector<char> read_file(std::string file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+bool same_file(const std::vector<char>& expected, std::string file_path) {
+    std::vector<char> contents = read_file(file_path);
+    return contents.size() == expected.size() && memcmp(contents.data(), expected.data(), expected.size()) == 0;
+}
+
+int main() {
+    std::vector<std::shared_ptr<arrow::Array>> arrays;
+    std::shared_ptr<arrow::Table> table = generate_table(&arrays);
+    int max_threads = std::max(std::thread::hardware_concurrency(), 3U);
+    bool passed = true;
+
+    for(int config=0; config<4; config++){
+        ptoa::ParquetWriter reference_writer;
+        configure(&reference_writer, config, 1);
+        if(reference_writer.write(table, "./test_threads_reference.prq") != ptoa::OK){
+            std::cout << "Configuration " << config << " could not be written" << std::endl;
+            passed = false;
+            continue;
+        }
+        std::vector<char> reference = read_file("./test_threads_reference.prq");
+
+        for(int threads : {1, 2, max_threads}){
+            ptoa::ParquetWriter writer;
+            configure(&writer, config, threads);
+
+            if(writer.write(table, "./test_threads.prq") != ptoa::OK || !same_file(reference, "./test_threads.prq")){
+                std::cout << "Configuration " << config << " written with " << threads << " threads differs" << std::endl;
+                passed = false;
+            }
+
+            if(!is_streamable(config)){
+                continue;
+            }
+
+            ptoa::ParquetWriter streaming_writer;
+            configure(&streaming_writer, config, threads);
+
+            if(write_streaming(&streaming_writer, table->schema(), arrays, "./test_threads.prq") != ptoa::OK || !same_file(reference, "./test_threads.prq")){
+                std::cout << "Configuration " << config << " streamed with " << threads << " threads differs" << std::endl;
+                passed = false;
+            }
+        }
+    }
+
+    if(passed){
+        std::cout << "Test passed!" << std::endl;
+    } else {
+        std::cout << "Test failed..." << std::endl;
+    }
+
+    return passed ? 0 : 1;
+}
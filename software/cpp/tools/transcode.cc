@@ -0,0 +1,321 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <parquet/arrow/reader.h>
+
+#include "../src/ptoa/parquetwriter.h"
+#include "../src/ptoa/ptoa.h"
+
+// Rows read from the input at a time, together with one page of every column this bounds the memory use
+#define DEFAULT_BATCH_ROWS (1024*1024)
+
+// Settings of a single column, -1 or an empty encoding falls back to the settings of all columns
+struct column_options {
+    std::string encoding;
+    int64_t page_size = -1;
+    int64_t rows_per_page = -1;
+};
+
+struct transcode_options {
+    std::string input_path;
+    std::string output_path;
+    std::vector<std::string> columns;
+    int64_t page_size = DEFAULT_PAGE_SIZE;
+    int64_t rows_per_page = DEFAULT_ROWS_PER_PAGE;
+    int64_t batch_rows = DEFAULT_BATCH_ROWS;
+    int64_t threads = 1;
+    std::map<std::string, column_options> column_settings;
+};
+
+void print_usage() {
+    std::cerr << "Usage: transcode [--option=value]... <input.parquet> <output.parquet>" << std::endl
+              << "Rewrites a Parquet file (V1 or V2 pages, any codec, dictionary encoded or not) as a single row group of" << std::endl
+              << "uncompressed V2 pages without dictionaries, the layout the hardware and SWParquetReader read." << std::endl
+              << "  --columns        comma separated columns to write (default all)" << std::endl
+              << "  --page_size      maximum plain encoded bytes per page (default " << DEFAULT_PAGE_SIZE << ")" << std::endl
+              << "  --rows_per_page  maximum values per page (default " << DEFAULT_ROWS_PER_PAGE << ")" << std::endl
+              << "  --column         settings of one column, name:key=value[,key=value], keys are encoding (plain, delta" << std::endl
+              << "                   or delta_length), page_size and rows_per_page, e.g. --column=id:encoding=plain" << std::endl
+              << "  --config         file of column settings, one name:key=value[,key=value] per line like --column, e.g." << std::endl
+              << "                   the recommendation of the advise benchmark; lines starting with # are skipped" << std::endl
+              << "  --threads        threads encoding the pages of a column (default 1)" << std::endl
+              << "  --batch_rows     rows read from the input at a time (default " << DEFAULT_BATCH_ROWS << ")" << std::endl
+              << "Integer columns are delta encoded and string columns delta length encoded unless configured otherwise." << std::endl;
+}
+
+std::vector<std::string> split(const std::string& value, char separator) {
+    std::vector<std::string> items;
+    size_t start = 0;
+
+    while(start <= value.size()) {
+        size_t end = value.find(separator, start);
+        if(end == std::string::npos) {
+            end = value.size();
+        }
+        if(end > start) {
+            items.push_back(value.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+
+    return items;
+}
+
+bool parse_number(const std::string& name, const std::string& value, int64_t* number) {
+    char* end;
+    *number = std::strtoll(value.c_str(), &end, 10);
+
+    if(value.empty() || *end != '\0' || *number <= 0) {
+        std::cerr << "[ERROR] Invalid value \"" << value << "\" for " << name << ", expected a positive number" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool parse_column(const std::string& value, transcode_options* options) {
+    size_t colon = value.rfind(':');
+    if(colon == std::string::npos || colon == 0) {
+        std::cerr << "[ERROR] Invalid value \"" << value << "\" for option --column, expected name:key=value[,key=value]" << std::endl;
+        return false;
+    }
+
+    column_options& settings = options->column_settings[value.substr(0, colon)];
+
+    for(const std::string& setting : split(value.substr(colon + 1), ',')) {
+        size_t equals = setting.find('=');
+        std::string key = setting.substr(0, equals);
+        std::string setting_value = equals == std::string::npos ? "" : setting.substr(equals + 1);
+
+        if(key == "encoding" && (setting_value == "plain" || setting_value == "delta" || setting_value == "delta_length")) {
+            settings.encoding = setting_value;
+        } else if(key == "page_size") {
+            if(!parse_number(key, setting_value, &settings.page_size)) {
+                return false;
+            }
+        } else if(key == "rows_per_page") {
+            if(!parse_number(key, setting_value, &settings.rows_per_page)) {
+                return false;
+            }
+        } else {
+            std::cerr << "[ERROR] Invalid column setting \"" << setting << "\"" << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool parse_config(const std::string& path, transcode_options* options) {
+    std::ifstream config(path);
+    if(!config) {
+        std::cerr << "[ERROR] Could not read " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while(std::getline(config, line)) {
+        if(line.empty() || line[0] == '#') {
+            continue;
+        }
+        if(!parse_column(line, options)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool parse_options(int argc, char** argv, transcode_options* options) {
+    std::vector<std::string> paths;
+
+    for(int i=1; i<argc; i++) {
+        std::string arg = argv[i];
+        if(arg.compare(0, 2, "--") != 0) {
+            paths.push_back(arg);
+            continue;
+        }
+
+        size_t equals = arg.find('=');
+        std::string name = arg.substr(2, equals == std::string::npos ? std::string::npos : equals - 2);
+        std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+        bool valid;
+
+        if(name == "columns") {
+            options->columns = split(value, ',');
+            valid = !options->columns.empty();
+        } else if(name == "page_size") {
+            valid = parse_number("--" + name, value, &options->page_size);
+        } else if(name == "rows_per_page") {
+            valid = parse_number("--" + name, value, &options->rows_per_page);
+        } else if(name == "column") {
+            valid = parse_column(value, options);
+        } else if(name == "config") {
+            valid = parse_config(value, options);
+        } else if(name == "threads") {
+            valid = parse_number("--" + name, value, &options->threads);
+        } else if(name == "batch_rows") {
+            valid = parse_number("--" + name, value, &options->batch_rows);
+        } else {
+            std::cerr << "[ERROR] Unknown option --" << name << std::endl;
+            valid = false;
+        }
+
+        if(!valid) {
+            return false;
+        }
+    }
+
+    if(paths.size() != 2) {
+        std::cerr << "[ERROR] Expected an input and an output file" << std::endl;
+        return false;
+    }
+    options->input_path = paths[0];
+    options->output_path = paths[1];
+
+    return true;
+}
+
+// Applies the settings of a column to the writer before the column is started
+ptoa::status configure_column(const transcode_options& options, const std::shared_ptr<arrow::Field>& field, ptoa::ParquetWriter* writer) {
+    arrow::Type::type type = field->type()->id();
+    bool integer = type == arrow::Type::INT32 || type == arrow::Type::INT64;
+    column_options settings;
+
+    if(!integer && type != arrow::Type::STRING && type != arrow::Type::BINARY) {
+        std::cerr << "[ERROR] Column " << field->name() << " has type " << field->type()->ToString() << ", only int32, int64, utf8 and binary columns can be transcoded, leave it out with --columns" << std::endl;
+        return ptoa::status::FAIL;
+    }
+
+    auto column = options.column_settings.find(field->name());
+    if(column != options.column_settings.end()) {
+        settings = column->second;
+    }
+
+    writer->set_page_size(settings.page_size > 0 ? settings.page_size : options.page_size);
+    writer->set_rows_per_page(settings.rows_per_page > 0 ? settings.rows_per_page : options.rows_per_page);
+
+    ptoa::encoding enc = integer ? ptoa::encoding::DELTA : ptoa::encoding::DELTA_LENGTH;
+    if(settings.encoding == "plain") {
+        enc = ptoa::encoding::PLAIN;
+    } else if(settings.encoding == "delta") {
+        enc = ptoa::encoding::DELTA;
+    } else if(settings.encoding == "delta_length") {
+        enc = ptoa::encoding::DELTA_LENGTH;
+    }
+
+    if(writer->set_encoding(type, enc) != ptoa::status::OK) {
+        std::cerr << "[ERROR] Column " << field->name() << " of type " << field->type()->ToString() << " cannot be " << settings.encoding << " encoded" << std::endl;
+        return ptoa::status::FAIL;
+    }
+
+    return ptoa::status::OK;
+}
+
+/**
+ * Columns are transcoded one after another, each streamed through the reader batch_rows rows at a time. The writer
+ * turns complete pages into output right away, so only a batch and a page of the current column are held in memory,
+ * no matter how large the file or its row groups are.
+ */
+int main(int argc, char **argv) {
+    transcode_options options;
+
+    if(!parse_options(argc, argv, &options)) {
+        print_usage();
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::shared_ptr<arrow::io::ReadableFile> infile;
+    PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(options.input_path, arrow::default_memory_pool(), &infile));
+
+    std::unique_ptr<parquet::arrow::FileReader> reader;
+    PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+
+    std::shared_ptr<arrow::Schema> schema;
+    PARQUET_THROW_NOT_OK(reader->GetSchema(&schema));
+
+    std::vector<int> column_indices;
+    if(options.columns.empty()) {
+        for(int c=0; c<schema->num_fields(); c++) {
+            column_indices.push_back(c);
+        }
+    }
+    for(const std::string& name : options.columns) {
+        int c = schema->GetFieldIndex(name);
+        if(c < 0) {
+            std::cerr << "[ERROR] " << options.input_path << " has no column " << name << std::endl;
+            return 1;
+        }
+        column_indices.push_back(c);
+    }
+
+    ptoa::ParquetWriter writer;
+    writer.set_threads(options.threads);
+
+    if(writer.open(options.output_path) != ptoa::status::OK) {
+        return 1;
+    }
+
+    int64_t num_rows = 0;
+    for(int c : column_indices) {
+        std::shared_ptr<arrow::Field> field = schema->field(c);
+
+        if(configure_column(options, field, &writer) != ptoa::status::OK || writer.begin_column(field) != ptoa::status::OK) {
+            return 1;
+        }
+
+        std::unique_ptr<parquet::arrow::ColumnReader> column_reader;
+        PARQUET_THROW_NOT_OK(reader->GetColumn(c, &column_reader));
+
+        num_rows = 0;
+        while(true) {
+            std::shared_ptr<arrow::ChunkedArray> batch;
+            PARQUET_THROW_NOT_OK(column_reader->NextBatch(options.batch_rows, &batch));
+            if(!batch || batch->length() == 0) {
+                break;
+            }
+
+            for(int i=0; i<batch->num_chunks(); i++) {
+                if(writer.append_column(batch->chunk(i)) != ptoa::status::OK) {
+                    return 1;
+                }
+            }
+            num_rows += batch->length();
+        }
+
+        if(writer.end_column() != ptoa::status::OK) {
+            return 1;
+        }
+        std::cout << "Column " << field->name() << ": " << num_rows << " values" << std::endl;
+    }
+
+    if(writer.close() != ptoa::status::OK) {
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Transcoded " << num_rows << " rows of " << column_indices.size() << " columns to " << options.output_path << " in " << seconds << " s" << std::endl;
+
+    return 0;
+}